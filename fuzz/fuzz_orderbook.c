@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "harness.h"
+#include "orderbook.h"
+
+/*
+    Differential fuzzer: runs random operation sequences through the
+    engine and the reference book until they disagree, then shrinks the
+    failing sequence and prints it.
+
+    -stp picks the self-trade prevention mode (as StpMode, 0 for none).
+
+    usage: fuzz_orderbook [-s first_seed] [-n seeds] [-l steps] [-ladder] [-stp mode]
+*/
+
+int main(int argc, char **argv)
+{
+    unsigned long long first_seed = 1;
+    int seeds = 1000;
+    int steps = 2000;
+    FuzzConfig config = default_fuzz_config();
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            first_seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            seeds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+            steps = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-ladder") == 0)
+            config.ladder = 1;
+        else if (strcmp(argv[i], "-stp") == 0 && i + 1 < argc)
+            config.stp_mode = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [-s first_seed] [-n seeds] [-l steps] [-ladder] [-stp mode]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (seeds <= 0 || steps <= 0)
+    {
+        fprintf(stderr, "seeds and steps must be positive\n");
+        return 2;
+    }
+    if (config.stp_mode < STP_NONE || config.stp_mode > STP_DECREMENT)
+    {
+        fprintf(stderr, "stp mode must be %d..%d\n", STP_NONE, STP_DECREMENT);
+        return 2;
+    }
+
+    FuzzOp *ops = (FuzzOp *)malloc(steps * sizeof(FuzzOp));
+    if (!ops)
+    {
+        fprintf(stderr, "Memory allocation failed for fuzz operations\n");
+        exit(EXIT_FAILURE);
+    }
+
+    char why[256];
+    for (unsigned long long seed = first_seed; seed < first_seed + seeds; seed++)
+    {
+        fuzz_generate(&config, seed, ops, steps);
+        int failed = fuzz_run(&config, ops, steps, why, sizeof(why));
+        if (failed < 0)
+            continue;
+
+        printf("seed %llu diverged at step %d: %s\n", seed, failed, why);
+        int n = fuzz_shrink(&config, ops, steps);
+        fuzz_run(&config, ops, n, why, sizeof(why));
+        printf("shrunk to %d operations (%s):\n", n, why);
+        fuzz_print(ops, n);
+        free(ops);
+        return 1;
+    }
+
+    printf("%d seeds x %d steps: engine and reference agree%s\n", seeds, steps,
+           config.ladder ? " (price ladder)" : "");
+    free(ops);
+    return 0;
+}
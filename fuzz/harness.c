@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "harness.h"
+#include "refbook.h"
+#include "orderbook.h"
+#include "matching/auction.h"
+
+FuzzConfig default_fuzz_config()
+{
+    FuzzConfig config;
+    config.ladder = 0;
+    config.tick = 0.5;
+    config.price_levels = 24;
+    config.base_price = 94;
+    config.stp_mode = STP_NONE;
+    config.owners = 4;
+    config.events = 1;
+    return config;
+}
+
+static unsigned long long next_random(unsigned long long *state)
+{
+    // xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static int pick(unsigned long long *state, int n)
+{
+    return (int)(next_random(state) % (unsigned long long)n);
+}
+
+void fuzz_generate(const FuzzConfig *config, unsigned long long seed, FuzzOp *ops, int n)
+{
+    unsigned long long state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    int next_id = 1;
+    long long now = 0;
+    int in_auction = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        FuzzOp *op = &ops[i];
+        memset(op, 0, sizeof(FuzzOp));
+        op->tif = TIF_GTC;
+
+        // one roll in eleven is an event when they are on
+        int roll = pick(&state, config->events ? 110 : 100);
+        if (roll >= 100)
+        {
+            if (roll < 106)
+            {
+                op->type = FUZZ_TICK;
+                now += 1 + pick(&state, 5);
+                op->time = now;
+            }
+            else if (roll < 107)
+                op->type = FUZZ_SESSION_END;
+            else
+            {
+                op->type = in_auction ? FUZZ_UNCROSS : FUZZ_AUCTION;
+                in_auction = !in_auction;
+            }
+            continue;
+        }
+
+        op->type = roll < 60 ? FUZZ_ADD : roll < 78 ? FUZZ_CANCEL : roll < 92 ? FUZZ_MODIFY : FUZZ_MARKET;
+        op->side = pick(&state, 2) ? 'B' : 'S';
+        op->price = config->base_price + config->tick * pick(&state, config->price_levels);
+        op->quantity = 1 + pick(&state, 20);
+
+        if (op->type == FUZZ_ADD || op->type == FUZZ_MARKET || next_id == 1)
+        {
+            if (op->type != FUZZ_MARKET)
+                op->type = FUZZ_ADD;
+            op->order_id = next_id++;
+        }
+        else
+        {
+            // mostly recent ids, some long gone or never used
+            int span = next_id - 1 < 40 ? next_id - 1 : 40;
+            op->order_id = pick(&state, 10) == 0 ? 1 + pick(&state, next_id + 5) : next_id - 1 - pick(&state, span);
+        }
+        // some modifies keep the price so size-down keeps priority
+        if (op->type == FUZZ_MODIFY && pick(&state, 2) == 0)
+            op->price = -1;
+
+        if (config->owners > 0)
+            op->owner_id = pick(&state, config->owners + 1); // 0 is no owner
+        if (config->events && op->type == FUZZ_ADD)
+        {
+            int tif = pick(&state, 10);
+            if (tif == 0)
+                op->tif = TIF_DAY;
+            else if (tif == 1)
+            {
+                op->tif = TIF_GTT;
+                op->time = now + 1 + pick(&state, 30);
+            }
+        }
+    }
+}
+
+static int compare_engine_priority(const void *a, const void *b)
+{
+    const Order *x = *(Order *const *)a;
+    const Order *y = *(Order *const *)b;
+    if (x->price != y->price)
+        return (x->side == 'B' ? x->price > y->price : x->price < y->price) ? -1 : 1;
+    return x->sequence < y->sequence ? -1 : 1;
+}
+
+static int compare_side(OrderBook *book, RefBook *ref, char side, char *why, size_t why_len)
+{
+    OrderHeap *heap = side == 'B' ? book->buy_orders : book->sell_orders;
+    Order **engine = (Order **)malloc((heap->size + 1) * sizeof(Order *));
+    RefOrder *expected = (RefOrder *)malloc((ref->count + 1) * sizeof(RefOrder));
+    if (!engine || !expected)
+    {
+        fprintf(stderr, "Memory allocation failed for fuzz comparison\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int n = collectOrders(heap, engine);
+    int m = ref_side(ref, side, expected);
+    qsort(engine, n, sizeof(Order *), compare_engine_priority);
+
+    int result = 0;
+    if (n != m)
+    {
+        snprintf(why, why_len, "side %c has %d orders, reference %d", side, n, m);
+        result = -1;
+    }
+    for (int i = 0; i < n && result == 0; i++)
+    {
+        if (engine[i]->order_id != expected[i].order_id || engine[i]->price != expected[i].price ||
+            engine[i]->quantity != expected[i].quantity)
+        {
+            snprintf(why, why_len, "side %c position %d: order %d %.2f x %d, reference %d %.2f x %d",
+                     side, i, engine[i]->order_id, engine[i]->price, engine[i]->quantity,
+                     expected[i].order_id, expected[i].price, expected[i].quantity);
+            result = -1;
+        }
+        else if (ordermap_get(book->order_map, engine[i]->order_id) != engine[i])
+        {
+            snprintf(why, why_len, "order %d resting but not mapped", engine[i]->order_id);
+            result = -1;
+        }
+    }
+    if (result == 0 && n > 0 && getTop(heap) != engine[0])
+    {
+        snprintf(why, why_len, "side %c top is order %d, expected %d", side,
+                 getTop(heap)->order_id, engine[0]->order_id);
+        result = -1;
+    }
+
+    free(engine);
+    free(expected);
+    return result;
+}
+
+static int compare_fills(OrderBook *book, RefBook *ref, int from, char *why, size_t why_len)
+{
+    if (book->trade_history_size != ref->fill_count)
+    {
+        snprintf(why, why_len, "%d fills, reference %d", book->trade_history_size - from,
+                 ref->fill_count - from);
+        return -1;
+    }
+    for (int i = from; i < ref->fill_count; i++)
+    {
+        FilledOrder *got = &book->trade_history[i];
+        RefFill *want = &ref->fills[i];
+        if (got->maker_id != want->maker_id || got->taker_id != want->taker_id ||
+            got->traded_quantity != want->quantity || got->traded_price != want->price ||
+            got->maker_leftover != want->maker_leftover || got->taker_leftover != want->taker_leftover)
+        {
+            snprintf(why, why_len, "fill %d: %d/%d %d @ %.2f, reference %d/%d %d @ %.2f", i,
+                     got->maker_id, got->taker_id, got->traded_quantity, got->traded_price,
+                     want->maker_id, want->taker_id, want->quantity, want->price);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// The engine has no market orders: they are sent as a limit through every
+// generated price (inside the ladder range) and the remainder is cancelled
+static void apply_engine(const FuzzConfig *config, OrderBook *book, const FuzzOp *op)
+{
+    double market_buy = config->base_price + 2 * config->tick * config->price_levels;
+
+    switch (op->type)
+    {
+    case FUZZ_ADD:
+    case FUZZ_MARKET:
+    {
+        Order *order = create_owned_order(op->order_id, 0, op->quantity, 0, op->side, op->owner_id);
+        order->price = op->type == FUZZ_ADD ? op->price : op->side == 'B' ? market_buy : 0;
+        if (op->type == FUZZ_ADD)
+            set_time_in_force(order, (TimeInForce)op->tif, op->time);
+        if (add_order(book, order) != 0)
+            free_order(order);
+        else if (op->type == FUZZ_MARKET)
+            cancel_order(book, op->order_id);
+        break;
+    }
+    case FUZZ_CANCEL:
+        cancel_order(book, op->order_id);
+        break;
+    case FUZZ_MODIFY:
+    {
+        Order *order = ordermap_get(book->order_map, op->order_id);
+        double price = op->price < 0 && order ? order->price : op->price;
+        modify_order(book, op->order_id, price, op->quantity);
+        break;
+    }
+    case FUZZ_TICK:
+        expire_orders(book, op->time);
+        break;
+    case FUZZ_SESSION_END:
+        expire_day_orders(book);
+        break;
+    case FUZZ_AUCTION:
+        begin_auction(book);
+        break;
+    case FUZZ_UNCROSS:
+        uncross_auction(book, 0, NULL);
+        break;
+    }
+}
+
+static void apply_reference(RefBook *ref, const FuzzOp *op)
+{
+    switch (op->type)
+    {
+    case FUZZ_ADD:
+        ref_add_owned(ref, op->order_id, op->owner_id, op->side, op->price, op->quantity, op->tif, op->time);
+        break;
+    case FUZZ_MARKET:
+        // a resting order with the same id makes the engine reject it
+        for (int i = 0; i < ref->count; i++)
+            if (ref->orders[i].order_id == op->order_id)
+                return;
+        ref_market(ref, op->order_id, op->owner_id, op->side, op->quantity);
+        break;
+    case FUZZ_CANCEL:
+        ref_cancel(ref, op->order_id);
+        break;
+    case FUZZ_MODIFY:
+    {
+        double price = op->price;
+        for (int i = 0; i < ref->count && price < 0; i++)
+            if (ref->orders[i].order_id == op->order_id)
+                price = ref->orders[i].price;
+        ref_modify(ref, op->order_id, price, op->quantity);
+        break;
+    }
+    case FUZZ_TICK:
+        ref_expire(ref, op->time);
+        break;
+    case FUZZ_SESSION_END:
+        ref_end_session(ref);
+        break;
+    case FUZZ_AUCTION:
+        ref_begin_auction(ref);
+        break;
+    case FUZZ_UNCROSS:
+        ref_uncross(ref);
+        break;
+    }
+}
+
+// The engine reports rejected orders on stderr, expected here. Points
+// descriptor 2 at /dev/null and returns a copy of the old one, or -1 if
+// stderr could not be redirected and is left as it was
+static int silence_stderr()
+{
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO);
+    if (saved < 0)
+        return -1;
+    int null = open("/dev/null", O_WRONLY);
+    if (null < 0 || dup2(null, STDERR_FILENO) < 0)
+    {
+        if (null >= 0)
+            close(null);
+        close(saved);
+        return -1;
+    }
+    close(null);
+    return saved;
+}
+
+static void restore_stderr(int saved)
+{
+    if (saved < 0)
+        return;
+    fflush(stderr);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+}
+
+int fuzz_run(const FuzzConfig *config, const FuzzOp *ops, int n, char *why, size_t why_len)
+{
+    OrderBook *book = create_orderbook();
+    if (config->ladder)
+        use_price_ladder(book, 0, config->tick,
+                         (int)(config->base_price / config->tick) + 2 * config->price_levels + 1);
+    set_stp_mode(book, (StpMode)config->stp_mode);
+    RefBook ref;
+    ref_init(&ref);
+    ref.stp_mode = config->stp_mode;
+
+    int saved = silence_stderr();
+
+    int failed = -1;
+    for (int i = 0; i < n && failed < 0; i++)
+    {
+        int fills_before = ref.fill_count;
+        apply_engine(config, book, &ops[i]);
+        apply_reference(&ref, &ops[i]);
+
+        if (compare_fills(book, &ref, fills_before, why, why_len) != 0 ||
+            compare_side(book, &ref, 'B', why, why_len) != 0 ||
+            compare_side(book, &ref, 'S', why, why_len) != 0)
+            failed = i;
+    }
+
+    restore_stderr(saved);
+
+    ref_free(&ref);
+    free_orderbook(book);
+    return failed;
+}
+
+int fuzz_shrink(const FuzzConfig *config, FuzzOp *ops, int n)
+{
+    char why[256];
+    int failed = fuzz_run(config, ops, n, why, sizeof(why));
+    if (failed < 0)
+        return n;
+    n = failed + 1; // nothing after the first divergence matters
+
+    FuzzOp *trial = (FuzzOp *)malloc(n * sizeof(FuzzOp));
+    if (!trial)
+    {
+        fprintf(stderr, "Memory allocation failed for fuzz shrink\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // delta debugging: drop ever smaller chunks while the failure persists
+    for (int chunk = n / 2; chunk >= 1; chunk /= 2)
+    {
+        for (int start = 0; start + chunk <= n;)
+        {
+            memcpy(trial, ops, start * sizeof(FuzzOp));
+            memcpy(trial + start, ops + start + chunk, (n - start - chunk) * sizeof(FuzzOp));
+            int still = fuzz_run(config, trial, n - chunk, why, sizeof(why));
+            if (still >= 0)
+            {
+                n = still + 1;
+                memcpy(ops, trial, n * sizeof(FuzzOp));
+            }
+            else
+            {
+                start += chunk;
+            }
+        }
+    }
+
+    // then make the remaining orders as small as possible
+    for (int i = 0; i < n; i++)
+    {
+        while (ops[i].quantity > 1)
+        {
+            FuzzOp saved = ops[i];
+            ops[i].quantity /= 2;
+            if (fuzz_run(config, ops, n, why, sizeof(why)) < 0)
+            {
+                ops[i] = saved;
+                break;
+            }
+        }
+    }
+
+    free(trial);
+    return n;
+}
+
+void fuzz_print(const FuzzOp *ops, int n)
+{
+    static const char *names[] = {"add", "cancel", "modify", "market", "tick", "session-end", "auction", "uncross"};
+    static const char *tifs[] = {"GTC", "DAY", "GTT"};
+    for (int i = 0; i < n; i++)
+    {
+        const FuzzOp *op = &ops[i];
+        if (op->type == FUZZ_TICK)
+            printf("  %3d: %-6s time=%lld\n", i, names[op->type], op->time);
+        else if (op->type > FUZZ_TICK)
+            printf("  %3d: %s\n", i, names[op->type]);
+        else
+            printf("  %3d: %-6s id=%d owner=%d side=%c price=%.2f qty=%d tif=%s expire=%lld\n", i,
+                   names[op->type], op->order_id, op->owner_id, op->side, op->price, op->quantity,
+                   tifs[op->tif], op->time);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <stddef.h>
+
+/*
+    Differential harness: runs one operation sequence through the engine
+    and the reference book, comparing the new fills and both sides of
+    the book (in priority order) after every step, and shrinks failing
+    sequences to a minimal reproducer. Orders carry owners (for
+    self-trade prevention) and times in force, and the sequence mixes
+    in clock ticks, session ends and call auctions.
+*/
+
+typedef enum
+{
+    FUZZ_ADD,
+    FUZZ_CANCEL,
+    FUZZ_MODIFY,
+    FUZZ_MARKET,
+    FUZZ_TICK,        // expire_orders at time
+    FUZZ_SESSION_END, // expire_day_orders
+    FUZZ_AUCTION,     // begin_auction
+    FUZZ_UNCROSS      // uncross_auction
+} FuzzOpType;
+
+typedef struct
+{
+    FuzzOpType type;
+    int order_id;
+    int owner_id;
+    char side;
+    double price;
+    int quantity;
+    int tif;            // as TimeInForce
+    long long time;     // GTT expiry, or the clock for a tick
+} FuzzOp;
+
+typedef struct
+{
+    int ladder;         // run the engine with dense price ladder sides
+    double tick;        // price grid of generated orders
+    int price_levels;   // generated limit prices span this many ticks
+    double base_price;  // lowest generated limit price
+    int stp_mode;       // as StpMode, for the whole run
+    int owners;         // orders get owners 1..owners, or none
+    int events;         // generate ticks, session ends and auctions
+} FuzzConfig;
+
+FuzzConfig default_fuzz_config();
+// Deterministic random sequence of n operations for seed
+void fuzz_generate(const FuzzConfig *config, unsigned long long seed, FuzzOp *ops, int n);
+// Index of the first step where engine and reference disagree (with a
+// description in why), or -1 if all n steps agree
+int fuzz_run(const FuzzConfig *config, const FuzzOp *ops, int n, char *why, size_t why_len);
+// Removes operations while the sequence still fails; returns the new length
+int fuzz_shrink(const FuzzConfig *config, FuzzOp *ops, int n);
+void fuzz_print(const FuzzOp *ops, int n);
+
+#endif
@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "refbook.h"
+#include "orderbook.h"
+
+void ref_init(RefBook *book)
+{
+    memset(book, 0, sizeof(RefBook));
+}
+
+void ref_free(RefBook *book)
+{
+    free(book->orders);
+    free(book->fills);
+    ref_init(book);
+}
+
+static void *grow(void *array, int *capacity, size_t width)
+{
+    *capacity = *capacity > 0 ? *capacity * 2 : 64;
+    array = realloc(array, (size_t)*capacity * width);
+    if (!array)
+    {
+        fprintf(stderr, "Memory reallocation failed for reference book\n");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+static int find(const RefBook *book, int order_id)
+{
+    for (int i = 0; i < book->count; i++)
+        if (book->orders[i].order_id == order_id)
+            return i;
+    return -1;
+}
+
+static int better(const RefOrder *a, const RefOrder *b)
+{
+    if (a->price != b->price)
+        return a->side == 'B' ? a->price > b->price : a->price < b->price;
+    return a->sequence < b->sequence;
+}
+
+static int best(const RefBook *book, char side)
+{
+    int top = -1;
+    for (int i = 0; i < book->count; i++)
+        if (book->orders[i].side == side && (top < 0 || better(&book->orders[i], &book->orders[top])))
+            top = i;
+    return top;
+}
+
+static void remove_at(RefBook *book, int i)
+{
+    book->orders[i] = book->orders[--book->count];
+}
+
+static void remove_id(RefBook *book, int order_id)
+{
+    int i = find(book, order_id);
+    if (i >= 0)
+        remove_at(book, i);
+}
+
+static int is_self_trade(const RefBook *book, const RefOrder *a, const RefOrder *b)
+{
+    return book->stp_mode != STP_NONE && a->owner_id != 0 && a->owner_id == b->owner_id;
+}
+
+// The engine's self-trade prevention between a crossing pair; removes
+// by id, so maker and taker may point into the orders array or not
+static void prevent_self_trade(RefBook *book, RefOrder *maker, RefOrder *taker)
+{
+    int maker_id = maker->order_id;
+    int taker_id = taker->order_id;
+    int overlap = maker->quantity < taker->quantity ? maker->quantity : taker->quantity;
+    int drop_maker = book->stp_mode == STP_CANCEL_OLDEST || book->stp_mode == STP_CANCEL_BOTH;
+    int drop_taker = book->stp_mode == STP_CANCEL_NEWEST || book->stp_mode == STP_CANCEL_BOTH;
+    if (book->stp_mode == STP_DECREMENT)
+    {
+        maker->quantity -= overlap;
+        taker->quantity -= overlap;
+        drop_maker = maker->quantity == 0;
+        drop_taker = taker->quantity == 0;
+    }
+    if (drop_taker)
+        taker->quantity = 0;
+    if (drop_maker)
+        remove_id(book, maker_id);
+    if (drop_taker)
+        remove_id(book, taker_id);
+}
+
+static void record_fill(RefBook *book, RefOrder *maker, RefOrder *taker, int quantity, double price)
+{
+    if (book->fill_count == book->fill_capacity)
+        book->fills = (RefFill *)grow(book->fills, &book->fill_capacity, sizeof(RefFill));
+
+    maker->quantity -= quantity;
+    taker->quantity -= quantity;
+
+    RefFill *fill = &book->fills[book->fill_count++];
+    fill->maker_id = maker->order_id;
+    fill->taker_id = taker->order_id;
+    fill->quantity = quantity;
+    fill->price = price;
+    fill->maker_leftover = maker->quantity;
+    fill->taker_leftover = taker->quantity;
+}
+
+// Continuous matching at the maker's price, or with uncross set, every
+// pair willing to trade at price trades at price
+static void match(RefBook *book, int uncross, double price)
+{
+    for (;;)
+    {
+        int buy = best(book, 'B');
+        int sell = best(book, 'S');
+        if (buy < 0 || sell < 0)
+            return;
+        RefOrder *b = &book->orders[buy];
+        RefOrder *s = &book->orders[sell];
+        if (uncross ? b->price < price || s->price > price : b->price < s->price)
+            return;
+
+        RefOrder *maker = b->sequence < s->sequence ? b : s;
+        RefOrder *taker = maker == b ? s : b;
+        if (is_self_trade(book, maker, taker))
+        {
+            prevent_self_trade(book, maker, taker);
+            continue;
+        }
+        int quantity = maker->quantity < taker->quantity ? maker->quantity : taker->quantity;
+        record_fill(book, maker, taker, quantity, uncross ? price : maker->price);
+
+        // remove the higher index first so the other stays put
+        int first = buy > sell ? buy : sell;
+        int second = buy > sell ? sell : buy;
+        if (book->orders[first].quantity == 0)
+            remove_at(book, first);
+        if (book->orders[second].quantity == 0)
+            remove_at(book, second);
+    }
+}
+
+int ref_add(RefBook *book, int order_id, char side, double price, int quantity)
+{
+    return ref_add_owned(book, order_id, 0, side, price, quantity, TIF_GTC, 0);
+}
+
+int ref_add_owned(RefBook *book, int order_id, int owner_id, char side, double price, int quantity,
+                  int tif, long long expire_time)
+{
+    if ((side != 'B' && side != 'S') || quantity <= 0 || price < 0 || find(book, order_id) >= 0)
+        return -1;
+    if (tif == TIF_GTT && expire_time <= book->now)
+        return -1;
+
+    if (book->count == book->capacity)
+        book->orders = (RefOrder *)grow(book->orders, &book->capacity, sizeof(RefOrder));
+
+    RefOrder *order = &book->orders[book->count++];
+    order->order_id = order_id;
+    order->owner_id = owner_id;
+    order->side = side;
+    order->tif = tif;
+    order->expire_time = expire_time;
+    order->price = price;
+    order->quantity = quantity;
+    order->sequence = book->next_sequence++;
+
+    if (!book->auction)
+        match(book, 0, 0);
+    return 0;
+}
+
+int ref_cancel(RefBook *book, int order_id)
+{
+    int i = find(book, order_id);
+    if (i < 0)
+        return -1;
+    remove_at(book, i);
+    return 0;
+}
+
+int ref_modify(RefBook *book, int order_id, double new_price, int new_quantity)
+{
+    int i = find(book, order_id);
+    if (i < 0 || new_quantity <= 0 || new_price < 0)
+        return -1;
+
+    RefOrder *order = &book->orders[i];
+    if (new_price == order->price && new_quantity <= order->quantity)
+    {
+        order->quantity = new_quantity;
+        return 0;
+    }
+
+    RefOrder replaced = *order;
+    remove_at(book, i);
+    return ref_add_owned(book, order_id, replaced.owner_id, replaced.side, new_price, new_quantity,
+                         replaced.tif, replaced.expire_time);
+}
+
+void ref_market(RefBook *book, int order_id, int owner_id, char side, int quantity)
+{
+    RefOrder taker = {order_id, owner_id, side, TIF_GTC, 0, 0, quantity, book->next_sequence++};
+    char other = side == 'B' ? 'S' : 'B';
+
+    while (taker.quantity > 0 && !book->auction)
+    {
+        int top = best(book, other);
+        if (top < 0)
+            break;
+
+        RefOrder *maker = &book->orders[top];
+        if (is_self_trade(book, maker, &taker))
+        {
+            prevent_self_trade(book, maker, &taker);
+            continue;
+        }
+        int traded = maker->quantity < taker.quantity ? maker->quantity : taker.quantity;
+        record_fill(book, maker, &taker, traded, maker->price);
+        if (maker->quantity == 0)
+            remove_at(book, top);
+    }
+}
+
+void ref_expire(RefBook *book, long long now)
+{
+    if (now > book->now)
+        book->now = now;
+    for (int i = book->count - 1; i >= 0; i--)
+        if (book->orders[i].tif == TIF_GTT && book->orders[i].expire_time <= book->now)
+            remove_at(book, i);
+}
+
+void ref_end_session(RefBook *book)
+{
+    for (int i = book->count - 1; i >= 0; i--)
+        if (book->orders[i].tif == TIF_DAY)
+            remove_at(book, i);
+}
+
+void ref_begin_auction(RefBook *book)
+{
+    book->auction = 1;
+}
+
+void ref_uncross(RefBook *book)
+{
+    // every resting price is a candidate: demand is the buys at or above
+    // it, supply the sells at or below; the most volume wins, then the
+    // smallest imbalance, then the lowest price
+    int found = 0;
+    long long best_volume = 0;
+    long long best_imbalance = 0;
+    double best_price = 0;
+    for (int i = 0; i < book->count; i++)
+    {
+        double price = book->orders[i].price;
+        long long demand = 0;
+        long long supply = 0;
+        for (int j = 0; j < book->count; j++)
+        {
+            if (book->orders[j].side == 'B' && book->orders[j].price >= price)
+                demand += book->orders[j].quantity;
+            if (book->orders[j].side == 'S' && book->orders[j].price <= price)
+                supply += book->orders[j].quantity;
+        }
+        long long volume = demand < supply ? demand : supply;
+        long long imbalance = demand > supply ? demand - supply : supply - demand;
+        if (volume == 0)
+            continue;
+        if (!found || volume > best_volume ||
+            (volume == best_volume && (imbalance < best_imbalance ||
+                                       (imbalance == best_imbalance && price < best_price))))
+        {
+            found = 1;
+            best_volume = volume;
+            best_imbalance = imbalance;
+            best_price = price;
+        }
+    }
+
+    if (found)
+        match(book, 1, best_price);
+    book->auction = 0;
+    match(book, 0, 0);
+}
+
+static int compare_priority(const void *a, const void *b)
+{
+    const RefOrder *x = (const RefOrder *)a;
+    const RefOrder *y = (const RefOrder *)b;
+    return better(x, y) ? -1 : better(y, x) ? 1 : 0;
+}
+
+int ref_side(const RefBook *book, char side, RefOrder *out)
+{
+    int n = 0;
+    for (int i = 0; i < book->count; i++)
+        if (book->orders[i].side == side)
+            out[n++] = book->orders[i];
+    qsort(out, n, sizeof(RefOrder), compare_priority);
+    return n;
+}
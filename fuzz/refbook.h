@@ -0,0 +1,77 @@
+#ifndef REFBOOK_H
+#define REFBOOK_H
+
+/*
+    Reference order book for differential testing: flat arrays and
+    linear scans, written to be obviously correct rather than fast.
+    It follows prototype/matching_engine.py's PriceTimeEngine loop
+    (match the two tops while they cross; market orders walk the other
+    side and drop any remainder) with the engine's pricing rule: the
+    older order of a crossing pair is the maker and sets the price.
+
+    On top of that it models the engine's self-trade prevention modes,
+    GTT/DAY expiry against an expiry clock and call auctions (orders
+    rest without matching, then all trade at the volume-maximizing
+    price), each as a plain scan over the orders.
+*/
+
+typedef struct
+{
+    int order_id;
+    int owner_id;
+    char side;
+    int tif;              // as TimeInForce
+    long long expire_time;
+    double price;
+    int quantity;
+    long long sequence;
+} RefOrder;
+
+typedef struct
+{
+    int maker_id;
+    int taker_id;
+    int quantity;
+    double price;
+    int maker_leftover;
+    int taker_leftover;
+} RefFill;
+
+typedef struct
+{
+    RefOrder *orders;
+    int count;
+    int capacity;
+    RefFill *fills;
+    int fill_count;
+    int fill_capacity;
+    long long next_sequence;
+    int stp_mode;         // as StpMode
+    int auction;          // orders rest without matching until ref_uncross
+    long long now;        // expiry clock
+} RefBook;
+
+void ref_init(RefBook *book);
+void ref_free(RefBook *book);
+// Same acceptance rules as add_order; 0 if accepted
+int ref_add(RefBook *book, int order_id, char side, double price, int quantity);
+// With an owner and time in force; expire_time only matters for GTT
+int ref_add_owned(RefBook *book, int order_id, int owner_id, char side, double price, int quantity,
+                  int tif, long long expire_time);
+int ref_cancel(RefBook *book, int order_id);
+int ref_modify(RefBook *book, int order_id, double new_price, int new_quantity);
+// Trades quantity against the other side; the unfilled rest is dropped.
+// Nothing trades during an auction
+void ref_market(RefBook *book, int order_id, int owner_id, char side, int quantity);
+// Moves the expiry clock forward to now and drops due GTT orders
+void ref_expire(RefBook *book, long long now);
+// Drops every DAY order
+void ref_end_session(RefBook *book);
+void ref_begin_auction(RefBook *book);
+// Trades every order willing to at the equilibrium price, then resumes
+// continuous matching
+void ref_uncross(RefBook *book);
+// Resting orders of one side in priority order; returns the count
+int ref_side(const RefBook *book, char side, RefOrder *out);
+
+#endif
@@ -1,41 +1,146 @@
 #ifndef TRADING_ENGINE_H
 #define TRADING_ENGINE_H
 
-/* Primary public entrypoint for the trading engine API. */
+/* Primary public entrypoint for the trading engine API.
+
+   Every call returns a TradingStatus and writes results into
+   caller-owned structs, so nothing is allocated just to report an
+   outcome. OrderBook is an opaque handle. Struct layouts and function
+   signatures are frozen within a major ABI version; check
+   trading_abi_version() against TRADING_ENGINE_ABI_VERSION at startup.
+
+   The asynchronous API (1.1) runs a book behind a TradingEngine. Each
+   client thread owns a TradingSession: it queues requests tagged with
+   its own correlation ids and later polls acks, rejects and fills from
+   the session's completion queue in batches, so it can keep many
+   requests in flight. One matching thread drives the engine with
+   trading_engine_run. */
 
 #include <stdint.h>
 
-typedef struct Order Order;
+#define TRADING_ENGINE_VERSION_MAJOR 1
+#define TRADING_ENGINE_VERSION_MINOR 1
+#define TRADING_ENGINE_ABI_VERSION \
+    ((uint32_t)TRADING_ENGINE_VERSION_MAJOR << 16 | TRADING_ENGINE_VERSION_MINOR)
+
+#if defined(__GNUC__)
+#define TRADING_API __attribute__((visibility("default")))
+#else
+#define TRADING_API
+#endif
+
 typedef struct OrderBook OrderBook;
+typedef struct TradingEngine TradingEngine;
+typedef struct TradingSession TradingSession;
+
+typedef enum
+{
+    TRADING_OK = 0,
+    TRADING_ERR_INVALID = -1,   // bad handle, pointer or order terms
+    TRADING_ERR_NOT_FOUND = -2, // no resting order with that id
+    TRADING_ERR_DUPLICATE = -3, // order id already resting
+    TRADING_ERR_NO_DATA = -4    // empty side, or no trade yet
+} TradingStatus;
+
+// An order as passed in and read back; plain value, owned by the caller
+typedef struct
+{
+    int order_id;
+    double price;
+    int quantity; // open quantity when read back
+    double timestamp;
+    char side;    // 'B' or 'S'
+} TradingOrder;
+
+typedef struct
+{
+    int bid_orders;  // resting orders per side
+    int ask_orders;
+    int trade_count; // trades since the book was created
+} TradingBookSummary;
+
+typedef enum
+{
+    TRADING_OP_ADD,
+    TRADING_OP_CANCEL, // order.order_id only
+    TRADING_OP_MODIFY  // order.order_id, price and quantity
+} TradingOp;
+
+typedef struct
+{
+    uint64_t user_data; // correlation id, echoed in every completion
+    uint32_t op;        // TradingOp
+    TradingOrder order; // the timestamp is replaced by the receive time
+} TradingRequest;
+
+typedef enum
+{
+    TRADING_CQE_ACK,    // request applied
+    TRADING_CQE_REJECT, // request refused; status says why
+    TRADING_CQE_FILL    // an order of this session traded
+} TradingCompletionType;
+
+typedef struct
+{
+    uint64_t user_data; // request's; for a fill, the request that placed or re-queued the order
+    uint64_t sequence;  // engine sequence of the request that caused this
+    uint32_t type;      // TradingCompletionType
+    int32_t status;     // TradingStatus
+    int order_id;
+    int quantity;       // ack: open quantity after the request; fill: traded
+    int leftover;       // fill: open quantity of the order after the fill
+    double price;       // ack: order price; fill: traded price
+} TradingCompletion;
+
+TRADING_API uint32_t trading_abi_version(void);
 
 /* order CRUD */
-// returns copy of order
-Order *trading_create_order(
+// fills out; does not touch any book
+TRADING_API int trading_create_order(
+    TradingOrder *out,
     int order_id,
     double price,
     int quantity,
     double timestamp,
     char side);
-// returns copy of order
-Order *trading_read_order(OrderBook *book, int order_id);
-// returns 0 if successful, -1 otherwise
-int *trading_cancel_order(OrderBook *book, int order_id);
-// returns 0 if successful, -1 otherwise
-int *trading_modify_order(
+// copies the resting order into out
+TRADING_API int trading_read_order(OrderBook *book, int order_id, TradingOrder *out);
+TRADING_API int trading_cancel_order(OrderBook *book, int order_id);
+// smaller size at the same price keeps priority; anything else re-queues
+TRADING_API int trading_modify_order(
     OrderBook *book,
     int order_id,
     double new_price,
     int new_quantity);
 
 /* orderbook CRUD */
-OrderBook *trading_create_ordebook(void);
-OrderBook *trading_read_orderbook(OrderBook *book);
-int *trading_add_order(OrderBook *book, Order *order);
-void *trading_free_orderbook(OrderBook *book);
+TRADING_API int trading_create_orderbook(OrderBook **out);
+TRADING_API int trading_read_orderbook(OrderBook *book, TradingBookSummary *out);
+// the book keeps its own copy of order; matching runs before this returns
+TRADING_API int trading_add_order(OrderBook *book, const TradingOrder *order);
+TRADING_API int trading_free_orderbook(OrderBook *book);
 
 /* retrieve market data */
-double trading_get_best_bid(OrderBook *book);
-double trading_get_best_ask(OrderBook *book);
-double trading_get_last_price(OrderBook *book);
+TRADING_API int trading_get_best_bid(OrderBook *book, double *out);
+TRADING_API int trading_get_best_ask(OrderBook *book, double *out);
+TRADING_API int trading_get_last_price(OrderBook *book, double *out);
+
+/* asynchronous requests */
+// engine thread; the book must not be used directly while the engine
+// runs. batch_size bounds the requests handled per trading_engine_run
+TRADING_API int trading_engine_create(OrderBook *book, int batch_size, TradingEngine **out);
+// frees the engine and its sessions, not the book
+TRADING_API int trading_engine_free(TradingEngine *engine);
+// before the engine starts running; entries sizes both of the session's
+// queues. TRADING_ERR_NO_DATA once every session slot is taken
+TRADING_API int trading_session_create(TradingEngine *engine, int entries, TradingSession **out);
+// client thread: queues up to count requests in order and returns how
+// many were queued (fewer if the submission queue fills up)
+TRADING_API int trading_submit(TradingSession *session, const TradingRequest *requests, int count);
+// client thread: copies up to max completions, oldest first; returns the count
+TRADING_API int trading_poll_completions(TradingSession *session, TradingCompletion *out, int max);
+// matching thread: sequences and applies one batch across all sessions;
+// returns the requests handled. An ack precedes the fills it caused
+TRADING_API int trading_engine_run(TradingEngine *engine);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,178 @@
+"""ctypes bindings to the C order book.
+
+Build the library first with `make shared` (or point ORDERBOOK_LIB at
+it). Orders go in as batches of parallel arrays. Fills and depth come
+back as zero-copy NumPy views of the engine's own arrays when numpy is
+installed, or as ctypes arrays otherwise. A view is only valid until
+the next call that changes the book.
+"""
+import ctypes
+import os
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+_DEFAULT_LIB = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                            '..', 'bin', 'liborderbook.so')
+
+
+class Fill(ctypes.Structure):
+    _fields_ = [('maker_id', ctypes.c_int),
+                ('taker_id', ctypes.c_int),
+                ('traded_quantity', ctypes.c_int),
+                ('maker_leftover', ctypes.c_int),
+                ('taker_leftover', ctypes.c_int),
+                ('traded_price', ctypes.c_double),
+                ('timestamp', ctypes.c_double),
+                ('taker_side', ctypes.c_char)]
+
+
+class Level(ctypes.Structure):
+    _fields_ = [('price', ctypes.c_double),
+                ('quantity', ctypes.c_longlong),
+                ('orders', ctypes.c_int)]
+
+
+_NUMPY_FORMATS = {ctypes.c_int: 'i4', ctypes.c_double: 'f8',
+                  ctypes.c_longlong: 'i8', ctypes.c_char: 'S1'}
+
+
+def _load(path):
+    lib = ctypes.CDLL(path)
+    p = ctypes.c_void_p
+    i_ptr = ctypes.POINTER(ctypes.c_int)
+    d_ptr = ctypes.POINTER(ctypes.c_double)
+
+    lib.pybook_create.restype = p
+    lib.pybook_create.argtypes = []
+    lib.pybook_free.argtypes = [p]
+    lib.pybook_submit.restype = ctypes.c_int
+    lib.pybook_submit.argtypes = [p, ctypes.c_int, i_ptr, ctypes.c_char_p, d_ptr,
+                                  i_ptr, d_ptr, i_ptr, i_ptr]
+    lib.pybook_cancel.restype = ctypes.c_int
+    lib.pybook_cancel.argtypes = [p, ctypes.c_int, i_ptr, i_ptr]
+    lib.pybook_fills.restype = ctypes.POINTER(Fill)
+    lib.pybook_fills.argtypes = [p, i_ptr]
+    lib.pybook_levels.restype = ctypes.POINTER(Level)
+    lib.pybook_levels.argtypes = [p, ctypes.c_char, i_ptr]
+    lib.pybook_fill_layout.argtypes = [ctypes.POINTER(ctypes.c_size_t)]
+    lib.pybook_level_layout.argtypes = [ctypes.POINTER(ctypes.c_size_t)]
+
+    # the structures above must describe the library's own layout
+    for struct, layout in ((Fill, lib.pybook_fill_layout), (Level, lib.pybook_level_layout)):
+        out = (ctypes.c_size_t * 16)()
+        n = layout(out)
+        expected = [ctypes.sizeof(struct)] + [getattr(struct, name).offset
+                                              for name, _ in struct._fields_]
+        if list(out[:n]) != expected:
+            raise ImportError(f'{struct.__name__} layout does not match {path}')
+    return lib
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        _lib = _load(os.environ.get('ORDERBOOK_LIB', _DEFAULT_LIB))
+    return _lib
+
+
+def _dtype(struct):
+    return np.dtype({'names': [name for name, _ in struct._fields_],
+                     'formats': [_NUMPY_FORMATS[kind] for _, kind in struct._fields_],
+                     'offsets': [getattr(struct, name).offset for name, _ in struct._fields_],
+                     'itemsize': ctypes.sizeof(struct)})
+
+
+def _view(pointer, struct, count):
+    if count == 0 or not pointer:
+        return np.zeros(0, dtype=_dtype(struct)) if np is not None else (struct * 0)()
+    array = ctypes.cast(pointer, ctypes.POINTER(struct * count)).contents
+    if np is None:
+        return array
+    return np.frombuffer(array, dtype=_dtype(struct), count=count)
+
+
+def _column(values, ctype, n):
+    if np is not None and isinstance(values, np.ndarray):
+        dtype = {ctypes.c_int: np.int32, ctypes.c_double: np.float64}[ctype]
+        values = np.ascontiguousarray(values, dtype=dtype)
+        return values, values.ctypes.data_as(ctypes.POINTER(ctype))
+    array = (ctype * n)(*values)
+    return array, array
+
+
+def _side(side):
+    side = side.decode() if isinstance(side, bytes) else str(side)
+    return b'B' if side in ('B', 'buy') else b'S' if side in ('S', 'sell') else side.encode()
+
+
+class Engine:
+    """One C order book running price-time matching."""
+
+    def __init__(self):
+        self._lib = _library()
+        self._book = self._lib.pybook_create()
+
+    def close(self):
+        if self._book:
+            self._lib.pybook_free(self._book)
+            self._book = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def submit(self, ids, sides, prices, quantities, timestamps=None, owners=None):
+        """Submits a batch; returns per-order status (0 accepted, -1 rejected)."""
+        n = len(ids)
+        if timestamps is None:
+            timestamps = [0.0] * n
+        id_keep, id_ptr = _column(ids, ctypes.c_int, n)
+        price_keep, price_ptr = _column(prices, ctypes.c_double, n)
+        qty_keep, qty_ptr = _column(quantities, ctypes.c_int, n)
+        time_keep, time_ptr = _column(timestamps, ctypes.c_double, n)
+        owner_keep, owner_ptr = _column(owners, ctypes.c_int, n) if owners is not None else (None, None)
+        side_bytes = b''.join(_side(s) for s in sides)
+        status = (ctypes.c_int * n)()
+
+        self._lib.pybook_submit(self._book, n, id_ptr, side_bytes, price_ptr,
+                                qty_ptr, time_ptr, owner_ptr, status)
+        return list(status)
+
+    def add_order(self, order_id, side, price, quantity, timestamp=0.0, owner=0):
+        return self.submit([order_id], [side], [price], [quantity], [timestamp], [owner])[0] == 0
+
+    def cancel(self, ids):
+        n = len(ids)
+        id_keep, id_ptr = _column(ids, ctypes.c_int, n)
+        status = (ctypes.c_int * n)()
+        self._lib.pybook_cancel(self._book, n, id_ptr, status)
+        return list(status)
+
+    def cancel_order(self, order_id):
+        return self.cancel([order_id])[0] == 0
+
+    def fills(self):
+        """Every fill so far, oldest first."""
+        count = ctypes.c_int()
+        pointer = self._lib.pybook_fills(self._book, ctypes.byref(count))
+        return _view(pointer, Fill, count.value)
+
+    def depth(self, side):
+        """Price levels of one side ('B'/'buy' or 'S'/'sell'), best first."""
+        count = ctypes.c_int()
+        pointer = self._lib.pybook_levels(self._book, _side(side), ctypes.byref(count))
+        levels = _view(pointer, Level, count.value)
+        # the engine keeps levels worst to best; reversing a NumPy view does not copy
+        return levels[::-1] if np is not None else list(reversed(levels))
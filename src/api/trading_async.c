@@ -0,0 +1,403 @@
+#include "trading_engine.h"
+#include "orderbook.h"
+#include "sequencer/sequencer.h"
+
+#define ROUTE_EMPTY INT32_MIN
+
+// Which session placed a resting order, for routing its fills
+typedef struct
+{
+    int order_id; // ROUTE_EMPTY when the slot is free
+    int session;
+    uint64_t user_data;
+} Route;
+
+// Engine -> client ring; anything that does not fit waits in overflow
+typedef struct
+{
+    _Alignas(SEQ_CACHE_LINE) _Atomic uint64_t tail;
+    _Alignas(SEQ_CACHE_LINE) _Atomic uint64_t head;
+    _Alignas(SEQ_CACHE_LINE) TradingCompletion *entries;
+    uint64_t mask;
+    TradingCompletion *overflow; // engine thread only
+    int overflow_count;
+    int overflow_capacity;
+} CompletionQueue;
+
+typedef struct
+{
+    int session;
+    TradingCompletion completion;
+} StagedFill;
+
+struct TradingSession
+{
+    TradingEngine *engine;
+    IngressQueue *submissions;
+    CompletionQueue completions;
+};
+
+struct TradingEngine
+{
+    OrderBook *book;
+    Sequencer *sequencer;
+    TradingSession *sessions[MAX_GATEWAYS];
+    int session_count;
+    Route *routes;
+    int route_count;
+    int route_capacity; // power of two
+    const SeqMessage *current; // request being applied
+    StagedFill *staged; // fills caused by the current request
+    int staged_count;
+    int staged_capacity;
+};
+
+static unsigned int route_slot(const TradingEngine *engine, int order_id)
+{
+    return ((unsigned int)order_id * 2654435761u) & (unsigned int)(engine->route_capacity - 1);
+}
+
+static Route *find_route(TradingEngine *engine, int order_id)
+{
+    for (unsigned int i = route_slot(engine, order_id);; i = (i + 1) & (engine->route_capacity - 1))
+    {
+        if (engine->routes[i].order_id == order_id)
+            return &engine->routes[i];
+        if (engine->routes[i].order_id == ROUTE_EMPTY)
+            return NULL;
+    }
+}
+
+static void allocate_routes(TradingEngine *engine, int capacity)
+{
+    engine->routes = (Route *)malloc(capacity * sizeof(Route));
+    if (!engine->routes)
+    {
+        fprintf(stderr, "Memory allocation failed for order routes\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < capacity; i++)
+        engine->routes[i].order_id = ROUTE_EMPTY;
+    engine->route_capacity = capacity;
+    engine->route_count = 0;
+}
+
+static void put_route(TradingEngine *engine, int order_id, int session, uint64_t user_data)
+{
+    if (2 * (engine->route_count + 1) > engine->route_capacity)
+    {
+        Route *old = engine->routes;
+        int old_capacity = engine->route_capacity;
+        allocate_routes(engine, 2 * old_capacity);
+        for (int i = 0; i < old_capacity; i++)
+            if (old[i].order_id != ROUTE_EMPTY)
+                put_route(engine, old[i].order_id, old[i].session, old[i].user_data);
+        free(old);
+    }
+
+    unsigned int i = route_slot(engine, order_id);
+    while (engine->routes[i].order_id != ROUTE_EMPTY && engine->routes[i].order_id != order_id)
+        i = (i + 1) & (engine->route_capacity - 1);
+    if (engine->routes[i].order_id == ROUTE_EMPTY)
+        engine->route_count++;
+    engine->routes[i].order_id = order_id;
+    engine->routes[i].session = session;
+    engine->routes[i].user_data = user_data;
+}
+
+static void remove_route(TradingEngine *engine, int order_id)
+{
+    Route *route = find_route(engine, order_id);
+    if (!route)
+        return;
+
+    // backward-shift deletion keeps every probe chain unbroken
+    unsigned int mask = (unsigned int)(engine->route_capacity - 1);
+    unsigned int hole = (unsigned int)(route - engine->routes);
+    for (unsigned int i = (hole + 1) & mask; engine->routes[i].order_id != ROUTE_EMPTY; i = (i + 1) & mask)
+    {
+        unsigned int home = route_slot(engine, engine->routes[i].order_id);
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            engine->routes[hole] = engine->routes[i];
+            hole = i;
+        }
+    }
+    engine->routes[hole].order_id = ROUTE_EMPTY;
+    engine->route_count--;
+}
+
+static void complete(TradingSession *session, const TradingCompletion *completion)
+{
+    CompletionQueue *queue = &session->completions;
+    uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (queue->overflow_count == 0 && tail - atomic_load_explicit(&queue->head, memory_order_acquire) <= queue->mask)
+    {
+        queue->entries[tail & queue->mask] = *completion;
+        atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+        return;
+    }
+
+    if (queue->overflow_count == queue->overflow_capacity)
+    {
+        int capacity = queue->overflow_capacity ? 2 * queue->overflow_capacity : 64;
+        TradingCompletion *overflow =
+            (TradingCompletion *)realloc(queue->overflow, capacity * sizeof(TradingCompletion));
+        if (!overflow)
+        {
+            fprintf(stderr, "Memory allocation failed for completion overflow\n");
+            exit(EXIT_FAILURE);
+        }
+        queue->overflow = overflow;
+        queue->overflow_capacity = capacity;
+    }
+    queue->overflow[queue->overflow_count++] = *completion;
+}
+
+// Moves overflowed completions into the ring as the client frees space
+static void drain_overflow(TradingSession *session)
+{
+    CompletionQueue *queue = &session->completions;
+    if (queue->overflow_count == 0)
+        return;
+
+    uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    int moved = 0;
+    while (moved < queue->overflow_count && tail - head <= queue->mask)
+        queue->entries[tail++ & queue->mask] = queue->overflow[moved++];
+    atomic_store_explicit(&queue->tail, tail, memory_order_release);
+
+    memmove(queue->overflow, queue->overflow + moved,
+            (queue->overflow_count - moved) * sizeof(TradingCompletion));
+    queue->overflow_count -= moved;
+}
+
+static void stage_fill(TradingEngine *engine, const Order *order, const FilledOrder *fill, int leftover)
+{
+    Route *route = find_route(engine, order->order_id);
+    if (!route)
+        return;
+
+    if (engine->staged_count == engine->staged_capacity)
+    {
+        int capacity = engine->staged_capacity ? 2 * engine->staged_capacity : 64;
+        StagedFill *staged = (StagedFill *)realloc(engine->staged, capacity * sizeof(StagedFill));
+        if (!staged)
+        {
+            fprintf(stderr, "Memory allocation failed for staged completions\n");
+            exit(EXIT_FAILURE);
+        }
+        engine->staged = staged;
+        engine->staged_capacity = capacity;
+    }
+
+    StagedFill *staged = &engine->staged[engine->staged_count++];
+    staged->session = route->session;
+    TradingCompletion *completion = &staged->completion;
+    completion->user_data = route->user_data;
+    completion->sequence = engine->current ? engine->current->sequence : 0;
+    completion->type = TRADING_CQE_FILL;
+    completion->status = TRADING_OK;
+    completion->order_id = order->order_id;
+    completion->quantity = fill->traded_quantity;
+    completion->leftover = leftover;
+    completion->price = fill->traded_price;
+}
+
+static void on_book_event(void *context, const BookEvent *event)
+{
+    TradingEngine *engine = (TradingEngine *)context;
+    switch (event->type)
+    {
+    case BOOK_EVENT_ADD:
+        if (engine->current)
+            put_route(engine, event->order->order_id, engine->current->gateway, engine->current->user_data);
+        break;
+    case BOOK_EVENT_TRADE:
+        stage_fill(engine, event->order, event->fill, event->fill->maker_leftover);
+        stage_fill(engine, event->counterparty, event->fill, event->fill->taker_leftover);
+        break;
+    case BOOK_EVENT_REMOVE:
+        remove_route(engine, event->order->order_id);
+        break;
+    case BOOK_EVENT_REDUCE:
+        break;
+    }
+}
+
+static int reject_status(OrderBook *book, const SeqMessage *message)
+{
+    int resting = ordermap_contains(book->order_map, message->order_id);
+    if (message->type == SEQ_NEW_ORDER)
+        return resting ? TRADING_ERR_DUPLICATE : TRADING_ERR_INVALID;
+    return resting ? TRADING_ERR_INVALID : TRADING_ERR_NOT_FOUND;
+}
+
+static void handle_request(TradingEngine *engine, const SeqMessage *message)
+{
+    // decided before applying: after a rejected add the id is still resting
+    int status = reject_status(engine->book, message);
+
+    engine->current = message;
+    engine->staged_count = 0;
+    int result = sequencer_apply(engine->book, message);
+    engine->current = NULL;
+
+    TradingCompletion ack;
+    ack.user_data = message->user_data;
+    ack.sequence = message->sequence;
+    ack.type = result == 0 ? TRADING_CQE_ACK : TRADING_CQE_REJECT;
+    ack.status = result == 0 ? TRADING_OK : status;
+    ack.order_id = message->order_id;
+    ack.quantity = 0;
+    ack.leftover = 0;
+    ack.price = message->price;
+    Order *order = ordermap_get(engine->book->order_map, message->order_id);
+    if (result == 0 && order)
+    {
+        ack.quantity = order->quantity;
+        ack.price = order->price;
+    }
+    complete(engine->sessions[message->gateway], &ack);
+
+    for (int i = 0; i < engine->staged_count; i++)
+        complete(engine->sessions[engine->staged[i].session], &engine->staged[i].completion);
+}
+
+int trading_engine_create(OrderBook *book, int batch_size, TradingEngine **out)
+{
+    if (!book || batch_size <= 0 || !out)
+        return TRADING_ERR_INVALID;
+
+    TradingEngine *engine = (TradingEngine *)calloc(1, sizeof(TradingEngine));
+    if (!engine)
+    {
+        fprintf(stderr, "Memory allocation failed for TradingEngine\n");
+        exit(EXIT_FAILURE);
+    }
+    engine->book = book;
+    engine->sequencer = create_sequencer(batch_size);
+    allocate_routes(engine, 1024);
+
+    if (add_book_listener(book, on_book_event, engine) != 0)
+    {
+        fprintf(stderr, "Order book has no free listener slot\n");
+        free_sequencer(engine->sequencer);
+        free(engine->routes);
+        free(engine);
+        return TRADING_ERR_INVALID;
+    }
+
+    *out = engine;
+    return TRADING_OK;
+}
+
+int trading_engine_free(TradingEngine *engine)
+{
+    if (!engine)
+        return TRADING_ERR_INVALID;
+
+    remove_book_listener(engine->book, on_book_event, engine);
+    for (int s = 0; s < engine->session_count; s++)
+    {
+        free(engine->sessions[s]->completions.entries);
+        free(engine->sessions[s]->completions.overflow);
+        free(engine->sessions[s]);
+    }
+    free_sequencer(engine->sequencer);
+    free(engine->routes);
+    free(engine->staged);
+    free(engine);
+    return TRADING_OK;
+}
+
+int trading_session_create(TradingEngine *engine, int entries, TradingSession **out)
+{
+    if (!engine || entries <= 0 || !out)
+        return TRADING_ERR_INVALID;
+
+    IngressQueue *submissions = sequencer_add_gateway(engine->sequencer, entries);
+    if (!submissions)
+        return TRADING_ERR_NO_DATA;
+
+    TradingSession *session = (TradingSession *)aligned_alloc(SEQ_CACHE_LINE, sizeof(TradingSession));
+    if (!session)
+    {
+        fprintf(stderr, "Memory allocation failed for TradingSession\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(session, 0, sizeof(TradingSession));
+    session->engine = engine;
+    session->submissions = submissions;
+    session->completions.mask = submissions->mask;
+    session->completions.entries =
+        (TradingCompletion *)malloc((submissions->mask + 1) * sizeof(TradingCompletion));
+    if (!session->completions.entries)
+    {
+        fprintf(stderr, "Memory allocation failed for completion queue\n");
+        exit(EXIT_FAILURE);
+    }
+
+    engine->sessions[engine->session_count++] = session;
+    *out = session;
+    return TRADING_OK;
+}
+
+int trading_submit(TradingSession *session, const TradingRequest *requests, int count)
+{
+    if (!session || !requests || count < 0)
+        return TRADING_ERR_INVALID;
+
+    static const uint8_t types[] = {SEQ_NEW_ORDER, SEQ_CANCEL, SEQ_MODIFY};
+    int queued = 0;
+    for (; queued < count; queued++)
+    {
+        const TradingRequest *request = &requests[queued];
+        if (request->op > TRADING_OP_MODIFY)
+            return queued > 0 ? queued : TRADING_ERR_INVALID;
+
+        SeqMessage message;
+        memset(&message, 0, sizeof(message));
+        message.user_data = request->user_data;
+        message.type = types[request->op];
+        message.side = request->order.side;
+        message.order_id = request->order.order_id;
+        message.quantity = request->order.quantity;
+        message.price = request->order.price;
+        message.tif = TIF_GTC;
+        if (ingress_push(session->submissions, &message) != 0)
+            break;
+    }
+    return queued;
+}
+
+int trading_poll_completions(TradingSession *session, TradingCompletion *out, int max)
+{
+    if (!session || !out || max < 0)
+        return TRADING_ERR_INVALID;
+
+    CompletionQueue *queue = &session->completions;
+    uint64_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    int n = 0;
+    while (n < max && head != tail)
+        out[n++] = queue->entries[head++ & queue->mask];
+    atomic_store_explicit(&queue->head, head, memory_order_release);
+    return n;
+}
+
+int trading_engine_run(TradingEngine *engine)
+{
+    if (!engine)
+        return TRADING_ERR_INVALID;
+
+    for (int s = 0; s < engine->session_count; s++)
+        drain_overflow(engine->sessions[s]);
+
+    Sequencer *sequencer = engine->sequencer;
+    int count = sequencer_poll(sequencer, sequencer->batch, sequencer->batch_size);
+    for (int i = 0; i < count; i++)
+        handle_request(engine, &sequencer->batch[i]);
+    return count;
+}
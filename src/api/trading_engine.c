@@ -0,0 +1,140 @@
+#include "trading_engine.h"
+#include "orderbook.h"
+
+uint32_t trading_abi_version(void)
+{
+    return TRADING_ENGINE_ABI_VERSION;
+}
+
+int trading_create_order(TradingOrder *out, int order_id, double price, int quantity,
+                         double timestamp, char side)
+{
+    if (!out || quantity <= 0 || price < 0 || (side != 'B' && side != 'S'))
+        return TRADING_ERR_INVALID;
+
+    out->order_id = order_id;
+    out->price = price;
+    out->quantity = quantity;
+    out->timestamp = timestamp;
+    out->side = side;
+    return TRADING_OK;
+}
+
+int trading_read_order(OrderBook *book, int order_id, TradingOrder *out)
+{
+    if (!book || !out)
+        return TRADING_ERR_INVALID;
+
+    Order *order = ordermap_get(book->order_map, order_id);
+    if (!order)
+        return TRADING_ERR_NOT_FOUND;
+
+    out->order_id = order->order_id;
+    out->price = order->price;
+    out->quantity = order->quantity;
+    out->timestamp = order->timestamp;
+    out->side = order->side;
+    return TRADING_OK;
+}
+
+int trading_cancel_order(OrderBook *book, int order_id)
+{
+    if (!book)
+        return TRADING_ERR_INVALID;
+
+    return cancel_order(book, order_id) == 0 ? TRADING_OK : TRADING_ERR_NOT_FOUND;
+}
+
+int trading_modify_order(OrderBook *book, int order_id, double new_price, int new_quantity)
+{
+    if (!book)
+        return TRADING_ERR_INVALID;
+    if (!ordermap_contains(book->order_map, order_id))
+        return TRADING_ERR_NOT_FOUND;
+
+    return modify_order(book, order_id, new_price, new_quantity) == 0 ? TRADING_OK : TRADING_ERR_INVALID;
+}
+
+int trading_create_orderbook(OrderBook **out)
+{
+    if (!out)
+        return TRADING_ERR_INVALID;
+
+    *out = create_orderbook();
+    return TRADING_OK;
+}
+
+int trading_read_orderbook(OrderBook *book, TradingBookSummary *out)
+{
+    if (!book || !out)
+        return TRADING_ERR_INVALID;
+
+    out->bid_orders = book->buy_orders->size;
+    out->ask_orders = book->sell_orders->size;
+    out->trade_count = book->trade_history_size;
+    return TRADING_OK;
+}
+
+int trading_add_order(OrderBook *book, const TradingOrder *order)
+{
+    if (!book || !order)
+        return TRADING_ERR_INVALID;
+    if (ordermap_contains(book->order_map, order->order_id))
+        return TRADING_ERR_DUPLICATE;
+
+    Order *copy = create_order(order->order_id, 0, order->quantity, 0, order->side);
+    copy->price = order->price;
+    copy->timestamp = order->timestamp;
+    if (add_order(book, copy) != 0)
+    {
+        free_order(copy);
+        return TRADING_ERR_INVALID;
+    }
+    return TRADING_OK;
+}
+
+int trading_free_orderbook(OrderBook *book)
+{
+    if (!book)
+        return TRADING_ERR_INVALID;
+
+    free_orderbook(book);
+    return TRADING_OK;
+}
+
+static int best_price(OrderHeap *side, double *out)
+{
+    Order *top = getTop(side);
+    if (!top)
+        return TRADING_ERR_NO_DATA;
+
+    *out = top->price;
+    return TRADING_OK;
+}
+
+int trading_get_best_bid(OrderBook *book, double *out)
+{
+    if (!book || !out)
+        return TRADING_ERR_INVALID;
+
+    return best_price(book->buy_orders, out);
+}
+
+int trading_get_best_ask(OrderBook *book, double *out)
+{
+    if (!book || !out)
+        return TRADING_ERR_INVALID;
+
+    return best_price(book->sell_orders, out);
+}
+
+int trading_get_last_price(OrderBook *book, double *out)
+{
+    if (!book || !out)
+        return TRADING_ERR_INVALID;
+    if (book->price_history_size == 0)
+        return TRADING_ERR_NO_DATA;
+
+    *out = book->price_history[book->price_history_size - 1];
+    return TRADING_OK;
+}
@@ -0,0 +1,650 @@
+#include "archive.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Columns stored as deltas from the previous row
+static const int delta_encoded[ARCHIVE_COLUMNS] = {
+    [ARCHIVE_TIME] = 1, [ARCHIVE_ORDER_ID] = 1, [ARCHIVE_PRICE] = 1};
+
+static uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static size_t put_varint(uint8_t *out, uint64_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80)
+    {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Reads one varint from [*in, end); -1 if it runs past the end
+static int get_varint(const uint8_t **in, const uint8_t *end, uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *in < end; shift += 7)
+    {
+        uint8_t byte = *(*in)++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int64_t price_ticks(double price)
+{
+    return llround(price * ORDER_KEY_PRICE_SCALE);
+}
+
+static int64_t column_value(const ArchiveRecord *record, int column, double time_resolution)
+{
+    switch (column)
+    {
+    case ARCHIVE_TIME:
+        return llround(record->time / time_resolution);
+    case ARCHIVE_TYPE:
+        return record->type;
+    case ARCHIVE_SIDE:
+        return (uint8_t)record->side;
+    case ARCHIVE_ORDER_ID:
+        return record->order_id;
+    case ARCHIVE_COUNTERPARTY_ID:
+        return record->counterparty_id;
+    case ARCHIVE_OWNER_ID:
+        return record->owner_id;
+    case ARCHIVE_PRICE:
+        return price_ticks(record->price);
+    case ARCHIVE_QUANTITY:
+        return record->quantity;
+    case ARCHIVE_LEFTOVER:
+        return record->leftover;
+    case ARCHIVE_COUNTERPARTY_LEFTOVER:
+        return record->counterparty_leftover;
+    }
+    return 0;
+}
+
+static int compare_int64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Encodes one column of the buffered chunk into writer->buffer; returns its size
+static size_t encode_column(ArchiveWriter *writer, int column)
+{
+    int n = writer->row_count;
+    int64_t *values = (int64_t *)malloc(2 * (size_t)n * sizeof(int64_t));
+    if (!values)
+    {
+        fprintf(stderr, "Memory allocation failed for archive column\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++)
+        values[i] = column_value(&writer->rows[i], column, writer->header.time_resolution);
+
+    uint8_t *out = writer->buffer;
+    size_t size = 0;
+    if (column == ARCHIVE_OWNER_ID)
+    {
+        // sorted dictionary of distinct owners, then an index per row
+        int64_t *dictionary = values + n;
+        memcpy(dictionary, values, n * sizeof(int64_t));
+        qsort(dictionary, n, sizeof(int64_t), compare_int64);
+        int entries = 0;
+        for (int i = 0; i < n; i++)
+            if (entries == 0 || dictionary[entries - 1] != dictionary[i])
+                dictionary[entries++] = dictionary[i];
+
+        size += put_varint(out + size, (uint64_t)entries);
+        for (int i = 0; i < entries; i++)
+            size += put_varint(out + size, zigzag(dictionary[i]));
+        for (int i = 0; i < n; i++)
+        {
+            int64_t *found = (int64_t *)bsearch(&values[i], dictionary, entries, sizeof(int64_t), compare_int64);
+            size += put_varint(out + size, (uint64_t)(found - dictionary));
+        }
+    }
+    else
+    {
+        int64_t previous = 0;
+        for (int i = 0; i < n; i++)
+        {
+            int64_t value = delta_encoded[column] ? values[i] - previous : values[i];
+            previous = values[i];
+            size += put_varint(out + size, zigzag(value));
+        }
+    }
+
+    free(values);
+    return size;
+}
+
+static int flush_chunk(ArchiveWriter *writer)
+{
+    int n = writer->row_count;
+    if (n == 0)
+        return 0;
+
+    if ((int)writer->header.chunk_count == writer->chunk_capacity)
+    {
+        int capacity = writer->chunk_capacity ? 2 * writer->chunk_capacity : 16;
+        ArchiveChunk *chunks = (ArchiveChunk *)realloc(writer->chunks, capacity * sizeof(ArchiveChunk));
+        if (!chunks)
+        {
+            fprintf(stderr, "Memory allocation failed for archive index\n");
+            exit(EXIT_FAILURE);
+        }
+        writer->chunks = chunks;
+        writer->chunk_capacity = capacity;
+    }
+
+    ArchiveChunk *chunk = &writer->chunks[writer->header.chunk_count];
+    memset(chunk, 0, sizeof(ArchiveChunk));
+    chunk->rows = (uint32_t)n;
+    for (int i = 0; i < n; i++)
+    {
+        int64_t time = column_value(&writer->rows[i], ARCHIVE_TIME, writer->header.time_resolution);
+        int64_t price = price_ticks(writer->rows[i].price);
+        if (i == 0 || time < chunk->min_time)
+            chunk->min_time = time;
+        if (i == 0 || time > chunk->max_time)
+            chunk->max_time = time;
+        if (i == 0 || price < chunk->min_price)
+            chunk->min_price = price;
+        if (i == 0 || price > chunk->max_price)
+            chunk->max_price = price;
+    }
+
+    for (int column = 0; column < ARCHIVE_COLUMNS; column++)
+    {
+        size_t size = encode_column(writer, column);
+        if (fwrite(writer->buffer, 1, size, writer->file) != size)
+        {
+            // the file now ends mid-chunk; nothing after it can be indexed
+            fprintf(stderr, "Could not write archive chunk %u\n", writer->header.chunk_count);
+            writer->failed = 1;
+            writer->row_count = 0;
+            return -1;
+        }
+        chunk->offset[column] = writer->offset;
+        chunk->size[column] = (uint32_t)size;
+        writer->offset += size;
+    }
+
+    writer->header.chunk_count++;
+    writer->row_count = 0;
+    return 0;
+}
+
+ArchiveWriter *create_archive_writer(const char *path, double time_resolution)
+{
+    if (!path || !(time_resolution > 0))
+        return NULL;
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Could not create archive %s\n", path);
+        return NULL;
+    }
+
+    ArchiveWriter *writer = (ArchiveWriter *)calloc(1, sizeof(ArchiveWriter));
+    if (!writer)
+    {
+        fprintf(stderr, "Memory allocation failed for ArchiveWriter\n");
+        exit(EXIT_FAILURE);
+    }
+    writer->file = file;
+    writer->header.magic = ARCHIVE_MAGIC;
+    writer->header.version = ARCHIVE_VERSION;
+    writer->header.columns = ARCHIVE_COLUMNS;
+    writer->header.time_resolution = time_resolution;
+    writer->rows = (ArchiveRecord *)malloc(ARCHIVE_CHUNK_ROWS * sizeof(ArchiveRecord));
+    // a dictionary column is at most one varint per row plus one per entry
+    writer->buffer_capacity = 2 * ARCHIVE_CHUNK_ROWS * 10 + 10;
+    writer->buffer = (uint8_t *)malloc(writer->buffer_capacity);
+    if (!writer->rows || !writer->buffer)
+    {
+        fprintf(stderr, "Memory allocation failed for archive buffers\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // the header is rewritten with the index offset on close
+    if (fwrite(&writer->header, sizeof(ArchiveHeader), 1, file) != 1)
+    {
+        fclose(file);
+        free(writer->rows);
+        free(writer->buffer);
+        free(writer);
+        return NULL;
+    }
+    writer->offset = sizeof(ArchiveHeader);
+    return writer;
+}
+
+int archive_append(ArchiveWriter *writer, const ArchiveRecord *record)
+{
+    if (!writer || !record || writer->failed)
+        return -1;
+
+    writer->rows[writer->row_count++] = *record;
+    if (writer->row_count == ARCHIVE_CHUNK_ROWS)
+        return flush_chunk(writer);
+    return 0;
+}
+
+static void on_book_event(void *context, const BookEvent *event)
+{
+    ArchiveWriter *writer = (ArchiveWriter *)context;
+    const Order *order = event->order;
+    ArchiveRecord record;
+    memset(&record, 0, sizeof(record));
+    // an order's timestamp is when it arrived, not when it was reduced
+    // or left the book
+    if (event->type == BOOK_EVENT_ADD)
+        writer->clock = order->timestamp;
+    record.time = writer->clock;
+    record.type = (uint8_t)event->type;
+    record.side = order->side;
+    record.order_id = order->order_id;
+    record.owner_id = order->owner_id;
+    record.price = order->price;
+    record.quantity = event->quantity;
+    record.leftover = event->type == BOOK_EVENT_REMOVE ? 0 : order->quantity;
+
+    if (event->type == BOOK_EVENT_TRADE)
+    {
+        writer->clock = event->fill->timestamp;
+        record.time = writer->clock;
+        record.counterparty_id = event->counterparty->order_id;
+        record.price = event->fill->traded_price;
+        record.leftover = event->fill->maker_leftover;
+        record.counterparty_leftover = event->fill->taker_leftover;
+    }
+    archive_append(writer, &record);
+}
+
+int archive_attach(ArchiveWriter *writer, OrderBook *book)
+{
+    if (!writer || !book || writer->book)
+        return -1;
+    if (add_book_listener(book, on_book_event, writer) != 0)
+        return -1;
+
+    writer->book = book;
+    return 0;
+}
+
+void archive_set_time(ArchiveWriter *writer, double time)
+{
+    if (writer)
+        writer->clock = time;
+}
+
+int archive_append_trades(ArchiveWriter *writer, const OrderBook *book)
+{
+    if (!writer || !book)
+        return -1;
+
+    for (int i = 0; i < book->trade_history_size; i++)
+    {
+        const FilledOrder *fill = &book->trade_history[i];
+        ArchiveRecord record;
+        memset(&record, 0, sizeof(record));
+        record.time = fill->timestamp;
+        record.type = BOOK_EVENT_TRADE;
+        record.side = fill->taker_side == 'B' ? 'S' : 'B';
+        record.order_id = fill->maker_id;
+        record.counterparty_id = fill->taker_id;
+        record.price = fill->traded_price;
+        record.quantity = fill->traded_quantity;
+        record.leftover = fill->maker_leftover;
+        record.counterparty_leftover = fill->taker_leftover;
+        if (archive_append(writer, &record) != 0)
+            return -1;
+    }
+    return book->trade_history_size;
+}
+
+int close_archive_writer(ArchiveWriter *writer)
+{
+    if (!writer)
+        return -1;
+
+    if (writer->book)
+        remove_book_listener(writer->book, on_book_event, writer);
+
+    int result = writer->failed ? -1 : flush_chunk(writer);
+    if (result == 0)
+    {
+        // the index is read in place from the mapping, so align it
+        static const uint8_t padding[sizeof(uint64_t)];
+        size_t pad = (sizeof(uint64_t) - writer->offset % sizeof(uint64_t)) % sizeof(uint64_t);
+        if (fwrite(padding, 1, pad, writer->file) != pad)
+            result = -1;
+        writer->offset += pad;
+        writer->header.index_offset = writer->offset;
+    }
+    if (result == 0)
+    {
+        size_t chunks = writer->header.chunk_count;
+        if (fwrite(writer->chunks, sizeof(ArchiveChunk), chunks, writer->file) != chunks ||
+            fseek(writer->file, 0, SEEK_SET) != 0 ||
+            fwrite(&writer->header, sizeof(ArchiveHeader), 1, writer->file) != 1)
+            result = -1;
+    }
+    if (fclose(writer->file) != 0)
+        result = -1;
+
+    free(writer->rows);
+    free(writer->buffer);
+    free(writer->chunks);
+    free(writer);
+    return result;
+}
+
+ArchiveReader *open_archive(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ArchiveHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)info.st_size;
+    void *mapped = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return NULL;
+
+    const ArchiveHeader *header = (const ArchiveHeader *)mapped;
+    int valid = header->magic == ARCHIVE_MAGIC && header->version == ARCHIVE_VERSION &&
+                header->columns == ARCHIVE_COLUMNS && header->time_resolution > 0 &&
+                header->index_offset >= sizeof(ArchiveHeader) && header->index_offset <= size &&
+                header->index_offset % sizeof(uint64_t) == 0 &&
+                (size - header->index_offset) / sizeof(ArchiveChunk) >= header->chunk_count;
+    const ArchiveChunk *chunks = (const ArchiveChunk *)((const uint8_t *)mapped + header->index_offset);
+    for (uint32_t c = 0; valid && c < header->chunk_count; c++)
+        for (int column = 0; column < ARCHIVE_COLUMNS; column++)
+            if (chunks[c].offset[column] > header->index_offset ||
+                chunks[c].size[column] > header->index_offset - chunks[c].offset[column])
+                valid = 0;
+    if (!valid)
+    {
+        munmap(mapped, size);
+        return NULL;
+    }
+
+    ArchiveReader *reader = (ArchiveReader *)malloc(sizeof(ArchiveReader));
+    if (!reader)
+    {
+        fprintf(stderr, "Memory allocation failed for ArchiveReader\n");
+        exit(EXIT_FAILURE);
+    }
+    reader->data = (const uint8_t *)mapped;
+    reader->size = size;
+    reader->header = header;
+    reader->chunks = chunks;
+    return reader;
+}
+
+void close_archive(ArchiveReader *reader)
+{
+    if (!reader)
+        return;
+
+    munmap((void *)reader->data, reader->size);
+    free(reader);
+}
+
+ArchiveQuery default_archive_query()
+{
+    ArchiveQuery query;
+    query.from = -INFINITY;
+    query.to = INFINITY;
+    query.min_price = -INFINITY;
+    query.max_price = INFINITY;
+    query.columns = ARCHIVE_ALL_COLUMNS;
+    return query;
+}
+
+// Decodes every row of one column of a chunk into out; -1 if corrupt
+static int decode_column(const ArchiveReader *reader, const ArchiveChunk *chunk, int column, int64_t *out)
+{
+    const uint8_t *in = reader->data + chunk->offset[column];
+    const uint8_t *end = in + chunk->size[column];
+    uint32_t n = chunk->rows;
+    uint64_t raw;
+
+    if (column == ARCHIVE_OWNER_ID)
+    {
+        uint64_t entries;
+        if (get_varint(&in, end, &entries) != 0 || entries > n)
+            return -1;
+        int64_t dictionary[ARCHIVE_CHUNK_ROWS];
+        for (uint64_t i = 0; i < entries; i++)
+        {
+            if (get_varint(&in, end, &raw) != 0)
+                return -1;
+            dictionary[i] = unzigzag(raw);
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            if (get_varint(&in, end, &raw) != 0 || raw >= entries)
+                return -1;
+            out[i] = dictionary[raw];
+        }
+        return 0;
+    }
+
+    int64_t previous = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (get_varint(&in, end, &raw) != 0)
+            return -1;
+        out[i] = delta_encoded[column] ? previous + unzigzag(raw) : unzigzag(raw);
+        previous = out[i];
+    }
+    return 0;
+}
+
+static void *grow(void *array, int selected, int capacity, size_t size)
+{
+    if (!selected)
+        return NULL;
+    void *grown = realloc(array, capacity * size);
+    if (!grown)
+    {
+        fprintf(stderr, "Memory allocation failed for archive columns\n");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+static void reserve_columns(ArchiveColumns *out, unsigned columns, int capacity)
+{
+    if (capacity <= out->capacity)
+        return;
+
+#define GROW(field, column, type) \
+    out->field = (type *)grow(out->field, columns & ARCHIVE_COLUMN_BIT(column), capacity, sizeof(type))
+    GROW(time, ARCHIVE_TIME, double);
+    GROW(type, ARCHIVE_TYPE, uint8_t);
+    GROW(side, ARCHIVE_SIDE, char);
+    GROW(order_id, ARCHIVE_ORDER_ID, int);
+    GROW(counterparty_id, ARCHIVE_COUNTERPARTY_ID, int);
+    GROW(owner_id, ARCHIVE_OWNER_ID, int);
+    GROW(price, ARCHIVE_PRICE, double);
+    GROW(quantity, ARCHIVE_QUANTITY, int);
+    GROW(leftover, ARCHIVE_LEFTOVER, int);
+    GROW(counterparty_leftover, ARCHIVE_COUNTERPARTY_LEFTOVER, int);
+#undef GROW
+    out->capacity = capacity;
+}
+
+static void store_value(ArchiveColumns *out, int column, int row, int64_t value, double time_resolution)
+{
+    switch (column)
+    {
+    case ARCHIVE_TIME:
+        out->time[row] = value * time_resolution;
+        break;
+    case ARCHIVE_TYPE:
+        out->type[row] = (uint8_t)value;
+        break;
+    case ARCHIVE_SIDE:
+        out->side[row] = (char)value;
+        break;
+    case ARCHIVE_ORDER_ID:
+        out->order_id[row] = (int)value;
+        break;
+    case ARCHIVE_COUNTERPARTY_ID:
+        out->counterparty_id[row] = (int)value;
+        break;
+    case ARCHIVE_OWNER_ID:
+        out->owner_id[row] = (int)value;
+        break;
+    case ARCHIVE_PRICE:
+        out->price[row] = value / ORDER_KEY_PRICE_SCALE;
+        break;
+    case ARCHIVE_QUANTITY:
+        out->quantity[row] = (int)value;
+        break;
+    case ARCHIVE_LEFTOVER:
+        out->leftover[row] = (int)value;
+        break;
+    case ARCHIVE_COUNTERPARTY_LEFTOVER:
+        out->counterparty_leftover[row] = (int)value;
+        break;
+    }
+}
+
+int archive_scan(const ArchiveReader *reader, const ArchiveQuery *query, ArchiveColumns *out)
+{
+    if (!reader || !query || !out)
+        return -1;
+
+    free_archive_columns(out);
+
+    double resolution = reader->header->time_resolution;
+    int64_t *times = (int64_t *)malloc(ARCHIVE_CHUNK_ROWS * sizeof(int64_t));
+    int64_t *prices = (int64_t *)malloc(ARCHIVE_CHUNK_ROWS * sizeof(int64_t));
+    int64_t *values = (int64_t *)malloc(ARCHIVE_CHUNK_ROWS * sizeof(int64_t));
+    uint8_t *keep = (uint8_t *)malloc(ARCHIVE_CHUNK_ROWS);
+    if (!times || !prices || !values || !keep)
+    {
+        fprintf(stderr, "Memory allocation failed for archive scan\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int result = 0;
+    for (uint32_t c = 0; c < reader->header->chunk_count && result == 0; c++)
+    {
+        const ArchiveChunk *chunk = &reader->chunks[c];
+        if (chunk->rows > ARCHIVE_CHUNK_ROWS)
+        {
+            result = -1;
+            break;
+        }
+        // the index rules out most chunks without touching their data
+        if (chunk->max_time * resolution < query->from || chunk->min_time * resolution > query->to ||
+            chunk->max_price / ORDER_KEY_PRICE_SCALE < query->min_price ||
+            chunk->min_price / ORDER_KEY_PRICE_SCALE > query->max_price)
+            continue;
+
+        if (decode_column(reader, chunk, ARCHIVE_TIME, times) != 0 ||
+            decode_column(reader, chunk, ARCHIVE_PRICE, prices) != 0)
+        {
+            result = -1;
+            break;
+        }
+        int kept = 0;
+        for (uint32_t i = 0; i < chunk->rows; i++)
+        {
+            double time = times[i] * resolution;
+            double price = prices[i] / ORDER_KEY_PRICE_SCALE;
+            keep[i] = time >= query->from && time <= query->to && price >= query->min_price &&
+                      price <= query->max_price;
+            kept += keep[i];
+        }
+        if (kept == 0)
+            continue;
+
+        int capacity = out->capacity ? out->capacity : ARCHIVE_CHUNK_ROWS;
+        while (capacity < out->count + kept)
+            capacity *= 2;
+        reserve_columns(out, query->columns, capacity);
+
+        for (int column = 0; column < ARCHIVE_COLUMNS && result == 0; column++)
+        {
+            if (!(query->columns & ARCHIVE_COLUMN_BIT(column)))
+                continue;
+
+            const int64_t *decoded = column == ARCHIVE_TIME ? times : column == ARCHIVE_PRICE ? prices : values;
+            if (decoded == values && decode_column(reader, chunk, column, values) != 0)
+            {
+                result = -1;
+                break;
+            }
+            int row = out->count;
+            for (uint32_t i = 0; i < chunk->rows; i++)
+                if (keep[i])
+                    store_value(out, column, row++, decoded[i], resolution);
+        }
+        out->count += kept;
+    }
+
+    free(times);
+    free(prices);
+    free(values);
+    free(keep);
+    if (result != 0)
+    {
+        free_archive_columns(out);
+        return -1;
+    }
+    return out->count;
+}
+
+void free_archive_columns(ArchiveColumns *columns)
+{
+    if (!columns)
+        return;
+
+    free(columns->time);
+    free(columns->type);
+    free(columns->side);
+    free(columns->order_id);
+    free(columns->counterparty_id);
+    free(columns->owner_id);
+    free(columns->price);
+    free(columns->quantity);
+    free(columns->leftover);
+    free(columns->counterparty_leftover);
+    memset(columns, 0, sizeof(ArchiveColumns));
+}
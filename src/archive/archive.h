@@ -0,0 +1,162 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "orderbook.h"
+
+/*
+    Columnar on-disk archive of order events and trades.
+
+    Records are buffered into chunks of ARCHIVE_CHUNK_ROWS rows and each
+    chunk is written column by column: times, prices and order ids as
+    zigzag varint deltas from the previous row, owner ids through a
+    per-chunk dictionary, the rest as plain varints. A footer index
+    keeps each chunk's row count, time and price range and column
+    offsets, so a reader maps the file, skips chunks outside the query
+    and decodes only the columns asked for.
+
+    A trade is stored as one BOOK_EVENT_TRADE record: the maker is the
+    order (its side, owner and leftover), the taker the counterparty.
+
+    An attached writer stamps adds with the order's timestamp and trades
+    with the fill's. Reduce and remove events carry no time of their
+    own, so they get the writer's clock: the latest add or trade time,
+    or whatever the caller set with archive_set_time before a cancel,
+    modify or expiry.
+*/
+
+#define ARCHIVE_MAGIC 0x41524356u // "ARCV"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_CHUNK_ROWS 4096
+
+typedef enum
+{
+    ARCHIVE_TIME,
+    ARCHIVE_TYPE,
+    ARCHIVE_SIDE,
+    ARCHIVE_ORDER_ID,
+    ARCHIVE_COUNTERPARTY_ID,
+    ARCHIVE_OWNER_ID,
+    ARCHIVE_PRICE,
+    ARCHIVE_QUANTITY,
+    ARCHIVE_LEFTOVER,
+    ARCHIVE_COUNTERPARTY_LEFTOVER,
+    ARCHIVE_COLUMNS
+} ArchiveColumn;
+
+#define ARCHIVE_COLUMN_BIT(column) (1u << (column))
+#define ARCHIVE_ALL_COLUMNS ((1u << ARCHIVE_COLUMNS) - 1)
+
+typedef struct
+{
+    double time;
+    uint8_t type;        // BookEventType
+    char side;           // of the order
+    int order_id;        // maker of a trade
+    int counterparty_id; // taker of a trade, 0 otherwise
+    int owner_id;
+    double price;        // limit price, or the traded price
+    int quantity;        // event quantity, or the traded quantity
+    int leftover;        // order's open quantity after the event
+    int counterparty_leftover;
+} ArchiveRecord;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t columns;
+    double time_resolution; // stored times are multiples of this
+    uint64_t index_offset;  // 0 until the writer is closed
+    uint32_t chunk_count;
+    uint32_t reserved;
+} ArchiveHeader;
+
+typedef struct
+{
+    uint32_t rows;
+    uint32_t reserved;
+    int64_t min_time; // in time_resolution units
+    int64_t max_time;
+    int64_t min_price; // in 1 / ORDER_KEY_PRICE_SCALE ticks
+    int64_t max_price;
+    uint64_t offset[ARCHIVE_COLUMNS];
+    uint32_t size[ARCHIVE_COLUMNS];
+} ArchiveChunk;
+
+typedef struct
+{
+    FILE *file;
+    ArchiveHeader header;
+    ArchiveRecord *rows; // current chunk
+    int row_count;
+    ArchiveChunk *chunks;
+    int chunk_capacity;
+    uint64_t offset; // end of the data written so far
+    uint8_t *buffer; // column encoding scratch
+    size_t buffer_capacity;
+    OrderBook *book; // attached book, if any
+    int failed;      // a write failed: appends are refused and close reports it
+    double clock;    // time of reduce and remove rows from the attached book
+} ArchiveWriter;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    const ArchiveHeader *header;
+    const ArchiveChunk *chunks;
+} ArchiveReader;
+
+typedef struct
+{
+    double from;      // inclusive time range
+    double to;
+    double min_price; // inclusive price range
+    double max_price;
+    unsigned columns; // ARCHIVE_COLUMN_BIT set to decode
+} ArchiveQuery;
+
+// Decoded rows; arrays of unselected columns are NULL
+typedef struct
+{
+    int count;
+    int capacity;
+    double *time;
+    uint8_t *type;
+    char *side;
+    int *order_id;
+    int *counterparty_id;
+    int *owner_id;
+    double *price;
+    int *quantity;
+    int *leftover;
+    int *counterparty_leftover;
+} ArchiveColumns;
+
+// NULL if path cannot be created; time_resolution > 0
+ArchiveWriter *create_archive_writer(const char *path, double time_resolution);
+// -1 once a chunk could not be written; the writer stays failed
+int archive_append(ArchiveWriter *writer, const ArchiveRecord *record);
+// Streams book's events into the archive until the writer is closed
+int archive_attach(ArchiveWriter *writer, OrderBook *book);
+// Time of the attached book's input about to be applied, for the reduce
+// and remove rows it causes
+void archive_set_time(ArchiveWriter *writer, double time);
+// Appends book's trade_history (end of session); returns the rows added
+int archive_append_trades(ArchiveWriter *writer, const OrderBook *book);
+// Flushes the last chunk and writes the index; 0 on success, -1 if
+// this or any earlier write failed
+int close_archive_writer(ArchiveWriter *writer);
+
+// Maps a closed archive; NULL if missing or not an archive
+ArchiveReader *open_archive(const char *path);
+void close_archive(ArchiveReader *reader);
+ArchiveQuery default_archive_query();
+// Decodes the selected columns of every row matching query into out
+// (replacing its contents); returns the row count, -1 on corrupt data
+int archive_scan(const ArchiveReader *reader, const ArchiveQuery *query, ArchiveColumns *out);
+void free_archive_columns(ArchiveColumns *columns);
+
+#endif
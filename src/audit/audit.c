@@ -0,0 +1,755 @@
+#include "audit.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <time.h>
+
+static const char *violation_names[AUDIT_VIOLATION_TYPES] = {
+    "heap order", "heap index", "key", "ladder level", "ladder bitmap", "order", "side size",
+    "orphan", "map", "account", "expiry", "crossed", "level aggregate"};
+
+const char *audit_violation_name(AuditViolationType type)
+{
+    return type < AUDIT_VIOLATION_TYPES ? violation_names[type] : "unknown";
+}
+
+// Grows buffer to hold needed entries of width bytes
+static void *reserve(void *buffer, int *capacity, int needed, size_t width)
+{
+    // allocated even when nothing is needed yet, so the copies never see NULL
+    if (buffer && needed <= *capacity)
+        return buffer;
+
+    int grown = *capacity > 0 ? *capacity : 64;
+    while (grown < needed)
+        grown *= 2;
+    void *resized = realloc(buffer, (size_t)grown * width);
+    if (!resized)
+    {
+        fprintf(stderr, "Memory reallocation failed for book snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+    *capacity = grown;
+    return resized;
+}
+
+BookSnapshot *create_book_snapshot()
+{
+    BookSnapshot *snapshot = (BookSnapshot *)calloc(1, sizeof(BookSnapshot));
+    if (!snapshot)
+    {
+        fprintf(stderr, "Memory allocation failed for BookSnapshot\n");
+        exit(EXIT_FAILURE);
+    }
+    snapshot->level_bids.is_buy = 1;
+    return snapshot;
+}
+
+static void free_audit_side(AuditSide *side)
+{
+    free(side->handles);
+    free(side->keys);
+    free(side->levels);
+    free(side->bitmap);
+    free(side->summary);
+}
+
+void free_book_snapshot(BookSnapshot *snapshot)
+{
+    if (!snapshot)
+        return;
+
+    free(snapshot->orders);
+    free_audit_side(&snapshot->bids);
+    free_audit_side(&snapshot->asks);
+    free(snapshot->map_entries);
+    free(snapshot->accounts);
+    free(snapshot->account_orders);
+    free(snapshot->level_bids.levels);
+    free(snapshot->level_asks.levels);
+    free(snapshot);
+}
+
+static OrderHandle handle_of(const Order *order)
+{
+    return order ? order->handle : INVALID_HANDLE;
+}
+
+static void capture_side(AuditSide *out, OrderHeap *heap, char side)
+{
+    out->side = side;
+    out->size = heap->size;
+    out->ladder = heap->ladder != NULL;
+    if (!heap->ladder)
+    {
+        int capacity = out->heap_capacity;
+        out->handles = (OrderHandle *)reserve(out->handles, &capacity, heap->size, sizeof(OrderHandle));
+        out->keys = (uint64_t *)reserve(out->keys, &out->heap_capacity, heap->size, sizeof(uint64_t));
+        memcpy(out->handles, heap->arr, heap->size * sizeof(OrderHandle));
+        memcpy(out->keys, heap->keys, heap->size * sizeof(uint64_t));
+        return;
+    }
+
+    PriceLadder *ladder = heap->ladder;
+    out->levels = (AuditLevel *)reserve(out->levels, &out->levels_capacity, ladder->num_levels, sizeof(AuditLevel));
+    out->bitmap = (unsigned long long *)reserve(out->bitmap, &out->bitmap_capacity, ladder->bitmap_words,
+                                                sizeof(unsigned long long));
+    out->summary = (unsigned long long *)reserve(out->summary, &out->summary_capacity, ladder->summary_words,
+                                                 sizeof(unsigned long long));
+    for (int i = 0; i < ladder->num_levels; i++)
+    {
+        out->levels[i].head = handle_of(ladder->levels[i].head);
+        out->levels[i].tail = handle_of(ladder->levels[i].tail);
+        out->levels[i].count = ladder->levels[i].count;
+    }
+    memcpy(out->bitmap, ladder->bitmap, ladder->bitmap_words * sizeof(unsigned long long));
+    memcpy(out->summary, ladder->summary, ladder->summary_words * sizeof(unsigned long long));
+    out->num_levels = ladder->num_levels;
+    out->bitmap_words = ladder->bitmap_words;
+    out->summary_words = ladder->summary_words;
+    out->best = ladder->best;
+    out->ladder_size = ladder->size;
+    out->base_price = ladder->base_price;
+    out->tick_size = ladder->tick_size;
+}
+
+static void capture_orders(BookSnapshot *snapshot, OrderTable *table)
+{
+    snapshot->orders = (AuditOrder *)reserve(snapshot->orders, &snapshot->orders_capacity, (int)table->used,
+                                             sizeof(AuditOrder));
+    snapshot->used = table->used;
+    snapshot->free_count = table->free_count;
+    for (uint32_t h = 0; h < table->used; h++)
+    {
+        AuditOrder *out = &snapshot->orders[h];
+        const Order *order = table->orders[h];
+        out->live = order != NULL;
+        if (!order)
+            continue;
+
+        out->order_id = order->order_id;
+        out->owner_id = order->owner_id;
+        out->quantity = order->quantity;
+        out->side = order->side;
+        out->tif = (uint8_t)order->tif;
+        out->scheduled = order->timer_slot != NULL;
+        out->handle = order->handle;
+        out->level_prev = handle_of(order->level_prev);
+        out->level_next = handle_of(order->level_next);
+        out->sequence = order->sequence;
+        out->price = order->price;
+        out->heap_index = table->heap_index[h];
+        out->key = table->keys[h];
+    }
+}
+
+// Walks stop after limit entries, so a cycle shows up as a count mismatch
+static void capture_map(BookSnapshot *snapshot, OrderMap *map)
+{
+    int limit = map->size + 1;
+    snapshot->map_entries = (AuditMapEntry *)reserve(snapshot->map_entries, &snapshot->map_entries_capacity,
+                                                     limit, sizeof(AuditMapEntry));
+    snapshot->map_size = map->size;
+    snapshot->map_capacity = map->capacity;
+    snapshot->map_old_capacity = map->old_buckets ? map->old_capacity : 0;
+    snapshot->map_rehash_index = map->rehash_index;
+    int count = 0;
+    for (int old = 0; old < 2; old++)
+    {
+        MapEntry **buckets = old ? map->old_buckets : map->buckets;
+        int capacity = old ? snapshot->map_old_capacity : map->capacity;
+        for (int b = 0; b < capacity && count < limit; b++)
+        {
+            for (MapEntry *entry = buckets[b]; entry && count < limit; entry = entry->next)
+            {
+                snapshot->map_entries[count].key = entry->key;
+                snapshot->map_entries[count].bucket = b;
+                snapshot->map_entries[count].old = old;
+                snapshot->map_entries[count].value = entry->value;
+                count++;
+            }
+        }
+    }
+    snapshot->map_count = count;
+}
+
+static void capture_accounts(BookSnapshot *snapshot, AccountMap *map, uint32_t used)
+{
+    snapshot->accounts = (AuditAccount *)reserve(snapshot->accounts, &snapshot->accounts_capacity, map->size,
+                                                 sizeof(AuditAccount));
+    int accounts = 0;
+    int listed = 0;
+    for (int b = 0; b < map->capacity; b++)
+    {
+        for (AccountEntry *entry = map->buckets[b]; entry && accounts < map->size; entry = entry->next)
+        {
+            AuditAccount *account = &snapshot->accounts[accounts++];
+            account->owner_id = entry->owner_id;
+            account->order_count = entry->order_count;
+            account->first = listed;
+            account->listed = 0;
+            for (Order *order = entry->orders; order && account->listed <= (int)used; order = order->account_next)
+            {
+                snapshot->account_orders = (OrderHandle *)reserve(
+                    snapshot->account_orders, &snapshot->account_orders_capacity, listed + 1, sizeof(OrderHandle));
+                snapshot->account_orders[listed++] = order->handle;
+                account->listed++;
+            }
+        }
+    }
+    snapshot->account_count = accounts;
+    snapshot->account_order_count = listed;
+}
+
+static void capture_levels(MdSide *out, const MdSide *side)
+{
+    out->levels = (MdLevel *)reserve(out->levels, &out->capacity, side->count, sizeof(MdLevel));
+    memcpy(out->levels, side->levels, side->count * sizeof(MdLevel));
+    out->count = side->count;
+}
+
+void capture_book_snapshot(BookSnapshot *snapshot, OrderBook *book, const LevelBook *levels)
+{
+    snapshot->phase = book->phase;
+    capture_orders(snapshot, book->order_table);
+    capture_side(&snapshot->bids, book->buy_orders, 'B');
+    capture_side(&snapshot->asks, book->sell_orders, 'S');
+    capture_map(snapshot, book->order_map);
+    capture_accounts(snapshot, book->account_map, book->order_table->used);
+    snapshot->wheel_scheduled = book->expiry_wheel->scheduled;
+    snapshot->wheel_session = book->expiry_wheel->session_size;
+    snapshot->has_levels = levels != NULL;
+    if (levels)
+    {
+        capture_levels(&snapshot->level_bids, &levels->bids);
+        capture_levels(&snapshot->level_asks, &levels->asks);
+    }
+}
+
+typedef struct
+{
+    const BookSnapshot *snapshot;
+    AuditReport *report;
+    uint8_t *resting; // side an order was found on, by handle
+    uint8_t *mapped;
+} Audit;
+
+static void violation(Audit *audit, AuditViolationType type, int order_id, const char *format, ...)
+{
+    AuditReport *report = audit->report;
+    report->violations++;
+    if (report->stored == AUDIT_MAX_VIOLATIONS)
+        return;
+
+    AuditViolation *out = &report->list[report->stored++];
+    out->type = type;
+    out->order_id = order_id;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(out->detail, sizeof(out->detail), format, args);
+    va_end(args);
+}
+
+static const AuditOrder *order_at(const BookSnapshot *snapshot, OrderHandle handle)
+{
+    return handle < snapshot->used && snapshot->orders[handle].live ? &snapshot->orders[handle] : NULL;
+}
+
+static void mark_resting(Audit *audit, const AuditOrder *order, OrderHandle handle, char side)
+{
+    if (audit->resting[handle])
+        violation(audit, AUDIT_ORPHAN, order->order_id, "rests twice (on %c and %c)", audit->resting[handle], side);
+    audit->resting[handle] = (uint8_t)side;
+    if (order->side != side)
+        violation(audit, AUDIT_ORDER, order->order_id, "side %c order rests on side %c", order->side, side);
+}
+
+static void audit_heap(Audit *audit, const AuditSide *side)
+{
+    const BookSnapshot *snapshot = audit->snapshot;
+    for (int i = 0; i < side->size; i++)
+    {
+        OrderHandle handle = side->handles[i];
+        const AuditOrder *order = order_at(snapshot, handle);
+        if (!order)
+        {
+            violation(audit, AUDIT_HEAP_INDEX, 0, "%c heap slot %d holds free handle %u", side->side, i, handle);
+            continue;
+        }
+        mark_resting(audit, order, handle, side->side);
+
+        if (order->heap_index != i)
+            violation(audit, AUDIT_HEAP_INDEX, order->order_id, "in %c heap slot %d, table says %d", side->side, i,
+                      order->heap_index);
+        if (side->keys[i] != order->key)
+            violation(audit, AUDIT_KEY, order->order_id, "heap key %llx, table key %llx",
+                      (unsigned long long)side->keys[i], (unsigned long long)order->key);
+        else if ((order->key & ~ORDER_KEY_RANK_MASK) != (order_key(order->side, order->price, 0) & ~ORDER_KEY_RANK_MASK))
+            violation(audit, AUDIT_KEY, order->order_id, "key does not encode price %.4f", order->price);
+
+        int parent = (i - 1) / HEAP_ARITY;
+        if (i > 0 && side->keys[parent] > side->keys[i])
+            violation(audit, AUDIT_HEAP_ORDER, order->order_id, "%c heap slot %d sorts ahead of its parent %d",
+                      side->side, i, parent);
+    }
+}
+
+// Ticks from base_price, rounded as the ladder rounds them
+static long long ladder_offset(const AuditSide *side, double price)
+{
+    double position = (price - side->base_price) / side->tick_size;
+    return position >= 0 ? (long long)(position + 0.5) : -(long long)(-position + 0.5);
+}
+
+static void audit_ladder(Audit *audit, const AuditSide *side)
+{
+    const BookSnapshot *snapshot = audit->snapshot;
+    int total = 0;
+    int best = -1;
+    for (int idx = 0; idx < side->num_levels; idx++)
+    {
+        const AuditLevel *level = &side->levels[idx];
+        int bit = (side->bitmap[idx >> 6] >> (idx & 63)) & 1;
+        if (bit != (level->count > 0))
+            violation(audit, AUDIT_LADDER_BITMAP, 0, "%c level %d: bit %d, count %d", side->side, idx, bit,
+                      level->count);
+
+        OrderHandle previous = INVALID_HANDLE;
+        OrderHandle handle = level->head;
+        uint64_t last_sequence = 0;
+        int walked = 0;
+        while (handle != INVALID_HANDLE && walked <= level->count)
+        {
+            const AuditOrder *order = order_at(snapshot, handle);
+            if (!order)
+            {
+                violation(audit, AUDIT_LADDER_LEVEL, 0, "%c level %d links free handle %u", side->side, idx, handle);
+                break;
+            }
+            mark_resting(audit, order, handle, side->side);
+            if (order->level_prev != previous)
+                violation(audit, AUDIT_LADDER_LEVEL, order->order_id, "back link does not match its predecessor");
+            if (ladder_offset(side, order->price) != idx)
+                violation(audit, AUDIT_LADDER_LEVEL, order->order_id, "price %.4f rests on %c level %d", order->price,
+                          side->side, idx);
+            if (walked > 0 && order->sequence <= last_sequence)
+                violation(audit, AUDIT_LADDER_LEVEL, order->order_id, "out of arrival order on %c level %d",
+                          side->side, idx);
+            if (order->heap_index != -1)
+                violation(audit, AUDIT_HEAP_INDEX, order->order_id, "ladder order has heap index %d",
+                          order->heap_index);
+            last_sequence = order->sequence;
+            previous = handle;
+            handle = order->level_next;
+            walked++;
+        }
+        if (walked != level->count || handle != INVALID_HANDLE)
+            violation(audit, AUDIT_LADDER_LEVEL, 0, "%c level %d counts %d orders, list has %s%d", side->side, idx,
+                      level->count, handle != INVALID_HANDLE ? "more than " : "", walked);
+        else if (level->tail != previous)
+            violation(audit, AUDIT_LADDER_LEVEL, 0, "%c level %d tail is not its last order", side->side, idx);
+
+        total += level->count;
+        if (level->count > 0 && (best < 0 || side->side == 'B'))
+            best = idx; // highest for bids, lowest for asks
+    }
+
+    for (int w = 0; w < side->bitmap_words; w++)
+    {
+        int bit = (side->summary[w >> 6] >> (w & 63)) & 1;
+        if (bit != (side->bitmap[w] != 0))
+            violation(audit, AUDIT_LADDER_BITMAP, 0, "%c summary bit %d is %d", side->side, w, bit);
+    }
+    if (best != side->best)
+        violation(audit, AUDIT_LADDER_BITMAP, 0, "%c best level is %d, cached %d", side->side, best, side->best);
+    if (total != side->ladder_size || side->ladder_size != side->size)
+        violation(audit, AUDIT_SIDE_SIZE, 0, "%c ladder levels hold %d, ladder size %d, side size %d", side->side,
+                  total, side->ladder_size, side->size);
+}
+
+static void audit_side(Audit *audit, const AuditSide *side)
+{
+    if (side->ladder)
+        audit_ladder(audit, side);
+    else
+        audit_heap(audit, side);
+}
+
+static const AuditOrder *best_order(const BookSnapshot *snapshot, const AuditSide *side)
+{
+    if (side->ladder)
+        return side->best >= 0 ? order_at(snapshot, side->levels[side->best].head) : NULL;
+    return side->size > 0 ? order_at(snapshot, side->handles[0]) : NULL;
+}
+
+static void audit_orders(Audit *audit)
+{
+    const BookSnapshot *snapshot = audit->snapshot;
+    uint32_t live = 0;
+    for (uint32_t h = 0; h < snapshot->used; h++)
+    {
+        const AuditOrder *order = order_at(snapshot, h);
+        if (!order)
+            continue;
+
+        live++;
+        if (order->handle != h)
+            violation(audit, AUDIT_ORDER, order->order_id, "stamped with handle %u, stored at %u", order->handle, h);
+        if (order->quantity <= 0)
+            violation(audit, AUDIT_ORDER, order->order_id, "rests with quantity %d", order->quantity);
+        if (!audit->resting[h])
+            violation(audit, AUDIT_ORPHAN, order->order_id, "in the order table but on no side");
+        else
+            audit->report->resting++;
+    }
+    if (live != snapshot->used - snapshot->free_count)
+        violation(audit, AUDIT_ORDER, 0, "table holds %u orders, free list implies %u", live,
+                  snapshot->used - snapshot->free_count);
+}
+
+static void audit_map(Audit *audit)
+{
+    const BookSnapshot *snapshot = audit->snapshot;
+    for (int i = 0; i < snapshot->map_count; i++)
+    {
+        const AuditMapEntry *entry = &snapshot->map_entries[i];
+        int capacity = entry->old ? snapshot->map_old_capacity : snapshot->map_capacity;
+        if ((int)hash_function(entry->key, capacity) != entry->bucket)
+            violation(audit, AUDIT_MAP, entry->key, "entry sits in bucket %d", entry->bucket);
+        // mid-rehash an entry is in the new array exactly when its old bucket has been moved
+        else if (snapshot->map_old_capacity > 0 &&
+                 entry->old != ((int)hash_function(entry->key, snapshot->map_old_capacity) >= snapshot->map_rehash_index))
+            violation(audit, AUDIT_MAP, entry->key, "entry sits in the %s bucket array", entry->old ? "old" : "new");
+
+        const AuditOrder *order = order_at(snapshot, entry->value);
+        if (!order)
+            violation(audit, AUDIT_MAP, entry->key, "maps to free handle %u", entry->value);
+        else if (order->order_id != entry->key)
+            violation(audit, AUDIT_MAP, entry->key, "maps to order %d", order->order_id);
+        else if (audit->mapped[entry->value]++)
+            violation(audit, AUDIT_MAP, entry->key, "mapped more than once");
+        else if (!audit->resting[entry->value])
+            violation(audit, AUDIT_MAP, entry->key, "mapped but not resting");
+    }
+    if (snapshot->map_count != snapshot->map_size)
+        violation(audit, AUDIT_MAP, 0, "map size %d, %s%d entries", snapshot->map_size,
+                  snapshot->map_count > snapshot->map_size ? "at least " : "", snapshot->map_count);
+
+    for (uint32_t h = 0; h < snapshot->used; h++)
+    {
+        if (audit->resting[h] && !audit->mapped[h])
+            violation(audit, AUDIT_MAP, snapshot->orders[h].order_id, "resting but not in the map");
+    }
+}
+
+static void audit_accounts(Audit *audit)
+{
+    const BookSnapshot *snapshot = audit->snapshot;
+    for (int a = 0; a < snapshot->account_count; a++)
+    {
+        const AuditAccount *account = &snapshot->accounts[a];
+        if (account->listed != account->order_count)
+            violation(audit, AUDIT_ACCOUNT, 0, "account %d counts %d orders, lists %d", account->owner_id,
+                      account->order_count, account->listed);
+        for (int i = account->first; i < account->first + account->listed; i++)
+        {
+            const AuditOrder *order = order_at(snapshot, snapshot->account_orders[i]);
+            if (!order || !audit->resting[snapshot->account_orders[i]])
+                violation(audit, AUDIT_ACCOUNT, order ? order->order_id : 0, "account %d lists a non-resting order",
+                          account->owner_id);
+            else if (order->owner_id != account->owner_id)
+                violation(audit, AUDIT_ACCOUNT, order->order_id, "owned by %d, listed under %d", order->owner_id,
+                          account->owner_id);
+        }
+    }
+
+    int owned = 0;
+    int gtt = 0;
+    int day = 0;
+    for (uint32_t h = 0; h < snapshot->used; h++)
+    {
+        const AuditOrder *order = &snapshot->orders[h];
+        if (!audit->resting[h])
+            continue;
+        owned += order->owner_id != 0;
+        if (order->scheduled != (order->tif != TIF_GTC))
+            violation(audit, AUDIT_EXPIRY, order->order_id, "%s in the expiry wheel",
+                      order->scheduled ? "GTC order is" : "expiring order is not");
+        gtt += order->scheduled && order->tif == TIF_GTT;
+        day += order->scheduled && order->tif == TIF_DAY;
+    }
+    if (owned != snapshot->account_order_count)
+        violation(audit, AUDIT_ACCOUNT, 0, "%d owned orders rest, accounts list %d", owned,
+                  snapshot->account_order_count);
+    if (gtt != snapshot->wheel_scheduled || day != snapshot->wheel_session)
+        violation(audit, AUDIT_EXPIRY, 0, "wheel counts %d GTT and %d DAY, book has %d and %d",
+                  snapshot->wheel_scheduled, snapshot->wheel_session, gtt, day);
+}
+
+typedef struct
+{
+    double price;
+    int quantity;
+} PricedQuantity;
+
+static int compare_prices(const void *a, const void *b)
+{
+    double pa = ((const PricedQuantity *)a)->price;
+    double pb = ((const PricedQuantity *)b)->price;
+    return (pa > pb) - (pa < pb);
+}
+
+// Recomputes one side's levels from its orders and merges them against
+// the LevelBook's, both lowest price first
+static void audit_level_side(Audit *audit, char side, const MdSide *levels)
+{
+    const BookSnapshot *snapshot = audit->snapshot;
+    PricedQuantity *orders = (PricedQuantity *)malloc((snapshot->used + 1) * sizeof(PricedQuantity));
+    if (!orders)
+    {
+        fprintf(stderr, "Memory allocation failed for level audit\n");
+        exit(EXIT_FAILURE);
+    }
+    int count = 0;
+    for (uint32_t h = 0; h < snapshot->used; h++)
+    {
+        if (audit->resting[h] == (uint8_t)side)
+        {
+            orders[count].price = snapshot->orders[h].price;
+            orders[count].quantity = snapshot->orders[h].quantity;
+            count++;
+        }
+    }
+    qsort(orders, count, sizeof(PricedQuantity), compare_prices);
+
+    int i = 0;
+    int l = 0;
+    // LevelBook sides run worst first: bids ascend already, asks are read backwards
+    while (i < count || l < levels->count)
+    {
+        const MdLevel *level = l < levels->count ? &levels->levels[side == 'B' ? l : levels->count - 1 - l] : NULL;
+        double price = i < count ? orders[i].price : level->price;
+        if (level && level->price < price)
+            price = level->price;
+
+        long long quantity = 0;
+        int found = 0;
+        for (; i < count && orders[i].price == price; i++, found++)
+            quantity += orders[i].quantity;
+        if (level && level->price == price)
+        {
+            if (level->quantity != quantity || level->orders != found)
+                violation(audit, AUDIT_LEVEL_AGGREGATE, 0, "%c %.4f: levels say %lld in %d, orders %lld in %d", side,
+                          price, level->quantity, level->orders, quantity, found);
+            l++;
+        }
+        else
+            violation(audit, AUDIT_LEVEL_AGGREGATE, 0, "%c %.4f: levels say nothing, orders %lld in %d", side, price,
+                      quantity, found);
+    }
+    free(orders);
+}
+
+int audit_snapshot(const BookSnapshot *snapshot, AuditReport *report)
+{
+    memset(report, 0, sizeof(AuditReport));
+    Audit audit = {snapshot, report, NULL, NULL};
+    audit.resting = (uint8_t *)calloc(2 * (size_t)snapshot->used + 1, 1);
+    if (!audit.resting)
+    {
+        fprintf(stderr, "Memory allocation failed for audit\n");
+        exit(EXIT_FAILURE);
+    }
+    audit.mapped = audit.resting + snapshot->used;
+
+    audit_side(&audit, &snapshot->bids);
+    audit_side(&audit, &snapshot->asks);
+    audit_orders(&audit);
+    audit_map(&audit);
+    audit_accounts(&audit);
+
+    const AuditOrder *bid = best_order(snapshot, &snapshot->bids);
+    const AuditOrder *ask = best_order(snapshot, &snapshot->asks);
+    if (snapshot->phase == PHASE_CONTINUOUS && bid && ask && bid->price >= ask->price)
+        violation(&audit, AUDIT_CROSSED, bid->order_id, "best bid %.4f, best ask %.4f (order %d)", bid->price,
+                  ask->price, ask->order_id);
+
+    if (snapshot->has_levels)
+    {
+        audit_level_side(&audit, 'B', &snapshot->level_bids);
+        audit_level_side(&audit, 'S', &snapshot->level_asks);
+    }
+
+    free(audit.resting);
+    return (int)report->violations;
+}
+
+int audit_orderbook(OrderBook *book, const LevelBook *levels, AuditReport *report)
+{
+    if (!book || !report)
+        return -1;
+
+    BookSnapshot *snapshot = create_book_snapshot();
+    capture_book_snapshot(snapshot, book, levels);
+    int violations = audit_snapshot(snapshot, report);
+    free_book_snapshot(snapshot);
+    return violations;
+}
+
+static void *auditor_thread(void *arg)
+{
+    AuditMonitor *monitor = (AuditMonitor *)arg;
+    AuditReport report;
+
+    for (;;)
+    {
+        while (sem_wait(&monitor->wake) != 0 && errno == EINTR)
+            ;
+        int expected = AUDIT_PENDING;
+        if (!atomic_compare_exchange_strong(&monitor->state, &expected, AUDIT_CHECKING))
+        {
+            if (expected == AUDIT_STOPPING)
+                break;
+            continue;
+        }
+
+        audit_snapshot(monitor->snapshot, &report);
+
+        pthread_mutex_lock(&monitor->lock);
+        report.audit = ++monitor->audits;
+        monitor->last = report;
+        pthread_mutex_unlock(&monitor->lock);
+
+        if (monitor->handler)
+            monitor->handler(monitor->handler_context, &report);
+
+        pthread_mutex_lock(&monitor->lock);
+        // a stop request made during the audit stands
+        expected = AUDIT_CHECKING;
+        atomic_compare_exchange_strong(&monitor->state, &expected, AUDIT_IDLE);
+        pthread_cond_broadcast(&monitor->done);
+        pthread_mutex_unlock(&monitor->lock);
+    }
+    return NULL;
+}
+
+AuditMonitor *create_audit_monitor(OrderBook *book, const LevelBook *levels, int every,
+                                   AuditHandler handler, void *context)
+{
+    if (!book || every <= 0)
+        return NULL;
+
+    AuditMonitor *monitor = (AuditMonitor *)calloc(1, sizeof(AuditMonitor));
+    if (!monitor)
+    {
+        fprintf(stderr, "Memory allocation failed for AuditMonitor\n");
+        exit(EXIT_FAILURE);
+    }
+    monitor->book = book;
+    monitor->levels = levels;
+    monitor->every = every;
+    monitor->snapshot = create_book_snapshot();
+    monitor->handler = handler;
+    monitor->handler_context = context;
+    atomic_init(&monitor->state, AUDIT_IDLE);
+    atomic_init(&monitor->requested, 0);
+    sem_init(&monitor->wake, 0, 0);
+    pthread_mutex_init(&monitor->lock, NULL);
+    pthread_cond_init(&monitor->done, NULL);
+
+    if (pthread_create(&monitor->thread, NULL, auditor_thread, monitor) != 0)
+    {
+        sem_destroy(&monitor->wake);
+        pthread_mutex_destroy(&monitor->lock);
+        pthread_cond_destroy(&monitor->done);
+        free_book_snapshot(monitor->snapshot);
+        free(monitor);
+        return NULL;
+    }
+    return monitor;
+}
+
+void free_audit_monitor(AuditMonitor *monitor)
+{
+    if (!monitor)
+        return;
+
+    atomic_store(&monitor->state, AUDIT_STOPPING);
+    sem_post(&monitor->wake);
+    pthread_join(monitor->thread, NULL);
+
+    sem_destroy(&monitor->wake);
+    pthread_mutex_destroy(&monitor->lock);
+    pthread_cond_destroy(&monitor->done);
+    free_book_snapshot(monitor->snapshot);
+    free(monitor);
+}
+
+static uint64_t clock_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+int audit_monitor_tick(AuditMonitor *monitor)
+{
+    int requested = atomic_load_explicit(&monitor->requested, memory_order_relaxed);
+    if (++monitor->ticks < monitor->every && !requested)
+        return 0;
+    // the auditor owns the snapshot until it is idle again
+    if (atomic_load_explicit(&monitor->state, memory_order_acquire) != AUDIT_IDLE)
+        return 0;
+    // the capture is a pause linear in the book; too big a book waits
+    // for an explicit request
+    int resting = monitor->book->buy_orders->size + monitor->book->sell_orders->size;
+    if (!requested && monitor->max_resting > 0 && resting > monitor->max_resting)
+    {
+        monitor->ticks = 0;
+        monitor->skipped++;
+        return 0;
+    }
+
+    uint64_t start = clock_ns();
+    capture_book_snapshot(monitor->snapshot, monitor->book, monitor->levels);
+    uint64_t elapsed = clock_ns() - start;
+    if (elapsed > monitor->longest_capture_ns)
+        monitor->longest_capture_ns = elapsed;
+    monitor->ticks = 0;
+    // a request made during the capture is served by it
+    atomic_store_explicit(&monitor->requested, 0, memory_order_relaxed);
+
+    // the release publishes the snapshot; the post wakes the auditor
+    // without a lock (a semaphore counts posts, so none is lost)
+    atomic_store_explicit(&monitor->state, AUDIT_PENDING, memory_order_release);
+    sem_post(&monitor->wake);
+    return 1;
+}
+
+void audit_monitor_limit(AuditMonitor *monitor, int max_resting)
+{
+    monitor->max_resting = max_resting > 0 ? max_resting : 0;
+}
+
+void audit_monitor_request(AuditMonitor *monitor)
+{
+    atomic_store_explicit(&monitor->requested, 1, memory_order_relaxed);
+}
+
+int audit_monitor_report(AuditMonitor *monitor, AuditReport *out)
+{
+    pthread_mutex_lock(&monitor->lock);
+    int ready = monitor->audits > 0;
+    if (ready)
+        *out = monitor->last;
+    pthread_mutex_unlock(&monitor->lock);
+    return ready;
+}
+
+void audit_monitor_wait(AuditMonitor *monitor)
+{
+    pthread_mutex_lock(&monitor->lock);
+    while (atomic_load(&monitor->state) == AUDIT_PENDING || atomic_load(&monitor->state) == AUDIT_CHECKING)
+        pthread_cond_wait(&monitor->done, &monitor->lock);
+    pthread_mutex_unlock(&monitor->lock);
+}
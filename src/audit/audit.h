@@ -0,0 +1,231 @@
+#ifndef AUDIT_H
+#define AUDIT_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "orderbook.h"
+#include "marketdata/levelbook.h"
+
+/*
+    Book integrity checks. The matching thread captures a BookSnapshot:
+    flat copies of both sides (heap arrays, or ladder levels and
+    bitmaps with links turned into handles), the order table, the
+    OrderMap entries, the account lists and the expiry counts. The
+    snapshot is then audited on any thread:
+
+    - heap ordering and table back-indexes, or ladder level lists,
+      counts, bitmaps and best level
+    - every table order resting on exactly one side, at a positive
+      quantity
+    - the OrderMap holding exactly the resting orders, each in its bucket
+    - account lists and expiry counts agreeing with the resting orders
+    - no crossed book outside an auction
+    - per-level quantity and order counts of an attached LevelBook
+
+    An AuditMonitor does this periodically in the background: when its
+    thread is idle, audit_monitor_tick captures a snapshot and hands it
+    over with an atomic state change and a semaphore post, so the
+    matching thread never takes a lock and only pays for the copy. The
+    copy is a pause linear in the size of the book (flat array copies
+    of the orders, sides, map and accounts); the monitor records the
+    longest one, and a resting-order limit skips periodic captures of
+    books too large to pause for.
+*/
+
+#define AUDIT_MAX_VIOLATIONS 32
+
+typedef enum
+{
+    AUDIT_HEAP_ORDER,      // a heap key sorts ahead of its parent's
+    AUDIT_HEAP_INDEX,      // heap slot and table back-index disagree
+    AUDIT_KEY,             // heap key differs from the table key or the order's price
+    AUDIT_LADDER_LEVEL,    // broken level list: links, head/tail, count, price or FIFO
+    AUDIT_LADDER_BITMAP,   // bitmap, summary or best level out of step with the levels
+    AUDIT_ORDER,           // bad quantity or side, or a stale handle
+    AUDIT_SIDE_SIZE,       // side size differs from the orders found on it
+    AUDIT_ORPHAN,          // order in the table but on no side, or on two
+    AUDIT_MAP,             // map entry misplaced, stale, duplicated or missing
+    AUDIT_ACCOUNT,         // account lists disagree with the resting orders
+    AUDIT_EXPIRY,          // expiry wheel counts disagree with the resting orders
+    AUDIT_CROSSED,         // best bid at or above best ask in continuous trading
+    AUDIT_LEVEL_AGGREGATE, // LevelBook quantity or order count differs from the orders
+    AUDIT_VIOLATION_TYPES
+} AuditViolationType;
+
+typedef struct
+{
+    uint32_t type; // AuditViolationType
+    int order_id;  // 0 when not about one order
+    char detail[96];
+} AuditViolation;
+
+typedef struct
+{
+    uint64_t audit;      // the monitor's audit count, this one included; 0 if one-off
+    uint64_t violations; // found; only the first AUDIT_MAX_VIOLATIONS are kept
+    int stored;
+    int resting;         // resting orders checked
+    AuditViolation list[AUDIT_MAX_VIOLATIONS];
+} AuditReport;
+
+typedef struct
+{
+    int order_id;
+    int owner_id;
+    int quantity;
+    char side;
+    uint8_t live;      // handle in use
+    uint8_t tif;       // TimeInForce
+    uint8_t scheduled; // linked into the expiry wheel
+    int heap_index;
+    OrderHandle handle; // as stamped on the order
+    OrderHandle level_prev;
+    OrderHandle level_next;
+    uint64_t sequence;
+    uint64_t key;
+    double price;
+} AuditOrder;
+
+typedef struct
+{
+    OrderHandle head;
+    OrderHandle tail;
+    int count;
+} AuditLevel;
+
+typedef struct
+{
+    char side;
+    int size;
+    int ladder; // dense ladder rather than a heap
+    // heap
+    OrderHandle *handles;
+    uint64_t *keys;
+    int heap_capacity;
+    // ladder
+    AuditLevel *levels;
+    unsigned long long *bitmap;
+    unsigned long long *summary;
+    int num_levels;
+    int bitmap_words;
+    int summary_words;
+    int levels_capacity;
+    int bitmap_capacity;
+    int summary_capacity;
+    int best;
+    int ladder_size;
+    double base_price;
+    double tick_size;
+} AuditSide;
+
+typedef struct
+{
+    int key;
+    int bucket;
+    int old; // found in the bucket array still being rehashed
+    OrderHandle value;
+} AuditMapEntry;
+
+typedef struct
+{
+    int owner_id;
+    int order_count; // as the entry records it
+    int listed;      // orders walked from its list
+    int first;       // its first walked order in account_orders
+} AuditAccount;
+
+typedef struct BookSnapshot
+{
+    TradingPhase phase;
+    AuditOrder *orders; // by handle
+    uint32_t used;
+    uint32_t free_count;
+    int orders_capacity;
+    AuditSide bids;
+    AuditSide asks;
+    AuditMapEntry *map_entries;
+    int map_count;
+    int map_size;
+    int map_capacity;
+    int map_old_capacity; // 0 unless a rehash is in progress
+    int map_rehash_index;
+    int map_entries_capacity;
+    AuditAccount *accounts;
+    int account_count;
+    int accounts_capacity;
+    OrderHandle *account_orders;
+    int account_order_count;
+    int account_orders_capacity;
+    int wheel_scheduled;
+    int wheel_session;
+    int has_levels;
+    MdSide level_bids; // copies of the attached LevelBook
+    MdSide level_asks;
+} BookSnapshot;
+
+typedef void (*AuditHandler)(void *context, const AuditReport *report);
+
+typedef enum
+{
+    AUDIT_IDLE,
+    AUDIT_PENDING,
+    AUDIT_CHECKING,
+    AUDIT_STOPPING
+} AuditMonitorState;
+
+typedef struct
+{
+    OrderBook *book;
+    const LevelBook *levels;
+    int every; // ticks between snapshots
+    int ticks;
+    int max_resting;  // periodic captures skipped above this many resting orders; 0 for no limit
+    uint64_t skipped; // periodic captures skipped for max_resting
+    uint64_t longest_capture_ns;
+    _Atomic int requested; // set from any thread, cleared by the tick that captures
+    BookSnapshot *snapshot;
+    AuditReport last; // newest finished report, under lock
+    uint64_t audits;
+    AuditHandler handler;
+    void *handler_context;
+    _Atomic int state; // AuditMonitorState
+    sem_t wake;        // posted when state leaves IDLE
+    pthread_mutex_t lock; // report and done; never taken by the tick
+    pthread_cond_t done;
+    pthread_t thread;
+} AuditMonitor;
+
+BookSnapshot *create_book_snapshot();
+void free_book_snapshot(BookSnapshot *snapshot);
+// Matching thread: copies book (and levels, if not NULL) into snapshot,
+// reusing its buffers
+void capture_book_snapshot(BookSnapshot *snapshot, OrderBook *book, const LevelBook *levels);
+// Any thread: fills report; returns the violations found
+int audit_snapshot(const BookSnapshot *snapshot, AuditReport *report);
+// On demand, on the matching thread: capture and audit in one call
+int audit_orderbook(OrderBook *book, const LevelBook *levels, AuditReport *report);
+const char *audit_violation_name(AuditViolationType type);
+
+// Starts the auditor thread. levels may be NULL; handler (optional) runs
+// on that thread after each audit. A snapshot is taken every `every`
+// ticks, skipped while the previous one is still being checked
+AuditMonitor *create_audit_monitor(OrderBook *book, const LevelBook *levels, int every,
+                                   AuditHandler handler, void *context);
+// Stops the thread after any audit in progress
+void free_audit_monitor(AuditMonitor *monitor);
+// Matching thread, between book calls: 1 if a snapshot was handed over
+int audit_monitor_tick(AuditMonitor *monitor);
+// Matching thread: skips periodic captures while more than max_resting
+// orders rest (0 for no limit)
+void audit_monitor_limit(AuditMonitor *monitor, int max_resting);
+// Any thread: makes the next tick take a snapshot regardless of the
+// interval and the resting-order limit
+void audit_monitor_request(AuditMonitor *monitor);
+// Copies the newest finished report; 0 if there is none yet
+int audit_monitor_report(AuditMonitor *monitor, AuditReport *out);
+// Blocks until the auditor thread is idle
+void audit_monitor_wait(AuditMonitor *monitor);
+
+#endif
@@ -0,0 +1,108 @@
+#include "pybook.h"
+
+static void on_book_event(void *context, const BookEvent *event)
+{
+    level_book_apply((LevelBook *)context, event);
+}
+
+PyBook *pybook_create()
+{
+    PyBook *pybook = (PyBook *)malloc(sizeof(PyBook));
+    if (!pybook)
+    {
+        fprintf(stderr, "Memory allocation failed for PyBook\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pybook->book = create_orderbook();
+    init_level_book(&pybook->levels);
+    add_book_listener(pybook->book, on_book_event, &pybook->levels);
+
+    return pybook;
+}
+
+void pybook_free(PyBook *pybook)
+{
+    if (!pybook)
+        return;
+
+    free_orderbook(pybook->book);
+    free_level_book(&pybook->levels);
+    free(pybook);
+}
+
+int pybook_submit(PyBook *pybook, int n, const int *ids, const char *sides, const double *prices,
+                  const int *quantities, const double *timestamps, const int *owners, int *status)
+{
+    int accepted = 0;
+    for (int i = 0; i < n; i++)
+    {
+        Order *order = create_owned_order(ids[i], 0, quantities[i], 0, sides[i], owners ? owners[i] : 0);
+        order->price = prices[i];
+        order->timestamp = timestamps[i];
+
+        int result = add_order(pybook->book, order);
+        if (result != 0)
+            free_order(order);
+        else
+            accepted++;
+        if (status)
+            status[i] = result;
+    }
+    return accepted;
+}
+
+int pybook_cancel(PyBook *pybook, int n, const int *ids, int *status)
+{
+    int cancelled = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int result = cancel_order(pybook->book, ids[i]);
+        if (result == 0)
+            cancelled++;
+        if (status)
+            status[i] = result;
+    }
+    return cancelled;
+}
+
+const FilledOrder *pybook_fills(PyBook *pybook, int *count)
+{
+    *count = pybook->book->trade_history_size;
+    return pybook->book->trade_history;
+}
+
+const MdLevel *pybook_levels(PyBook *pybook, char side, int *count)
+{
+    const MdSide *levels = side == 'B' ? &pybook->levels.bids : &pybook->levels.asks;
+    *count = levels->count;
+    return levels->levels;
+}
+
+int pybook_fill_layout(size_t *out)
+{
+    size_t layout[] = {
+        sizeof(FilledOrder),
+        offsetof(FilledOrder, maker_id),
+        offsetof(FilledOrder, taker_id),
+        offsetof(FilledOrder, traded_quantity),
+        offsetof(FilledOrder, maker_leftover),
+        offsetof(FilledOrder, taker_leftover),
+        offsetof(FilledOrder, traded_price),
+        offsetof(FilledOrder, timestamp),
+        offsetof(FilledOrder, taker_side),
+    };
+    int n = sizeof(layout) / sizeof(layout[0]);
+    for (int i = 0; i < n; i++)
+        out[i] = layout[i];
+    return n;
+}
+
+int pybook_level_layout(size_t *out)
+{
+    out[0] = sizeof(MdLevel);
+    out[1] = offsetof(MdLevel, price);
+    out[2] = offsetof(MdLevel, quantity);
+    out[3] = offsetof(MdLevel, orders);
+    return 4;
+}
@@ -0,0 +1,46 @@
+#ifndef PYBOOK_H
+#define PYBOOK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include "orderbook.h"
+#include "marketdata/levelbook.h"
+
+/*
+    Flat, ctypes-friendly API over one OrderBook for prototype/engine.py.
+    Only ints, doubles and pointers cross the boundary. Orders are
+    submitted in batches from parallel arrays, and fills and depth are
+    exposed as pointers into the engine's own arrays so Python can wrap
+    them as NumPy views without copying. A view is valid until the next
+    call that changes the book.
+*/
+
+typedef struct PyBook
+{
+    OrderBook *book;
+    LevelBook levels;
+} PyBook;
+
+PyBook *pybook_create();
+void pybook_free(PyBook *pybook);
+
+// Submits orders i = 0..n-1; owners may be NULL. status[i] (if given)
+// is 0 when accepted and -1 when rejected. Returns the accepted count
+int pybook_submit(PyBook *pybook, int n, const int *ids, const char *sides, const double *prices,
+                  const int *quantities, const double *timestamps, const int *owners, int *status);
+// Cancels orders by id; returns the number cancelled
+int pybook_cancel(PyBook *pybook, int n, const int *ids, int *status);
+
+// Every fill so far, oldest first
+const FilledOrder *pybook_fills(PyBook *pybook, int *count);
+// Price levels of side 'B' or 'S', ordered worst to best
+const MdLevel *pybook_levels(PyBook *pybook, char side, int *count);
+
+// Struct layouts for building matching NumPy dtypes: writes the size
+// followed by each field's offset, in declaration order; returns the
+// number of values written
+int pybook_fill_layout(size_t *out);
+int pybook_level_layout(size_t *out);
+
+#endif
@@ -0,0 +1,151 @@
+#include "accountmap.h"
+
+// Create a new AccountMap
+AccountMap *create_accountmap()
+{
+    AccountMap *map = (AccountMap *)arena_malloc(sizeof(AccountMap));
+    if (!map)
+    {
+        fprintf(stderr, "Memory allocation failed for AccountMap\n");
+        exit(EXIT_FAILURE);
+    }
+
+    map->capacity = INITIAL_CAPACITY;
+    map->size = 0;
+
+    map->buckets = (AccountEntry **)arena_calloc(map->capacity, sizeof(AccountEntry *));
+    if (!map->buckets)
+    {
+        fprintf(stderr, "Memory allocation failed for AccountMap buckets\n");
+        arena_free(map);
+        exit(EXIT_FAILURE);
+    }
+
+    return map;
+}
+
+void free_accountmap(AccountMap *map)
+{
+    if (!map)
+        return;
+
+    for (int i = 0; i < map->capacity; i++)
+    {
+        AccountEntry *entry = map->buckets[i];
+        while (entry)
+        {
+            AccountEntry *next = entry->next;
+            arena_free(entry);
+            entry = next;
+        }
+    }
+
+    arena_free(map->buckets);
+    arena_free(map);
+}
+
+// Rehash every entry into a larger bucket array
+static void accountmap_resize(AccountMap *map, int new_capacity)
+{
+    AccountEntry **buckets = (AccountEntry **)arena_calloc(new_capacity, sizeof(AccountEntry *));
+    if (!buckets)
+    {
+        fprintf(stderr, "Memory allocation failed during resize\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < map->capacity; i++)
+    {
+        AccountEntry *entry = map->buckets[i];
+        while (entry)
+        {
+            AccountEntry *next = entry->next;
+            unsigned int index = hash_function(entry->owner_id, new_capacity);
+            entry->next = buckets[index];
+            buckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    arena_free(map->buckets);
+    map->buckets = buckets;
+    map->capacity = new_capacity;
+}
+
+AccountEntry *accountmap_get(AccountMap *map, int owner_id)
+{
+    if (!map)
+        return NULL;
+
+    AccountEntry *entry = map->buckets[hash_function(owner_id, map->capacity)];
+    while (entry)
+    {
+        if (entry->owner_id == owner_id)
+            return entry;
+        entry = entry->next;
+    }
+
+    return NULL;
+}
+
+AccountEntry *accountmap_get_or_create(AccountMap *map, int owner_id)
+{
+    AccountEntry *entry = accountmap_get(map, owner_id);
+    if (entry)
+        return entry;
+
+    if ((float)map->size / map->capacity >= LOAD_FACTOR_THRESHOLD)
+        accountmap_resize(map, map->capacity * 2);
+
+    entry = (AccountEntry *)arena_calloc(1, sizeof(AccountEntry));
+    if (!entry)
+    {
+        fprintf(stderr, "Memory allocation failed for new account entry\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned int index = hash_function(owner_id, map->capacity);
+    entry->owner_id = owner_id;
+    entry->next = map->buckets[index];
+    map->buckets[index] = entry;
+    map->size++;
+
+    return entry;
+}
+
+void accountmap_link(AccountMap *map, Order *order)
+{
+    if (!map || !order || order->owner_id == 0)
+        return;
+
+    AccountEntry *entry = accountmap_get_or_create(map, order->owner_id);
+    order->account_prev = NULL;
+    order->account_next = entry->orders;
+    if (entry->orders)
+        entry->orders->account_prev = order;
+    entry->orders = order;
+    entry->order_count++;
+}
+
+void accountmap_unlink(AccountMap *map, Order *order)
+{
+    if (!map || !order || order->owner_id == 0)
+        return;
+
+    AccountEntry *entry = accountmap_get(map, order->owner_id);
+    if (!entry)
+        return;
+
+    if (order->account_prev)
+        order->account_prev->account_next = order->account_next;
+    else if (entry->orders == order)
+        entry->orders = order->account_next;
+    else
+        return; // not linked
+    if (order->account_next)
+        order->account_next->account_prev = order->account_prev;
+
+    order->account_prev = NULL;
+    order->account_next = NULL;
+    entry->order_count--;
+}
@@ -0,0 +1,36 @@
+#ifndef ACCOUNTMAP_H
+#define ACCOUNTMAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include "order.h"
+#include "ordermap.h"
+
+typedef struct AccountEntry
+{
+    int owner_id;
+    Order *orders;            // intrusive list of the account's resting orders
+    int order_count;
+    int cancel_on_disconnect; // mass cancel the account when its session drops
+    struct AccountEntry *next; // for handling collisions
+} AccountEntry;
+
+typedef struct AccountMap
+{
+    AccountEntry **buckets;
+    int capacity;
+    int size;
+} AccountMap;
+
+AccountMap *create_accountmap();
+// Frees the entries only; orders are owned by the book
+void free_accountmap(AccountMap *map);
+AccountEntry *accountmap_get(AccountMap *map, int owner_id);
+AccountEntry *accountmap_get_or_create(AccountMap *map, int owner_id);
+// Links/unlinks an order into its owner's list; anonymous orders are ignored
+void accountmap_link(AccountMap *map, Order *order);
+void accountmap_unlink(AccountMap *map, Order *order);
+
+#endif
@@ -0,0 +1,403 @@
+#define _GNU_SOURCE
+
+#include "arena.h"
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+#define ARENA_MIN_CLASS 5            // 32 byte blocks
+#define ARENA_MAX_ALIGNMENT 4096     // larger alignments go to malloc
+#define MALLOC_ALIGNMENT 16          // what malloc guarantees
+
+static _Thread_local Arena *current_arena;
+
+// Live arenas by address range, for frees of blocks whose arena is not
+// the caller's current one. Changed under registry_lock and read under
+// registry_version, odd while a change is in progress
+typedef struct
+{
+    _Atomic(uintptr_t) start;
+    _Atomic(uintptr_t) end;
+    _Atomic(Arena *) arena;
+} ArenaRange;
+
+static ArenaRange registry[ARENA_MAX_ARENAS];
+static _Atomic int registry_count;
+static _Atomic uint64_t registry_version;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static size_t normal_page_size()
+{
+#ifdef __linux__
+    return (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+static size_t huge_page_size(ArenaPages pages)
+{
+    return pages == ARENA_PAGES_1G ? (size_t)1 << 30 : pages == ARENA_PAGES_2M ? (size_t)2 << 20 : normal_page_size();
+}
+
+// Maps size bytes from the largest pages available up to arena->pages
+static int map_arena(Arena *arena, size_t size)
+{
+#ifdef __linux__
+    for (ArenaPages pages = arena->pages; pages > ARENA_PAGES_NORMAL; pages--)
+    {
+        size_t page_size = huge_page_size(pages);
+        int shift = pages == ARENA_PAGES_1G ? 30 : 21;
+        size_t length = round_up(size, page_size);
+        void *base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+        if (base != MAP_FAILED)
+        {
+            arena->base = (char *)base;
+            arena->size = length;
+            arena->page_size = page_size;
+            arena->pages = pages;
+            return 0;
+        }
+    }
+
+    // no reserved huge pages: normal pages, promoted by the kernel if it can
+    size_t length = round_up(size, normal_page_size());
+    void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return -1;
+#ifdef MADV_HUGEPAGE
+    madvise(base, length, MADV_HUGEPAGE);
+#endif
+#else
+    size_t length = round_up(size, normal_page_size());
+    void *base = aligned_alloc(normal_page_size(), length);
+    if (!base)
+        return -1;
+#endif
+    arena->base = (char *)base;
+    arena->size = length;
+    arena->page_size = normal_page_size();
+    arena->pages = ARENA_PAGES_NORMAL;
+    return 0;
+}
+
+static void unmap_arena(Arena *arena)
+{
+#ifdef __linux__
+    munmap(arena->base, arena->size);
+#else
+    free(arena->base);
+#endif
+}
+
+static int register_arena(Arena *arena)
+{
+    pthread_mutex_lock(&registry_lock);
+    int count = atomic_load_explicit(&registry_count, memory_order_relaxed);
+    int slot = 0;
+    while (slot < count && atomic_load_explicit(&registry[slot].arena, memory_order_relaxed))
+        slot++;
+    if (slot == ARENA_MAX_ARENAS)
+    {
+        pthread_mutex_unlock(&registry_lock);
+        return -1;
+    }
+
+    atomic_fetch_add_explicit(&registry_version, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&registry[slot].start, (uintptr_t)arena->base, memory_order_relaxed);
+    atomic_store_explicit(&registry[slot].end, (uintptr_t)arena->base + arena->size, memory_order_relaxed);
+    atomic_store_explicit(&registry[slot].arena, arena, memory_order_relaxed);
+    if (slot == count)
+        atomic_store_explicit(&registry_count, count + 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&registry_version, 1, memory_order_release);
+    pthread_mutex_unlock(&registry_lock);
+    return 0;
+}
+
+static void unregister_arena(Arena *arena)
+{
+    pthread_mutex_lock(&registry_lock);
+    int count = atomic_load_explicit(&registry_count, memory_order_relaxed);
+    for (int slot = 0; slot < count; slot++)
+    {
+        if (atomic_load_explicit(&registry[slot].arena, memory_order_relaxed) != arena)
+            continue;
+        atomic_fetch_add_explicit(&registry_version, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&registry[slot].start, 0, memory_order_relaxed);
+        atomic_store_explicit(&registry[slot].end, 0, memory_order_relaxed);
+        atomic_store_explicit(&registry[slot].arena, NULL, memory_order_relaxed);
+        atomic_fetch_add_explicit(&registry_version, 1, memory_order_release);
+        break;
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static int in_arena(const Arena *arena, const void *ptr)
+{
+    return (const char *)ptr >= arena->base && (const char *)ptr < arena->base + arena->size;
+}
+
+// The arena ptr was carved from, or NULL if malloc served it
+static Arena *arena_of(const void *ptr)
+{
+    if (current_arena && in_arena(current_arena, ptr))
+        return current_arena;
+
+    uintptr_t address = (uintptr_t)ptr;
+    for (;;)
+    {
+        uint64_t version = atomic_load_explicit(&registry_version, memory_order_acquire);
+        if (version & 1)
+            continue;
+
+        Arena *found = NULL;
+        int count = atomic_load_explicit(&registry_count, memory_order_relaxed);
+        for (int slot = 0; slot < count && !found; slot++)
+            if (address >= atomic_load_explicit(&registry[slot].start, memory_order_relaxed) &&
+                address < atomic_load_explicit(&registry[slot].end, memory_order_relaxed))
+                found = atomic_load_explicit(&registry[slot].arena, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&registry_version, memory_order_relaxed) == version)
+            return found;
+    }
+}
+
+Arena *create_arena(size_t size, ArenaPages pages, int prefault)
+{
+    if (size == 0 || pages < ARENA_PAGES_NORMAL || pages > ARENA_PAGES_1G)
+        return NULL;
+
+    Arena *arena = (Arena *)calloc(1, sizeof(Arena));
+    if (!arena)
+    {
+        fprintf(stderr, "Memory allocation failed for Arena\n");
+        exit(EXIT_FAILURE);
+    }
+    arena->pages = pages;
+    if (map_arena(arena, size) != 0)
+    {
+        free(arena);
+        return NULL;
+    }
+
+    arena->page_classes = (uint8_t *)calloc(arena->size >> ARENA_PAGE_SHIFT, 1);
+    if (!arena->page_classes)
+    {
+        fprintf(stderr, "Memory allocation failed for arena page classes\n");
+        exit(EXIT_FAILURE);
+    }
+    if (register_arena(arena) != 0)
+    {
+        fprintf(stderr, "More than %d arenas live\n", ARENA_MAX_ARENAS);
+        unmap_arena(arena);
+        free(arena->page_classes);
+        free(arena);
+        return NULL;
+    }
+
+    if (prefault)
+    {
+        // volatile so the stores are not elided; one per normal page also
+        // backs every huge page
+        volatile char *bytes = (volatile char *)arena->base;
+        size_t stride = normal_page_size();
+        for (size_t offset = 0; offset < arena->size; offset += stride)
+            bytes[offset] = 0;
+    }
+    return arena;
+}
+
+void free_arena(Arena *arena)
+{
+    if (!arena)
+        return;
+    if (current_arena == arena)
+        current_arena = NULL;
+    unregister_arena(arena);
+    unmap_arena(arena);
+    free(arena->page_classes);
+    free(arena);
+}
+
+Arena *arena_set_current(Arena *arena)
+{
+    Arena *previous = current_arena;
+    current_arena = arena;
+    return previous;
+}
+
+Arena *arena_current()
+{
+    return current_arena;
+}
+
+size_t arena_remaining(const Arena *arena)
+{
+    return arena ? arena->size - arena->used : 0;
+}
+
+int arena_owns(const Arena *arena, const void *ptr)
+{
+    return arena && ptr && in_arena(arena, ptr);
+}
+
+static void *allocate_system(size_t size, size_t alignment)
+{
+    if (alignment <= MALLOC_ALIGNMENT)
+        return malloc(size);
+    if (size > SIZE_MAX - alignment)
+        return NULL;
+    return aligned_alloc(alignment, round_up(size ? size : 1, alignment));
+}
+
+static size_t page_index(const Arena *arena, const void *block)
+{
+    return (size_t)((const char *)block - arena->base) >> ARENA_PAGE_SHIFT;
+}
+
+// Takes whole pages off the end of the carved region
+static char *take_pages(Arena *arena, size_t bytes)
+{
+    if (arena->size - arena->used < bytes)
+        return NULL;
+    char *start = arena->base + arena->used;
+    arena->used += bytes;
+    return start;
+}
+
+// A new block of size_class: classes under a page are cut from the
+// class's current page, larger ones take whole pages. Either way a
+// block is aligned to its size, up to a page
+static void *carve(Arena *arena, uint32_t size_class)
+{
+    size_t block_size = (size_t)1 << size_class;
+    if (block_size >= ARENA_PAGE_SIZE)
+    {
+        char *block = take_pages(arena, block_size);
+        if (block)
+            arena->page_classes[page_index(arena, block)] = (uint8_t)size_class;
+        return block;
+    }
+
+    if (arena->carve_next[size_class] == arena->carve_end[size_class])
+    {
+        char *page = take_pages(arena, ARENA_PAGE_SIZE);
+        if (!page)
+            return NULL;
+        arena->page_classes[page_index(arena, page)] = (uint8_t)size_class;
+        arena->carve_next[size_class] = page;
+        arena->carve_end[size_class] = page + ARENA_PAGE_SIZE;
+    }
+    char *block = arena->carve_next[size_class];
+    arena->carve_next[size_class] += block_size;
+    return block;
+}
+
+// alignment is a power of two; blocks of a class at least that large
+// are aligned to it
+static void *allocate(Arena *arena, size_t size, size_t alignment)
+{
+    if (!arena || alignment > ARENA_MAX_ALIGNMENT)
+        return allocate_system(size, alignment);
+    if (size > (size_t)1 << (ARENA_CLASSES - 1))
+    {
+        arena->overflows++;
+        return allocate_system(size, alignment);
+    }
+
+    uint32_t size_class = ARENA_MIN_CLASS;
+    while (((size_t)1 << size_class) < size || ((size_t)1 << size_class) < alignment)
+        size_class++;
+
+    void *block = arena->free_lists[size_class];
+    if (block)
+        arena->free_lists[size_class] = *(void **)block;
+    else if (!(block = carve(arena, size_class)))
+    {
+        arena->overflows++;
+        return allocate_system(size, alignment);
+    }
+    arena->allocations++;
+    return block;
+}
+
+void *arena_malloc(size_t size)
+{
+    return allocate(current_arena, size, MALLOC_ALIGNMENT);
+}
+
+void *arena_calloc(size_t count, size_t size)
+{
+    if (size && count > SIZE_MAX / size)
+        return NULL;
+    void *ptr = allocate(current_arena, count * size, MALLOC_ALIGNMENT);
+    if (ptr)
+        memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void *arena_aligned_alloc(size_t alignment, size_t size)
+{
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+        return NULL;
+    return allocate(current_arena, size, alignment > MALLOC_ALIGNMENT ? alignment : MALLOC_ALIGNMENT);
+}
+
+void *arena_realloc(void *ptr, size_t size)
+{
+    if (!ptr)
+        return arena_malloc(size);
+
+    Arena *arena = arena_of(ptr);
+    if (!arena)
+        return realloc(ptr, size);
+
+    size_t usable = (size_t)1 << arena->page_classes[page_index(arena, ptr)];
+    if (size <= usable)
+        return ptr;
+    // a block is aligned to its class size, up to a page; the larger
+    // block keeps that even if it has to come from malloc
+    size_t alignment = usable < ARENA_MAX_ALIGNMENT ? usable : ARENA_MAX_ALIGNMENT;
+
+    // grows within the block's own arena
+    void *resized = allocate(arena, size, alignment);
+    if (!resized)
+        return NULL;
+    memcpy(resized, ptr, usable < size ? usable : size);
+    arena_free(ptr);
+    return resized;
+}
+
+void arena_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    Arena *arena = arena_of(ptr);
+    if (!arena)
+    {
+        free(ptr);
+        return;
+    }
+    uint32_t size_class = arena->page_classes[page_index(arena, ptr)];
+    *(void **)ptr = arena->free_lists[size_class];
+    arena->free_lists[size_class] = ptr;
+}
@@ -0,0 +1,82 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+    Reserved memory for a book's structures. An arena maps its whole
+    size up front, from 1 GiB or 2 MiB huge pages when the system has
+    them reserved and from normal pages (advised for transparent huge
+    pages) otherwise, and can prefault every page at creation so trading
+    never takes a first-touch fault.
+
+    Blocks come in power-of-two size classes carved from the reservation,
+    each class with a free list, so orders and map entries are recycled
+    in O(1) and growing arrays reuse their old blocks. Blocks carry no
+    header: the reservation is handed out in 4 KiB pages, each holding
+    blocks of one class (or starting one larger block), and a table with
+    a byte per page records the class. A 128 byte Order takes exactly 128
+    bytes and a power-of-two array exactly its size.
+
+    The core allocates through arena_malloc and friends, which serve the
+    calling thread's current arena and fall back to malloc without one
+    or once it is full. arena_free tells the two apart by address: the
+    current arena first, then a registry of every live arena. An arena
+    is not thread-safe: its blocks are allocated and freed on the thread
+    that made it current.
+*/
+
+typedef enum
+{
+    ARENA_PAGES_NORMAL, // 4 KiB pages, transparent huge pages advised
+    ARENA_PAGES_2M,
+    ARENA_PAGES_1G
+} ArenaPages;
+
+#define ARENA_CLASSES 48
+#define ARENA_PAGE_SHIFT 12 // class table granularity
+#define ARENA_PAGE_SIZE ((size_t)1 << ARENA_PAGE_SHIFT)
+#define ARENA_MAX_ARENAS 64 // live at once
+
+typedef struct Arena
+{
+    char *base;
+    size_t size;      // bytes reserved
+    size_t used;      // bytes carved into blocks so far
+    size_t page_size; // page size actually obtained
+    ArenaPages pages; // as obtained; may be smaller than requested
+    void *free_lists[ARENA_CLASSES];
+    uint8_t *page_classes; // size class of the blocks in each page
+    char *carve_next[ARENA_CLASSES]; // classes under a page share one page at a time
+    char *carve_end[ARENA_CLASSES];
+    uint64_t allocations;
+    uint64_t overflows; // requests malloc served because the arena was full
+} Arena;
+
+// Reserves size bytes (rounded up to the page size) from the largest
+// pages available up to `pages`; NULL if nothing could be mapped or
+// ARENA_MAX_ARENAS are already live
+Arena *create_arena(size_t size, ArenaPages pages, int prefault);
+// Unmaps the arena; its blocks must no longer be in use
+void free_arena(Arena *arena);
+// Makes arena (or NULL for malloc) serve the calling thread's
+// allocations; returns the previous one
+Arena *arena_set_current(Arena *arena);
+Arena *arena_current();
+// Bytes of the reservation still to be carved
+size_t arena_remaining(const Arena *arena);
+// 1 if ptr was served by arena
+int arena_owns(const Arena *arena, const void *ptr);
+
+void *arena_malloc(size_t size);
+void *arena_calloc(size_t count, size_t size);
+// Keeps an arena block's alignment; blocks from malloc get realloc's
+void *arena_realloc(void *ptr, size_t size);
+// alignment is a power of two
+void *arena_aligned_alloc(size_t alignment, size_t size);
+void arena_free(void *ptr);
+
+#endif
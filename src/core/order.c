@@ -2,37 +2,90 @@
 
 Order *create_order(int order_id, int price, int quantity, int timestamp, char side)
 {
-    Order *order = (Order *)malloc(sizeof(Order));
+    return create_owned_order(order_id, price, quantity, timestamp, side, 0);
+}
+
+Order *create_owned_order(int order_id, int price, int quantity, int timestamp, char side, int owner_id)
+{
+    Order *order = (Order *)arena_malloc(sizeof(Order));
     order->order_id = order_id;
     order->price = price;
     order->quantity = quantity;
     order->timestamp = timestamp;
     order->side = side;
+    order->owner_id = owner_id;
+    order->handle = INVALID_HANDLE;
+    order->sequence = 0;
+    order->level_prev = NULL;
+    order->level_next = NULL;
+    order->tif = TIF_GTC;
+    order->expire_time = 0;
+    order->timer_prev = NULL;
+    order->timer_next = NULL;
+    order->timer_slot = NULL;
+    order->account_prev = NULL;
+    order->account_next = NULL;
 
     return order;
 }
 
+Order *copy_order(Order *order)
+{
+    if (order == NULL)
+        return NULL;
+
+    Order *copy = (Order *)arena_malloc(sizeof(Order));
+    if (!copy)
+    {
+        fprintf(stderr, "Memory allocation failed for Order copy\n");
+        exit(EXIT_FAILURE);
+    }
+    *copy = *order;
+    // the copy is not resting or scheduled anywhere
+    copy->handle = INVALID_HANDLE;
+    copy->sequence = 0;
+    copy->level_prev = NULL;
+    copy->level_next = NULL;
+    copy->timer_prev = NULL;
+    copy->timer_next = NULL;
+    copy->timer_slot = NULL;
+    copy->account_prev = NULL;
+    copy->account_next = NULL;
+
+    return copy;
+}
+
+void set_time_in_force(Order *order, TimeInForce tif, long long expire_time)
+{
+    if (order == NULL)
+        return;
+
+    order->tif = tif;
+    order->expire_time = expire_time;
+}
+
 void print_order(Order *order)
 {
-    printf("Order ID: %d || Price: %d || Quantity: %d || Timestamp: %d || Side: %c\n", order->order_id, order->price, order->quantity, order->timestamp, order->side);
+    printf("Order ID: %d || Price: %.2f || Quantity: %d || Timestamp: %.0f || Side: %c\n", order->order_id, order->price, order->quantity, order->timestamp, order->side);
 }
 
 void free_order(Order *order)
 {
     if (order == NULL)
         return;
-    free(order);
+    arena_free(order);
     order = NULL;
     return;
 }
 
+// Price, then arrival sequence: caller timestamps never decide priority
 int compare_buy_orders(Order *order1, Order *order2)
 {
     if (order1->price > order2->price)
         return -1;
-    else if (order1->price == order2->price && order1->timestamp < order2->timestamp)
+    else if (order1->price == order2->price && order1->sequence < order2->sequence)
         return -1;
-    else if (order1->price == order2->price && order1->timestamp == order2->timestamp)
+    else if (order1->price == order2->price && order1->sequence == order2->sequence)
         return 0;
     else
         return 1;
@@ -42,9 +95,9 @@ int compare_sell_orders(Order *order1, Order *order2)
 {
     if (order1->price < order2->price)
         return -1;
-    else if (order1->price == order2->price && order1->timestamp < order2->timestamp)
+    else if (order1->price == order2->price && order1->sequence < order2->sequence)
         return -1;
-    else if (order1->price == order2->price && order1->timestamp == order2->timestamp)
+    else if (order1->price == order2->price && order1->sequence == order2->sequence)
         return 0;
     else
         return 1;
@@ -5,6 +5,19 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
+#include <stdint.h>
+#include "arena.h"
+
+// 32-bit index of an order in its book's OrderTable
+typedef uint32_t OrderHandle;
+#define INVALID_HANDLE UINT32_MAX
+
+typedef enum
+{
+    TIF_GTC, // good till cancelled
+    TIF_DAY, // expires at session end
+    TIF_GTT  // good till expire_time
+} TimeInForce;
 
 typedef struct Order
 {
@@ -12,10 +25,28 @@ typedef struct Order
     double price;
     int quantity;
     double timestamp;
-    char side; // 'B' for "buy", 'S' for "sell"
+    char side;    // 'B' for "buy", 'S' for "sell"
+    int owner_id; // owning account/firm; 0 means anonymous (no self-trade checks)
+    OrderHandle handle; // slot in the book's OrderTable, INVALID_HANDLE when not in a book
+    unsigned long long sequence; // arrival order within the book; breaks price ties
+    // intrusive price ladder level links
+    struct Order *level_prev;
+    struct Order *level_next;
+    // expiry scheduling
+    TimeInForce tif;
+    long long expire_time;     // GTT expiry in expiry-clock ticks
+    struct Order *timer_prev;  // intrusive expiry list links
+    struct Order *timer_next;
+    struct Order **timer_slot; // list head the order is linked into, NULL if unscheduled
+    // intrusive per-account list links
+    struct Order *account_prev;
+    struct Order *account_next;
 } Order;
 
 Order *create_order(int order_id, int price, int quantity, int timestamp, char side);
+Order *create_owned_order(int order_id, int price, int quantity, int timestamp, char side, int owner_id);
+Order *copy_order(Order *order);
+void set_time_in_force(Order *order, TimeInForce tif, long long expire_time);
 void print_order(Order *order);
 void free_order(Order *order);
 int compare_buy_orders(Order *order1, Order *order2);
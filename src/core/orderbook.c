@@ -1,24 +1,32 @@
 #include "orderbook.h"
+#include "matching/matcher.h"
 
 #define INITIAL_HISTORY_CAPACITY 100
+#define INITIAL_SIDE_CAPACITY 64
+
+static OrderHeap *side_heap(OrderBook *orderbook, char side)
+{
+    return side == 'B' ? orderbook->buy_orders : orderbook->sell_orders;
+}
 
 OrderBook *create_orderbook()
 {
-    OrderBook *orderbook = (OrderBook *)malloc(sizeof(OrderBook));
+    OrderBook *orderbook = (OrderBook *)arena_malloc(sizeof(OrderBook));
     if (!orderbook)
     {
         fprintf(stderr, "Memory allocation failed for OrderBook\n");
         exit(EXIT_FAILURE);
     }
 
-    orderbook->buy_orders = createOrderHeap(50, BUY_HEAP);
-    orderbook->sell_orders = createOrderHeap(50, SELL_HEAP);
+    orderbook->order_table = create_order_table(64);
+    orderbook->buy_orders = createOrderHeap(INITIAL_SIDE_CAPACITY, BUY_HEAP, orderbook->order_table);
+    orderbook->sell_orders = createOrderHeap(INITIAL_SIDE_CAPACITY, SELL_HEAP, orderbook->order_table);
 
-    orderbook->order_map = create_ordermap();
+    orderbook->order_map = create_ordermap(orderbook->order_table);
 
     orderbook->trade_history_capacity = INITIAL_HISTORY_CAPACITY;
     orderbook->trade_history_size = 0;
-    orderbook->trade_history = (Order **)malloc(INITIAL_HISTORY_CAPACITY * sizeof(Order *));
+    orderbook->trade_history = (FilledOrder *)arena_malloc(INITIAL_HISTORY_CAPACITY * sizeof(FilledOrder));
     if (!orderbook->trade_history)
     {
         fprintf(stderr, "Memory allocation failed for trade history\n");
@@ -27,13 +35,20 @@ OrderBook *create_orderbook()
 
     orderbook->price_history_capacity = INITIAL_HISTORY_CAPACITY;
     orderbook->price_history_size = 0;
-    orderbook->price_history = (double *)malloc(INITIAL_HISTORY_CAPACITY * sizeof(double));
+    orderbook->price_history = (double *)arena_malloc(INITIAL_HISTORY_CAPACITY * sizeof(double));
     if (!orderbook->price_history)
     {
         fprintf(stderr, "Memory allocation failed for price history\n");
         exit(EXIT_FAILURE);
     }
 
+    orderbook->stp_mode = STP_NONE;
+    orderbook->phase = PHASE_CONTINUOUS;
+    orderbook->policy = price_time_policy();
+    orderbook->expiry_wheel = create_timing_wheel(0);
+    orderbook->account_map = create_accountmap();
+    orderbook->listener_count = 0;
+
     return orderbook;
 }
 
@@ -42,36 +57,30 @@ void free_orderbook(OrderBook *orderbook)
     if (!orderbook)
         return;
 
-    // Note: The orders themselves are managed by the order_map
-    if (orderbook->buy_orders)
-    {
-        free(orderbook->buy_orders->arr);
-        free(orderbook->buy_orders);
-    }
-
-    if (orderbook->sell_orders)
-    {
-        free(orderbook->sell_orders->arr);
-        free(orderbook->sell_orders);
-    }
+    // Note: The orders themselves are managed by the order_table
+    freeOrderHeap(orderbook->buy_orders);
+    freeOrderHeap(orderbook->sell_orders);
 
+    free_timing_wheel(orderbook->expiry_wheel);
+    free_accountmap(orderbook->account_map);
     free_ordermap(orderbook->order_map);
+    free_order_table(orderbook->order_table);
 
     if (orderbook->trade_history)
-        free(orderbook->trade_history);
+        arena_free(orderbook->trade_history);
 
     if (orderbook->price_history)
-        free(orderbook->price_history);
+        arena_free(orderbook->price_history);
 
-    free(orderbook);
+    arena_free(orderbook);
 }
 
 // Helper function to expand trade history capacity
 static void expand_trade_history(OrderBook *orderbook)
 {
     int new_capacity = orderbook->trade_history_capacity * 2;
-    Order **new_history = (Order **)realloc(orderbook->trade_history,
-                                            new_capacity * sizeof(Order *));
+    FilledOrder *new_history = (FilledOrder *)arena_realloc(orderbook->trade_history,
+                                                      new_capacity * sizeof(FilledOrder));
     if (!new_history)
     {
         fprintf(stderr, "Memory reallocation failed for trade history\n");
@@ -86,7 +95,7 @@ static void expand_trade_history(OrderBook *orderbook)
 static void expand_price_history(OrderBook *orderbook)
 {
     int new_capacity = orderbook->price_history_capacity * 2;
-    double *new_history = (double *)realloc(orderbook->price_history,
+    double *new_history = (double *)arena_realloc(orderbook->price_history,
                                             new_capacity * sizeof(double));
     if (!new_history)
     {
@@ -98,47 +107,420 @@ static void expand_price_history(OrderBook *orderbook)
     orderbook->price_history_capacity = new_capacity;
 }
 
-// Helper function to record a trade
-static void record_trade(OrderBook *orderbook, Order *order, double price)
+// Record a trade and its price
+void record_trade(OrderBook *orderbook, const FilledOrder *fill)
 {
     if (orderbook->trade_history_size >= orderbook->trade_history_capacity)
     {
         expand_trade_history(orderbook);
     }
 
-    orderbook->trade_history[orderbook->trade_history_size++] = order;
+    orderbook->trade_history[orderbook->trade_history_size++] = *fill;
 
     if (orderbook->price_history_size >= orderbook->price_history_capacity)
     {
         expand_price_history(orderbook);
     }
 
-    orderbook->price_history[orderbook->price_history_size++] = price;
+    orderbook->price_history[orderbook->price_history_size++] = fill->traded_price;
 }
 
-void add_order(OrderBook *orderbook, Order *order)
+int add_book_listener(OrderBook *orderbook, BookListener listener, void *context)
 {
-    if (!orderbook || !order)
+    if (!orderbook || !listener || orderbook->listener_count == MAX_BOOK_LISTENERS)
+        return -1;
+
+    orderbook->listeners[orderbook->listener_count] = listener;
+    orderbook->listener_contexts[orderbook->listener_count] = context;
+    orderbook->listener_count++;
+    return 0;
+}
+
+void remove_book_listener(OrderBook *orderbook, BookListener listener, void *context)
+{
+    if (!orderbook)
         return;
 
-    ordermap_put(orderbook->order_map, order->order_id, order);
+    for (int i = 0; i < orderbook->listener_count; i++)
+    {
+        if (orderbook->listeners[i] == listener && orderbook->listener_contexts[i] == context)
+        {
+            orderbook->listener_count--;
+            orderbook->listeners[i] = orderbook->listeners[orderbook->listener_count];
+            orderbook->listener_contexts[i] = orderbook->listener_contexts[orderbook->listener_count];
+            return;
+        }
+    }
+}
 
-    if (order->side == 'B')
+void notify_book_event(OrderBook *orderbook, const BookEvent *event)
+{
+    for (int i = 0; i < orderbook->listener_count; i++)
+        orderbook->listeners[i](orderbook->listener_contexts[i], event);
+}
+
+static void notify_order_event(OrderBook *orderbook, BookEventType type, const Order *order)
+{
+    if (orderbook->listener_count == 0)
+        return;
+
+    BookEvent event = {type, order, NULL, order->quantity, NULL};
+    notify_book_event(orderbook, &event);
+}
+
+// Advances the incremental doubling of the side and the order table by one
+// step. Runs after the order has been handled; each starts doubling once
+// three quarters full and copies a bounded number of entries per add, so
+// it switches to the larger arrays long before an add could find it full.
+// The order map rehashes the same way, a few buckets per put, so no add
+// pays for an O(n) copy or rehash.
+static void ensure_headroom(OrderBook *orderbook, OrderHeap *heap)
+{
+    growOrderHeap(heap);
+    order_table_grow(orderbook->order_table);
+}
+
+// The key rank bits are about to wrap: compact the ranks of the resting
+// orders so new arrivals still sort behind them
+static void rebase_order_keys(OrderBook *orderbook)
+{
+    int buys = rebaseOrderKeys(orderbook->buy_orders);
+    int sells = rebaseOrderKeys(orderbook->sell_orders);
+    orderbook->order_table->next_rank = buys > sells ? buys : sells;
+}
+
+// Checks everything about an order except its id; 0 if it may rest
+static int validate_order(OrderBook *orderbook, Order *order)
+{
+    if (order->side != 'B' && order->side != 'S')
     {
-        insertOrderHeap(orderbook->buy_orders, order);
+        fprintf(stderr, "Invalid order side: %c\n", order->side);
+        return -1;
     }
-    else if (order->side == 'S')
+    if (order->quantity <= 0 || order->price < 0 || order->price > ORDER_KEY_MAX_PRICE)
     {
-        insertOrderHeap(orderbook->sell_orders, order);
+        fprintf(stderr, "Invalid order %d: quantity %d, price %.2f\n",
+                order->order_id, order->quantity, order->price);
+        return -1;
     }
-    else
+    if (!order_key_on_grid(order->price))
     {
-        fprintf(stderr, "Invalid order side: %c\n", order->side);
+        fprintf(stderr, "Order %d price %f is finer than the book's precision\n", order->order_id, order->price);
+        return -1;
+    }
+    OrderHeap *heap = side_heap(orderbook, order->side);
+    if (heap->ladder && !ladder_on_tick(heap->ladder, order->price))
+    {
+        fprintf(stderr, "Order %d price %.2f is off tick\n", order->order_id, order->price);
+        return -1;
+    }
+    if (heap->ladder && !ladder_fits(heap->ladder, order->price))
+    {
+        fprintf(stderr, "Order %d price %.2f is out of the ladder's reach\n", order->order_id, order->price);
+        return -1;
+    }
+    if (order->tif == TIF_GTT && order->expire_time <= orderbook->expiry_wheel->now)
+    {
+        fprintf(stderr, "Order %d already expired\n", order->order_id);
+        return -1;
+    }
+    return 0;
+}
+
+int add_order(OrderBook *orderbook, Order *order)
+{
+    if (!orderbook || !order)
+        return -1;
+
+    // Rejected orders remain owned by the caller
+    if (validate_order(orderbook, order) != 0)
+        return -1;
+    if (ordermap_contains(orderbook->order_map, order->order_id))
+    {
+        fprintf(stderr, "Duplicate order id: %d\n", order->order_id);
+        return -1;
+    }
+    OrderHeap *heap = side_heap(orderbook, order->side);
+
+    if (orderbook->order_table->next_rank > ORDER_KEY_RANK_MASK)
+        rebase_order_keys(orderbook);
+    order_table_add(orderbook->order_table, order);
+    ordermap_put(orderbook->order_map, order->order_id, order);
+
+    insertOrderHeap(heap, order);
+
+    timing_wheel_schedule(orderbook->expiry_wheel, order);
+    accountmap_link(orderbook->account_map, order);
+    notify_order_event(orderbook, BOOK_EVENT_ADD, order);
+
+    // Try to match orders and execute trades; auctions only match at uncross
+    if (orderbook->phase == PHASE_CONTINUOUS)
+        match_orderbook(orderbook);
+
+    ensure_headroom(orderbook, heap);
+
+    return 0;
+}
+
+static void cancel_resting(OrderBook *orderbook, Order *order)
+{
+    removeOrder(side_heap(orderbook, order->side), order);
+    release_order(orderbook, order);
+}
+
+void release_order(OrderBook *orderbook, Order *order)
+{
+    if (!orderbook || !order)
         return;
+
+    notify_order_event(orderbook, BOOK_EVENT_REMOVE, order);
+    timing_wheel_remove(orderbook->expiry_wheel, order);
+    accountmap_unlink(orderbook->account_map, order);
+    ordermap_remove(orderbook->order_map, order->order_id);
+    order_table_remove(orderbook->order_table, order->handle);
+    free_order(order);
+}
+
+int cancel_order(OrderBook *orderbook, int order_id)
+{
+    if (!orderbook)
+        return -1;
+
+    // every mapped order is resting
+    Order *order = ordermap_get(orderbook->order_map, order_id);
+    if (!order)
+        return -1;
+
+    cancel_resting(orderbook, order);
+
+    return 0;
+}
+
+int modify_order(OrderBook *orderbook, int order_id, double new_price, int new_quantity)
+{
+    if (!orderbook)
+        return -1;
+
+    Order *order = ordermap_get(orderbook->order_map, order_id);
+    if (!order || new_quantity <= 0)
+        return -1;
+
+    // Reducing size at the same price keeps time priority
+    if (new_price == order->price && new_quantity <= order->quantity)
+    {
+        int reduced = order->quantity - new_quantity;
+        if (reduced > 0)
+        {
+            order->quantity = new_quantity;
+            if (orderbook->listener_count > 0)
+            {
+                BookEvent event = {BOOK_EVENT_REDUCE, order, NULL, reduced, NULL};
+                notify_book_event(orderbook, &event);
+            }
+        }
+        return 0;
+    }
+
+    // Anything else is a cancel/replace that joins the back of the queue
+    Order *replacement = copy_order(order);
+    replacement->price = new_price;
+    replacement->quantity = new_quantity;
+    if (validate_order(orderbook, replacement) != 0)
+    {
+        free_order(replacement);
+        return -1;
+    }
+
+    cancel_resting(orderbook, order);
+    return add_order(orderbook, replacement);
+}
+
+// Cancels a chain of orders already unlinked from the expiry wheel
+static int cancel_expired(OrderBook *orderbook, Order *expired)
+{
+    int count = 0;
+    while (expired)
+    {
+        Order *next = expired->timer_next;
+        expired->timer_next = NULL;
+        if (cancel_order(orderbook, expired->order_id) == 0)
+            count++;
+        expired = next;
+    }
+    return count;
+}
+
+int expire_orders(OrderBook *orderbook, long long now)
+{
+    if (!orderbook)
+        return 0;
+
+    return cancel_expired(orderbook, timing_wheel_advance(orderbook->expiry_wheel, now));
+}
+
+int expire_day_orders(OrderBook *orderbook)
+{
+    if (!orderbook)
+        return 0;
+
+    return cancel_expired(orderbook, timing_wheel_expire_session(orderbook->expiry_wheel));
+}
+
+static int mass_cancel_matches(const MassCancelFilter *filter, Order *order)
+{
+    if (filter->side && order->side != filter->side)
+        return 0;
+    if (filter->outside_range && order->price >= filter->low && order->price <= filter->high)
+        return 0;
+    return 1;
+}
+
+// Clears one side without an owner filter, working inward from its ends
+// so the cost follows the orders removed. Without a range the heap gives
+// up its last slot each time, which never sifts. With one, the best end
+// is cancelled from the top down to the range; a ladder's worst end is
+// walked up level by level the same way, while a heap cannot reach its
+// worst prices without a pass over the side
+static int mass_cancel_side(OrderBook *orderbook, OrderHeap *heap, const MassCancelFilter *filter)
+{
+    int count = 0;
+
+    if (!filter->outside_range)
+    {
+        while (heap->size > 0)
+        {
+            cancel_resting(orderbook, heap->ladder ? ladder_worst(heap->ladder)
+                                                   : heap->table->orders[heap->arr[heap->size - 1]]);
+            count++;
+        }
+        return count;
+    }
+
+    // everything left once the top is inside the range, or nothing when
+    // the whole side lies beyond it
+    for (Order *top; (top = getTop(heap)) && mass_cancel_matches(filter, top); count++)
+        cancel_resting(orderbook, top);
+    if (heap->size == 0)
+        return count;
+
+    if (heap->ladder)
+    {
+        for (Order *worst; (worst = ladder_worst(heap->ladder)) && mass_cancel_matches(filter, worst); count++)
+            cancel_resting(orderbook, worst);
+        return count;
+    }
+
+    // already out of the heap; release from the back of the moved run
+    int moved = splitOrderHeap(heap, filter->low, filter->high);
+    for (int i = moved - 1; i >= 0; i--)
+        release_order(orderbook, heap->table->orders[heap->arr[heap->size + i]]);
+    return count + moved;
+}
+
+int mass_cancel(OrderBook *orderbook, const MassCancelFilter *filter)
+{
+    if (!orderbook || !filter)
+        return 0;
+
+    int count = 0;
+
+    // Walk the account's own list: cost follows the account, not the book
+    if (filter->owner_id != 0)
+    {
+        AccountEntry *entry = accountmap_get(orderbook->account_map, filter->owner_id);
+        Order *order = entry ? entry->orders : NULL;
+        while (order)
+        {
+            Order *next = order->account_next;
+            if (mass_cancel_matches(filter, order))
+            {
+                cancel_resting(orderbook, order);
+                count++;
+            }
+            order = next;
+        }
+        return count;
     }
 
-    // Try to match orders and execute trades
-    // match_orders(orderbook);
+    if (filter->side != 'S')
+        count += mass_cancel_side(orderbook, orderbook->buy_orders, filter);
+    if (filter->side != 'B')
+        count += mass_cancel_side(orderbook, orderbook->sell_orders, filter);
+
+    return count;
+}
+
+int cancel_account_orders(OrderBook *orderbook, int owner_id)
+{
+    if (owner_id == 0)
+        return 0;
+
+    MassCancelFilter filter = {owner_id, 0, 0, 0.0, 0.0};
+    return mass_cancel(orderbook, &filter);
+}
+
+void set_cancel_on_disconnect(OrderBook *orderbook, int owner_id, int enabled)
+{
+    if (!orderbook || owner_id == 0)
+        return;
+
+    accountmap_get_or_create(orderbook->account_map, owner_id)->cancel_on_disconnect = enabled;
+}
+
+int account_disconnected(OrderBook *orderbook, int owner_id)
+{
+    if (!orderbook)
+        return 0;
+
+    AccountEntry *entry = accountmap_get(orderbook->account_map, owner_id);
+    if (!entry || !entry->cancel_on_disconnect)
+        return 0;
+
+    return cancel_account_orders(orderbook, owner_id);
+}
+
+int use_price_ladder(OrderBook *orderbook, double base_price, double tick_size, int num_levels)
+{
+    if (!orderbook || tick_size <= 0 || num_levels <= 0 || num_levels > LADDER_MAX_LEVELS)
+        return -1;
+    if (orderbook->buy_orders->size > 0 || orderbook->sell_orders->size > 0)
+        return -1;
+
+    useOrderLadder(orderbook->buy_orders, base_price, tick_size, num_levels);
+    useOrderLadder(orderbook->sell_orders, base_price, tick_size, num_levels);
+
+    return 0;
+}
+
+void reserve_orderbook(OrderBook *orderbook, int orders_per_side)
+{
+    if (!orderbook || orders_per_side <= 0)
+        return;
+
+    reserveOrderHeap(orderbook->buy_orders, orders_per_side);
+    reserveOrderHeap(orderbook->sell_orders, orders_per_side);
+    order_table_reserve(orderbook->order_table, 2 * (uint32_t)orders_per_side);
+
+    int buckets = (int)(2 * orders_per_side / LOAD_FACTOR_THRESHOLD) + 1;
+    if (buckets > orderbook->order_map->capacity)
+        ordermap_resize(orderbook->order_map, buckets);
+}
+
+void set_stp_mode(OrderBook *orderbook, StpMode mode)
+{
+    if (!orderbook)
+        return;
+
+    orderbook->stp_mode = mode;
+}
+
+int set_matching_policy(OrderBook *orderbook, MatchingPolicy policy)
+{
+    if (!orderbook || validate_matching_policy(&policy) != 0)
+        return -1;
+
+    orderbook->policy = policy;
+    return 0;
 }
 
 void print_orderbook(OrderBook *orderbook)
@@ -152,7 +534,7 @@ void print_orderbook(OrderBook *orderbook)
     printf("-------------\n");
 
     int buy_size = orderbook->buy_orders->size;
-    Order **buy_orders_temp = (Order **)malloc(buy_size * sizeof(Order *));
+    Order **buy_orders_temp = (Order **)arena_malloc(buy_size * sizeof(Order *));
 
     for (int i = 0; i < buy_size; i++)
     {
@@ -165,13 +547,13 @@ void print_orderbook(OrderBook *orderbook)
         insertOrderHeap(orderbook->buy_orders, buy_orders_temp[i]);
     }
 
-    free(buy_orders_temp);
+    arena_free(buy_orders_temp);
 
     printf("\nSELL ORDERS:\n");
     printf("-------------\n");
 
     int sell_size = orderbook->sell_orders->size;
-    Order **sell_orders_temp = (Order **)malloc(sell_size * sizeof(Order *));
+    Order **sell_orders_temp = (Order **)arena_malloc(sell_size * sizeof(Order *));
 
     for (int i = 0; i < sell_size; i++)
     {
@@ -184,7 +566,7 @@ void print_orderbook(OrderBook *orderbook)
         insertOrderHeap(orderbook->sell_orders, sell_orders_temp[i]);
     }
 
-    free(sell_orders_temp);
+    arena_free(sell_orders_temp);
 
     printf("\nRECENT TRADES:\n");
     printf("-------------\n");
@@ -193,8 +575,9 @@ void print_orderbook(OrderBook *orderbook)
 
     for (int i = start_idx; i < orderbook->trade_history_size; i++)
     {
-        printf("Trade at price: %.2f - ", orderbook->price_history[i]);
-        print_order(orderbook->trade_history[i]);
+        FilledOrder *trade = &orderbook->trade_history[i];
+        printf("Trade at price: %.2f - Maker: %d || Taker: %d || Quantity: %d\n",
+               trade->traded_price, trade->maker_id, trade->taker_id, trade->traded_quantity);
     }
 
     printf("\n======================\n");
@@ -7,28 +7,146 @@
 #include "order.h"
 #include "orderheap.h"
 #include "ordermap.h"
+#include "ordertable.h"
+#include "timingwheel.h"
+#include "accountmap.h"
+#include "matching/policy.h"
+
+// Self-trade prevention: what to do when the crossing orders share an owner_id
+typedef enum
+{
+    STP_NONE,          // allow self-trades
+    STP_CANCEL_NEWEST, // cancel the incoming (newer) order
+    STP_CANCEL_OLDEST, // cancel the resting (older) order
+    STP_CANCEL_BOTH,   // cancel both orders
+    STP_DECREMENT      // reduce both by the overlapping quantity without trading
+} StpMode;
+
+// Continuous matching, or a call auction that accumulates orders until uncross
+typedef enum
+{
+    PHASE_CONTINUOUS,
+    PHASE_AUCTION
+} TradingPhase;
+
+// Selects orders for mass_cancel; unset criteria match everything
+typedef struct
+{
+    int owner_id;      // 0 for every account
+    char side;         // 'B', 'S', or 0 for both sides
+    int outside_range; // if set, only orders priced below low or above high
+    double low;
+    double high;
+} MassCancelFilter;
+
+// One executed trade between a resting (maker) and incoming (taker) order
+typedef struct
+{
+    int maker_id;
+    int taker_id;
+    int traded_quantity;
+    int maker_leftover;
+    int taker_leftover;
+    double traded_price;
+    double timestamp; // taker's timestamp
+    char taker_side;
+
+} FilledOrder;
+
+// Changes to resting interest, in the order they happen inside the book
+typedef enum
+{
+    BOOK_EVENT_ADD,    // order accepted into the book with quantity
+    BOOK_EVENT_TRADE,  // order (maker) traded with counterparty (taker)
+    BOOK_EVENT_REDUCE, // quantity taken off order without a trade (STP decrement)
+    BOOK_EVENT_REMOVE  // order left the book with quantity still open
+} BookEventType;
+
+typedef struct
+{
+    BookEventType type;
+    const Order *order;
+    const Order *counterparty; // taker of a trade, NULL otherwise
+    int quantity;
+    const FilledOrder *fill;   // trade only
+} BookEvent;
+
+// Called synchronously from inside the book; must not modify it
+typedef void (*BookListener)(void *context, const BookEvent *event);
+
+#define MAX_BOOK_LISTENERS 4
+
 typedef struct OrderBook
 {
     // buy orders
     OrderHeap *buy_orders;
     // sell orders
     OrderHeap *sell_orders;
+    // order storage, addressed by handle from the heaps and map
+    OrderTable *order_table;
     // order map
     OrderMap *order_map;
     // trade history
-    Order **trade_history;
+    FilledOrder *trade_history;
     int trade_history_size;
     int trade_history_capacity;
     // price history
     double *price_history;
     int price_history_size;
     int price_history_capacity;
+    // self-trade prevention mode
+    StpMode stp_mode;
+    // current trading phase
+    TradingPhase phase;
+    // allocation of incoming quantity within a price level
+    MatchingPolicy policy;
+    // GTT and DAY order expiry
+    TimingWheel *expiry_wheel;
+    // resting orders by owner_id
+    AccountMap *account_map;
+    // event subscribers
+    BookListener listeners[MAX_BOOK_LISTENERS];
+    void *listener_contexts[MAX_BOOK_LISTENERS];
+    int listener_count;
 
 } OrderBook;
 
 OrderBook *create_orderbook();
 void free_orderbook(OrderBook *orderbook);
-void add_order(OrderBook *orderbook, Order *order);
+// 0 if the order was accepted (the book takes ownership), -1 if rejected
+int add_order(OrderBook *orderbook, Order *order);
+// 0 if the order was resting and has been cancelled, -1 otherwise
+int cancel_order(OrderBook *orderbook, int order_id);
+// Reduces quantity in place (keeping priority) or cancel/replaces the
+// order at the new price or larger size; 0 on success, -1 if the order is
+// not resting or the new terms are invalid (the order is then unchanged)
+int modify_order(OrderBook *orderbook, int order_id, double new_price, int new_quantity);
+// Drops an order that is no longer in its heap from the map and expiry wheel
+void release_order(OrderBook *orderbook, Order *order);
+// Advances the expiry clock (in ticks) and cancels due GTT orders; returns the count
+int expire_orders(OrderBook *orderbook, long long now);
+// Cancels every DAY order at session end; returns the count
+int expire_day_orders(OrderBook *orderbook);
+// Cancels every resting order selected by filter; returns the count
+int mass_cancel(OrderBook *orderbook, const MassCancelFilter *filter);
+int cancel_account_orders(OrderBook *orderbook, int owner_id);
+void set_cancel_on_disconnect(OrderBook *orderbook, int owner_id, int enabled);
+// Session loss for owner_id; cancels its orders if cancel-on-disconnect is set
+int account_disconnected(OrderBook *orderbook, int owner_id);
+// Switches both (empty) sides to dense price ladders covering num_levels
+// ticks from base_price; orders must then be priced on tick. 0 on success
+int use_price_ladder(OrderBook *orderbook, double base_price, double tick_size, int num_levels);
+// Pre-sizes both sides, the order table and the order map for
+// orders_per_side resting orders
+void reserve_orderbook(OrderBook *orderbook, int orders_per_side);
+void set_stp_mode(OrderBook *orderbook, StpMode mode);
+// 0 on success; -1 (and the book keeps its policy) if the policy is invalid
+int set_matching_policy(OrderBook *orderbook, MatchingPolicy policy);
+void record_trade(OrderBook *orderbook, const FilledOrder *fill);
+// 0 on success, -1 if every listener slot is taken
+int add_book_listener(OrderBook *orderbook, BookListener listener, void *context);
+void remove_book_listener(OrderBook *orderbook, BookListener listener, void *context);
+void notify_book_event(OrderBook *orderbook, const BookEvent *event);
 void print_orderbook(OrderBook *orderbook);
 
 #endif
\ No newline at end of file
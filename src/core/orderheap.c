@@ -1,8 +1,26 @@
 #include "orderheap.h"
 
-OrderHeap *createOrderHeap(int capacity, HeapType type)
+#define CACHE_LINE 64
+
+// Keys are offset so that index 1, and with it every sibling group
+// (HEAP_ARITY * i + 1 ...), starts on a HEAP_ARITY * 8 byte boundary
+static uint64_t *alloc_key_block(int capacity)
+{
+    size_t bytes = (size_t)(capacity + HEAP_ARITY - 1) * sizeof(uint64_t);
+    bytes = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+    uint64_t *block = (uint64_t *)arena_aligned_alloc(CACHE_LINE, bytes);
+    if (!block)
+    {
+        fprintf(stderr, "Memory error\n");
+        exit(EXIT_FAILURE);
+    }
+    return block;
+}
+
+OrderHeap *createOrderHeap(int capacity, HeapType type, OrderTable *table)
 {
-    OrderHeap *heap = (OrderHeap *)malloc(sizeof(OrderHeap));
+    OrderHeap *heap = (OrderHeap *)arena_malloc(sizeof(OrderHeap));
     if (!heap)
     {
         fprintf(stderr, "Memory error\n");
@@ -12,122 +30,240 @@ OrderHeap *createOrderHeap(int capacity, HeapType type)
     heap->capacity = capacity;
     heap->size = 0;
     heap->type = type;
+    heap->table = table;
+    heap->ladder = NULL;
+    heap->next_arr = NULL;
+    heap->next_keys = NULL;
+    heap->next_key_block = NULL;
+    heap->next_capacity = 0;
+    heap->migrated = 0;
 
-    heap->arr = (Order **)malloc(capacity * sizeof(Order *));
+    heap->arr = (OrderHandle *)arena_malloc(capacity * sizeof(OrderHandle));
     if (!heap->arr)
     {
         fprintf(stderr, "Memory error\n");
         exit(EXIT_FAILURE);
     }
+    heap->key_block = alloc_key_block(capacity);
+    heap->keys = heap->key_block + HEAP_ARITY - 1;
 
     return heap;
 }
 
-void swap(Order **a, Order **b)
+static inline void place(OrderHeap *heap, int i, uint64_t key, OrderHandle handle)
 {
-    Order *temp = *a;
-    *a = *b;
-    *b = temp;
+    heap->keys[i] = key;
+    heap->arr[i] = handle;
+    order_table_set_heap_index(heap->table, handle, i);
+    // keep already copied entries current while the side grows
+    if (i < heap->migrated)
+    {
+        heap->next_keys[i] = key;
+        heap->next_arr[i] = handle;
+    }
 }
 
-void heapify(OrderHeap *heap, int idx)
+static inline int min_of(const uint64_t *keys, int a, int b)
 {
-    int left = 2 * idx + 1;
-    int right = 2 * idx + 2;
-    int smallest = idx;
+    return keys[b] < keys[a] ? b : a;
+}
 
-    if (heap->type == BUY_HEAP)
-    {
-        if (left < heap->size &&
-            compare_buy_orders(heap->arr[left], heap->arr[smallest]) < 0)
-        {
-            smallest = left;
-        }
+// Smallest of a full sibling group as a pairwise tournament; the
+// selects compile to conditional moves rather than branches
+static inline int min_of_group(const uint64_t *keys, int first)
+{
+#if HEAP_ARITY == 2
+    return min_of(keys, first, first + 1);
+#else
+    int best = min_of(keys, min_of(keys, first, first + 1), min_of(keys, first + 2, first + 3));
+#if HEAP_ARITY == 8
+    best = min_of(keys, best, min_of(keys, min_of(keys, first + 4, first + 5),
+                                      min_of(keys, first + 6, first + 7)));
+#endif
+    return best;
+#endif
+}
 
-        if (right < heap->size &&
-            compare_buy_orders(heap->arr[right], heap->arr[smallest]) < 0)
-        {
-            smallest = right;
-        }
+// Keys encode side and time priority, so both heaps share one min-heap
+// and the sifts never look at heap->type. Both move a hole rather than
+// swapping, writing the carried entry once at its final slot.
+static int sift_up(OrderHeap *heap, int i, uint64_t key, OrderHandle handle)
+{
+    while (i > 0)
+    {
+        int parent = (i - 1) / HEAP_ARITY;
+        if (heap->keys[parent] <= key)
+            break;
+        place(heap, i, heap->keys[parent], heap->arr[parent]);
+        i = parent;
     }
-    else
+    place(heap, i, key, handle);
+    return i;
+}
+
+static void sift_down(OrderHeap *heap, int i, uint64_t key, OrderHandle handle)
+{
+    const uint64_t *keys = heap->keys;
+    for (;;)
     {
-        if (left < heap->size &&
-            compare_sell_orders(heap->arr[left], heap->arr[smallest]) < 0)
+        int first = HEAP_ARITY * i + 1;
+        if (first >= heap->size)
+            break;
+
+        int child;
+        if (first + HEAP_ARITY <= heap->size)
         {
-            smallest = left;
+            child = min_of_group(keys, first);
         }
-
-        if (right < heap->size &&
-            compare_sell_orders(heap->arr[right], heap->arr[smallest]) < 0)
+        else
         {
-            smallest = right;
+            child = first;
+            for (int c = first + 1; c < heap->size; c++)
+                child = min_of(keys, child, c);
         }
+
+        if (keys[child] >= key)
+            break;
+        place(heap, i, keys[child], heap->arr[child]);
+        i = child;
     }
+    place(heap, i, key, handle);
+}
 
-    if (smallest != idx)
+// Copies up to count more entries into the growing arrays, switching to
+// them once every resting entry is there
+static void migrate_entries(OrderHeap *heap, int count)
+{
+    int end = heap->migrated + count < heap->size ? heap->migrated + count : heap->size;
+    if (end > heap->migrated)
     {
-        swap(&heap->arr[idx], &heap->arr[smallest]);
-        heapify(heap, smallest);
+        memcpy(heap->next_arr + heap->migrated, heap->arr + heap->migrated,
+               (end - heap->migrated) * sizeof(OrderHandle));
+        memcpy(heap->next_keys + heap->migrated, heap->keys + heap->migrated,
+               (end - heap->migrated) * sizeof(uint64_t));
+        heap->migrated = end;
     }
+    if (heap->migrated < heap->size)
+        return;
+
+    arena_free(heap->arr);
+    arena_free(heap->key_block);
+    heap->arr = heap->next_arr;
+    heap->keys = heap->next_keys;
+    heap->key_block = heap->next_key_block;
+    heap->capacity = heap->next_capacity;
+    heap->next_arr = NULL;
+    heap->next_keys = NULL;
+    heap->next_key_block = NULL;
+    heap->next_capacity = 0;
+    heap->migrated = 0;
+}
+
+// Completes a growth in progress at once, before operations that rewrite
+// the arrays wholesale
+static void finish_growth(OrderHeap *heap)
+{
+    if (heap->next_arr)
+        migrate_entries(heap, heap->size);
+}
+
+void heapify(OrderHeap *heap, int idx)
+{
+    if (idx >= 0 && idx < heap->size)
+        sift_down(heap, idx, heap->keys[idx], heap->arr[idx]);
 }
 
 void insertOrderHeap(OrderHeap *heap, Order *key)
 {
-    if (heap->size == heap->capacity)
+    if (heap->ladder)
     {
-        printf("Heap is full; cannot insert key %d\n", key->order_id);
+        ladder_insert(heap->ladder, key);
+        heap->size = heap->ladder->size;
         return;
     }
 
-    int i = heap->size;
-    heap->arr[i] = key;
+    // last resort; the book normally grows sides ahead of time
+    if (heap->size == heap->capacity)
+        finish_growth(heap);
+    if (heap->size == heap->capacity)
+        increaseHeapCapacity(heap, heap->capacity > 0 ? heap->capacity : 1);
+
     heap->size++;
+    sift_up(heap, heap->size - 1, heap->table->keys[key->handle], key->handle);
+}
 
-    if (heap->type == BUY_HEAP)
-    {
-        while (i != 0 && compare_buy_orders(heap->arr[(i - 1) / 2], heap->arr[i]) > 0)
-        {
-            swap(&heap->arr[i], &heap->arr[(i - 1) / 2]);
-            i = (i - 1) / 2;
-        }
-    }
-    else
+Order *extractTop(OrderHeap *heap)
+{
+    if (heap->ladder)
     {
-        while (i != 0 && compare_sell_orders(heap->arr[(i - 1) / 2], heap->arr[i]) > 0)
-        {
-            swap(&heap->arr[i], &heap->arr[(i - 1) / 2]);
-            i = (i - 1) / 2;
-        }
+        Order *top = ladder_extract_top(heap->ladder);
+        heap->size = heap->ladder->size;
+        return top;
     }
+
+    if (heap->size <= 0)
+        return NULL;
+
+    return removeOrderHeap(heap, 0);
 }
 
-Order *extractTop(OrderHeap *heap)
+Order *getTop(OrderHeap *heap)
 {
+    if (heap->ladder)
+        return ladder_top(heap->ladder);
+
     if (heap->size <= 0)
         return NULL;
 
-    if (heap->size == 1)
-    {
-        heap->size--;
-        return heap->arr[0];
-    }
+    return heap->table->orders[heap->arr[0]];
+}
 
-    Order *root = heap->arr[0];
-    heap->arr[0] = heap->arr[heap->size - 1];
+Order *removeOrderHeap(OrderHeap *heap, int idx)
+{
+    if (heap->ladder || idx < 0 || idx >= heap->size)
+        return NULL;
+
+    OrderHandle removed = heap->arr[idx];
     heap->size--;
 
-    heapify(heap, 0);
+    if (idx != heap->size)
+    {
+        // refill the hole with the last entry and restore order either way
+        uint64_t key = heap->keys[heap->size];
+        OrderHandle moved = heap->arr[heap->size];
+        if (sift_up(heap, idx, key, moved) == idx)
+            sift_down(heap, idx, key, moved);
+    }
 
-    return root;
+    order_table_set_heap_index(heap->table, removed, -1);
+    return heap->table->orders[removed];
 }
 
-Order *getTop(OrderHeap *heap)
+void growOrderHeap(OrderHeap *heap)
 {
-    if (heap->size <= 0)
-        return NULL;
+    if (heap->ladder)
+        return;
 
-    return heap->arr[0];
+    if (heap->next_arr)
+    {
+        migrate_entries(heap, HEAP_GROW_STEP);
+        return;
+    }
+    if (heap->size * 4 < heap->capacity * 3)
+        return;
+
+    // allocation only; the copying is spread over the following calls
+    int capacity = heap->capacity > 0 ? heap->capacity * 2 : 1;
+    heap->next_arr = (OrderHandle *)arena_malloc(capacity * sizeof(OrderHandle));
+    if (!heap->next_arr)
+    {
+        fprintf(stderr, "Memory error\n");
+        exit(EXIT_FAILURE);
+    }
+    heap->next_key_block = alloc_key_block(capacity);
+    heap->next_keys = heap->next_key_block + HEAP_ARITY - 1;
+    heap->next_capacity = capacity;
+    heap->migrated = 0;
 }
 
 void increaseHeapCapacity(OrderHeap *heap, int increment)
@@ -137,15 +273,172 @@ void increaseHeapCapacity(OrderHeap *heap, int increment)
         return;
     }
 
+    finish_growth(heap);
+
     int newCapacity = heap->capacity + increment;
 
-    Order **newArr = (Order **)realloc(heap->arr, newCapacity * sizeof(Order *));
+    OrderHandle *newArr = (OrderHandle *)arena_realloc(heap->arr, newCapacity * sizeof(OrderHandle));
     if (newArr == NULL)
     {
         fprintf(stderr, "Error: memory realloc failed while increasing capacity.\n");
         exit(EXIT_FAILURE);
     }
 
+    // aligned blocks cannot be realloc'd in place
+    uint64_t *newBlock = alloc_key_block(newCapacity);
+    memcpy(newBlock + HEAP_ARITY - 1, heap->keys, heap->size * sizeof(uint64_t));
+    arena_free(heap->key_block);
+
     heap->arr = newArr;
+    heap->key_block = newBlock;
+    heap->keys = newBlock + HEAP_ARITY - 1;
     heap->capacity = newCapacity;
-}
\ No newline at end of file
+}
+
+// Grows the heap to hold at least capacity orders
+void reserveOrderHeap(OrderHeap *heap, int capacity)
+{
+    finish_growth(heap);
+    if (capacity > heap->capacity)
+        increaseHeapCapacity(heap, capacity - heap->capacity);
+}
+
+typedef struct
+{
+    uint64_t key;
+    int idx;
+} RankedKey;
+
+static int compare_ranked_keys(const void *a, const void *b)
+{
+    uint64_t ka = ((const RankedKey *)a)->key;
+    uint64_t kb = ((const RankedKey *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Renumbers the rank bits of every resting key to 0..size-1 in priority
+// order. Relative order is unchanged, so the heap stays valid. Returns
+// the first free rank; a ladder side does not use keys and returns 0.
+int rebaseOrderKeys(OrderHeap *heap)
+{
+    if (heap->ladder || heap->size == 0)
+        return 0;
+
+    finish_growth(heap);
+    RankedKey *ranked = (RankedKey *)arena_malloc(heap->size * sizeof(RankedKey));
+    if (!ranked)
+    {
+        fprintf(stderr, "Memory error\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < heap->size; i++)
+    {
+        ranked[i].key = heap->keys[i];
+        ranked[i].idx = i;
+    }
+    qsort(ranked, heap->size, sizeof(RankedKey), compare_ranked_keys);
+
+    for (int r = 0; r < heap->size; r++)
+    {
+        int i = ranked[r].idx;
+        uint64_t key = (heap->keys[i] & ~ORDER_KEY_RANK_MASK) | (uint64_t)r;
+        heap->keys[i] = key;
+        order_table_set_key(heap->table, heap->arr[i], key);
+    }
+
+    arena_free(ranked);
+    return heap->size;
+}
+
+// Removes a resting order from whichever layout backs the side
+void removeOrder(OrderHeap *heap, Order *order)
+{
+    if (heap->ladder)
+    {
+        ladder_remove(heap->ladder, order);
+        heap->size = heap->ladder->size;
+        return;
+    }
+
+    removeOrderHeap(heap, heap->table->heap_index[order->handle]);
+}
+
+// Copies every resting order into out (heap order, or best level first
+// for a ladder); returns the count
+int collectOrders(OrderHeap *heap, Order **out)
+{
+    if (heap->ladder)
+        return ladder_collect(heap->ladder, out);
+
+    for (int i = 0; i < heap->size; i++)
+        out[i] = heap->table->orders[heap->arr[i]];
+    return heap->size;
+}
+
+int splitOrderHeap(OrderHeap *heap, double low, double high)
+{
+    if (heap->ladder)
+        return 0;
+
+    finish_growth(heap);
+
+    int kept = 0;
+    for (int i = 0; i < heap->size; i++)
+    {
+        double price = heap->table->orders[heap->arr[i]]->price;
+        if (price < low || price > high)
+            continue;
+
+        OrderHandle handle = heap->arr[i];
+        uint64_t key = heap->keys[i];
+        heap->arr[i] = heap->arr[kept];
+        heap->keys[i] = heap->keys[kept];
+        heap->arr[kept] = handle;
+        heap->keys[kept] = key;
+        kept++;
+    }
+
+    int moved = heap->size - kept;
+    for (int i = kept; i < heap->size; i++)
+        order_table_set_heap_index(heap->table, heap->arr[i], -1);
+    heap->size = kept;
+    for (int i = 0; i < kept; i++)
+        order_table_set_heap_index(heap->table, heap->arr[i], i);
+    for (int i = kept > 1 ? (kept - 2) / HEAP_ARITY : -1; i >= 0; i--)
+        sift_down(heap, i, heap->keys[i], heap->arr[i]);
+
+    return moved;
+}
+
+// Empties the side without touching the orders
+void clearOrderHeap(OrderHeap *heap)
+{
+    if (heap->ladder)
+        ladder_clear(heap->ladder);
+    for (int i = 0; i < heap->size && !heap->ladder; i++)
+        order_table_set_heap_index(heap->table, heap->arr[i], -1);
+    heap->size = 0;
+}
+
+// Switches an empty side to a dense price ladder
+void useOrderLadder(OrderHeap *heap, double base_price, double tick_size, int num_levels)
+{
+    if (heap->size > 0)
+        return;
+
+    free_price_ladder(heap->ladder);
+    heap->ladder = create_price_ladder(heap->type == BUY_HEAP, base_price, tick_size, num_levels);
+}
+
+void freeOrderHeap(OrderHeap *heap)
+{
+    if (!heap)
+        return;
+
+    free_price_ladder(heap->ladder);
+    arena_free(heap->arr);
+    arena_free(heap->key_block);
+    arena_free(heap->next_arr);
+    arena_free(heap->next_key_block);
+    arena_free(heap);
+}
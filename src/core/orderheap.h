@@ -6,6 +6,20 @@
 #include <limits.h>
 #include <string.h>
 #include "order.h"
+#include "ordertable.h"
+#include "priceladder.h"
+
+// Children per node; 4 or 8 keeps each sibling group inside one cache line
+#ifndef HEAP_ARITY
+#define HEAP_ARITY 4
+#endif
+
+#if HEAP_ARITY != 2 && HEAP_ARITY != 4 && HEAP_ARITY != 8
+#error "HEAP_ARITY must be 2, 4 or 8"
+#endif
+
+// Entries copied into the doubled arrays per growOrderHeap step
+#define HEAP_GROW_STEP 64
 
 typedef enum
 {
@@ -15,18 +29,44 @@ typedef enum
 
 typedef struct OrderHeap
 {
-    Order **arr;
+    OrderHandle *arr;    // handles into table
+    uint64_t *keys;      // sort key of arr[i]; sibling groups start on a cache line
+    uint64_t *key_block; // allocation backing keys
     int capacity;
     int size;
     HeapType type;
+    OrderTable *table;   // the book's order storage
+    PriceLadder *ladder; // when set, the side is a dense price ladder instead of a heap
+    // doubling in progress: next_* are the larger arrays, holding copies of
+    // entries [0, migrated); NULL when the side is not growing
+    OrderHandle *next_arr;
+    uint64_t *next_keys;
+    uint64_t *next_key_block;
+    int next_capacity;
+    int migrated;
 } OrderHeap;
 
-OrderHeap *createOrderHeap(int capacity, HeapType type);
-void swap(Order **a, Order **b);
+OrderHeap *createOrderHeap(int capacity, HeapType type, OrderTable *table);
 void heapify(OrderHeap *heap, int idx);
 void insertOrderHeap(OrderHeap *heap, Order *key);
 Order *extractTop(OrderHeap *heap);
 Order *getTop(OrderHeap *heap);
 void increaseHeapCapacity(OrderHeap *heap, int increment);
+// One step of incremental doubling, for the book to call after each add:
+// starts once the side is three quarters full, then copies HEAP_GROW_STEP entries
+// per call and switches arrays when all are copied
+void growOrderHeap(OrderHeap *heap);
+void reserveOrderHeap(OrderHeap *heap, int capacity);
+int rebaseOrderKeys(OrderHeap *heap);
+Order *removeOrderHeap(OrderHeap *heap, int idx);
+void removeOrder(OrderHeap *heap, Order *order);
+int collectOrders(OrderHeap *heap, Order **out);
+// Moves the heap's entries priced outside [low, high] past its end and
+// restores heap order over the rest in one pass; returns how many moved.
+// They stay at arr[size, size + count) for the caller to release
+int splitOrderHeap(OrderHeap *heap, double low, double high);
+void clearOrderHeap(OrderHeap *heap);
+void useOrderLadder(OrderHeap *heap, double base_price, double tick_size, int num_levels);
+void freeOrderHeap(OrderHeap *heap);
 
-#endif
\ No newline at end of file
+#endif
@@ -6,9 +6,9 @@ unsigned int hash_function(int key, int capacity)
 }
 
 // Create a new OrderMap
-OrderMap *create_ordermap()
+OrderMap *create_ordermap(OrderTable *table)
 {
-    OrderMap *map = (OrderMap *)malloc(sizeof(OrderMap));
+    OrderMap *map = (OrderMap *)arena_malloc(sizeof(OrderMap));
     if (!map)
     {
         fprintf(stderr, "Memory allocation failed for OrderMap\n");
@@ -17,49 +17,132 @@ OrderMap *create_ordermap()
 
     map->capacity = INITIAL_CAPACITY;
     map->size = 0;
+    map->table = table;
+    map->old_buckets = NULL;
+    map->old_capacity = 0;
+    map->rehash_index = 0;
 
-    map->buckets = (MapEntry **)calloc(map->capacity, sizeof(MapEntry *));
+    map->buckets = (MapEntry **)arena_calloc(map->capacity, sizeof(MapEntry *));
     if (!map->buckets)
     {
         fprintf(stderr, "Memory allocation failed for OrderMap buckets\n");
-        free(map);
+        arena_free(map);
         exit(EXIT_FAILURE);
     }
 
     return map;
 }
 
-// Free the OrderMap and all its entries
+// Free the OrderMap and all its entries; the orders belong to the table
 void free_ordermap(OrderMap *map)
 {
     if (!map)
         return;
 
     // Free all entries and their chains
+    for (int i = map->rehash_index; i < map->old_capacity; i++)
+    {
+        MapEntry *entry = map->old_buckets[i];
+        while (entry)
+        {
+            MapEntry *next = entry->next;
+            arena_free(entry);
+            entry = next;
+        }
+    }
     for (int i = 0; i < map->capacity; i++)
     {
         MapEntry *entry = map->buckets[i];
         while (entry)
         {
             MapEntry *next = entry->next;
-            free_order(entry->value);
-            free(entry);
+            arena_free(entry);
+            entry = next;
+        }
+    }
+
+    arena_free(map->old_buckets);
+    arena_free(map->buckets);
+    arena_free(map);
+}
+
+// The chain that holds order_id: its old bucket until that one has been
+// moved, the new array after
+static MapEntry **bucket_of(OrderMap *map, int order_id)
+{
+    if (map->old_buckets)
+    {
+        int old_index = (int)hash_function(order_id, map->old_capacity);
+        if (old_index >= map->rehash_index)
+            return &map->old_buckets[old_index];
+    }
+    return &map->buckets[hash_function(order_id, map->capacity)];
+}
+
+// Moves up to count more old buckets into the new array, dropping the old
+// one when it is empty
+static void rehash_buckets(OrderMap *map, int count)
+{
+    int end = map->rehash_index + count < map->old_capacity ? map->rehash_index + count : map->old_capacity;
+    for (; map->rehash_index < end; map->rehash_index++)
+    {
+        MapEntry *entry = map->old_buckets[map->rehash_index];
+        map->old_buckets[map->rehash_index] = NULL;
+        while (entry)
+        {
+            MapEntry *next = entry->next;
+            unsigned int index = hash_function(entry->key, map->capacity);
+            entry->next = map->buckets[index];
+            map->buckets[index] = entry;
             entry = next;
         }
     }
+    if (map->rehash_index < map->old_capacity)
+        return;
 
-    free(map->buckets);
-    free(map);
+    arena_free(map->old_buckets);
+    map->old_buckets = NULL;
+    map->old_capacity = 0;
+    map->rehash_index = 0;
+}
+
+// Starts doubling once the map is three quarters full, then moves
+// MAP_REHASH_STEP buckets per put; the map has doubled long before it
+// could fill again, so no put rehashes every entry
+static void grow_step(OrderMap *map)
+{
+    if (map->old_buckets)
+    {
+        rehash_buckets(map, MAP_REHASH_STEP);
+        return;
+    }
+    if ((float)map->size / map->capacity < LOAD_FACTOR_THRESHOLD)
+        return;
+
+    MapEntry **buckets = (MapEntry **)arena_calloc(map->capacity * 2, sizeof(MapEntry *));
+    if (!buckets)
+    {
+        fprintf(stderr, "Memory allocation failed during resize\n");
+        exit(EXIT_FAILURE);
+    }
+    map->old_buckets = map->buckets;
+    map->old_capacity = map->capacity;
+    map->rehash_index = 0;
+    map->buckets = buckets;
+    map->capacity *= 2;
 }
 
 // Resize the map when it gets too full
 void ordermap_resize(OrderMap *map, int new_capacity)
 {
+    if (map->old_buckets)
+        rehash_buckets(map, map->old_capacity);
+
     MapEntry **old_buckets = map->buckets;
     int old_capacity = map->capacity;
 
     // Allocate new buckets
-    map->buckets = (MapEntry **)calloc(new_capacity, sizeof(MapEntry *));
+    map->buckets = (MapEntry **)arena_calloc(new_capacity, sizeof(MapEntry *));
     if (!map->buckets)
     {
         fprintf(stderr, "Memory allocation failed during resize\n");
@@ -87,35 +170,30 @@ void ordermap_resize(OrderMap *map, int new_capacity)
         }
     }
 
-    free(old_buckets);
+    arena_free(old_buckets);
 }
 
 // Add or update an order in the map
 void ordermap_put(OrderMap *map, int order_id, Order *order)
 {
-    // Check if resize is needed
-    if ((float)map->size / map->capacity >= LOAD_FACTOR_THRESHOLD)
-    {
-        ordermap_resize(map, map->capacity * 2);
-    }
-
-    unsigned int index = hash_function(order_id, map->capacity);
+    grow_step(map);
+    MapEntry **bucket = bucket_of(map, order_id);
 
     // Check if key already exists
-    MapEntry *current = map->buckets[index];
+    MapEntry *current = *bucket;
     while (current)
     {
         if (current->key == order_id)
         {
             // Update existing entry
-            current->value = order;
+            current->value = order->handle;
             return;
         }
         current = current->next;
     }
 
     // Create new entry
-    MapEntry *new_entry = (MapEntry *)malloc(sizeof(MapEntry));
+    MapEntry *new_entry = (MapEntry *)arena_malloc(sizeof(MapEntry));
     if (!new_entry)
     {
         fprintf(stderr, "Memory allocation failed for new map entry\n");
@@ -123,9 +201,9 @@ void ordermap_put(OrderMap *map, int order_id, Order *order)
     }
 
     new_entry->key = order_id;
-    new_entry->value = order;
-    new_entry->next = map->buckets[index];
-    map->buckets[index] = new_entry;
+    new_entry->value = order->handle;
+    new_entry->next = *bucket;
+    *bucket = new_entry;
     map->size++;
 }
 
@@ -135,14 +213,14 @@ Order *ordermap_get(OrderMap *map, int order_id)
     if (!map)
         return NULL;
 
-    unsigned int index = hash_function(order_id, map->capacity);
-    MapEntry *entry = map->buckets[index];
+    MapEntry **bucket = bucket_of(map, order_id);
+    MapEntry *entry = *bucket;
 
     while (entry)
     {
         if (entry->key == order_id)
         {
-            return entry->value;
+            return order_table_get(map->table, entry->value);
         }
         entry = entry->next;
     }
@@ -156,8 +234,8 @@ Order *ordermap_remove(OrderMap *map, int order_id)
     if (!map)
         return NULL;
 
-    unsigned int index = hash_function(order_id, map->capacity);
-    MapEntry *entry = map->buckets[index];
+    MapEntry **bucket = bucket_of(map, order_id);
+    MapEntry *entry = *bucket;
     MapEntry *prev = NULL;
 
     while (entry)
@@ -171,11 +249,11 @@ Order *ordermap_remove(OrderMap *map, int order_id)
             }
             else
             {
-                map->buckets[index] = entry->next;
+                *bucket = entry->next;
             }
 
-            Order *order = entry->value;
-            free(entry);
+            Order *order = order_table_get(map->table, entry->value);
+            arena_free(entry);
             map->size--;
             return order;
         }
@@ -193,8 +271,8 @@ int ordermap_contains(OrderMap *map, int order_id)
     if (!map)
         return 0;
 
-    unsigned int index = hash_function(order_id, map->capacity);
-    MapEntry *entry = map->buckets[index];
+    MapEntry **bucket = bucket_of(map, order_id);
+    MapEntry *entry = *bucket;
 
     while (entry)
     {
@@ -6,14 +6,16 @@
 #include <limits.h>
 #include <string.h>
 #include "order.h"
+#include "ordertable.h"
 
 #define INITIAL_CAPACITY 16
 #define LOAD_FACTOR_THRESHOLD 0.75
+#define MAP_REHASH_STEP 16 // old buckets moved per put while the map grows
 
 typedef struct MapEntry
 {
     int key;               // order_id
-    Order *value;          // pointer to the order
+    OrderHandle value;     // handle of the order in the table
     struct MapEntry *next; // for handling collisions
 } MapEntry;
 
@@ -22,15 +24,23 @@ typedef struct OrderMap
     MapEntry **buckets; // array of entry pointers
     int capacity;       // total number of buckets
     int size;           // current number of entries
+    OrderTable *table;  // resolves handles; owns the orders
+    // doubling in progress: buckets is the larger array, and old buckets
+    // below rehash_index have been moved into it; NULL when not growing
+    MapEntry **old_buckets;
+    int old_capacity;
+    int rehash_index;
 } OrderMap;
 
 // Function declarations
-OrderMap *create_ordermap();
+// Orders must already be registered in the map's table
+OrderMap *create_ordermap(OrderTable *table);
 void free_ordermap(OrderMap *map);
 void ordermap_put(OrderMap *map, int order_id, Order *order);
 Order *ordermap_get(OrderMap *map, int order_id);
 Order *ordermap_remove(OrderMap *map, int order_id);
 int ordermap_contains(OrderMap *map, int order_id);
+// Rehashes everything at once, for sizing the map off the matching path
 void ordermap_resize(OrderMap *map, int new_capacity);
 unsigned int hash_function(int key, int capacity);
 
@@ -0,0 +1,173 @@
+#include "ordertable.h"
+
+static void *resize_column(void *column, uint32_t capacity, size_t width)
+{
+    void *resized = arena_realloc(column, (size_t)capacity * width);
+    if (!resized)
+    {
+        fprintf(stderr, "Memory reallocation failed for OrderTable column\n");
+        exit(EXIT_FAILURE);
+    }
+    return resized;
+}
+
+static void resize_table(OrderTable *table, uint32_t capacity)
+{
+    table->keys = (uint64_t *)resize_column(table->keys, capacity, sizeof(uint64_t));
+    table->heap_index = (int *)resize_column(table->heap_index, capacity, sizeof(int));
+    table->orders = (Order **)resize_column(table->orders, capacity, sizeof(Order *));
+    table->free_list = (OrderHandle *)resize_column(table->free_list, capacity, sizeof(OrderHandle));
+    table->capacity = capacity;
+}
+
+static void *alloc_column(uint32_t capacity, size_t width)
+{
+    void *column = arena_malloc((size_t)capacity * width);
+    if (!column)
+    {
+        fprintf(stderr, "Memory allocation failed for OrderTable column\n");
+        exit(EXIT_FAILURE);
+    }
+    return column;
+}
+
+// Copies up to count more handles into the growing columns, switching to
+// them once every handle handed out is there
+static void migrate_handles(OrderTable *table, uint32_t count)
+{
+    uint32_t start = table->migrated;
+    uint32_t end = start + count < table->used ? start + count : table->used;
+    if (end > start)
+    {
+        memcpy(table->next_keys + start, table->keys + start, (end - start) * sizeof(uint64_t));
+        memcpy(table->next_heap_index + start, table->heap_index + start, (end - start) * sizeof(int));
+        memcpy(table->next_orders + start, table->orders + start, (end - start) * sizeof(Order *));
+        memcpy(table->next_free_list + start, table->free_list + start, (end - start) * sizeof(OrderHandle));
+        table->migrated = end;
+    }
+    if (table->migrated < table->used)
+        return;
+
+    arena_free(table->keys);
+    arena_free(table->heap_index);
+    arena_free(table->orders);
+    arena_free(table->free_list);
+    table->keys = table->next_keys;
+    table->heap_index = table->next_heap_index;
+    table->orders = table->next_orders;
+    table->free_list = table->next_free_list;
+    table->capacity = table->next_capacity;
+    table->next_keys = NULL;
+    table->next_heap_index = NULL;
+    table->next_orders = NULL;
+    table->next_free_list = NULL;
+    table->next_capacity = 0;
+    table->migrated = 0;
+}
+
+// Completes a growth in progress at once
+static void finish_growth(OrderTable *table)
+{
+    if (table->next_keys)
+        migrate_handles(table, table->used);
+}
+
+OrderTable *create_order_table(uint32_t capacity)
+{
+    OrderTable *table = (OrderTable *)arena_calloc(1, sizeof(OrderTable));
+    if (!table)
+    {
+        fprintf(stderr, "Memory allocation failed for OrderTable\n");
+        exit(EXIT_FAILURE);
+    }
+
+    resize_table(table, capacity > 0 ? capacity : 64);
+
+    return table;
+}
+
+void free_order_table(OrderTable *table)
+{
+    if (!table)
+        return;
+
+    for (uint32_t h = 0; h < table->used; h++)
+        free_order(table->orders[h]);
+
+    finish_growth(table);
+    arena_free(table->keys);
+    arena_free(table->heap_index);
+    arena_free(table->orders);
+    arena_free(table->free_list);
+    arena_free(table);
+}
+
+void order_table_reserve(OrderTable *table, uint32_t capacity)
+{
+    finish_growth(table);
+    if (capacity > table->capacity)
+        resize_table(table, capacity);
+}
+
+OrderHandle order_table_add(OrderTable *table, Order *order)
+{
+    OrderHandle handle;
+    if (table->free_count > 0)
+    {
+        handle = table->free_list[--table->free_count];
+    }
+    else
+    {
+        // last resort; the book normally grows the table ahead of time
+        if (table->used == table->capacity)
+            finish_growth(table);
+        if (table->used == table->capacity)
+            resize_table(table, table->capacity * 2);
+        handle = table->used++;
+    }
+
+    order_table_set_key(table, handle, order_key(order->side, order->price, table->next_rank++));
+    order_table_set_heap_index(table, handle, -1);
+    table->orders[handle] = order;
+    if (handle < table->migrated)
+        table->next_orders[handle] = order;
+    order->handle = handle;
+    order->sequence = table->next_sequence++;
+
+    return handle;
+}
+
+void order_table_remove(OrderTable *table, OrderHandle handle)
+{
+    if (handle >= table->used || !table->orders[handle])
+        return;
+
+    table->orders[handle]->handle = INVALID_HANDLE;
+    table->orders[handle] = NULL;
+    order_table_set_heap_index(table, handle, -1);
+    if (handle < table->migrated)
+        table->next_orders[handle] = NULL;
+    if (table->free_count < table->migrated)
+        table->next_free_list[table->free_count] = handle;
+    table->free_list[table->free_count++] = handle;
+}
+
+void order_table_grow(OrderTable *table)
+{
+    if (table->next_keys)
+    {
+        migrate_handles(table, TABLE_GROW_STEP);
+        return;
+    }
+    if ((uint64_t)table->used * 4 < (uint64_t)table->capacity * 3)
+        return;
+
+    // allocation only; the copying is spread over the following calls
+    uint32_t capacity = table->capacity * 2;
+    table->next_keys = (uint64_t *)alloc_column(capacity, sizeof(uint64_t));
+    table->next_heap_index = (int *)alloc_column(capacity, sizeof(int));
+    table->next_orders = (Order **)alloc_column(capacity, sizeof(Order *));
+    table->next_free_list = (OrderHandle *)alloc_column(capacity, sizeof(OrderHandle));
+    table->next_capacity = capacity;
+    table->migrated = 0;
+}
@@ -0,0 +1,105 @@
+#ifndef ORDERTABLE_H
+#define ORDERTABLE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "order.h"
+
+/*
+    Per-book order storage addressed by 32-bit handles. The columns hold
+    what the heaps read while sifting (the sort key and the back-index
+    into the side's heap); everything else, fixed or mutable, stays on
+    the Order record in orders[].
+*/
+
+// Heap sort key: price ticks in the high bits, inverted for bids so the
+// best order on either side has the smallest key, and the arrival rank
+// in the low bits. Prices are kept to ORDER_KEY_PRICE_SCALE precision,
+// and add_order rejects any price between two key ticks, which would
+// otherwise share a key with a better one and queue behind it by arrival.
+#define ORDER_KEY_RANK_BITS 28
+#define ORDER_KEY_RANK_MASK ((1ULL << ORDER_KEY_RANK_BITS) - 1)
+#define ORDER_KEY_PRICE_MASK ((1ULL << (64 - ORDER_KEY_RANK_BITS)) - 1)
+#define ORDER_KEY_PRICE_SCALE 10000.0
+#define ORDER_KEY_MAX_PRICE ((double)ORDER_KEY_PRICE_MASK / ORDER_KEY_PRICE_SCALE)
+
+static inline uint64_t order_key(char side, double price, uint64_t rank)
+{
+    uint64_t ticks = (uint64_t)(price * ORDER_KEY_PRICE_SCALE + 0.5);
+    if (side == 'B')
+        ticks = ORDER_KEY_PRICE_MASK - ticks;
+    return (ticks << ORDER_KEY_RANK_BITS) | (rank & ORDER_KEY_RANK_MASK);
+}
+
+#define ORDER_KEY_TICK_TOLERANCE 1e-4 // of a tick, for binary rounding of decimal prices
+
+// 1 if price is a whole number of key ticks
+static inline int order_key_on_grid(double price)
+{
+    double ticks = price * ORDER_KEY_PRICE_SCALE;
+    double error = ticks - (double)(uint64_t)(ticks + 0.5);
+    return error < ORDER_KEY_TICK_TOLERANCE && error > -ORDER_KEY_TICK_TOLERANCE;
+}
+
+// Handles copied into the doubled columns per order_table_grow step
+#define TABLE_GROW_STEP 64
+
+typedef struct OrderTable
+{
+    uint64_t *keys;       // heap sort key, see order_key
+    int *heap_index;      // position in the side's heap, -1 when not in one
+    Order **orders;       // owning record, NULL for a free handle
+    OrderHandle *free_list;
+    uint32_t free_count;
+    uint32_t used;        // handles ever handed out
+    uint32_t capacity;
+    uint64_t next_sequence; // arrival counter stamped on each added order
+    uint64_t next_rank;     // key rank counter; rebased before it exceeds ORDER_KEY_RANK_MASK
+    // doubling in progress: next_* are the larger columns, holding copies
+    // of handles (and free list slots) [0, migrated); NULL when not growing
+    uint64_t *next_keys;
+    int *next_heap_index;
+    Order **next_orders;
+    OrderHandle *next_free_list;
+    uint32_t next_capacity;
+    uint32_t migrated;
+} OrderTable;
+
+OrderTable *create_order_table(uint32_t capacity);
+// Frees the table and every order still registered in it
+void free_order_table(OrderTable *table);
+// Grows the columns to hold at least capacity handles
+void order_table_reserve(OrderTable *table, uint32_t capacity);
+// Registers order, stamps its handle, sequence and sort key; returns the handle
+OrderHandle order_table_add(OrderTable *table, Order *order);
+// Releases the handle; the Order itself is left to the caller
+void order_table_remove(OrderTable *table, OrderHandle handle);
+// One step of incremental doubling, for the book to call after each add:
+// starts once three quarters of the handles are in use, then copies
+// TABLE_GROW_STEP handles per call and switches columns when all are copied
+void order_table_grow(OrderTable *table);
+
+// Column writes after registration go through these so a growing table
+// keeps its copies current
+static inline void order_table_set_heap_index(OrderTable *table, OrderHandle handle, int index)
+{
+    table->heap_index[handle] = index;
+    if (handle < table->migrated)
+        table->next_heap_index[handle] = index;
+}
+
+static inline void order_table_set_key(OrderTable *table, OrderHandle handle, uint64_t key)
+{
+    table->keys[handle] = key;
+    if (handle < table->migrated)
+        table->next_keys[handle] = key;
+}
+
+static inline Order *order_table_get(OrderTable *table, OrderHandle handle)
+{
+    return handle < table->used ? table->orders[handle] : NULL;
+}
+
+#endif
@@ -0,0 +1,340 @@
+#include "priceladder.h"
+
+#define TICK_TOLERANCE 1e-6
+
+static void allocate_levels(PriceLadder *ladder, int num_levels)
+{
+    ladder->num_levels = (num_levels + 63) & ~63;
+    ladder->bitmap_words = ladder->num_levels / 64;
+    ladder->summary_words = (ladder->bitmap_words + 63) / 64;
+
+    ladder->levels = (PriceLevel *)arena_calloc(ladder->num_levels, sizeof(PriceLevel));
+    ladder->bitmap = (unsigned long long *)arena_calloc(ladder->bitmap_words, sizeof(unsigned long long));
+    ladder->summary = (unsigned long long *)arena_calloc(ladder->summary_words, sizeof(unsigned long long));
+    if (!ladder->levels || !ladder->bitmap || !ladder->summary)
+    {
+        fprintf(stderr, "Memory allocation failed for PriceLadder levels\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+PriceLadder *create_price_ladder(int is_buy, double base_price, double tick_size, int num_levels)
+{
+    PriceLadder *ladder = (PriceLadder *)arena_malloc(sizeof(PriceLadder));
+    if (!ladder)
+    {
+        fprintf(stderr, "Memory allocation failed for PriceLadder\n");
+        exit(EXIT_FAILURE);
+    }
+
+    allocate_levels(ladder, num_levels > 0 ? num_levels : 64);
+    ladder->base_price = base_price;
+    ladder->tick_size = tick_size;
+    ladder->is_buy = is_buy;
+    ladder->best = -1;
+    ladder->size = 0;
+
+    return ladder;
+}
+
+// Orders are owned by the book; only the ladder itself is released
+void free_price_ladder(PriceLadder *ladder)
+{
+    if (!ladder)
+        return;
+
+    arena_free(ladder->levels);
+    arena_free(ladder->bitmap);
+    arena_free(ladder->summary);
+    arena_free(ladder);
+}
+
+// Ticks from base_price, rounded to the nearest tick
+static long long tick_offset(PriceLadder *ladder, double price)
+{
+    double position = (price - ladder->base_price) / ladder->tick_size;
+    return position >= 0 ? (long long)(position + 0.5) : -(long long)(-position + 0.5);
+}
+
+int ladder_on_tick(PriceLadder *ladder, double price)
+{
+    double position = (price - ladder->base_price) / ladder->tick_size;
+    double error = position - (double)tick_offset(ladder, price);
+    return error < TICK_TOLERANCE && error > -TICK_TOLERANCE;
+}
+
+static void set_bit(PriceLadder *ladder, int idx)
+{
+    ladder->bitmap[idx >> 6] |= 1ULL << (idx & 63);
+    ladder->summary[idx >> 12] |= 1ULL << ((idx >> 6) & 63);
+}
+
+static void clear_bit(PriceLadder *ladder, int idx)
+{
+    int word = idx >> 6;
+    ladder->bitmap[word] &= ~(1ULL << (idx & 63));
+    if (ladder->bitmap[word] == 0)
+        ladder->summary[word >> 6] &= ~(1ULL << (word & 63));
+}
+
+// Lowest non-empty level at or above idx, -1 if none
+static int next_set_up(PriceLadder *ladder, int idx)
+{
+    if (idx < 0)
+        idx = 0;
+    if (idx >= ladder->num_levels)
+        return -1;
+
+    int word = idx >> 6;
+    unsigned long long bits = ladder->bitmap[word] & (~0ULL << (idx & 63));
+    if (bits)
+        return (word << 6) + __builtin_ctzll(bits);
+
+    // skip empty words through the summary
+    word++;
+    for (int s = word >> 6; s < ladder->summary_words && word < ladder->bitmap_words; s++)
+    {
+        unsigned long long words = ladder->summary[s];
+        if (s == word >> 6)
+            words &= ~0ULL << (word & 63);
+        if (words)
+        {
+            int w = (s << 6) + __builtin_ctzll(words);
+            return (w << 6) + __builtin_ctzll(ladder->bitmap[w]);
+        }
+    }
+
+    return -1;
+}
+
+// Highest non-empty level at or below idx, -1 if none
+static int next_set_down(PriceLadder *ladder, int idx)
+{
+    if (idx >= ladder->num_levels)
+        idx = ladder->num_levels - 1;
+    if (idx < 0)
+        return -1;
+
+    int word = idx >> 6;
+    unsigned long long bits = ladder->bitmap[word] & (~0ULL >> (63 - (idx & 63)));
+    if (bits)
+        return (word << 6) + 63 - __builtin_clzll(bits);
+
+    word--;
+    for (int s = word >> 6; s >= 0 && word >= 0; s--)
+    {
+        unsigned long long words = ladder->summary[s];
+        if (s == word >> 6)
+            words &= ~0ULL >> (63 - (word & 63));
+        if (words)
+        {
+            int w = (s << 6) + 63 - __builtin_clzll(words);
+            return (w << 6) + 63 - __builtin_clzll(ladder->bitmap[w]);
+        }
+    }
+
+    return -1;
+}
+
+static int is_better_level(PriceLadder *ladder, int a, int b)
+{
+    return ladder->is_buy ? a > b : a < b;
+}
+
+// Moves every level by shift ticks into a ladder of num_levels levels
+static void rebuild_levels(PriceLadder *ladder, long long shift, int num_levels)
+{
+    PriceLevel *old_levels = ladder->levels;
+    unsigned long long *old_bitmap = ladder->bitmap;
+    unsigned long long *old_summary = ladder->summary;
+    int old_num_levels = ladder->num_levels;
+
+    allocate_levels(ladder, num_levels);
+    ladder->base_price -= shift * ladder->tick_size;
+
+    for (int i = 0; i < old_num_levels; i++)
+    {
+        if (old_levels[i].count == 0)
+            continue;
+        int idx = (int)(i + shift);
+        ladder->levels[idx] = old_levels[i];
+        set_bit(ladder, idx);
+    }
+    if (ladder->best >= 0)
+        ladder->best = (int)(ladder->best + shift);
+
+    arena_free(old_levels);
+    arena_free(old_bitmap);
+    arena_free(old_summary);
+}
+
+// Levels after doubling until span fills at most half the ladder
+static long long grown_levels(PriceLadder *ladder, long long span)
+{
+    long long num_levels = ladder->num_levels;
+    while (num_levels < span * 2)
+        num_levels *= 2;
+    return num_levels;
+}
+
+// Re-centres the occupied range plus offset inside the ladder, growing it
+// when the range is wider than the ladder
+static void recenter(PriceLadder *ladder, long long offset)
+{
+    long long low = offset;
+    long long high = offset;
+    if (ladder->size > 0)
+    {
+        int lowest = next_set_up(ladder, 0);
+        int highest = next_set_down(ladder, ladder->num_levels - 1);
+        if (lowest < low)
+            low = lowest;
+        if (highest > high)
+            high = highest;
+    }
+
+    long long span = high - low + 1;
+    long long num_levels = grown_levels(ladder, span);
+    long long shift = (num_levels - span) / 2 - low;
+    rebuild_levels(ladder, shift, (int)num_levels);
+}
+
+int ladder_fits(PriceLadder *ladder, double price)
+{
+    double position = (price - ladder->base_price) / ladder->tick_size;
+    if (position >= 0 && position < ladder->num_levels - 0.5)
+        return 1;
+    // far enough out to overflow the span arithmetic
+    if (position > LADDER_MAX_LEVELS + (double)ladder->num_levels || position < -(double)LADDER_MAX_LEVELS)
+        return 0;
+
+    long long offset = tick_offset(ladder, price);
+    long long low = offset;
+    long long high = offset;
+    if (ladder->size > 0)
+    {
+        int lowest = next_set_up(ladder, 0);
+        int highest = next_set_down(ladder, ladder->num_levels - 1);
+        if (lowest < low)
+            low = lowest;
+        if (highest > high)
+            high = highest;
+    }
+    return grown_levels(ladder, high - low + 1) <= LADDER_MAX_LEVELS;
+}
+
+void ladder_insert(PriceLadder *ladder, Order *order)
+{
+    long long offset = tick_offset(ladder, order->price);
+    if (offset < 0 || offset >= ladder->num_levels)
+    {
+        recenter(ladder, offset);
+        offset = tick_offset(ladder, order->price);
+    }
+
+    int idx = (int)offset;
+    PriceLevel *level = &ladder->levels[idx];
+
+    // FIFO by arrival; almost always an append at the tail
+    Order *after = level->tail;
+    while (after && after->sequence > order->sequence)
+        after = after->level_prev;
+
+    order->level_prev = after;
+    order->level_next = after ? after->level_next : level->head;
+    if (order->level_next)
+        order->level_next->level_prev = order;
+    else
+        level->tail = order;
+    if (after)
+        after->level_next = order;
+    else
+        level->head = order;
+
+    if (level->count++ == 0)
+        set_bit(ladder, idx);
+    if (ladder->best < 0 || is_better_level(ladder, idx, ladder->best))
+        ladder->best = idx;
+
+    ladder->size++;
+}
+
+Order *ladder_top(PriceLadder *ladder)
+{
+    if (ladder->best < 0)
+        return NULL;
+
+    return ladder->levels[ladder->best].head;
+}
+
+int ladder_next_level(PriceLadder *ladder, int idx)
+{
+    return next_set_up(ladder, idx);
+}
+
+Order *ladder_worst(PriceLadder *ladder)
+{
+    if (ladder->best < 0)
+        return NULL;
+
+    int idx = ladder->is_buy ? next_set_up(ladder, 0) : next_set_down(ladder, ladder->num_levels - 1);
+    return ladder->levels[idx].tail;
+}
+
+void ladder_remove(PriceLadder *ladder, Order *order)
+{
+    int idx = (int)tick_offset(ladder, order->price);
+    PriceLevel *level = &ladder->levels[idx];
+
+    if (order->level_prev)
+        order->level_prev->level_next = order->level_next;
+    else
+        level->head = order->level_next;
+    if (order->level_next)
+        order->level_next->level_prev = order->level_prev;
+    else
+        level->tail = order->level_prev;
+
+    order->level_prev = NULL;
+    order->level_next = NULL;
+    ladder->size--;
+
+    if (--level->count == 0)
+    {
+        clear_bit(ladder, idx);
+        if (idx == ladder->best)
+            ladder->best = ladder->is_buy ? next_set_down(ladder, idx) : next_set_up(ladder, idx);
+    }
+}
+
+Order *ladder_extract_top(PriceLadder *ladder)
+{
+    Order *top = ladder_top(ladder);
+    if (top)
+        ladder_remove(ladder, top);
+
+    return top;
+}
+
+int ladder_collect(PriceLadder *ladder, Order **out)
+{
+    int count = 0;
+    int idx = ladder->best;
+    while (idx >= 0)
+    {
+        for (Order *order = ladder->levels[idx].head; order; order = order->level_next)
+            out[count++] = order;
+        idx = ladder->is_buy ? next_set_down(ladder, idx - 1) : next_set_up(ladder, idx + 1);
+    }
+
+    return count;
+}
+
+void ladder_clear(PriceLadder *ladder)
+{
+    memset(ladder->levels, 0, ladder->num_levels * sizeof(PriceLevel));
+    memset(ladder->bitmap, 0, ladder->bitmap_words * sizeof(unsigned long long));
+    memset(ladder->summary, 0, ladder->summary_words * sizeof(unsigned long long));
+    ladder->best = -1;
+    ladder->size = 0;
+}
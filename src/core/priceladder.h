@@ -0,0 +1,65 @@
+#ifndef PRICELADDER_H
+#define PRICELADDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order.h"
+
+/*
+    Dense price ladder: one FIFO level per tick between base_price and
+    base_price + num_levels * tick_size, with a two-level bitmap of
+    non-empty levels. The best level is cached; finding the next one after
+    it empties is a couple of count-trailing/leading-zero operations.
+
+    A ladder re-centres and doubles to follow prices outside it, up to
+    LADDER_MAX_LEVELS; prices it could not reach are refused (see
+    ladder_fits) rather than growing it without bound.
+*/
+
+#define LADDER_MAX_LEVELS (1 << 20)
+
+typedef struct PriceLevel
+{
+    Order *head; // earliest order
+    Order *tail;
+    int count;
+} PriceLevel;
+
+typedef struct PriceLadder
+{
+    PriceLevel *levels;
+    unsigned long long *bitmap;  // bit per level
+    unsigned long long *summary; // bit per non-zero bitmap word
+    int num_levels;              // multiple of 64
+    int bitmap_words;
+    int summary_words;
+    double base_price;
+    double tick_size;
+    int is_buy;                  // best is the highest level instead of the lowest
+    int best;                    // best non-empty level, -1 when empty
+    int size;
+} PriceLadder;
+
+PriceLadder *create_price_ladder(int is_buy, double base_price, double tick_size, int num_levels);
+void free_price_ladder(PriceLadder *ladder);
+int ladder_on_tick(PriceLadder *ladder, double price);
+// 1 if price is on the ladder, or within LADDER_MAX_LEVELS of the
+// resting orders so that the ladder can re-centre or grow to cover it
+int ladder_fits(PriceLadder *ladder, double price);
+// Re-centres or grows the ladder when price falls outside it; the price
+// must fit
+void ladder_insert(PriceLadder *ladder, Order *order);
+Order *ladder_top(PriceLadder *ladder);
+// Lowest non-empty level at or above idx, -1 if none; a level's price is
+// base_price + idx * tick_size
+int ladder_next_level(PriceLadder *ladder, int idx);
+// The last order of the worst non-empty level, NULL when empty
+Order *ladder_worst(PriceLadder *ladder);
+Order *ladder_extract_top(PriceLadder *ladder);
+void ladder_remove(PriceLadder *ladder, Order *order);
+// Writes every resting order, best level first, into out; returns the count
+int ladder_collect(PriceLadder *ladder, Order **out);
+void ladder_clear(PriceLadder *ladder);
+
+#endif
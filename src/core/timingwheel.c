@@ -0,0 +1,201 @@
+#include "timingwheel.h"
+
+TimingWheel *create_timing_wheel(long long now)
+{
+    TimingWheel *wheel = (TimingWheel *)arena_calloc(1, sizeof(TimingWheel));
+    if (!wheel)
+    {
+        fprintf(stderr, "Memory allocation failed for TimingWheel\n");
+        exit(EXIT_FAILURE);
+    }
+
+    wheel->now = now;
+
+    return wheel;
+}
+
+// Orders are owned by the book; only the wheel itself is released
+void free_timing_wheel(TimingWheel *wheel)
+{
+    arena_free(wheel);
+}
+
+static void link_order(Order **head, Order *order)
+{
+    order->timer_slot = head;
+    order->timer_prev = NULL;
+    order->timer_next = *head;
+    if (*head)
+        (*head)->timer_prev = order;
+    *head = order;
+}
+
+static void unlink_order(Order *order)
+{
+    if (order->timer_prev)
+        order->timer_prev->timer_next = order->timer_next;
+    else
+        *order->timer_slot = order->timer_next;
+    if (order->timer_next)
+        order->timer_next->timer_prev = order->timer_prev;
+
+    order->timer_prev = NULL;
+    order->timer_next = NULL;
+    order->timer_slot = NULL;
+}
+
+static int slot_level(TimingWheel *wheel, Order **slot)
+{
+    return (int)((slot - &wheel->slots[0][0]) / WHEEL_SLOTS);
+}
+
+// Picks the level by distance to expiry and the slot by the expiry's digit
+// at that level
+static void place_order(TimingWheel *wheel, Order *order, long long expire)
+{
+    long long delta = expire - wheel->now;
+    long long max_delta = (1LL << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+    // far expiries park in the top level and are re-placed on cascade
+    if (delta > max_delta)
+    {
+        delta = max_delta;
+        expire = wheel->now + max_delta;
+    }
+
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (1LL << (WHEEL_BITS * (level + 1))))
+        level++;
+
+    int slot = (int)((expire >> (WHEEL_BITS * level)) & WHEEL_MASK);
+    link_order(&wheel->slots[level][slot], order);
+    wheel->level_count[level]++;
+}
+
+void timing_wheel_schedule(TimingWheel *wheel, Order *order)
+{
+    if (!wheel || !order || order->timer_slot)
+        return;
+
+    if (order->tif == TIF_DAY)
+    {
+        link_order(&wheel->session, order);
+        wheel->session_size++;
+    }
+    else if (order->tif == TIF_GTT)
+    {
+        // the current tick's slot has already been processed
+        long long expire = order->expire_time > wheel->now ? order->expire_time : wheel->now + 1;
+        place_order(wheel, order, expire);
+        wheel->scheduled++;
+    }
+}
+
+void timing_wheel_remove(TimingWheel *wheel, Order *order)
+{
+    if (!wheel || !order || !order->timer_slot)
+        return;
+
+    if (order->timer_slot == &wheel->session)
+        wheel->session_size--;
+    else
+    {
+        wheel->level_count[slot_level(wheel, order->timer_slot)]--;
+        wheel->scheduled--;
+    }
+
+    unlink_order(order);
+}
+
+// Re-places a higher level slot into the levels below
+static void cascade(TimingWheel *wheel, int level, int slot)
+{
+    Order *order = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+
+    while (order)
+    {
+        Order *next = order->timer_next;
+        wheel->level_count[level]--;
+        place_order(wheel, order, order->expire_time > wheel->now ? order->expire_time : wheel->now);
+        order = next;
+    }
+}
+
+Order *timing_wheel_advance(TimingWheel *wheel, long long now)
+{
+    Order *expired = NULL;
+    if (!wheel)
+        return NULL;
+
+    while (wheel->now < now)
+    {
+        // With every level below k empty nothing can fire before the next
+        // level-k boundary, so jump to just before it
+        int k = 0;
+        while (k < WHEEL_LEVELS && wheel->level_count[k] == 0)
+            k++;
+        if (k == WHEEL_LEVELS)
+        {
+            wheel->now = now;
+            break;
+        }
+        if (k > 0)
+        {
+            long long span = 1LL << (WHEEL_BITS * k);
+            long long boundary = (wheel->now / span + 1) * span;
+            if (boundary > now)
+            {
+                wheel->now = now;
+                break;
+            }
+            wheel->now = boundary - 1;
+        }
+
+        wheel->now++;
+
+        // a level cascades when every digit below it wraps to zero
+        for (int level = 1; level < WHEEL_LEVELS; level++)
+        {
+            if (((wheel->now >> (WHEEL_BITS * (level - 1))) & WHEEL_MASK) != 0)
+                break;
+            cascade(wheel, level, (int)((wheel->now >> (WHEEL_BITS * level)) & WHEEL_MASK));
+        }
+
+        int slot = (int)(wheel->now & WHEEL_MASK);
+        Order *order = wheel->slots[0][slot];
+        wheel->slots[0][slot] = NULL;
+
+        while (order)
+        {
+            Order *next = order->timer_next;
+            order->timer_prev = NULL;
+            order->timer_slot = NULL;
+            order->timer_next = expired;
+            expired = order;
+            wheel->level_count[0]--;
+            wheel->scheduled--;
+            order = next;
+        }
+    }
+
+    return expired;
+}
+
+Order *timing_wheel_expire_session(TimingWheel *wheel)
+{
+    if (!wheel)
+        return NULL;
+
+    Order *expired = wheel->session;
+    for (Order *order = expired; order; order = order->timer_next)
+    {
+        order->timer_prev = NULL;
+        order->timer_slot = NULL;
+    }
+
+    wheel->session = NULL;
+    wheel->session_size = 0;
+
+    return expired;
+}
@@ -0,0 +1,42 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order.h"
+
+/*
+    Hierarchical timing wheel for order expiry. Level 0 has one slot per
+    tick; each higher level slot spans a full rotation of the level below.
+    Orders are linked intrusively, so scheduling, unscheduling and expiring
+    are O(1) per order.
+*/
+
+#define WHEEL_BITS 8
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+
+typedef struct TimingWheel
+{
+    long long now;                              // current tick
+    Order *slots[WHEEL_LEVELS][WHEEL_SLOTS];    // GTT orders by expiry
+    Order *session;                             // DAY orders, expired together
+    int scheduled;                              // orders in slots
+    int level_count[WHEEL_LEVELS];              // orders per level, for skipping idle ticks
+    int session_size;                           // orders in session
+} TimingWheel;
+
+TimingWheel *create_timing_wheel(long long now);
+void free_timing_wheel(TimingWheel *wheel);
+// GTT orders go into the wheel by expire_time, DAY orders into the session list
+void timing_wheel_schedule(TimingWheel *wheel, Order *order);
+void timing_wheel_remove(TimingWheel *wheel, Order *order);
+// Moves the clock to now and returns the expired orders chained through
+// timer_next (already unlinked from the wheel)
+Order *timing_wheel_advance(TimingWheel *wheel, long long now);
+// Returns every DAY order chained through timer_next and empties the list
+Order *timing_wheel_expire_session(TimingWheel *wheel);
+
+#endif
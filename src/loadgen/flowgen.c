@@ -0,0 +1,423 @@
+#include "flowgen.h"
+
+#include <math.h>
+
+#define FLOW_WRITE_BATCH 4096
+
+static uint64_t next_random(uint64_t *state)
+{
+    // splitmix64
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in (0, 1], so its log is finite
+static double next_uniform(uint64_t *state)
+{
+    return (double)((next_random(state) >> 11) + 1) * 0x1.0p-53;
+}
+
+static int next_below(uint64_t *state, int n)
+{
+    return (int)(((next_random(state) >> 32) * (uint64_t)n) >> 32);
+}
+
+FlowConfig default_flow_config()
+{
+    FlowConfig config;
+    config.seed = 1;
+    config.arrivals = FLOW_POISSON;
+    config.rate = 1e6;
+    config.hawkes_alpha = 7e3;
+    config.hawkes_beta = 1e4;
+    config.mid = 100;
+    config.tick = 0.01;
+    config.tail_exponent = 1.5;
+    config.max_distance = 1000;
+    config.cross_ratio = 0.05;
+    config.cancel_ratio = 0.45;
+    config.modify_ratio = 0.05;
+    config.symbols = 64;
+    config.symbol_skew = 1.0;
+    config.min_quantity = 1;
+    config.max_quantity = 100;
+    config.max_live = 4096;
+    config.first_order_id = 1;
+    return config;
+}
+
+static int valid_config(const FlowConfig *config)
+{
+    if (config->rate <= 0 || config->tick <= 0 || config->tail_exponent <= 0 || config->max_distance < 1)
+        return 0;
+    if (config->arrivals == FLOW_HAWKES)
+    {
+        if (config->hawkes_alpha < 0 || config->hawkes_beta <= 0 || config->hawkes_alpha >= config->hawkes_beta)
+            return 0;
+    }
+    else if (config->arrivals != FLOW_POISSON)
+        return 0;
+    // the farthest passive bid must still have a positive price
+    if (config->mid - config->max_distance * config->tick <= 0)
+        return 0;
+    if (config->cross_ratio < 0 || config->cross_ratio > 1 || config->cancel_ratio < 0 ||
+        config->modify_ratio < 0 || config->cancel_ratio + config->modify_ratio > 1)
+        return 0;
+    if (config->symbols < 1 || config->symbol_skew < 0)
+        return 0;
+    return config->min_quantity >= 1 && config->max_quantity >= config->min_quantity &&
+           config->max_live >= 1 && config->first_order_id >= 1;
+}
+
+// Walker alias table over weights[0..n): one draw and one compare per sample
+static void build_alias(const double *weights, int n, double *prob, int *alias)
+{
+    double total = 0;
+    for (int i = 0; i < n; i++)
+        total += weights[i];
+
+    int *small = (int *)malloc(2 * n * sizeof(int));
+    if (!small)
+    {
+        fprintf(stderr, "Memory allocation failed for alias worklist\n");
+        exit(EXIT_FAILURE);
+    }
+    int *large = small + n;
+    int small_count = 0;
+    int large_count = 0;
+    for (int i = 0; i < n; i++)
+    {
+        prob[i] = weights[i] * n / total;
+        alias[i] = i;
+        if (prob[i] < 1.0)
+            small[small_count++] = i;
+        else
+            large[large_count++] = i;
+    }
+    while (small_count > 0 && large_count > 0)
+    {
+        int s = small[--small_count];
+        int l = large[large_count - 1];
+        alias[s] = l;
+        prob[l] -= 1.0 - prob[s];
+        if (prob[l] < 1.0)
+        {
+            large_count--;
+            small[small_count++] = l;
+        }
+    }
+    // whatever is left is 1 up to rounding
+    while (large_count > 0)
+        prob[large[--large_count]] = 1.0;
+    while (small_count > 0)
+        prob[small[--small_count]] = 1.0;
+    free(small);
+}
+
+static int sample_alias(uint64_t *state, const double *prob, const int *alias, int n)
+{
+    uint64_t r = next_random(state);
+    int i = (int)(((r >> 32) * (uint64_t)n) >> 32);
+    double u = (double)(r & 0xffffffffULL) * 0x1.0p-32;
+    return u < prob[i] ? i : alias[i];
+}
+
+FlowGenerator *create_flow_generator(const FlowConfig *config)
+{
+    if (!config || !valid_config(config))
+        return NULL;
+
+    FlowGenerator *generator = (FlowGenerator *)calloc(1, sizeof(FlowGenerator));
+    if (!generator)
+    {
+        fprintf(stderr, "Memory allocation failed for FlowGenerator\n");
+        exit(EXIT_FAILURE);
+    }
+    generator->config = *config;
+    generator->rng = config->seed;
+    generator->next_order_id = config->first_order_id;
+
+    int symbols = config->symbols;
+    int distances = config->max_distance;
+    generator->symbol_prob = (double *)malloc(symbols * sizeof(double));
+    generator->symbol_alias = (int *)malloc(symbols * sizeof(int));
+    generator->distance_prob = (double *)malloc(distances * sizeof(double));
+    generator->distance_alias = (int *)malloc(distances * sizeof(int));
+    generator->symbols = (FlowSymbol *)calloc(symbols, sizeof(FlowSymbol));
+    generator->pool = (FlowOrder *)malloc((size_t)symbols * config->max_live * sizeof(FlowOrder));
+    double *weights = (double *)malloc((symbols > distances ? symbols : distances) * sizeof(double));
+    if (!generator->symbol_prob || !generator->symbol_alias || !generator->distance_prob ||
+        !generator->distance_alias || !generator->symbols || !generator->pool || !weights)
+    {
+        fprintf(stderr, "Memory allocation failed for FlowGenerator tables\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Zipf over symbols
+    for (int s = 0; s < symbols; s++)
+        weights[s] = pow(s + 1, -config->symbol_skew);
+    build_alias(weights, symbols, generator->symbol_prob, generator->symbol_alias);
+
+    // discrete power law: P(distance = d) = d^-a - (d + 1)^-a, the tail
+    // beyond max_distance folded into the last entry
+    for (int d = 1; d <= distances; d++)
+    {
+        double survival = pow(d, -config->tail_exponent);
+        weights[d - 1] = d < distances ? survival - pow(d + 1, -config->tail_exponent) : survival;
+    }
+    build_alias(weights, distances, generator->distance_prob, generator->distance_alias);
+    free(weights);
+
+    for (int s = 0; s < symbols; s++)
+        generator->symbols[s].live = generator->pool + (size_t)s * config->max_live;
+    return generator;
+}
+
+void free_flow_generator(FlowGenerator *generator)
+{
+    if (!generator)
+        return;
+
+    free(generator->symbol_prob);
+    free(generator->symbol_alias);
+    free(generator->distance_prob);
+    free(generator->distance_alias);
+    free(generator->symbols);
+    free(generator->pool);
+    free(generator);
+}
+
+// Slot of the i-th oldest tracked order
+static int live_slot(const FlowSymbol *symbol, int i, int capacity)
+{
+    int slot = symbol->head + i;
+    return slot < capacity ? slot : slot - capacity;
+}
+
+static double next_arrival(FlowGenerator *generator)
+{
+    const FlowConfig *config = &generator->config;
+    double wait = -log(next_uniform(&generator->rng)) / config->rate;
+    if (config->arrivals == FLOW_POISSON)
+        return wait;
+
+    // Exact simulation for an exponential kernel (Dassios and Zhao): the
+    // next arrival is the earlier of the baseline's and the decaying
+    // excitation's, and the excitation's may never come
+    if (generator->excitation > 0)
+    {
+        double d = 1 + config->hawkes_beta * log(next_uniform(&generator->rng)) / generator->excitation;
+        if (d > 0)
+        {
+            double excited = -log(d) / config->hawkes_beta;
+            if (excited < wait)
+                wait = excited;
+        }
+    }
+    generator->excitation = generator->excitation * exp(-config->hawkes_beta * wait) + config->hawkes_alpha;
+    return wait;
+}
+
+static double next_price(FlowGenerator *generator, char side)
+{
+    const FlowConfig *config = &generator->config;
+    int distance = 1 + sample_alias(&generator->rng, generator->distance_prob, generator->distance_alias,
+                                    config->max_distance);
+    int through = next_uniform(&generator->rng) <= config->cross_ratio;
+    // a buy below mid or a sell above it rests; the other way it crosses
+    int above = (side == 'S') != through;
+    return config->mid + (above ? distance : -distance) * config->tick;
+}
+
+static int next_quantity(FlowGenerator *generator)
+{
+    const FlowConfig *config = &generator->config;
+    return config->min_quantity + next_below(&generator->rng, config->max_quantity - config->min_quantity + 1);
+}
+
+void flow_next(FlowGenerator *generator, FlowMessage *out)
+{
+    const FlowConfig *config = &generator->config;
+    generator->time += next_arrival(generator);
+
+    int s = sample_alias(&generator->rng, generator->symbol_prob, generator->symbol_alias, config->symbols);
+    FlowSymbol *symbol = &generator->symbols[s];
+
+    out->time_ns = (uint64_t)(generator->time * 1e9);
+    out->symbol = (uint32_t)s;
+    out->reserved = 0;
+
+    double u = next_uniform(&generator->rng);
+    if (symbol->count > 0 && u <= config->cancel_ratio + config->modify_ratio)
+    {
+        int slot = live_slot(symbol, next_below(&generator->rng, symbol->count), config->max_live);
+        FlowOrder order = symbol->live[slot];
+        out->order_id = order.order_id;
+        out->side = order.side;
+        if (u <= config->cancel_ratio)
+        {
+            // the newest entry takes the cancelled one's slot
+            int last = live_slot(symbol, symbol->count - 1, config->max_live);
+            symbol->live[slot] = symbol->live[last];
+            symbol->count--;
+            out->type = SEQ_CANCEL;
+            out->quantity = 0;
+            out->price = 0;
+        }
+        else
+        {
+            out->type = SEQ_MODIFY;
+            out->quantity = next_quantity(generator);
+            out->price = next_price(generator, order.side);
+        }
+    }
+    else
+    {
+        char side = (next_random(&generator->rng) & 1) ? 'B' : 'S';
+        if (symbol->count == config->max_live)
+        {
+            symbol->head = live_slot(symbol, 1, config->max_live);
+            symbol->count--;
+        }
+        FlowOrder *order = &symbol->live[live_slot(symbol, symbol->count++, config->max_live)];
+        order->order_id = generator->next_order_id++;
+        order->side = side;
+
+        out->type = SEQ_NEW_ORDER;
+        out->side = side;
+        out->order_id = order->order_id;
+        out->quantity = next_quantity(generator);
+        out->price = next_price(generator, side);
+    }
+    generator->counts[out->type]++;
+}
+
+void flow_generate(FlowGenerator *generator, FlowMessage *out, int count)
+{
+    for (int i = 0; i < count; i++)
+        flow_next(generator, &out[i]);
+}
+
+void flow_to_seq(const FlowMessage *message, SeqMessage *out)
+{
+    memset(out, 0, sizeof(SeqMessage));
+    out->user_data = message->symbol;
+    out->type = message->type;
+    out->side = message->side;
+    out->order_id = message->order_id;
+    out->quantity = message->quantity;
+    out->price = message->price;
+    out->tif = TIF_GTC;
+}
+
+int flow_feed(FlowGenerator *generator, IngressQueue *const *queues, int count, int max)
+{
+    if (!generator || !queues || count <= 0)
+        return 0;
+
+    int fed = 0;
+    SeqMessage message;
+    while (fed < max)
+    {
+        if (!generator->has_pending)
+        {
+            flow_next(generator, &generator->pending);
+            generator->has_pending = 1;
+        }
+        flow_to_seq(&generator->pending, &message);
+        if (ingress_push(queues[generator->pending.symbol % count], &message) != 0)
+            break;
+        generator->has_pending = 0;
+        fed++;
+    }
+    return fed;
+}
+
+int flow_write_file(FlowGenerator *generator, const char *path, uint64_t count)
+{
+    if (!generator || !path)
+        return -1;
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return -1;
+
+    FlowFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FLOW_FILE_MAGIC;
+    header.version = FLOW_FILE_VERSION;
+    header.record_size = sizeof(FlowMessage);
+    header.seed = generator->config.seed;
+    header.count = count;
+    int failed = fwrite(&header, sizeof(header), 1, file) != 1;
+
+    FlowMessage *batch = (FlowMessage *)malloc(FLOW_WRITE_BATCH * sizeof(FlowMessage));
+    if (!batch)
+    {
+        fprintf(stderr, "Memory allocation failed for flow write batch\n");
+        exit(EXIT_FAILURE);
+    }
+    for (uint64_t written = 0; !failed && written < count;)
+    {
+        int n = count - written < FLOW_WRITE_BATCH ? (int)(count - written) : FLOW_WRITE_BATCH;
+        flow_generate(generator, batch, n);
+        failed = fwrite(batch, sizeof(FlowMessage), n, file) != (size_t)n;
+        written += n;
+    }
+    free(batch);
+
+    if (fclose(file) != 0)
+        failed = 1;
+    return failed ? -1 : 0;
+}
+
+FlowReader *open_flow_file(const char *path)
+{
+    if (!path)
+        return NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    FlowReader *reader = (FlowReader *)calloc(1, sizeof(FlowReader));
+    if (!reader)
+    {
+        fprintf(stderr, "Memory allocation failed for FlowReader\n");
+        exit(EXIT_FAILURE);
+    }
+    reader->file = file;
+    if (fread(&reader->header, sizeof(FlowFileHeader), 1, file) != 1 || reader->header.magic != FLOW_FILE_MAGIC ||
+        reader->header.version != FLOW_FILE_VERSION || reader->header.record_size != sizeof(FlowMessage))
+    {
+        close_flow_file(reader);
+        return NULL;
+    }
+    reader->remaining = reader->header.count;
+    return reader;
+}
+
+int flow_read(FlowReader *reader, FlowMessage *out, int max)
+{
+    if (!reader || max <= 0)
+        return 0;
+
+    int n = reader->remaining < (uint64_t)max ? (int)reader->remaining : max;
+    if (n == 0)
+        return 0;
+    if (fread(out, sizeof(FlowMessage), n, reader->file) != (size_t)n)
+        return -1;
+    reader->remaining -= n;
+    return n;
+}
+
+void close_flow_file(FlowReader *reader)
+{
+    if (!reader)
+        return;
+
+    fclose(reader->file);
+    free(reader);
+}
@@ -0,0 +1,140 @@
+#ifndef FLOWGEN_H
+#define FLOWGEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "sequencer/sequencer.h"
+
+/*
+    Synthetic order flow for load testing.
+
+    Messages arrive as a Poisson process or as a self-exciting Hawkes
+    process with an exponential kernel (each arrival raises the rate by
+    alpha, which decays at beta per second), simulated exactly rather
+    than by thinning. Each message picks a symbol from a Zipf
+    distribution, then either cancels or modifies one of that symbol's
+    live orders or places a new one whose distance from mid in ticks is
+    power-law distributed. A flow is a pure function of its FlowConfig:
+    the same seed gives the same messages, byte for byte.
+
+    The generator does not see the book, so a cancel can name an order
+    that has already traded; the engine rejects it as it would a late
+    cancel from a client.
+*/
+
+#define FLOW_FILE_MAGIC 0x574f4c46u // "FLOW"
+#define FLOW_FILE_VERSION 1
+
+typedef enum
+{
+    FLOW_POISSON,
+    FLOW_HAWKES
+} FlowArrivals;
+
+typedef struct
+{
+    uint64_t seed;
+    int arrivals;         // FlowArrivals
+    double rate;          // baseline messages per second, all symbols together
+    double hawkes_alpha;  // rate added per arrival; alpha / beta < 1 keeps it stationary
+    double hawkes_beta;   // decay of the excitation per second
+    double mid;
+    double tick;
+    double tail_exponent; // P(distance >= d ticks) = d^-tail_exponent
+    int max_distance;     // ticks from mid; farther draws are clamped
+    double cross_ratio;   // new orders priced through mid (marketable)
+    double cancel_ratio;  // fraction of messages that cancel a live order
+    double modify_ratio;  // fraction that reprice or resize one
+    int symbols;
+    double symbol_skew;   // Zipf exponent; 0 spreads flow evenly
+    int min_quantity;
+    int max_quantity;
+    int max_live;         // live orders tracked per symbol; a full symbol forgets its oldest
+    int first_order_id;   // ids are unique across symbols
+} FlowConfig;
+
+// One generated message; order_id is the target of a cancel or modify
+typedef struct
+{
+    uint64_t time_ns; // since the start of the flow
+    uint32_t symbol;
+    uint8_t type;     // SeqMessageType
+    char side;
+    uint16_t reserved;
+    int order_id;
+    int quantity;
+    double price;
+} FlowMessage;
+
+typedef struct
+{
+    int order_id;
+    char side;
+} FlowOrder;
+
+typedef struct
+{
+    FlowOrder *live; // ring, oldest at head
+    int head;
+    int count;
+} FlowSymbol;
+
+typedef struct
+{
+    FlowConfig config;
+    uint64_t rng;
+    double time;          // seconds since the start
+    double excitation;    // Hawkes intensity above the baseline
+    double *symbol_prob;  // alias tables: symbols by Zipf weight,
+    int *symbol_alias;    // distances by the power law
+    double *distance_prob;
+    int *distance_alias;
+    FlowSymbol *symbols;
+    FlowOrder *pool;      // backing store of every symbol's ring
+    int next_order_id;
+    int has_pending;      // a message flow_feed could not queue yet
+    FlowMessage pending;
+    uint64_t counts[3];   // messages per SeqMessageType
+} FlowGenerator;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size; // sizeof(FlowMessage)
+    uint64_t seed;
+    uint64_t count;       // records that follow
+} FlowFileHeader;
+
+typedef struct
+{
+    FILE *file;
+    FlowFileHeader header;
+    uint64_t remaining;
+} FlowReader;
+
+FlowConfig default_flow_config();
+// NULL when the config is inconsistent (ratios, ranges, rates)
+FlowGenerator *create_flow_generator(const FlowConfig *config);
+void free_flow_generator(FlowGenerator *generator);
+
+void flow_next(FlowGenerator *generator, FlowMessage *out);
+// Fills out with the next count messages
+void flow_generate(FlowGenerator *generator, FlowMessage *out, int count);
+
+// Engine ingress message for a flow message; the symbol goes in user_data
+void flow_to_seq(const FlowMessage *message, SeqMessage *out);
+// Queues up to max messages, symbol s to queues[s % count]; stops early
+// at a full queue and resumes with the same message on the next call.
+// Returns the messages queued
+int flow_feed(FlowGenerator *generator, IngressQueue *const *queues, int count, int max);
+
+// Writes count messages after a FlowFileHeader; 0 on success, -1 on I/O failure
+int flow_write_file(FlowGenerator *generator, const char *path, uint64_t count);
+// NULL if the file is missing or not a flow file of this version
+FlowReader *open_flow_file(const char *path);
+// Reads up to max messages; returns the count, 0 at the end, -1 on a short file
+int flow_read(FlowReader *reader, FlowMessage *out, int max);
+void close_flow_file(FlowReader *reader);
+
+#endif
@@ -0,0 +1,130 @@
+#include "levelbook.h"
+
+// Orders the side worst to best so the busy end is at the back
+static int level_before(const MdSide *side, double a, double b)
+{
+    return side->is_buy ? a < b : a > b;
+}
+
+// Index of the level at price, or where it would be inserted
+static int find_level(const MdSide *side, double price, int *found)
+{
+    int low = 0;
+    int high = side->count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (level_before(side, side->levels[mid].price, price))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    *found = low < side->count && side->levels[low].price == price;
+    return low;
+}
+
+static void adjust_level(MdSide *side, double price, long long quantity, int orders)
+{
+    int found;
+    int i = find_level(side, price, &found);
+    if (!found)
+    {
+        if (quantity <= 0 && orders <= 0)
+            return;
+        if (side->count == side->capacity)
+        {
+            side->capacity = side->capacity > 0 ? side->capacity * 2 : 64;
+            side->levels = (MdLevel *)realloc(side->levels, side->capacity * sizeof(MdLevel));
+            if (!side->levels)
+            {
+                fprintf(stderr, "Memory reallocation failed for market data levels\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        memmove(&side->levels[i + 1], &side->levels[i], (side->count - i) * sizeof(MdLevel));
+        side->levels[i].price = price;
+        side->levels[i].quantity = 0;
+        side->levels[i].orders = 0;
+        side->count++;
+    }
+
+    side->levels[i].quantity += quantity;
+    side->levels[i].orders += orders;
+    if (side->levels[i].orders <= 0)
+    {
+        memmove(&side->levels[i], &side->levels[i + 1], (side->count - i - 1) * sizeof(MdLevel));
+        side->count--;
+    }
+}
+
+static void seed_side(OrderHeap *heap, MdSide *side)
+{
+    if (heap->size == 0)
+        return;
+
+    Order **orders = (Order **)malloc(heap->size * sizeof(Order *));
+    if (!orders)
+    {
+        fprintf(stderr, "Memory allocation failed for market data seed\n");
+        exit(EXIT_FAILURE);
+    }
+    int count = collectOrders(heap, orders);
+    for (int i = 0; i < count; i++)
+        adjust_level(side, orders[i]->price, orders[i]->quantity, 1);
+    free(orders);
+}
+
+void init_level_book(LevelBook *levels)
+{
+    memset(levels, 0, sizeof(LevelBook));
+    levels->bids.is_buy = 1;
+}
+
+void free_level_book(LevelBook *levels)
+{
+    free(levels->bids.levels);
+    free(levels->asks.levels);
+    init_level_book(levels);
+}
+
+void level_book_seed(LevelBook *levels, OrderBook *book)
+{
+    seed_side(book->buy_orders, &levels->bids);
+    seed_side(book->sell_orders, &levels->asks);
+}
+
+static MdSide *order_side(LevelBook *levels, const Order *order)
+{
+    return order->side == 'B' ? &levels->bids : &levels->asks;
+}
+
+void level_book_apply(LevelBook *levels, const BookEvent *event)
+{
+    const Order *order = event->order;
+    switch (event->type)
+    {
+    case BOOK_EVENT_ADD:
+        adjust_level(order_side(levels, order), order->price, event->quantity, 1);
+        break;
+    case BOOK_EVENT_TRADE:
+        // both orders rest at their own limit prices
+        adjust_level(order_side(levels, order), order->price, -event->quantity, 0);
+        adjust_level(order_side(levels, event->counterparty), event->counterparty->price,
+                     -event->quantity, 0);
+        break;
+    case BOOK_EVENT_REDUCE:
+        adjust_level(order_side(levels, order), order->price, -event->quantity, 0);
+        break;
+    case BOOK_EVENT_REMOVE:
+        adjust_level(order_side(levels, order), order->price, -event->quantity, -1);
+        break;
+    }
+}
+
+int level_book_best(const MdSide *side, MdLevel *out, int max)
+{
+    int n = side->count < max ? side->count : max;
+    for (int i = 0; i < n; i++)
+        out[i] = side->levels[side->count - 1 - i];
+    return n;
+}
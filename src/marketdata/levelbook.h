@@ -0,0 +1,39 @@
+#ifndef LEVELBOOK_H
+#define LEVELBOOK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "orderbook.h"
+#include "mdfeed.h"
+
+/*
+    Price-level view of an OrderBook (quantity and order count per
+    price) kept up to date from its BookEvents. Each side is a sorted
+    array ordered worst to best, so activity near the touch works at the
+    back of the array and reading the best levels is O(depth).
+*/
+
+typedef struct
+{
+    MdLevel *levels; // worst price first, best last
+    int count;
+    int capacity;
+    int is_buy;
+} MdSide;
+
+typedef struct
+{
+    MdSide bids;
+    MdSide asks;
+} LevelBook;
+
+void init_level_book(LevelBook *levels);
+void free_level_book(LevelBook *levels);
+// Adds the book's resting orders; used when attaching mid-session
+void level_book_seed(LevelBook *levels, OrderBook *book);
+void level_book_apply(LevelBook *levels, const BookEvent *event);
+// Copies up to max levels, best first; returns the count
+int level_book_best(const MdSide *side, MdLevel *out, int max);
+
+#endif
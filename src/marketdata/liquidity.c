@@ -0,0 +1,273 @@
+#include "liquidity.h"
+
+#include <math.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define LIQUIDITY_X86 1
+#endif
+
+static atomic_int simd_state = -1; // -1 until the CPU has been checked
+
+int liquidity_simd_enabled()
+{
+    int state = atomic_load_explicit(&simd_state, memory_order_relaxed);
+    if (state < 0)
+    {
+#ifdef LIQUIDITY_X86
+        state = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+        state = 0;
+#endif
+        atomic_store_explicit(&simd_state, state, memory_order_relaxed);
+    }
+    return state;
+}
+
+void liquidity_set_simd(int enabled)
+{
+    atomic_store_explicit(&simd_state, -1, memory_order_relaxed);
+    if (!enabled || !liquidity_simd_enabled())
+        atomic_store_explicit(&simd_state, 0, memory_order_relaxed);
+}
+
+int gather_levels(const MdSide *side, int max, double *price, double *quantity)
+{
+    int n = side->count < max ? side->count : max;
+    for (int i = 0; i < n; i++)
+    {
+        const MdLevel *level = &side->levels[side->count - 1 - i];
+        price[i] = level->price;
+        quantity[i] = (double)level->quantity;
+    }
+    return n;
+}
+
+/* scalar kernels */
+
+static double sum_scalar(const double *x, int n)
+{
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += x[i];
+    return sum;
+}
+
+static double dot_scalar(const double *x, const double *y, int n)
+{
+    double dot = 0;
+    for (int i = 0; i < n; i++)
+        dot += x[i] * y[i];
+    return dot;
+}
+
+static void prefix_scalar(const double *x, int n, double *out)
+{
+    double sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += x[i];
+        out[i] = sum;
+    }
+}
+
+// Levels fully swept before size is reached; *swept is their quantity
+static int sweep_scalar(const double *quantity, int n, double size, double *swept)
+{
+    double sum = 0;
+    int i = 0;
+    while (i < n && sum + quantity[i] < size)
+        sum += quantity[i++];
+    *swept = sum;
+    return i;
+}
+
+/* AVX2 kernels */
+
+#ifdef LIQUIDITY_X86
+
+__attribute__((target("avx2,fma"))) static double hsum(__m256d v)
+{
+    __m128d low = _mm256_castpd256_pd128(v);
+    __m128d high = _mm256_extractf128_pd(v, 1);
+    low = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+__attribute__((target("avx2,fma"))) static double sum_avx2(const double *x, int n)
+{
+    __m256d a = _mm256_setzero_pd();
+    __m256d b = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        a = _mm256_add_pd(a, _mm256_loadu_pd(x + i));
+        b = _mm256_add_pd(b, _mm256_loadu_pd(x + i + 4));
+    }
+    if (i + 4 <= n)
+    {
+        a = _mm256_add_pd(a, _mm256_loadu_pd(x + i));
+        i += 4;
+    }
+    double sum = hsum(_mm256_add_pd(a, b));
+    for (; i < n; i++)
+        sum += x[i];
+    return sum;
+}
+
+__attribute__((target("avx2,fma"))) static double dot_avx2(const double *x, const double *y, int n)
+{
+    __m256d a = _mm256_setzero_pd();
+    __m256d b = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        a = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a);
+        b = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), b);
+    }
+    if (i + 4 <= n)
+    {
+        a = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a);
+        i += 4;
+    }
+    double dot = hsum(_mm256_add_pd(a, b));
+    for (; i < n; i++)
+        dot += x[i] * y[i];
+    return dot;
+}
+
+// In-register inclusive scan of four lanes
+__attribute__((target("avx2,fma"))) static __m256d scan4(__m256d x)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    // [a b c d] + [0 a b c]
+    x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x1));
+    // + [0 0 a a+b]
+    x = _mm256_add_pd(x, _mm256_blend_pd(_mm256_permute4x64_pd(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x3));
+    return x;
+}
+
+__attribute__((target("avx2,fma"))) static void prefix_avx2(const double *x, int n, double *out)
+{
+    __m256d carry = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d sum = _mm256_add_pd(scan4(_mm256_loadu_pd(x + i)), carry);
+        _mm256_storeu_pd(out + i, sum);
+        carry = _mm256_permute4x64_pd(sum, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    double sum = _mm256_cvtsd_f64(carry);
+    for (; i < n; i++)
+    {
+        sum += x[i];
+        out[i] = sum;
+    }
+}
+
+__attribute__((target("avx2,fma"))) static int sweep_avx2(const double *quantity, int n, double size, double *swept)
+{
+    const __m256d target = _mm256_set1_pd(size);
+    __m256d carry = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d cumulative = _mm256_add_pd(scan4(_mm256_loadu_pd(quantity + i)), carry);
+        int reached = _mm256_movemask_pd(_mm256_cmp_pd(cumulative, target, _CMP_GE_OQ));
+        if (reached)
+        {
+            // the first level whose cumulative quantity reaches size
+            int k = __builtin_ctz(reached);
+            double lanes[4];
+            _mm256_storeu_pd(lanes, cumulative);
+            *swept = k == 0 ? _mm256_cvtsd_f64(carry) : lanes[k - 1];
+            return i + k;
+        }
+        carry = _mm256_permute4x64_pd(cumulative, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    double sum = _mm256_cvtsd_f64(carry);
+    while (i < n && sum + quantity[i] < size)
+        sum += quantity[i++];
+    *swept = sum;
+    return i;
+}
+
+#endif
+
+/* dispatch */
+
+static double sum(const double *x, int n)
+{
+#ifdef LIQUIDITY_X86
+    if (liquidity_simd_enabled())
+        return sum_avx2(x, n);
+#endif
+    return sum_scalar(x, n);
+}
+
+static double dot(const double *x, const double *y, int n)
+{
+#ifdef LIQUIDITY_X86
+    if (liquidity_simd_enabled())
+        return dot_avx2(x, y, n);
+#endif
+    return dot_scalar(x, y, n);
+}
+
+static int sweep(const double *quantity, int n, double size, double *swept)
+{
+#ifdef LIQUIDITY_X86
+    if (liquidity_simd_enabled())
+        return sweep_avx2(quantity, n, size, swept);
+#endif
+    return sweep_scalar(quantity, n, size, swept);
+}
+
+void cumulative_depth(const double *quantity, int n, double *out)
+{
+#ifdef LIQUIDITY_X86
+    if (liquidity_simd_enabled())
+    {
+        prefix_avx2(quantity, n, out);
+        return;
+    }
+#endif
+    prefix_scalar(quantity, n, out);
+}
+
+double weighted_mid(const double *bid_price, const double *bid_quantity, int bid_levels,
+                    const double *ask_price, const double *ask_quantity, int ask_levels)
+{
+    double bid_size = sum(bid_quantity, bid_levels);
+    double ask_size = sum(ask_quantity, ask_levels);
+    if (!(bid_size > 0) || !(ask_size > 0))
+        return NAN;
+
+    double bid_vwap = dot(bid_price, bid_quantity, bid_levels) / bid_size;
+    double ask_vwap = dot(ask_price, ask_quantity, ask_levels) / ask_size;
+    // the heavier side pulls the mid toward the other side's price
+    return (bid_vwap * ask_size + ask_vwap * bid_size) / (bid_size + ask_size);
+}
+
+double book_imbalance(const double *bid_quantity, int bid_levels, const double *ask_quantity, int ask_levels)
+{
+    double bid_size = sum(bid_quantity, bid_levels);
+    double ask_size = sum(ask_quantity, ask_levels);
+    double total = bid_size + ask_size;
+    return total > 0 ? (bid_size - ask_size) / total : 0;
+}
+
+double expected_slippage(const double *price, const double *quantity, int n, double size)
+{
+    if (n <= 0 || !(size > 0))
+        return n > 0 ? 0 : INFINITY;
+
+    double swept;
+    int k = sweep(quantity, n, size, &swept);
+    if (k == n)
+        return INFINITY;
+
+    double cost = dot(price, quantity, k) + price[k] * (size - swept);
+    return fabs(cost / size - price[0]);
+}
@@ -0,0 +1,37 @@
+#ifndef LIQUIDITY_H
+#define LIQUIDITY_H
+
+#include "levelbook.h"
+
+/*
+    Depth and liquidity kernels over contiguous per-level arrays, best
+    level first: price[i] and quantity[i] for i < n. They are meant for
+    risk loops that run on every book update, so they allocate nothing
+    and use AVX2 when the CPU has it (checked once at run time), with a
+    scalar fallback. Quantities are doubles so both paths vectorize;
+    sums of whole quantities below 2^53 are exact either way.
+*/
+
+// Copies up to max levels of side into price/quantity, best first;
+// returns the count
+int gather_levels(const MdSide *side, int max, double *price, double *quantity);
+
+// out[i] = quantity[0] + ... + quantity[i]
+void cumulative_depth(const double *quantity, int n, double *out);
+// Each side's VWAP weighted by the opposite side's size (the microprice
+// when given one level per side); NAN if either side is empty
+double weighted_mid(const double *bid_price, const double *bid_quantity, int bid_levels,
+                    const double *ask_price, const double *ask_quantity, int ask_levels);
+// (bid size - ask size) / (bid size + ask size) over the levels given, in
+// [-1, 1]; 0 when both sides are empty
+double book_imbalance(const double *bid_quantity, int bid_levels, const double *ask_quantity, int ask_levels);
+// Distance between the average price of sweeping size through the
+// levels and the best price; INFINITY if the levels hold less than size
+double expected_slippage(const double *price, const double *quantity, int n, double size);
+
+// 1 if the kernels run on AVX2
+int liquidity_simd_enabled();
+// Forces the scalar kernels (0) or AVX2 where available (1)
+void liquidity_set_simd(int enabled);
+
+#endif
@@ -0,0 +1,219 @@
+#include "marketstats.h"
+
+#include <math.h>
+
+static void open_bar(Bar *bar, double start, double price, int quantity)
+{
+    bar->start = start;
+    bar->open = price;
+    bar->high = price;
+    bar->low = price;
+    bar->close = price;
+    bar->volume = quantity;
+    bar->notional = price * quantity;
+    bar->trades = 1;
+}
+
+static void update_bar(Bar *bar, double price, int quantity)
+{
+    if (price > bar->high)
+        bar->high = price;
+    if (price < bar->low)
+        bar->low = price;
+    bar->close = price;
+    bar->volume += quantity;
+    bar->notional += price * quantity;
+    bar->trades++;
+}
+
+static void add_fill(BarSeries *series, double time, double price, int quantity)
+{
+    double start = floor(time / series->interval) * series->interval;
+
+    // fills stamped before the open bar (out-of-order timestamps) fold into it
+    if (series->current.trades > 0 && start <= series->current.start)
+    {
+        update_bar(&series->current, price, quantity);
+        return;
+    }
+
+    if (series->current.trades > 0)
+    {
+        series->history[series->head] = series->current;
+        series->head = (series->head + 1) % series->capacity;
+        if (series->count < series->capacity)
+            series->count++;
+    }
+    open_bar(&series->current, start, price, quantity);
+}
+
+static void refresh_bbo(MarketStats *stats, double timestamp)
+{
+    MdLevel bid = {0, 0, 0};
+    MdLevel ask = {0, 0, 0};
+    level_book_best(&stats->levels.bids, &bid, 1);
+    level_book_best(&stats->levels.asks, &ask, 1);
+
+    Bbo *bbo = &stats->bbo;
+    if (bid.price == bbo->bid_price && bid.quantity == bbo->bid_quantity &&
+        ask.price == bbo->ask_price && ask.quantity == bbo->ask_quantity)
+        return;
+
+    bbo->bid_price = bid.price;
+    bbo->bid_quantity = bid.quantity;
+    bbo->ask_price = ask.price;
+    bbo->ask_quantity = ask.quantity;
+    bbo->timestamp = timestamp;
+    bbo->updates++;
+}
+
+static void on_book_event(void *context, const BookEvent *event)
+{
+    MarketStats *stats = (MarketStats *)context;
+    level_book_apply(&stats->levels, event);
+
+    double timestamp = event->order->timestamp;
+    if (event->type == BOOK_EVENT_TRADE)
+    {
+        const FilledOrder *fill = event->fill;
+        timestamp = fill->timestamp;
+
+        stats->volume += fill->traded_quantity;
+        stats->notional += fill->traded_price * fill->traded_quantity;
+        stats->trades++;
+        for (int s = 0; s < stats->series_count; s++)
+            add_fill(&stats->series[s], fill->timestamp, fill->traded_price, fill->traded_quantity);
+    }
+
+    refresh_bbo(stats, timestamp);
+}
+
+MarketStats *create_market_stats(OrderBook *book, const double *intervals, int count, int history)
+{
+    if (!book || !intervals || count <= 0 || count > MAX_BAR_SERIES || history <= 0)
+        return NULL;
+    for (int s = 0; s < count; s++)
+        if (!(intervals[s] > 0))
+            return NULL;
+
+    MarketStats *stats = (MarketStats *)calloc(1, sizeof(MarketStats));
+    if (!stats)
+    {
+        fprintf(stderr, "Memory allocation failed for MarketStats\n");
+        exit(EXIT_FAILURE);
+    }
+    stats->book = book;
+    stats->series_count = count;
+    for (int s = 0; s < count; s++)
+    {
+        stats->series[s].interval = intervals[s];
+        stats->series[s].capacity = history;
+        stats->series[s].history = (Bar *)malloc(history * sizeof(Bar));
+        if (!stats->series[s].history)
+        {
+            fprintf(stderr, "Memory allocation failed for bar history\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (add_book_listener(book, on_book_event, stats) != 0)
+    {
+        fprintf(stderr, "Order book has no free listener slot\n");
+        free_market_stats(stats);
+        return NULL;
+    }
+
+    init_level_book(&stats->levels);
+    level_book_seed(&stats->levels, book);
+    refresh_bbo(stats, 0);
+
+    return stats;
+}
+
+void free_market_stats(MarketStats *stats)
+{
+    if (!stats)
+        return;
+
+    remove_book_listener(stats->book, on_book_event, stats);
+    free_level_book(&stats->levels);
+    for (int s = 0; s < stats->series_count; s++)
+        free(stats->series[s].history);
+    free(stats);
+}
+
+void stats_bbo(const MarketStats *stats, Bbo *out)
+{
+    *out = stats->bbo;
+}
+
+double stats_vwap(const MarketStats *stats)
+{
+    return stats->volume > 0 ? stats->notional / stats->volume : 0;
+}
+
+double bar_vwap(const Bar *bar)
+{
+    return bar->volume > 0 ? bar->notional / bar->volume : 0;
+}
+
+int stats_current_bar(const MarketStats *stats, int series, Bar *out)
+{
+    if (series < 0 || series >= stats->series_count || stats->series[series].current.trades == 0)
+        return 0;
+
+    *out = stats->series[series].current;
+    return 1;
+}
+
+// i-th closed bar, newest first
+static const Bar *closed_bar(const BarSeries *series, int i)
+{
+    return &series->history[(series->head - 1 - i + series->capacity) % series->capacity];
+}
+
+int stats_bars(const MarketStats *stats, int series, Bar *out, int max)
+{
+    if (series < 0 || series >= stats->series_count)
+        return 0;
+
+    const BarSeries *bars = &stats->series[series];
+    int n = bars->count < max ? bars->count : max;
+    for (int i = 0; i < n; i++)
+        out[i] = *closed_bar(bars, i);
+    return n;
+}
+
+int stats_bar_at(const MarketStats *stats, int series, double time, Bar *out)
+{
+    if (series < 0 || series >= stats->series_count)
+        return 0;
+
+    const BarSeries *bars = &stats->series[series];
+    double start = floor(time / bars->interval) * bars->interval;
+    if (bars->current.trades > 0 && bars->current.start == start)
+    {
+        *out = bars->current;
+        return 1;
+    }
+
+    // closed bars have increasing starts (empty intervals are skipped):
+    // binary search from newest (index 0) to oldest
+    int low = 0;
+    int high = bars->count - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        const Bar *bar = closed_bar(bars, mid);
+        if (bar->start == start)
+        {
+            *out = *bar;
+            return 1;
+        }
+        if (bar->start > start)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return 0;
+}
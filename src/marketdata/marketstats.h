@@ -0,0 +1,83 @@
+#ifndef MARKETSTATS_H
+#define MARKETSTATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "orderbook.h"
+#include "levelbook.h"
+
+/*
+    Incremental market statistics for one OrderBook, fed by its events:
+    a conflated best bid/offer, session VWAP, and OHLCV bars at up to
+    MAX_BAR_SERIES intervals. Each fill updates the open bar of every
+    series in O(1); a bar is closed into its series' history ring when
+    a fill lands in a later interval. Intervals and bar start times are
+    in the same units as order timestamps.
+*/
+
+#define MAX_BAR_SERIES 4
+
+typedef struct
+{
+    double start; // interval start; bars cover [start, start + interval)
+    double open;
+    double high;
+    double low;
+    double close;
+    long long volume;
+    double notional; // sum of price * quantity
+    int trades;
+} Bar;
+
+// Best bid and offer with the quantity resting at each; a quantity of 0
+// means that side is empty
+typedef struct
+{
+    double bid_price;
+    long long bid_quantity;
+    double ask_price;
+    long long ask_quantity;
+    double timestamp;  // of the fill or order that last changed it
+    long long updates; // changes so far; readers poll this to conflate
+} Bbo;
+
+typedef struct
+{
+    double interval;
+    Bar current; // open bar, valid when current.trades > 0
+    Bar *history; // closed bars, ring of capacity entries
+    int head;     // next slot to write
+    int count;
+    int capacity;
+} BarSeries;
+
+typedef struct MarketStats
+{
+    OrderBook *book;
+    LevelBook levels;
+    Bbo bbo;
+    long long volume; // session totals
+    double notional;
+    int trades;
+    BarSeries series[MAX_BAR_SERIES];
+    int series_count;
+} MarketStats;
+
+// Attaches to book with one bar series per interval, each keeping its
+// last history closed bars. NULL on bad arguments or no listener slot
+MarketStats *create_market_stats(OrderBook *book, const double *intervals, int count, int history);
+void free_market_stats(MarketStats *stats);
+
+void stats_bbo(const MarketStats *stats, Bbo *out);
+// Session VWAP, 0 before the first trade
+double stats_vwap(const MarketStats *stats);
+double bar_vwap(const Bar *bar);
+// Open bar of a series; 0 if it has no trades yet
+int stats_current_bar(const MarketStats *stats, int series, Bar *out);
+// Closed bars of a series, newest first; returns the count copied
+int stats_bars(const MarketStats *stats, int series, Bar *out, int max);
+// Bar whose interval contains time, open or closed; 0 if none is kept
+int stats_bar_at(const MarketStats *stats, int series, double time, Bar *out);
+
+#endif
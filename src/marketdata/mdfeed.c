@@ -0,0 +1,72 @@
+#include "mdfeed.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+const MdRegion *md_attach(const char *shm_name)
+{
+    int fd = shm_open(shm_name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+
+    void *mapped = mmap(NULL, sizeof(MdRegion), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        return NULL;
+
+    const MdRegion *region = (const MdRegion *)mapped;
+    if (region->magic != MD_MAGIC || region->ring_capacity != MD_RING_CAPACITY)
+    {
+        munmap(mapped, sizeof(MdRegion));
+        return NULL;
+    }
+    return region;
+}
+
+void md_detach(const MdRegion *region)
+{
+    if (region)
+        munmap((void *)region, sizeof(MdRegion));
+}
+
+void md_read_snapshot(const MdRegion *region, MdSnapshot *out)
+{
+    MdRegion *shared = (MdRegion *)region;
+    for (;;)
+    {
+        uint64_t before = atomic_load_explicit(&shared->snapshot_version, memory_order_acquire);
+        if (before & 1)
+            continue;
+
+        memcpy(out, &region->snapshot, sizeof(MdSnapshot));
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shared->snapshot_version, memory_order_relaxed) == before)
+            return;
+    }
+}
+
+int md_read_event(const MdRegion *region, uint64_t index, MdEvent *out)
+{
+    if (index == 0)
+        return -1;
+
+    MdSlot *slot = (MdSlot *)&region->ring[(index - 1) & (MD_RING_CAPACITY - 1)];
+    uint64_t complete = 2 * index;
+
+    uint64_t before = atomic_load_explicit(&slot->version, memory_order_acquire);
+    if (before < complete)
+        return 0;
+    if (before > complete)
+        return -1;
+
+    memcpy(out, &slot->event, sizeof(MdEvent));
+
+    // the writer lapped us mid-copy
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->version, memory_order_relaxed) != complete)
+        return -1;
+    return 1;
+}
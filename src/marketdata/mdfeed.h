@@ -0,0 +1,79 @@
+#ifndef MDFEED_H
+#define MDFEED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+    Shared-memory market-data layout, written by one MdPublisher and read
+    by any number of local consumers without syscalls or locks.
+
+    The depth snapshot sits behind a seqlock: the writer makes
+    snapshot_version odd while it writes, so readers retry instead of
+    blocking it. Incremental events go to a broadcast ring in which
+    every slot carries its own version (2n - 1 while event n is being
+    written, 2n once it is complete), so a reader that falls a full ring
+    behind sees an overrun and re-syncs from the snapshot rather than
+    holding the writer back.
+*/
+
+#define MD_MAGIC 0x4D444642u // "MDFB"
+#define MD_DEPTH 10
+#define MD_RING_CAPACITY 4096 // power of two
+#define MD_CACHE_LINE 64
+
+typedef struct
+{
+    double price;
+    long long quantity;
+    int orders;
+} MdLevel;
+
+typedef struct
+{
+    uint64_t last_event; // events published when the snapshot was taken
+    int bid_levels;
+    int ask_levels;
+    MdLevel bids[MD_DEPTH]; // best first
+    MdLevel asks[MD_DEPTH];
+} MdSnapshot;
+
+// A BookEvent flattened for the wire
+typedef struct
+{
+    uint32_t type; // BookEventType
+    char side;
+    int order_id;
+    int counterparty_id; // taker of a trade, 0 otherwise
+    double price;        // limit price, or the traded price for a trade
+    int quantity;
+} MdEvent;
+
+typedef struct
+{
+    _Alignas(MD_CACHE_LINE) _Atomic uint64_t version;
+    MdEvent event;
+} MdSlot;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t depth;
+    uint32_t ring_capacity;
+    _Alignas(MD_CACHE_LINE) _Atomic uint64_t snapshot_version;
+    MdSnapshot snapshot;
+    _Alignas(MD_CACHE_LINE) _Atomic uint64_t events_published;
+    MdSlot ring[MD_RING_CAPACITY];
+} MdRegion;
+
+// Maps a publisher's region read-only; NULL if missing or not a feed
+const MdRegion *md_attach(const char *shm_name);
+void md_detach(const MdRegion *region);
+// Copies a consistent snapshot, retrying while the writer is mid-update
+void md_read_snapshot(const MdRegion *region, MdSnapshot *out);
+// Reads event number index (the first event is 1): 1 when copied, 0 if
+// not published yet, -1 if overwritten (re-sync from a snapshot)
+int md_read_event(const MdRegion *region, uint64_t index, MdEvent *out);
+
+#endif
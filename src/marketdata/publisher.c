@@ -0,0 +1,152 @@
+#include "publisher.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static MdRegion *map_region(const char *shm_name)
+{
+    void *mapped;
+    if (shm_name)
+    {
+        int fd = shm_open(shm_name, O_CREAT | O_RDWR, 0644);
+        if (fd < 0)
+            return NULL;
+        if (ftruncate(fd, sizeof(MdRegion)) != 0)
+        {
+            close(fd);
+            shm_unlink(shm_name);
+            return NULL;
+        }
+        mapped = mmap(NULL, sizeof(MdRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    else
+    {
+        mapped = mmap(NULL, sizeof(MdRegion), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    }
+    if (mapped == MAP_FAILED)
+    {
+        if (shm_name)
+            shm_unlink(shm_name);
+        return NULL;
+    }
+
+    MdRegion *region = (MdRegion *)mapped;
+    memset(region, 0, sizeof(MdRegion));
+    region->depth = MD_DEPTH;
+    region->ring_capacity = MD_RING_CAPACITY;
+    // magic last: a reader attaching early rejects a half-built region
+    atomic_thread_fence(memory_order_release);
+    region->magic = MD_MAGIC;
+    return region;
+}
+
+static void publish_event(MdPublisher *publisher, const MdEvent *event)
+{
+    uint64_t index = ++publisher->events;
+    MdSlot *slot = &publisher->region->ring[(index - 1) & (MD_RING_CAPACITY - 1)];
+
+    atomic_store_explicit(&slot->version, 2 * index - 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->event = *event;
+    atomic_store_explicit(&slot->version, 2 * index, memory_order_release);
+    atomic_store_explicit(&publisher->region->events_published, index, memory_order_release);
+}
+
+static void on_book_event(void *context, const BookEvent *event)
+{
+    MdPublisher *publisher = (MdPublisher *)context;
+    const Order *order = event->order;
+
+    MdEvent wire;
+    wire.type = event->type;
+    wire.side = order->side;
+    wire.order_id = order->order_id;
+    wire.counterparty_id = 0;
+    wire.price = order->price;
+    wire.quantity = event->quantity;
+
+    if (event->type == BOOK_EVENT_TRADE)
+    {
+        wire.counterparty_id = event->counterparty->order_id;
+        wire.price = event->fill->traded_price;
+    }
+
+    level_book_apply(&publisher->levels, event);
+    publish_event(publisher, &wire);
+    publisher->dirty = 1;
+}
+
+void md_publisher_flush(MdPublisher *publisher)
+{
+    if (!publisher || !publisher->dirty)
+        return;
+
+    MdRegion *region = publisher->region;
+    uint64_t version = atomic_load_explicit(&region->snapshot_version, memory_order_relaxed);
+
+    atomic_store_explicit(&region->snapshot_version, version + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    region->snapshot.last_event = publisher->events;
+    region->snapshot.bid_levels = level_book_best(&publisher->levels.bids, region->snapshot.bids, MD_DEPTH);
+    region->snapshot.ask_levels = level_book_best(&publisher->levels.asks, region->snapshot.asks, MD_DEPTH);
+
+    atomic_store_explicit(&region->snapshot_version, version + 2, memory_order_release);
+    publisher->dirty = 0;
+}
+
+MdPublisher *create_md_publisher(OrderBook *book, const char *shm_name)
+{
+    if (!book)
+        return NULL;
+
+    MdRegion *region = map_region(shm_name);
+    if (!region)
+    {
+        fprintf(stderr, "Could not create market data region %s\n", shm_name ? shm_name : "(anonymous)");
+        return NULL;
+    }
+
+    MdPublisher *publisher = (MdPublisher *)calloc(1, sizeof(MdPublisher));
+    if (!publisher)
+    {
+        fprintf(stderr, "Memory allocation failed for MdPublisher\n");
+        exit(EXIT_FAILURE);
+    }
+    publisher->book = book;
+    publisher->region = region;
+    publisher->shm_name = shm_name ? strdup(shm_name) : NULL;
+    init_level_book(&publisher->levels);
+
+    if (add_book_listener(book, on_book_event, publisher) != 0)
+    {
+        fprintf(stderr, "Order book has no free listener slot\n");
+        free_md_publisher(publisher);
+        return NULL;
+    }
+
+    level_book_seed(&publisher->levels, book);
+    publisher->dirty = 1;
+    md_publisher_flush(publisher);
+
+    return publisher;
+}
+
+void free_md_publisher(MdPublisher *publisher)
+{
+    if (!publisher)
+        return;
+
+    remove_book_listener(publisher->book, on_book_event, publisher);
+    munmap(publisher->region, sizeof(MdRegion));
+    if (publisher->shm_name)
+    {
+        shm_unlink(publisher->shm_name);
+        free(publisher->shm_name);
+    }
+    free_level_book(&publisher->levels);
+    free(publisher);
+}
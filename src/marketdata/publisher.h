@@ -0,0 +1,40 @@
+#ifndef PUBLISHER_H
+#define PUBLISHER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "orderbook.h"
+#include "mdfeed.h"
+#include "levelbook.h"
+
+/*
+    Publishes one OrderBook into an MdRegion. The publisher listens to
+    the book's events: each one is written straight to the event ring
+    and folded into a LevelBook, so refreshing the depth snapshot costs
+    O(MD_DEPTH) rather than a walk of the book.
+    Snapshots are refreshed by md_publisher_flush, which the matching
+    thread calls once an inbound message has been fully handled so
+    readers never see a half-matched (crossed) book.
+*/
+
+typedef struct MdPublisher
+{
+    OrderBook *book;
+    MdRegion *region;
+    char *shm_name; // NULL for a process-private region
+    LevelBook levels;
+    uint64_t events;
+    int dirty; // levels changed since the last snapshot
+} MdPublisher;
+
+// Creates the region (POSIX shm_name, or an anonymous mapping if NULL),
+// seeds the levels from the book's resting orders and starts listening.
+// NULL if the region cannot be created
+MdPublisher *create_md_publisher(OrderBook *book, const char *shm_name);
+// Stops listening and unmaps (and unlinks) the region
+void free_md_publisher(MdPublisher *publisher);
+// Writes the depth snapshot if anything changed since the last flush
+void md_publisher_flush(MdPublisher *publisher);
+
+#endif
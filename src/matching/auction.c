@@ -0,0 +1,246 @@
+#include "auction.h"
+#include "matcher.h"
+
+typedef struct
+{
+    double price;
+    long long buy_quantity;
+    long long sell_quantity;
+} AuctionLevel;
+
+// A heap entry on its way into a level, keyed by its price ticks
+typedef struct
+{
+    uint64_t ticks;
+    double price;
+    int quantity;
+} AuctionEntry;
+
+static void *alloc_buffer(int count, size_t width, const char *what)
+{
+    void *buffer = arena_malloc((size_t)(count > 0 ? count : 1) * width);
+    if (!buffer)
+    {
+        fprintf(stderr, "Memory allocation failed for auction %s\n", what);
+        exit(EXIT_FAILURE);
+    }
+    return buffer;
+}
+
+// LSD radix sort on ticks, a byte per pass and only as many passes as the
+// largest tick needs; returns whichever of the two buffers ends up sorted
+static AuctionEntry *sort_entries(AuctionEntry *entries, AuctionEntry *scratch, int n)
+{
+    uint64_t largest = 0;
+    for (int i = 0; i < n; i++)
+        if (entries[i].ticks > largest)
+            largest = entries[i].ticks;
+
+    for (int shift = 0; shift < 64 && (largest >> shift) != 0; shift += 8)
+    {
+        int starts[257] = {0};
+        for (int i = 0; i < n; i++)
+            starts[((entries[i].ticks >> shift) & 0xff) + 1]++;
+        for (int b = 0; b < 256; b++)
+            starts[b + 1] += starts[b];
+        for (int i = 0; i < n; i++)
+            scratch[starts[(entries[i].ticks >> shift) & 0xff]++] = entries[i];
+
+        AuctionEntry *sorted = scratch;
+        scratch = entries;
+        entries = sorted;
+    }
+    return entries;
+}
+
+static void add_level(AuctionLevel *levels, int *count, double price, long long quantity, int is_buy)
+{
+    if (*count == 0 || levels[*count - 1].price != price)
+    {
+        levels[*count].price = price;
+        levels[*count].buy_quantity = 0;
+        levels[*count].sell_quantity = 0;
+        (*count)++;
+    }
+    if (is_buy)
+        levels[*count - 1].buy_quantity += quantity;
+    else
+        levels[*count - 1].sell_quantity += quantity;
+}
+
+// Writes one side's price levels into out in ascending price order;
+// returns the count. A ladder is walked level by level; a heap's entries
+// are radix sorted by the price ticks of their keys, both linear
+static int side_levels(OrderHeap *heap, int is_buy, AuctionLevel *out)
+{
+    int count = 0;
+    if (heap->ladder)
+    {
+        PriceLadder *ladder = heap->ladder;
+        for (int idx = ladder_next_level(ladder, 0); idx >= 0; idx = ladder_next_level(ladder, idx + 1))
+            for (Order *order = ladder->levels[idx].head; order; order = order->level_next)
+                add_level(out, &count, ladder->levels[idx].head->price, order->quantity, is_buy);
+        return count;
+    }
+
+    int n = heap->size;
+    AuctionEntry *entries = (AuctionEntry *)alloc_buffer(n, sizeof(AuctionEntry), "entries");
+    AuctionEntry *scratch = (AuctionEntry *)alloc_buffer(n, sizeof(AuctionEntry), "entries");
+    for (int i = 0; i < n; i++)
+    {
+        const Order *order = heap->table->orders[heap->arr[i]];
+        uint64_t ticks = heap->keys[i] >> ORDER_KEY_RANK_BITS;
+        entries[i].ticks = is_buy ? ORDER_KEY_PRICE_MASK - ticks : ticks;
+        entries[i].price = order->price;
+        entries[i].quantity = order->quantity;
+    }
+
+    AuctionEntry *sorted = sort_entries(entries, scratch, n);
+    for (int i = 0; i < n; i++)
+    {
+        // a level takes the price of its first entry
+        int same = i > 0 && sorted[i].ticks == sorted[i - 1].ticks;
+        add_level(out, &count, same ? out[count - 1].price : sorted[i].price, sorted[i].quantity, is_buy);
+    }
+
+    arena_free(entries);
+    arena_free(scratch);
+    return count;
+}
+
+// Collapses every resting order into one ascending array of price levels:
+// each side's levels in order, then a linear merge of the two
+static int build_levels(OrderBook *book, AuctionLevel **out)
+{
+    int n = book->buy_orders->size + book->sell_orders->size;
+    AuctionLevel *sides = (AuctionLevel *)alloc_buffer(n, sizeof(AuctionLevel), "levels");
+    int bids = side_levels(book->buy_orders, 1, sides);
+    int asks = side_levels(book->sell_orders, 0, sides + bids);
+
+    AuctionLevel *levels = (AuctionLevel *)alloc_buffer(bids + asks, sizeof(AuctionLevel), "levels");
+    const AuctionLevel *bid = sides;
+    const AuctionLevel *ask = sides + bids;
+    int count = 0;
+    for (int b = 0, a = 0; b < bids || a < asks;)
+    {
+        if (a == asks || (b < bids && bid[b].price < ask[a].price))
+            levels[count++] = bid[b++];
+        else if (b == bids || ask[a].price < bid[b].price)
+            levels[count++] = ask[a++];
+        else
+        {
+            levels[count] = bid[b++];
+            levels[count++].sell_quantity = ask[a++].sell_quantity;
+        }
+    }
+    arena_free(sides);
+
+    *out = levels;
+    return count;
+}
+
+static long long abs_ll(long long v)
+{
+    return v < 0 ? -v : v;
+}
+
+static double distance(double a, double b)
+{
+    return a > b ? a - b : b - a;
+}
+
+void begin_auction(OrderBook *book)
+{
+    if (!book)
+        return;
+
+    book->phase = PHASE_AUCTION;
+}
+
+int compute_uncross(OrderBook *book, double reference_price, AuctionResult *result)
+{
+    if (!book || !result)
+        return -1;
+
+    AuctionLevel *levels;
+    int count = build_levels(book, &levels);
+
+    long long total_buy = 0;
+    for (int i = 0; i < count; i++)
+        total_buy += levels[i].buy_quantity;
+
+    // Walking up the ladder, demand at a level is every buy priced at or
+    // above it and supply is every sell priced at or below it.
+    long long buys_below = 0;
+    long long supply = 0;
+    int best = -1;
+    long long best_volume = 0;
+    long long best_imbalance = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        long long demand = total_buy - buys_below;
+        supply += levels[i].sell_quantity;
+        buys_below += levels[i].buy_quantity;
+
+        long long volume = demand < supply ? demand : supply;
+        long long imbalance = demand - supply;
+        if (volume == 0)
+            continue;
+
+        int better = 0;
+        if (best < 0 || volume > best_volume)
+            better = 1;
+        else if (volume == best_volume)
+        {
+            if (abs_ll(imbalance) < abs_ll(best_imbalance))
+                better = 1;
+            else if (abs_ll(imbalance) == abs_ll(best_imbalance) && reference_price > 0 &&
+                     distance(levels[i].price, reference_price) < distance(levels[best].price, reference_price))
+                better = 1;
+        }
+
+        if (better)
+        {
+            best = i;
+            best_volume = volume;
+            best_imbalance = imbalance;
+        }
+    }
+
+    result->levels = count;
+    if (best < 0)
+    {
+        result->price = 0.0;
+        result->volume = 0;
+        result->imbalance = 0;
+        arena_free(levels);
+        return 1;
+    }
+
+    result->price = levels[best].price;
+    result->volume = best_volume;
+    result->imbalance = best_imbalance;
+    arena_free(levels);
+    return 0;
+}
+
+int uncross_auction(OrderBook *book, double reference_price, AuctionResult *result)
+{
+    if (!book)
+        return -1;
+
+    AuctionResult local;
+    if (!result)
+        result = &local;
+
+    int status = compute_uncross(book, reference_price, result);
+    if (status == 0)
+        status = match_orderbook_at_price(book, result->price);
+
+    book->phase = PHASE_CONTINUOUS;
+    // pick up anything a self-trade cancellation left crossed
+    match_orderbook(book);
+
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef AUCTION_H
+#define AUCTION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "order.h"
+#include "orderbook.h"
+
+/*
+    Opening/closing call auction
+*/
+
+typedef struct
+{
+    double price;          // equilibrium (uncross) price
+    long long volume;      // executable volume at price
+    long long imbalance;   // buy minus sell quantity willing to trade at price
+    int levels;            // distinct price levels considered
+} AuctionResult;
+
+// Stops continuous matching; subsequent orders rest without matching.
+void begin_auction(OrderBook *book);
+
+// Computes the price maximizing executable volume, breaking ties by the
+// smallest absolute imbalance and then by distance to reference_price
+// (ignored when <= 0). Does not modify the book.
+// 0: result filled, 1: book does not cross, -1: error
+int compute_uncross(OrderBook *book, double reference_price, AuctionResult *result);
+
+// Computes the uncross, executes every fill at the equilibrium price and
+// returns the book to continuous trading. result may be NULL.
+// 0: auction traded, 1: nothing to execute, -1: error
+int uncross_auction(OrderBook *book, double reference_price, AuctionResult *result);
+
+#endif
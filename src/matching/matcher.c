@@ -1,40 +1,304 @@
 #include "matcher.h"
 
-int match_orderbook(OrderBook *book)
+// The taker is the later arrival of the two crossing orders
+static int is_newer(Order *a, Order *b)
 {
-    // see if top buy and top sell can be matched
-    Order *top_sell = extractTop(book->sell_orders);
-    Order *top_buy = extractTop(book->buy_orders);
-    if (top_buy->price >= top_sell->price)
-    {
-        // if so, fill the trade
-        // top_sell = extractTop(book->sell_orders);
-        // top_buy = extractTop(book->sell_orders);
-        int traded_quantity;
-        if (top_buy->quantity <= top_sell->quantity)
+    return a->sequence > b->sequence;
+}
+
+static int is_self_trade(Order *buy, Order *sell)
+{
+    return buy->owner_id != 0 && buy->owner_id == sell->owner_id;
+}
+
+static OrderHeap *side_heap(OrderBook *book, char side)
+{
+    return side == 'B' ? book->buy_orders : book->sell_orders;
+}
+
+// Removes an order sitting at the top of its side and releases it
+static void remove_top(OrderBook *book, Order *order)
+{
+    extractTop(side_heap(book, order->side));
+    release_order(book, order);
+}
+
+// STP decrement: both orders lose overlap without trading
+static void decrement_orders(OrderBook *book, Order *maker, Order *taker, int overlap)
+{
+    maker->quantity -= overlap;
+    taker->quantity -= overlap;
+
+    BookEvent event = {BOOK_EVENT_REDUCE, maker, NULL, overlap, NULL};
+    notify_book_event(book, &event);
+    event.order = taker;
+    notify_book_event(book, &event);
+}
+
+static void apply_stp(OrderBook *book, Order *maker, Order *taker)
+{
+    switch (book->stp_mode)
+    {
+    case STP_CANCEL_NEWEST:
+        remove_top(book, taker);
+        break;
+    case STP_CANCEL_OLDEST:
+        remove_top(book, maker);
+        break;
+    case STP_CANCEL_BOTH:
+        remove_top(book, maker);
+        remove_top(book, taker);
+        break;
+    case STP_DECREMENT:
+    {
+        int overlap = maker->quantity < taker->quantity ? maker->quantity : taker->quantity;
+        decrement_orders(book, maker, taker, overlap);
+        if (maker->quantity == 0)
+            remove_top(book, maker);
+        if (taker->quantity == 0)
+            remove_top(book, taker);
+        break;
+    }
+    case STP_NONE:
+        break;
+    }
+}
+
+static FilledOrder execute_fill(OrderBook *book, Order *maker, Order *taker, int quantity, double price)
+{
+    FilledOrder fill;
+    fill.maker_id = maker->order_id;
+    fill.taker_id = taker->order_id;
+    fill.traded_quantity = quantity;
+    fill.traded_price = price;
+
+    maker->quantity -= quantity;
+    taker->quantity -= quantity;
+    fill.maker_leftover = maker->quantity;
+    fill.taker_leftover = taker->quantity;
+    fill.timestamp = taker->timestamp;
+    fill.taker_side = taker->side;
+
+    record_trade(book, &fill);
+
+    BookEvent event = {BOOK_EVENT_TRADE, maker, taker, quantity, &fill};
+    notify_book_event(book, &event);
+
+    return fill;
+}
+
+// Price-time: the two top orders trade and filled tops leave the book
+static void fill_trade(OrderBook *book, Order *maker, Order *taker, double price)
+{
+    int quantity = maker->quantity < taker->quantity ? maker->quantity : taker->quantity;
+    execute_fill(book, maker, taker, quantity, price);
+
+    if (maker->quantity == 0)
+        remove_top(book, maker);
+    if (taker->quantity == 0)
+        remove_top(book, taker);
+}
+
+// Resolves self-trades between the taker and same-owner orders of a level
+// that has been pulled out of its heap. Cancelled resting orders are
+// released and nulled out; returns 1 if the taker must leave the book.
+static int apply_level_stp(OrderBook *book, Order **level, int n, Order *taker)
+{
+    int cancel_taker = 0;
+    for (int i = 0; i < n && !cancel_taker; i++)
+    {
+        if (level[i]->owner_id != taker->owner_id)
+            continue;
+
+        switch (book->stp_mode)
         {
-            traded_quantity = top_buy->quantity;
+        case STP_CANCEL_NEWEST:
+            cancel_taker = 1;
+            break;
+        case STP_CANCEL_OLDEST:
+            release_order(book, level[i]);
+            level[i] = NULL;
+            break;
+        case STP_CANCEL_BOTH:
+            release_order(book, level[i]);
+            level[i] = NULL;
+            cancel_taker = 1;
+            break;
+        case STP_DECREMENT:
+        {
+            int overlap = level[i]->quantity < taker->quantity ? level[i]->quantity : taker->quantity;
+            decrement_orders(book, level[i], taker, overlap);
+            if (level[i]->quantity == 0)
+            {
+                release_order(book, level[i]);
+                level[i] = NULL;
+            }
+            cancel_taker = taker->quantity == 0;
+            break;
         }
-        else
+        case STP_NONE:
+            break;
+        }
+    }
+    return cancel_taker;
+}
+
+// Pro-rata and hybrid: the taker trades against the maker's whole price
+// level at once, split according to book->policy.
+static void match_level(OrderBook *book, Order *maker_top, Order *taker)
+{
+    OrderHeap *heap = side_heap(book, maker_top->side);
+    double level_price = maker_top->price;
+
+    // pull the level out of the heap in time priority
+    int n = 0;
+    int capacity = 16;
+    Order **level = (Order **)arena_malloc(capacity * sizeof(Order *));
+    int *buffer = NULL;
+    if (!level)
+    {
+        fprintf(stderr, "Memory allocation failed for price level\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Order *top;
+    while ((top = getTop(heap)) != NULL && top->price == level_price)
+    {
+        if (n == capacity)
         {
-            traded_quantity = top_sell->quantity;
+            capacity *= 2;
+            level = (Order **)arena_realloc(level, capacity * sizeof(Order *));
+            if (!level)
+            {
+                fprintf(stderr, "Memory reallocation failed for price level\n");
+                exit(EXIT_FAILURE);
+            }
         }
-        top_sell->quantity -= traded_quantity;
-        top_buy->quantity -= traded_quantity;
+        level[n++] = extractTop(heap);
+    }
+
+    int cancel_taker = 0;
+    if (book->stp_mode != STP_NONE && taker->owner_id != 0)
+    {
+        cancel_taker = apply_level_stp(book, level, n, taker);
 
-        if (top_sell->quantity == 0)
+        int kept = 0;
+        for (int i = 0; i < n; i++)
+            if (level[i])
+                level[kept++] = level[i];
+        n = kept;
+    }
+
+    if (!cancel_taker && n > 0)
+    {
+        buffer = (int *)arena_malloc(2 * n * sizeof(int));
+        if (!buffer)
         {
-            top_sell = extractTop(book->sell_orders);
+            fprintf(stderr, "Memory allocation failed for level allocation\n");
+            exit(EXIT_FAILURE);
         }
-        if (top_buy->quantity == 0)
+        int *resting = buffer;
+        int *alloc = buffer + n;
+        for (int i = 0; i < n; i++)
+            resting[i] = level[i]->quantity;
+
+        allocate_level(&book->policy, taker->quantity, resting, n, alloc);
+
+        for (int i = 0; i < n; i++)
+            if (alloc[i] > 0)
+                execute_fill(book, level[i], taker, alloc[i], level_price);
+    }
+
+    // put the survivors back; their keys keep the original priority
+    for (int i = 0; i < n; i++)
+    {
+        if (level[i]->quantity == 0)
+            release_order(book, level[i]);
+        else
+            insertOrderHeap(heap, level[i]);
+    }
+
+    if (cancel_taker || taker->quantity == 0)
+        remove_top(book, taker);
+
+    arena_free(buffer);
+    arena_free(level);
+}
+
+// Shared matching loop. In continuous mode trades print at the maker's
+// price; at an uncross every order willing to trade at uncross_price
+// executes at that single price.
+static int run_matching(OrderBook *book, int uncross, double uncross_price)
+{
+    if (!book)
+        return -1;
+
+    int traded = 0;
+    Order *top_buy;
+    Order *top_sell;
+
+    // see if top buy and top sell can be matched
+    while ((top_buy = getTop(book->buy_orders)) != NULL &&
+           (top_sell = getTop(book->sell_orders)) != NULL &&
+           (uncross ? top_buy->price >= uncross_price && top_sell->price <= uncross_price
+                    : top_buy->price >= top_sell->price))
+    {
+        Order *taker = is_newer(top_buy, top_sell) ? top_buy : top_sell;
+        Order *maker = taker == top_buy ? top_sell : top_buy;
+
+        if (book->stp_mode != STP_NONE && is_self_trade(top_buy, top_sell))
         {
-            top_buy = extractTop(book->buy_orders);
+            apply_stp(book, maker, taker);
+            continue;
         }
+
+        fill_trade(book, maker, taker, uncross ? uncross_price : maker->price);
+        traded = 1;
     }
-    else
+
+    return traded ? 0 : 1;
+}
+
+// Level-at-a-time loop for allocation policies other than price-time
+static int run_level_matching(OrderBook *book)
+{
+    int traded = 0;
+    Order *top_buy;
+    Order *top_sell;
+
+    while ((top_buy = getTop(book->buy_orders)) != NULL &&
+           (top_sell = getTop(book->sell_orders)) != NULL &&
+           top_buy->price >= top_sell->price)
     {
-        return 1;
+        Order *taker = is_newer(top_buy, top_sell) ? top_buy : top_sell;
+        Order *maker = taker == top_buy ? top_sell : top_buy;
+
+        int trades_before = book->trade_history_size;
+        match_level(book, maker, taker);
+        traded |= book->trade_history_size > trades_before;
     }
 
-    // record data
-}
\ No newline at end of file
+    return traded ? 0 : 1;
+}
+
+int match_orderbook(OrderBook *book)
+{
+    if (!book)
+        return -1;
+
+    // one dispatch per call; each loop is specialized for its policy
+    switch (book->policy.type)
+    {
+    case POLICY_PRO_RATA:
+    case POLICY_HYBRID:
+        return run_level_matching(book);
+    case POLICY_PRICE_TIME:
+    default:
+        return run_matching(book, 0, 0.0);
+    }
+}
+
+int match_orderbook_at_price(OrderBook *book, double price)
+{
+    return run_matching(book, 1, price);
+}
@@ -9,31 +9,30 @@
 #include "orderbook.h"
 #include "orderheap.h"
 #include "ordermap.h"
+#include "policy.h"
 
 /*
     Matching engine logic
 */
 
-typedef struct
-{
-    int maker_id;
-    int taker_id;
-    int traded_quantity;
-    int maker_leftover;
-    int taker_leftover;
-    double traded_price;
-
-} FilledOrder;
-
 // int _fill_trade(
 //     Order *maker,
 //     Order *taker,
 //     OrderHeap *buy_orders,
 //     OrderHeap *sell_orders);
 
+// Matches the book until it is no longer crossed. Trades execute at the
+// resting (maker) order's price and are allocated within a level according
+// to book->policy; crossing orders with the same non-zero owner_id are
+// resolved according to book->stp_mode.
 // -1: error filling and/or logging trade
 // 0: successfully filled and logged trade
 // 1: orderbook is non-crossing
 int match_orderbook(OrderBook *book);
 
+// Executes every crossing order willing to trade at price (buys at or
+// above, sells at or below) at that single price, in price-time priority.
+// Same return codes as match_orderbook.
+int match_orderbook_at_price(OrderBook *book, double price);
+
 #endif
\ No newline at end of file
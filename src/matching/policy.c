@@ -0,0 +1,165 @@
+#include "policy.h"
+#include "arena.h"
+
+typedef struct
+{
+    int index;
+    int quantity;
+} ResidualSlot;
+
+MatchingPolicy price_time_policy(void)
+{
+    MatchingPolicy policy = {POLICY_PRICE_TIME, 0, 0, RESIDUAL_FIFO};
+    return policy;
+}
+
+MatchingPolicy pro_rata_policy(int min_allocation, ResidualRule residual)
+{
+    MatchingPolicy policy = {POLICY_PRO_RATA, min_allocation, 0, residual};
+    return policy;
+}
+
+MatchingPolicy hybrid_policy(int top_order_percent, int min_allocation, ResidualRule residual)
+{
+    MatchingPolicy policy = {POLICY_HYBRID, min_allocation, top_order_percent, residual};
+    return policy;
+}
+
+int validate_matching_policy(const MatchingPolicy *policy)
+{
+    if (!policy)
+        return -1;
+    if (policy->type != POLICY_PRICE_TIME && policy->type != POLICY_PRO_RATA && policy->type != POLICY_HYBRID)
+        return -1;
+    if (policy->residual != RESIDUAL_FIFO && policy->residual != RESIDUAL_LARGEST)
+        return -1;
+    if (policy->min_allocation < 0 || policy->top_order_percent < 0 || policy->top_order_percent > 100)
+        return -1;
+    return 0;
+}
+
+// Larger remaining capacity first; earlier orders win ties
+static int compare_residual_slots(const void *a, const void *b)
+{
+    const ResidualSlot *sa = (const ResidualSlot *)a;
+    const ResidualSlot *sb = (const ResidualSlot *)b;
+    if (sa->quantity != sb->quantity)
+        return sa->quantity > sb->quantity ? -1 : 1;
+    return sa->index - sb->index;
+}
+
+static void allocate_fifo(int quantity, const int *resting, int n, int *alloc)
+{
+    for (int i = 0; i < n && quantity > 0; i++)
+    {
+        int take = resting[i] - alloc[i] < quantity ? resting[i] - alloc[i] : quantity;
+        alloc[i] += take;
+        quantity -= take;
+    }
+}
+
+static void allocate_residual(const MatchingPolicy *policy, int residual,
+                              const int *resting, int n, int *alloc)
+{
+    if (residual <= 0)
+        return;
+
+    if (policy->residual == RESIDUAL_FIFO)
+    {
+        allocate_fifo(residual, resting, n, alloc);
+        return;
+    }
+
+    ResidualSlot *slots = (ResidualSlot *)arena_malloc(n * sizeof(ResidualSlot));
+    if (!slots)
+    {
+        fprintf(stderr, "Memory allocation failed for residual slots\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        slots[i].index = i;
+        slots[i].quantity = resting[i] - alloc[i];
+    }
+    qsort(slots, n, sizeof(ResidualSlot), compare_residual_slots);
+
+    for (int i = 0; i < n && residual > 0; i++)
+    {
+        int take = slots[i].quantity < residual ? slots[i].quantity : residual;
+        alloc[slots[i].index] += take;
+        residual -= take;
+    }
+
+    arena_free(slots);
+}
+
+// Proportional split of quantity by each order's unallocated size
+static void allocate_pro_rata(const MatchingPolicy *policy, int quantity,
+                              const int *resting, int n, int *alloc)
+{
+    long long capacity = 0;
+    for (int i = 0; i < n; i++)
+        capacity += resting[i] - alloc[i];
+    if (capacity <= 0 || quantity <= 0)
+        return;
+
+    int allocated = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int share = (int)((long long)quantity * (resting[i] - alloc[i]) / capacity);
+        if (share < policy->min_allocation)
+            share = 0;
+        alloc[i] += share;
+        allocated += share;
+    }
+
+    allocate_residual(policy, quantity - allocated, resting, n, alloc);
+}
+
+int allocate_level(const MatchingPolicy *policy, int incoming,
+                   const int *resting, int n, int *alloc)
+{
+    long long total = 0;
+    for (int i = 0; i < n; i++)
+    {
+        alloc[i] = 0;
+        total += resting[i];
+    }
+
+    int fill = total < incoming ? (int)total : incoming;
+    if (fill <= 0)
+        return 0;
+
+    // The whole level trades; no allocation decision to make
+    if (fill == total)
+    {
+        memcpy(alloc, resting, n * sizeof(int));
+        return fill;
+    }
+
+    switch (policy->type)
+    {
+    case POLICY_PRICE_TIME:
+        allocate_fifo(fill, resting, n, alloc);
+        break;
+    case POLICY_PRO_RATA:
+        allocate_pro_rata(policy, fill, resting, n, alloc);
+        break;
+    case POLICY_HYBRID:
+    {
+        int top = (int)((long long)fill * policy->top_order_percent / 100);
+        // clamped so an unvalidated policy still never overfills
+        if (top > resting[0])
+            top = resting[0];
+        if (top > fill)
+            top = fill;
+        if (top < 0)
+            top = 0;
+        alloc[0] = top;
+        allocate_pro_rata(policy, fill - top, resting, n, alloc);
+        break;
+    }
+    }
+
+    return fill;
+}
@@ -0,0 +1,48 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Matching policies: how an incoming order's quantity is shared among
+    the resting orders at a price level
+*/
+
+typedef enum
+{
+    POLICY_PRICE_TIME, // strict FIFO within a level
+    POLICY_PRO_RATA,   // proportional to resting size
+    POLICY_HYBRID      // top order gets a FIFO share, the rest is pro-rata
+} PolicyType;
+
+// Where quantity lost to rounding and minimum allocations goes
+typedef enum
+{
+    RESIDUAL_FIFO,   // to the earliest orders first
+    RESIDUAL_LARGEST // to the largest orders first
+} ResidualRule;
+
+typedef struct
+{
+    PolicyType type;
+    int min_allocation;    // pro-rata shares below this are rounded to zero
+    int top_order_percent; // hybrid: share of the incoming quantity for the first order
+    ResidualRule residual;
+} MatchingPolicy;
+
+MatchingPolicy price_time_policy(void);
+MatchingPolicy pro_rata_policy(int min_allocation, ResidualRule residual);
+MatchingPolicy hybrid_policy(int top_order_percent, int min_allocation, ResidualRule residual);
+// 0 if the policy is usable: a known type and residual rule, a
+// non-negative minimum and a top order share within 0..100. -1 otherwise
+int validate_matching_policy(const MatchingPolicy *policy);
+
+// Splits incoming quantity across n resting quantities (in time priority)
+// into alloc. The allocations always sum to min(incoming, sum(resting)).
+// Returns that sum.
+int allocate_level(const MatchingPolicy *policy, int incoming,
+                   const int *resting, int n, int *alloc);
+
+#endif
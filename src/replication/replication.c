@@ -0,0 +1,523 @@
+#include "replication.h"
+#include "matching/auction.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+uint64_t repl_clock_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static uint64_t mix64(uint64_t x)
+{
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Hash of order as if it had quantity open
+static uint64_t order_hash(const Order *order, int quantity)
+{
+    uint64_t price_bits;
+    memcpy(&price_bits, &order->price, sizeof(price_bits));
+
+    uint64_t h = mix64((uint64_t)(uint32_t)order->order_id << 8 | (uint8_t)order->side);
+    h = mix64(h ^ price_bits);
+    h = mix64(h ^ (uint64_t)(uint32_t)quantity);
+    return mix64(h ^ order->sequence);
+}
+
+static uint64_t book_checksum(OrderBook *book, uint64_t order_sum)
+{
+    return mix64((uint64_t)book->trade_history_size) + order_sum;
+}
+
+static uint64_t sum_orders(OrderBook *book)
+{
+    int total = book->buy_orders->size + book->sell_orders->size;
+    Order **orders = (Order **)malloc((total + 1) * sizeof(Order *));
+    if (!orders)
+    {
+        fprintf(stderr, "Memory allocation failed for book checksum\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int n = collectOrders(book->buy_orders, orders);
+    n += collectOrders(book->sell_orders, orders + n);
+
+    // summing per-order hashes needs no sort; sequence carries priority
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += order_hash(orders[i], orders[i]->quantity);
+
+    free(orders);
+    return sum;
+}
+
+uint64_t orderbook_checksum(OrderBook *book)
+{
+    return book_checksum(book, sum_orders(book));
+}
+
+// Events report a reduction after the fact: order had taken more open
+static void rehash_reduced(uint64_t *sum, const Order *order, int taken)
+{
+    *sum += order_hash(order, order->quantity) - order_hash(order, order->quantity + taken);
+}
+
+// Keeps a replica's order_sum equal to sum_orders of its book
+static void track_orders(void *context, const BookEvent *event)
+{
+    uint64_t *sum = (uint64_t *)context;
+    switch (event->type)
+    {
+    case BOOK_EVENT_ADD:
+        *sum += order_hash(event->order, event->order->quantity);
+        break;
+    case BOOK_EVENT_TRADE:
+        rehash_reduced(sum, event->order, event->quantity);
+        rehash_reduced(sum, event->counterparty, event->quantity);
+        break;
+    case BOOK_EVENT_REDUCE:
+        rehash_reduced(sum, event->order, event->quantity);
+        break;
+    case BOOK_EVENT_REMOVE:
+        *sum -= order_hash(event->order, event->order->quantity);
+        break;
+    }
+}
+
+// Seeds order_sum from the book as it stands, then follows its events
+static int track_book(OrderBook *book, uint64_t *order_sum)
+{
+    *order_sum = sum_orders(book);
+    if (add_book_listener(book, track_orders, order_sum) != 0)
+    {
+        fprintf(stderr, "No book listener slot left for replication\n");
+        return -1;
+    }
+    return 0;
+}
+
+int repl_apply(OrderBook *book, const ReplMessage *message)
+{
+    switch (message->type)
+    {
+    case REPL_ADD:
+    {
+        Order *order = create_owned_order(message->body.add.order_id, 0, message->body.add.quantity, 0,
+                                          message->body.add.side, message->body.add.owner_id);
+        order->price = message->body.add.price;
+        order->timestamp = message->body.add.timestamp;
+        set_time_in_force(order, (TimeInForce)message->body.add.tif, message->body.add.expire_time);
+        if (add_order(book, order) != 0)
+        {
+            free_order(order);
+            return -1;
+        }
+        return 0;
+    }
+    case REPL_CANCEL:
+        return cancel_order(book, message->body.order.order_id);
+    case REPL_MODIFY:
+        return modify_order(book, message->body.order.order_id, message->body.order.price,
+                            message->body.order.quantity);
+    case REPL_EXPIRE:
+        return expire_orders(book, message->body.now);
+    case REPL_EXPIRE_DAY:
+        return expire_day_orders(book);
+    case REPL_MASS_CANCEL:
+        return mass_cancel(book, &message->body.mass_cancel);
+    case REPL_SET_COD:
+        set_cancel_on_disconnect(book, message->body.account.owner_id, message->body.account.enabled);
+        return 0;
+    case REPL_DISCONNECT:
+        return account_disconnected(book, message->body.account.owner_id);
+    case REPL_BEGIN_AUCTION:
+        begin_auction(book);
+        return 0;
+    case REPL_UNCROSS:
+        return uncross_auction(book, message->body.reference_price, NULL);
+    case REPL_CHECKSUM:
+        return 0;
+    }
+    return -1;
+}
+
+static ReplRegion *open_region(const char *shm_name, int create)
+{
+    int fd = shm_open(shm_name, create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+    if (fd < 0)
+        return NULL;
+    if (create && ftruncate(fd, sizeof(ReplRegion)) != 0)
+    {
+        close(fd);
+        shm_unlink(shm_name);
+        return NULL;
+    }
+
+    void *mapped = mmap(NULL, sizeof(ReplRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        if (create)
+            shm_unlink(shm_name);
+        return NULL;
+    }
+
+    ReplRegion *region = (ReplRegion *)mapped;
+    if (create)
+    {
+        memset(region, 0, sizeof(ReplRegion));
+        region->ring_capacity = REPL_RING_CAPACITY;
+        atomic_store_explicit(&region->heartbeat_ns, repl_clock_ns(), memory_order_relaxed);
+        // magic last: a backup attaching early rejects a half-built region
+        atomic_thread_fence(memory_order_release);
+        region->magic = REPL_MAGIC;
+    }
+    else if (region->magic != REPL_MAGIC || region->ring_capacity != REPL_RING_CAPACITY)
+    {
+        munmap(mapped, sizeof(ReplRegion));
+        return NULL;
+    }
+    return region;
+}
+
+ReplPrimary *create_repl_primary(OrderBook *book, const char *shm_name, int checksum_interval)
+{
+    if (!book || !shm_name || checksum_interval < 0)
+        return NULL;
+
+    ReplRegion *region = open_region(shm_name, 1);
+    if (!region)
+    {
+        fprintf(stderr, "Could not create replication log %s\n", shm_name);
+        return NULL;
+    }
+
+    ReplPrimary *primary = (ReplPrimary *)calloc(1, sizeof(ReplPrimary));
+    if (!primary)
+    {
+        fprintf(stderr, "Memory allocation failed for ReplPrimary\n");
+        exit(EXIT_FAILURE);
+    }
+    primary->book = book;
+    primary->region = region;
+    primary->shm_name = strdup(shm_name);
+    primary->checksum_interval = checksum_interval;
+    if (track_book(book, &primary->order_sum) != 0)
+    {
+        free_repl_primary(primary);
+        return NULL;
+    }
+    return primary;
+}
+
+uint64_t repl_primary_checksum(const ReplPrimary *primary)
+{
+    return book_checksum(primary->book, primary->order_sum);
+}
+
+void free_repl_primary(ReplPrimary *primary)
+{
+    if (!primary)
+        return;
+
+    remove_book_listener(primary->book, track_orders, &primary->order_sum);
+    munmap(primary->region, sizeof(ReplRegion));
+    shm_unlink(primary->shm_name);
+    free(primary->shm_name);
+    free(primary);
+}
+
+static uint64_t published_word(uint64_t epoch, uint64_t sequence)
+{
+    return epoch << REPL_SEQUENCE_BITS | sequence;
+}
+
+// Writes the next slot, then publishes it with a compare-and-swap that
+// also checks the epoch. 0 if published, -1 if a backup was promoted
+// first; the backup never reads past the published sequence, so the
+// slot written for a fenced message is never applied
+static int publish(ReplPrimary *primary, ReplMessage *message)
+{
+    ReplRegion *region = primary->region;
+    uint64_t sequence = primary->sequence + 1;
+    message->sequence = sequence;
+    message->timestamp_ns = repl_clock_ns();
+
+    ReplSlot *slot = &region->ring[(sequence - 1) & (REPL_RING_CAPACITY - 1)];
+    atomic_store_explicit(&slot->version, 2 * sequence - 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->message = *message;
+    atomic_store_explicit(&slot->version, 2 * sequence, memory_order_release);
+
+    uint64_t expected = published_word(primary->epoch, primary->sequence);
+    if (!atomic_compare_exchange_strong_explicit(&region->published, &expected,
+                                                 published_word(primary->epoch, sequence),
+                                                 memory_order_acq_rel, memory_order_acquire))
+        return -1;
+    primary->sequence = sequence;
+    atomic_store_explicit(&region->heartbeat_ns, message->timestamp_ns, memory_order_relaxed);
+    return 0;
+}
+
+static int fenced(const ReplPrimary *primary)
+{
+    uint64_t published = atomic_load_explicit(&primary->region->published, memory_order_acquire);
+    return published >> REPL_SEQUENCE_BITS != primary->epoch;
+}
+
+int repl_submit(ReplPrimary *primary, ReplMessage *message)
+{
+    if (!primary || !message || message->type == REPL_CHECKSUM)
+        return -1;
+    // logged before it is applied: the backup may run ahead of us, never
+    // behind what a client has already seen acknowledged
+    if (fenced(primary) || publish(primary, message) != 0)
+    {
+        fprintf(stderr, "Replication primary has been fenced by a promoted backup\n");
+        return -1;
+    }
+    int result = repl_apply(primary->book, message);
+
+    if (primary->checksum_interval > 0 && ++primary->since_checksum >= primary->checksum_interval)
+    {
+        ReplMessage checksum;
+        memset(&checksum, 0, sizeof(checksum));
+        checksum.type = REPL_CHECKSUM;
+        checksum.body.checksum = book_checksum(primary->book, primary->order_sum);
+        publish(primary, &checksum); // fenced since: the next submit reports it
+        primary->since_checksum = 0;
+    }
+    return result;
+}
+
+int repl_add_order(ReplPrimary *primary, const Order *order)
+{
+    if (!order)
+        return -1;
+
+    ReplMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = REPL_ADD;
+    message.body.add.order_id = order->order_id;
+    message.body.add.owner_id = order->owner_id;
+    message.body.add.quantity = order->quantity;
+    message.body.add.side = order->side;
+    message.body.add.tif = order->tif;
+    message.body.add.price = order->price;
+    message.body.add.timestamp = order->timestamp;
+    message.body.add.expire_time = order->expire_time;
+    return repl_submit(primary, &message);
+}
+
+int repl_cancel_order(ReplPrimary *primary, int order_id)
+{
+    ReplMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = REPL_CANCEL;
+    message.body.order.order_id = order_id;
+    return repl_submit(primary, &message);
+}
+
+int repl_modify_order(ReplPrimary *primary, int order_id, double new_price, int new_quantity)
+{
+    ReplMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = REPL_MODIFY;
+    message.body.order.order_id = order_id;
+    message.body.order.price = new_price;
+    message.body.order.quantity = new_quantity;
+    return repl_submit(primary, &message);
+}
+
+int repl_expire_orders(ReplPrimary *primary, long long now)
+{
+    ReplMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = REPL_EXPIRE;
+    message.body.now = now;
+    return repl_submit(primary, &message);
+}
+
+int repl_begin_auction(ReplPrimary *primary)
+{
+    ReplMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = REPL_BEGIN_AUCTION;
+    return repl_submit(primary, &message);
+}
+
+int repl_uncross_auction(ReplPrimary *primary, double reference_price)
+{
+    ReplMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = REPL_UNCROSS;
+    message.body.reference_price = reference_price;
+    return repl_submit(primary, &message);
+}
+
+void repl_primary_heartbeat(ReplPrimary *primary)
+{
+    if (primary)
+        atomic_store_explicit(&primary->region->heartbeat_ns, repl_clock_ns(), memory_order_relaxed);
+}
+
+uint64_t repl_primary_lag(const ReplPrimary *primary)
+{
+    ReplRegion *region = primary->region;
+    return primary->sequence - atomic_load_explicit(&region->applied, memory_order_acquire);
+}
+
+ReplBackup *create_repl_backup(OrderBook *book, const char *shm_name)
+{
+    if (!book || !shm_name)
+        return NULL;
+
+    ReplRegion *region = open_region(shm_name, 0);
+    if (!region)
+    {
+        fprintf(stderr, "Could not attach to replication log %s\n", shm_name);
+        return NULL;
+    }
+
+    ReplBackup *backup = (ReplBackup *)calloc(1, sizeof(ReplBackup));
+    if (!backup)
+    {
+        fprintf(stderr, "Memory allocation failed for ReplBackup\n");
+        exit(EXIT_FAILURE);
+    }
+    backup->book = book;
+    backup->region = region;
+    backup->state = REPL_BACKUP_OK;
+    if (track_book(book, &backup->order_sum) != 0)
+    {
+        free_repl_backup(backup);
+        return NULL;
+    }
+    return backup;
+}
+
+uint64_t repl_backup_checksum(const ReplBackup *backup)
+{
+    return book_checksum(backup->book, backup->order_sum);
+}
+
+void free_repl_backup(ReplBackup *backup)
+{
+    if (!backup)
+        return;
+
+    remove_book_listener(backup->book, track_orders, &backup->order_sum);
+    munmap(backup->region, sizeof(ReplRegion));
+    free(backup);
+}
+
+// 1 when message sequence was copied, 0 if not published yet, -1 if overwritten
+static int read_message(const ReplRegion *region, uint64_t sequence, ReplMessage *out)
+{
+    ReplSlot *slot = (ReplSlot *)&region->ring[(sequence - 1) & (REPL_RING_CAPACITY - 1)];
+    uint64_t complete = 2 * sequence;
+
+    uint64_t before = atomic_load_explicit(&slot->version, memory_order_acquire);
+    if (before < complete)
+        return 0;
+    if (before > complete)
+        return -1;
+
+    memcpy(out, &slot->message, sizeof(ReplMessage));
+
+    // the primary lapped us mid-copy
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&slot->version, memory_order_relaxed) != complete)
+        return -1;
+    return out->sequence == sequence ? 1 : -1;
+}
+
+int repl_backup_poll(ReplBackup *backup, int max)
+{
+    if (!backup || backup->state != REPL_BACKUP_OK)
+        return -1;
+
+    // only published messages: a slot past it may be one a fenced primary
+    // wrote and then failed to publish
+    uint64_t published = atomic_load_explicit(&backup->region->published, memory_order_acquire) &
+                         REPL_SEQUENCE_MASK;
+    int applied = 0;
+    ReplMessage message;
+    while (applied < max && backup->applied < published)
+    {
+        uint64_t next = backup->applied + 1;
+        int read = read_message(backup->region, next, &message);
+        if (read == 0)
+            break;
+        if (read < 0)
+        {
+            fprintf(stderr, "Replication gap: message %llu was overwritten\n", (unsigned long long)next);
+            backup->gap_at = next;
+            backup->state = REPL_BACKUP_GAP;
+            return -1;
+        }
+
+        if (message.type == REPL_CHECKSUM)
+        {
+            if (book_checksum(backup->book, backup->order_sum) != message.body.checksum)
+            {
+                fprintf(stderr, "Replicated book diverged at message %llu\n", (unsigned long long)next);
+                backup->state = REPL_BACKUP_DIVERGED;
+                return -1;
+            }
+            backup->checksums_matched++;
+        }
+        else
+        {
+            repl_apply(backup->book, &message);
+        }
+
+        backup->applied = next;
+        applied++;
+    }
+
+    atomic_store_explicit(&backup->region->applied, backup->applied, memory_order_release);
+    return applied;
+}
+
+int repl_primary_alive(const ReplBackup *backup, uint64_t timeout_ns)
+{
+    uint64_t heartbeat = atomic_load_explicit(&backup->region->heartbeat_ns, memory_order_relaxed);
+    uint64_t now = repl_clock_ns();
+    return now < heartbeat || now - heartbeat <= timeout_ns;
+}
+
+OrderBook *repl_promote(ReplBackup *backup)
+{
+    if (!backup)
+        return NULL;
+
+    // fence first so a primary that is only slow stops logging, then
+    // drain what it did log; a publish racing the fence either lands
+    // before it (and is drained) or fails
+    uint64_t published = atomic_load_explicit(&backup->region->published, memory_order_acquire);
+    uint64_t fenced_word;
+    do
+        fenced_word = published_word((published >> REPL_SEQUENCE_BITS) + 1, published & REPL_SEQUENCE_MASK);
+    while (!atomic_compare_exchange_weak_explicit(&backup->region->published, &published, fenced_word,
+                                                  memory_order_acq_rel, memory_order_acquire));
+    while (repl_backup_poll(backup, REPL_RING_CAPACITY) > 0)
+        ;
+    if (backup->state != REPL_BACKUP_OK)
+        return NULL;
+
+    backup->state = REPL_BACKUP_PROMOTED;
+    return backup->book;
+}
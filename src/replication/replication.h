@@ -0,0 +1,188 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "orderbook.h"
+
+/*
+    Primary/backup replication of one OrderBook. The primary sequences
+    every state-changing input, writes it to a shared-memory log and
+    applies it to its own book; a hot standby applies the same messages
+    in sequence order to a book configured the same way, so both books
+    stay identical (matching is deterministic given its inputs).
+
+    The log is a ring in which every slot carries its own version, as in
+    the market-data feed: the primary never waits for the backup, and a
+    backup that falls a full ring behind sees the overwritten slot as a
+    sequence gap. Every checksum_interval messages the primary also logs
+    a checksum of its book, which the backup compares with its own after
+    applying the same prefix of the stream. Both sides keep their
+    checksum current from the book's events, so taking one is O(1).
+
+    The primary stamps a heartbeat on every message (and on
+    repl_primary_heartbeat when idle). A backup that sees the heartbeat
+    go stale drains what is left of the log and promotes itself; the
+    epoch it bumps fences the old primary, whose submits then fail.
+    Epoch and published sequence share one word: the primary publishes
+    with a compare-and-swap that fails once the epoch has moved, so a
+    message is either published before the fence (and drained by the
+    promoting backup) or not at all, and the primary applies only what
+    it published.
+*/
+
+#define REPL_MAGIC 0x5245504Cu // "REPL"
+#define REPL_RING_CAPACITY 16384 // power of two
+#define REPL_CACHE_LINE 64
+#define REPL_SEQUENCE_BITS 48 // low bits of published; the epoch is above them
+#define REPL_SEQUENCE_MASK ((1ULL << REPL_SEQUENCE_BITS) - 1)
+
+typedef enum
+{
+    REPL_ADD,            // add_order
+    REPL_CANCEL,         // cancel_order
+    REPL_MODIFY,         // modify_order
+    REPL_EXPIRE,         // expire_orders
+    REPL_EXPIRE_DAY,     // expire_day_orders
+    REPL_MASS_CANCEL,    // mass_cancel
+    REPL_SET_COD,        // set_cancel_on_disconnect
+    REPL_DISCONNECT,     // account_disconnected
+    REPL_BEGIN_AUCTION,  // begin_auction
+    REPL_UNCROSS,        // uncross_auction
+    REPL_CHECKSUM        // primary's book checksum after the previous message
+} ReplMessageType;
+
+// One sequenced input; the body is selected by type
+typedef struct
+{
+    uint64_t sequence;     // 1, 2, ... with no gaps
+    uint64_t timestamp_ns; // primary's monotonic clock when sequenced
+    uint32_t type;         // ReplMessageType
+    union
+    {
+        struct
+        {
+            int order_id;
+            int owner_id;
+            int quantity;
+            char side;
+            uint32_t tif; // TimeInForce
+            double price;
+            double timestamp;
+            long long expire_time;
+        } add;
+        struct
+        {
+            int order_id;
+            int quantity; // modify only
+            double price; // modify only
+        } order;
+        struct
+        {
+            int owner_id;
+            int enabled; // set-cancel-on-disconnect only
+        } account;
+        long long now;                 // expire
+        double reference_price;        // uncross
+        MassCancelFilter mass_cancel;
+        uint64_t checksum;
+    } body;
+} ReplMessage;
+
+typedef struct
+{
+    _Alignas(REPL_CACHE_LINE) _Atomic uint64_t version; // 2n - 1 while message n is written, 2n once complete
+    ReplMessage message;
+} ReplSlot;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t ring_capacity;
+    // epoch << REPL_SEQUENCE_BITS | last sequence published; the epoch
+    // is bumped on promotion
+    _Alignas(REPL_CACHE_LINE) _Atomic uint64_t published;
+    _Atomic uint64_t heartbeat_ns;
+    _Alignas(REPL_CACHE_LINE) _Atomic uint64_t applied; // backup's last applied sequence
+    ReplSlot ring[REPL_RING_CAPACITY];
+} ReplRegion;
+
+typedef struct
+{
+    OrderBook *book;
+    ReplRegion *region;
+    char *shm_name;
+    uint64_t sequence;
+    uint64_t epoch;         // region epoch when created; a change means fenced
+    int checksum_interval;  // messages between checksums, 0 for none
+    int since_checksum;
+    uint64_t order_sum;     // orderbook_checksum's order part, kept from book events
+} ReplPrimary;
+
+typedef enum
+{
+    REPL_BACKUP_OK,
+    REPL_BACKUP_GAP,      // a message was overwritten before it was applied
+    REPL_BACKUP_DIVERGED, // book checksum differs from the primary's
+    REPL_BACKUP_PROMOTED
+} ReplBackupState;
+
+typedef struct
+{
+    OrderBook *book;
+    ReplRegion *region;
+    uint64_t applied;         // last sequence applied
+    uint64_t gap_at;          // first missing sequence, when state is GAP
+    uint64_t checksums_matched;
+    ReplBackupState state;
+    uint64_t order_sum;       // as in ReplPrimary
+} ReplBackup;
+
+// Order-independent hash of every resting order (id, side, price,
+// quantity and arrival sequence) and the trade count. Walks the whole
+// book; primary and backup keep the same value incrementally
+uint64_t orderbook_checksum(OrderBook *book);
+// Applies one message to book; returns the call's own result
+int repl_apply(OrderBook *book, const ReplMessage *message);
+uint64_t repl_clock_ns();
+
+// Creates the log in POSIX shm_name for book and listens to its events.
+// NULL if the region cannot be created or the book has no listener slot
+ReplPrimary *create_repl_primary(OrderBook *book, const char *shm_name, int checksum_interval);
+// The running checksum the primary logs; equals orderbook_checksum(book)
+uint64_t repl_primary_checksum(const ReplPrimary *primary);
+// Unmaps and unlinks the log and stops listening to the book
+void free_repl_primary(ReplPrimary *primary);
+// Sequences message (its sequence and timestamp are filled in), logs it
+// and applies it to the primary's book. Returns the apply result, or -1
+// without touching the book once a backup has been promoted, including
+// one that promotes while this call is logging
+int repl_submit(ReplPrimary *primary, ReplMessage *message);
+int repl_add_order(ReplPrimary *primary, const Order *order);
+int repl_cancel_order(ReplPrimary *primary, int order_id);
+int repl_modify_order(ReplPrimary *primary, int order_id, double new_price, int new_quantity);
+int repl_expire_orders(ReplPrimary *primary, long long now);
+int repl_begin_auction(ReplPrimary *primary);
+int repl_uncross_auction(ReplPrimary *primary, double reference_price);
+void repl_primary_heartbeat(ReplPrimary *primary);
+// Messages the backup has not applied yet
+uint64_t repl_primary_lag(const ReplPrimary *primary);
+
+// Attaches a standby to the log; book must be configured like the
+// primary's (policy, STP mode, ladder) and not have taken input. NULL
+// if the log cannot be attached or the book has no listener slot
+ReplBackup *create_repl_backup(OrderBook *book, const char *shm_name);
+// The running checksum compared with the primary's
+uint64_t repl_backup_checksum(const ReplBackup *backup);
+// Unmaps the log and stops listening; the book stays with the caller
+void free_repl_backup(ReplBackup *backup);
+// Applies up to max published messages in order; returns the number
+// applied, or -1 once the backup has hit a gap or diverged
+int repl_backup_poll(ReplBackup *backup, int max);
+// 1 if the primary has stamped its heartbeat within timeout_ns
+int repl_primary_alive(const ReplBackup *backup, uint64_t timeout_ns);
+// Applies everything still in the log and fences the primary. Returns
+// the book, now live, or NULL if the backup is not a faithful copy
+OrderBook *repl_promote(ReplBackup *backup);
+
+#endif
@@ -0,0 +1,253 @@
+#define _GNU_SOURCE
+
+#include "runtime.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// From linux/mempolicy.h; called through syscall() to avoid a libnuma dependency
+#define RUNTIME_MPOL_PREFERRED 1
+#define RUNTIME_MAX_NODES 64
+
+RuntimeConfig default_runtime_config()
+{
+    RuntimeConfig config;
+    for (int r = 0; r < ROLE_COUNT; r++)
+        config.cpu[r] = -1;
+    config.reserve_orders = 0;
+    config.prefault = 0;
+    config.lock_memory = 0;
+    config.arena_bytes = 0;
+    config.arena_pages = ARENA_PAGES_2M;
+    return config;
+}
+
+static int parse_int(const char *value, int *out)
+{
+    char *end;
+    long parsed = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || parsed < 0 || parsed > 1 << 30)
+        return -1;
+    *out = (int)parsed;
+    return 0;
+}
+
+// Bytes with an optional K, M or G suffix
+static int parse_size(const char *value, size_t *out)
+{
+    char *end;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (end == value || value[0] == '-')
+        return -1;
+    int shift = *end == 'K' ? 10 : *end == 'M' ? 20 : *end == 'G' ? 30 : 0;
+    if (shift)
+        end++;
+    if (*end != '\0' || parsed > (SIZE_MAX >> shift))
+        return -1;
+    *out = (size_t)parsed << shift;
+    return 0;
+}
+
+static int parse_pages(const char *value, ArenaPages *out)
+{
+    if (strcmp(value, "none") == 0)
+        *out = ARENA_PAGES_NORMAL;
+    else if (strcmp(value, "2M") == 0)
+        *out = ARENA_PAGES_2M;
+    else if (strcmp(value, "1G") == 0)
+        *out = ARENA_PAGES_1G;
+    else
+        return -1;
+    return 0;
+}
+
+static int apply_entry(char *entry, RuntimeConfig *config)
+{
+    static const char *role_names[ROLE_COUNT] = {"matching", "ingress", "publisher"};
+
+    char *value = strchr(entry, '=');
+    if (!value)
+    {
+        if (strcmp(entry, "prefault") == 0)
+            config->prefault = 1;
+        else if (strcmp(entry, "mlock") == 0)
+            config->lock_memory = 1;
+        else
+            return -1;
+        return 0;
+    }
+
+    *value++ = '\0';
+    for (int r = 0; r < ROLE_COUNT; r++)
+    {
+        if (strcmp(entry, role_names[r]) == 0)
+            return parse_int(value, &config->cpu[r]);
+    }
+    if (strcmp(entry, "reserve") == 0)
+        return parse_int(value, &config->reserve_orders);
+    if (strcmp(entry, "arena") == 0)
+        return parse_size(value, &config->arena_bytes);
+    if (strcmp(entry, "hugepages") == 0)
+        return parse_pages(value, &config->arena_pages);
+    return -1;
+}
+
+int parse_runtime_config(const char *spec, RuntimeConfig *config)
+{
+    if (!spec || !config)
+        return -1;
+
+    char *copy = strdup(spec);
+    if (!copy)
+    {
+        fprintf(stderr, "Memory allocation failed for runtime config\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int result = 0;
+    for (char *entry = strtok(copy, ","); entry; entry = strtok(NULL, ","))
+    {
+        if (apply_entry(entry, config) != 0)
+        {
+            fprintf(stderr, "Invalid runtime config entry: %s\n", entry);
+            result = -1;
+            break;
+        }
+    }
+
+    free(copy);
+    return result;
+}
+
+int runtime_cpu_node(int cpu)
+{
+    // sysfs lists the owning node as a nodeN entry in the cpu directory
+    char path[96];
+    for (int node = 0; cpu >= 0 && node < RUNTIME_MAX_NODES; node++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        FILE *probe = fopen(path, "r");
+        if (probe)
+        {
+            fclose(probe);
+            return node;
+        }
+    }
+    return 0;
+}
+
+int runtime_enter_thread(const RuntimeConfig *config, ThreadRole role)
+{
+    if (!config || role < 0 || role >= ROLE_COUNT)
+        return -1;
+
+    int cpu = config->cpu[role];
+    if (cpu < 0)
+        return 0;
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    {
+        perror("sched_setaffinity");
+        return -1;
+    }
+
+    unsigned long nodemask = 1UL << runtime_cpu_node(cpu);
+    if (syscall(SYS_set_mempolicy, RUNTIME_MPOL_PREFERRED, &nodemask, RUNTIME_MAX_NODES + 1) != 0)
+    {
+        perror("set_mempolicy");
+        return -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+void runtime_prefault(void *addr, size_t len)
+{
+    if (!addr || len == 0)
+        return;
+
+#ifdef __linux__
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#else
+    size_t page = 4096;
+#endif
+    // volatile so the stores are not elided; rewriting the byte keeps contents
+    volatile char *bytes = (volatile char *)addr;
+    for (size_t offset = 0; offset < len; offset += page)
+        bytes[offset] = bytes[offset];
+    bytes[len - 1] = bytes[len - 1];
+}
+
+int runtime_lock_memory()
+{
+#ifdef __linux__
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        perror("mlockall");
+        return -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+static void prefault_orderbook(OrderBook *orderbook)
+{
+    OrderHeap *sides[2] = {orderbook->buy_orders, orderbook->sell_orders};
+    for (int s = 0; s < 2; s++)
+    {
+        runtime_prefault(sides[s]->arr, sides[s]->capacity * sizeof(OrderHandle));
+        runtime_prefault(sides[s]->keys, sides[s]->capacity * sizeof(uint64_t));
+    }
+
+    OrderTable *table = orderbook->order_table;
+    runtime_prefault(table->keys, table->capacity * sizeof(uint64_t));
+    runtime_prefault(table->heap_index, table->capacity * sizeof(int));
+    runtime_prefault(table->orders, table->capacity * sizeof(Order *));
+    runtime_prefault(table->free_list, table->capacity * sizeof(OrderHandle));
+
+    OrderMap *map = orderbook->order_map;
+    runtime_prefault(map->buckets, map->capacity * sizeof(MapEntry *));
+}
+
+OrderBook *runtime_create_orderbook(const RuntimeConfig *config)
+{
+    RuntimeConfig defaults = default_runtime_config();
+    if (!config)
+        config = &defaults;
+
+    if (runtime_enter_thread(config, ROLE_MATCHING) != 0)
+        fprintf(stderr, "Matching thread left unplaced\n");
+
+    // after entering the role, so the reservation comes from the matching node
+    if (config->arena_bytes > 0 && !arena_current())
+    {
+        Arena *arena = create_arena(config->arena_bytes, config->arena_pages, config->prefault);
+        if (!arena)
+            fprintf(stderr, "Book arena not reserved, allocating from the heap\n");
+        else if (arena->pages != config->arena_pages)
+            fprintf(stderr, "Book arena backed by smaller pages than requested\n");
+        arena_set_current(arena);
+    }
+
+    OrderBook *orderbook = create_orderbook();
+    reserve_orderbook(orderbook, config->reserve_orders);
+
+    if (config->prefault)
+        prefault_orderbook(orderbook);
+    if (config->lock_memory && runtime_lock_memory() != 0)
+        fprintf(stderr, "Book memory left unlocked\n");
+
+    return orderbook;
+}
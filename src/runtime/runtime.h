@@ -0,0 +1,62 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "orderbook.h"
+
+/*
+    Thread placement and memory locality for the engine's threads.
+
+    Each role is pinned to one core. A thread that enters its role also
+    prefers memory from that core's NUMA node, so a book created on the
+    matching thread afterwards (heaps, order table, OrderMap) is
+    allocated node-local, from a huge-page arena reserved up front if
+    one is configured. Linux only; elsewhere the calls fail with -1
+    and the engine runs unplaced.
+*/
+
+typedef enum
+{
+    ROLE_MATCHING,
+    ROLE_INGRESS,
+    ROLE_PUBLISHER,
+    ROLE_COUNT
+} ThreadRole;
+
+typedef struct RuntimeConfig
+{
+    int cpu[ROLE_COUNT];    // core per role, -1 leaves the thread unpinned
+    int reserve_orders;     // resting orders per side to pre-size each book for
+    int prefault;           // touch every reserved page at startup
+    int lock_memory;        // mlockall current and future pages
+    size_t arena_bytes;     // book memory reserved up front, 0 allocates from the heap
+    ArenaPages arena_pages; // largest pages to back the arena with
+} RuntimeConfig;
+
+RuntimeConfig default_runtime_config();
+// Parses "matching=2,ingress=3,publisher=4,reserve=100000,arena=512M,
+// hugepages=1G,prefault,mlock" (hugepages is none, 2M or 1G);
+// unspecified fields keep their defaults. 0 on success, -1 on a bad entry
+int parse_runtime_config(const char *spec, RuntimeConfig *config);
+
+// NUMA node of cpu, 0 when the topology is unknown
+int runtime_cpu_node(int cpu);
+// Pins the calling thread to its role's core and prefers that node's
+// memory for its allocations. 0 on success (or nothing to do), -1 on failure
+int runtime_enter_thread(const RuntimeConfig *config, ThreadRole role);
+// Writes one byte per page so the range is backed before trading starts
+void runtime_prefault(void *addr, size_t len);
+int runtime_lock_memory();
+
+// Creates a book for the calling (matching) thread: enters ROLE_MATCHING,
+// makes a new arena of arena_bytes (prefaulted with prefault) the
+// thread's current one unless it already has one, reserves and
+// optionally prefaults the book, then locks memory if asked. The arena
+// serves every book the thread creates; free it with
+// free_arena(arena_set_current(NULL)) after the last book. Placement
+// failures are reported on stderr but do not stop the engine
+OrderBook *runtime_create_orderbook(const RuntimeConfig *config);
+
+#endif
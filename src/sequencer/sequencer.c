@@ -0,0 +1,187 @@
+#include "sequencer.h"
+
+#include <time.h>
+
+static uint64_t clock_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+Sequencer *create_sequencer(int batch_size)
+{
+    if (batch_size <= 0)
+        return NULL;
+
+    Sequencer *sequencer = (Sequencer *)calloc(1, sizeof(Sequencer));
+    if (!sequencer)
+    {
+        fprintf(stderr, "Memory allocation failed for Sequencer\n");
+        exit(EXIT_FAILURE);
+    }
+    sequencer->batch = (SeqMessage *)malloc(batch_size * sizeof(SeqMessage));
+    if (!sequencer->batch)
+    {
+        fprintf(stderr, "Memory allocation failed for sequencer batch\n");
+        exit(EXIT_FAILURE);
+    }
+    sequencer->batch_size = batch_size;
+    sequencer->next_sequence = 1;
+    return sequencer;
+}
+
+void free_sequencer(Sequencer *sequencer)
+{
+    if (!sequencer)
+        return;
+
+    for (int g = 0; g < sequencer->gateway_count; g++)
+    {
+        free(sequencer->gateways[g]->slots);
+        free(sequencer->gateways[g]);
+    }
+    free(sequencer->batch);
+    free(sequencer);
+}
+
+IngressQueue *sequencer_add_gateway(Sequencer *sequencer, int capacity)
+{
+    if (!sequencer || capacity <= 0 || sequencer->gateway_count == MAX_GATEWAYS)
+        return NULL;
+
+    uint64_t size = 1;
+    while (size < (uint64_t)capacity)
+        size <<= 1;
+
+    IngressQueue *queue = (IngressQueue *)aligned_alloc(SEQ_CACHE_LINE, sizeof(IngressQueue));
+    if (!queue)
+    {
+        fprintf(stderr, "Memory allocation failed for IngressQueue\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(queue, 0, sizeof(IngressQueue));
+    queue->slots = (SeqMessage *)malloc(size * sizeof(SeqMessage));
+    if (!queue->slots)
+    {
+        fprintf(stderr, "Memory allocation failed for ingress slots\n");
+        exit(EXIT_FAILURE);
+    }
+    queue->mask = size - 1;
+    queue->gateway = (uint16_t)sequencer->gateway_count;
+
+    sequencer->gateways[sequencer->gateway_count++] = queue;
+    return queue;
+}
+
+void set_sequenced_handler(Sequencer *sequencer, SequencedHandler handler, void *context)
+{
+    if (!sequencer)
+        return;
+
+    sequencer->handler = handler;
+    sequencer->handler_context = context;
+}
+
+int ingress_push(IngressQueue *queue, const SeqMessage *message)
+{
+    uint64_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&queue->head, memory_order_acquire) > queue->mask)
+        return -1;
+
+    SeqMessage *slot = &queue->slots[tail & queue->mask];
+    *slot = *message;
+    slot->gateway = queue->gateway;
+    slot->ingress_ns = clock_ns();
+    slot->sequence = 0;
+    slot->receive_ns = 0;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+int sequencer_poll(Sequencer *sequencer, SeqMessage *out, int max)
+{
+    int count = sequencer->gateway_count;
+    uint64_t head[MAX_GATEWAYS];
+    uint64_t tail[MAX_GATEWAYS];
+    // one snapshot of every queue, so a busy gateway cannot starve the rest
+    for (int g = 0; g < count; g++)
+    {
+        head[g] = atomic_load_explicit(&sequencer->gateways[g]->head, memory_order_relaxed);
+        tail[g] = atomic_load_explicit(&sequencer->gateways[g]->tail, memory_order_acquire);
+    }
+
+    uint64_t now = clock_ns();
+    if (now < sequencer->last_receive_ns)
+        now = sequencer->last_receive_ns;
+
+    int taken = 0;
+    while (taken < max)
+    {
+        int best = -1;
+        uint64_t best_ns = 0;
+        for (int g = 0; g < count; g++)
+        {
+            if (head[g] == tail[g])
+                continue;
+            uint64_t ns = sequencer->gateways[g]->slots[head[g] & sequencer->gateways[g]->mask].ingress_ns;
+            if (best < 0 || ns < best_ns)
+            {
+                best = g;
+                best_ns = ns;
+            }
+        }
+        if (best < 0)
+            break;
+
+        IngressQueue *queue = sequencer->gateways[best];
+        out[taken] = queue->slots[head[best] & queue->mask];
+        out[taken].sequence = sequencer->next_sequence++;
+        out[taken].receive_ns = now;
+        head[best]++;
+        taken++;
+    }
+
+    for (int g = 0; g < count; g++)
+        atomic_store_explicit(&sequencer->gateways[g]->head, head[g], memory_order_release);
+    sequencer->last_receive_ns = now;
+    return taken;
+}
+
+int sequencer_apply(OrderBook *book, const SeqMessage *message)
+{
+    switch (message->type)
+    {
+    case SEQ_NEW_ORDER:
+    {
+        Order *order = create_owned_order(message->order_id, 0, message->quantity, 0, message->side,
+                                          message->owner_id);
+        order->price = message->price;
+        order->timestamp = (double)message->receive_ns;
+        set_time_in_force(order, (TimeInForce)message->tif, message->expire_time);
+        if (add_order(book, order) != 0)
+        {
+            free_order(order);
+            return -1;
+        }
+        return 0;
+    }
+    case SEQ_CANCEL:
+        return cancel_order(book, message->order_id);
+    case SEQ_MODIFY:
+        return modify_order(book, message->order_id, message->price, message->quantity);
+    }
+    return -1;
+}
+
+int sequencer_run(Sequencer *sequencer, OrderBook *book)
+{
+    int count = sequencer_poll(sequencer, sequencer->batch, sequencer->batch_size);
+    for (int i = 0; i < count; i++)
+    {
+        int result = sequencer_apply(book, &sequencer->batch[i]);
+        if (sequencer->handler)
+            sequencer->handler(sequencer->handler_context, &sequencer->batch[i], result);
+    }
+    return count;
+}
@@ -0,0 +1,92 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "orderbook.h"
+
+/*
+    Engine-side sequencer. Each gateway thread pushes inbound messages
+    into its own single-producer ingress queue; the matching thread
+    merges the queues in batches, stamps every message with the next
+    64-bit sequence number and a nanosecond receive time, and applies
+    them to the book in that order.
+
+    The sequenced stream is the only input the book sees: orders take
+    their timestamp from the receive time and their priority from
+    arrival, so client clocks never affect matching. Applying a recorded
+    stream with sequencer_apply rebuilds the session exactly.
+*/
+
+#define MAX_GATEWAYS 16
+#define SEQ_CACHE_LINE 64
+
+typedef enum
+{
+    SEQ_NEW_ORDER,
+    SEQ_CANCEL,
+    SEQ_MODIFY
+} SeqMessageType;
+
+typedef struct
+{
+    uint64_t sequence;   // stamped by the sequencer: 1, 2, ...
+    uint64_t receive_ns; // stamped by the sequencer; never decreases
+    uint64_t ingress_ns; // stamped when the gateway queued the message
+    uint64_t user_data;  // caller's correlation id, carried through unchanged
+    uint16_t gateway;
+    uint8_t type;        // SeqMessageType
+    char side;
+    int order_id;
+    int owner_id;
+    int quantity;
+    uint32_t tif; // TimeInForce
+    double price;
+    long long expire_time;
+} SeqMessage;
+
+// Single-producer, single-consumer ring between one gateway and the sequencer
+typedef struct
+{
+    _Alignas(SEQ_CACHE_LINE) _Atomic uint64_t tail; // next slot the gateway writes
+    _Alignas(SEQ_CACHE_LINE) _Atomic uint64_t head; // next slot the sequencer reads
+    _Alignas(SEQ_CACHE_LINE) SeqMessage *slots;
+    uint64_t mask;
+    uint16_t gateway;
+} IngressQueue;
+
+// Called for each message after it has been applied, with the result
+typedef void (*SequencedHandler)(void *context, const SeqMessage *message, int result);
+
+typedef struct
+{
+    IngressQueue *gateways[MAX_GATEWAYS];
+    int gateway_count;
+    uint64_t next_sequence;
+    uint64_t last_receive_ns;
+    SeqMessage *batch;
+    int batch_size;
+    SequencedHandler handler;
+    void *handler_context;
+} Sequencer;
+
+// batch_size bounds the messages merged per sequencer_run
+Sequencer *create_sequencer(int batch_size);
+void free_sequencer(Sequencer *sequencer);
+// Adds a gateway whose queue holds capacity messages (rounded up to a
+// power of two); NULL when MAX_GATEWAYS are in use
+IngressQueue *sequencer_add_gateway(Sequencer *sequencer, int capacity);
+void set_sequenced_handler(Sequencer *sequencer, SequencedHandler handler, void *context);
+
+// Gateway thread: queues a copy of message; -1 if the queue is full
+int ingress_push(IngressQueue *queue, const SeqMessage *message);
+
+// Matching thread: merges up to max queued messages, oldest ingress
+// first (ties to the lower gateway), and stamps them into out
+int sequencer_poll(Sequencer *sequencer, SeqMessage *out, int max);
+// Polls one batch and applies it to book; returns the messages handled
+int sequencer_run(Sequencer *sequencer, OrderBook *book);
+// Applies one sequenced message; returns the book call's result
+int sequencer_apply(OrderBook *book, const SeqMessage *message);
+
+#endif
@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "trading_engine.h"
+#include "orderbook.h"
+
+// Test status codes and caller-owned outputs
+void test_api_orders()
+{
+    printf("Testing public API orders...\n");
+
+    assert(trading_abi_version() >> 16 == TRADING_ENGINE_VERSION_MAJOR);
+
+    OrderBook *book = NULL;
+    assert(trading_create_orderbook(&book) == TRADING_OK && book != NULL);
+
+    TradingOrder order;
+    assert(trading_create_order(&order, 1, 100.5, 10, 1000, 'B') == TRADING_OK);
+    assert(trading_create_order(&order, 1, 100.5, 0, 1000, 'B') == TRADING_ERR_INVALID);
+    assert(trading_create_order(&order, 1, 100.5, 10, 1000, 'X') == TRADING_ERR_INVALID);
+    assert(trading_create_order(NULL, 1, 100.5, 10, 1000, 'B') == TRADING_ERR_INVALID);
+
+    trading_create_order(&order, 1, 100.5, 10, 1000, 'B');
+    assert(trading_add_order(book, &order) == TRADING_OK);
+    assert(trading_add_order(book, &order) == TRADING_ERR_DUPLICATE);
+    order.order_id = 2;
+    order.price = -1;
+    assert(trading_add_order(book, &order) == TRADING_ERR_INVALID);
+
+    double price;
+    assert(trading_get_best_ask(book, &price) == TRADING_ERR_NO_DATA);
+    assert(trading_get_last_price(book, &price) == TRADING_ERR_NO_DATA);
+    assert(trading_get_best_bid(book, &price) == TRADING_OK && price == 100.5);
+
+    TradingOrder read;
+    assert(trading_read_order(book, 1, &read) == TRADING_OK);
+    assert(read.order_id == 1 && read.quantity == 10 && read.side == 'B' && read.timestamp == 1000);
+    assert(trading_read_order(book, 9, &read) == TRADING_ERR_NOT_FOUND);
+
+    trading_create_order(&order, 3, 100, 4, 1001, 'S');
+    assert(trading_add_order(book, &order) == TRADING_OK);
+    assert(trading_get_last_price(book, &price) == TRADING_OK && price == 100.5);
+    assert(trading_read_order(book, 1, &read) == TRADING_OK && read.quantity == 6);
+
+    TradingBookSummary summary;
+    assert(trading_read_orderbook(book, &summary) == TRADING_OK);
+    assert(summary.bid_orders == 1 && summary.ask_orders == 0 && summary.trade_count == 1);
+
+    assert(trading_cancel_order(book, 1) == TRADING_OK);
+    assert(trading_cancel_order(book, 1) == TRADING_ERR_NOT_FOUND);
+    assert(trading_free_orderbook(book) == TRADING_OK);
+    assert(trading_free_orderbook(NULL) == TRADING_ERR_INVALID);
+
+    printf("Public API orders test passed!\n");
+}
+
+// Test order modification and its effect on priority
+void test_api_modify()
+{
+    printf("Testing order modification...\n");
+
+    OrderBook *book;
+    trading_create_orderbook(&book);
+
+    TradingOrder order;
+    for (int id = 1; id <= 3; id++)
+    {
+        trading_create_order(&order, id, 100, 10, 1000 + id, 'B');
+        trading_add_order(book, &order);
+    }
+
+    // size down keeps the front of the queue
+    assert(trading_modify_order(book, 1, 100, 4) == TRADING_OK);
+    assert(getTop(book->buy_orders)->order_id == 1);
+    assert(getTop(book->buy_orders)->quantity == 4);
+
+    // size up goes to the back
+    assert(trading_modify_order(book, 1, 100, 20) == TRADING_OK);
+    assert(getTop(book->buy_orders)->order_id == 2);
+
+    // a better price takes the top
+    assert(trading_modify_order(book, 3, 101, 10) == TRADING_OK);
+    assert(getTop(book->buy_orders)->order_id == 3);
+
+    // invalid terms leave the order alone
+    assert(trading_modify_order(book, 3, -5, 10) == TRADING_ERR_INVALID);
+    assert(trading_modify_order(book, 3, 101, 0) == TRADING_ERR_INVALID);
+    assert(trading_modify_order(book, 42, 101, 1) == TRADING_ERR_NOT_FOUND);
+    TradingOrder read;
+    assert(trading_read_order(book, 3, &read) == TRADING_OK && read.price == 101 && read.quantity == 10);
+
+    // repricing through the other side trades
+    trading_create_order(&order, 4, 105, 5, 2000, 'S');
+    trading_add_order(book, &order);
+    assert(trading_modify_order(book, 4, 101, 5) == TRADING_OK);
+    assert(book->trade_history_size == 1);
+    assert(trading_read_order(book, 3, &read) == TRADING_OK && read.quantity == 5);
+    assert(trading_read_order(book, 4, &read) == TRADING_ERR_NOT_FOUND);
+
+    printf("Order modification test passed!\n");
+
+    trading_free_orderbook(book);
+}
+
+static TradingRequest request(uint64_t user_data, TradingOp op, int order_id, char side, double price, int quantity)
+{
+    // set directly: cancels and modifies carry fields trading_create_order rejects
+    TradingRequest r = {0};
+    r.user_data = user_data;
+    r.op = op;
+    r.order.order_id = order_id;
+    r.order.price = price;
+    r.order.quantity = quantity;
+    r.order.side = side;
+    return r;
+}
+
+// Test acks, rejects and routed fills through the completion queues
+void test_api_async()
+{
+    printf("Testing asynchronous requests...\n");
+
+    OrderBook *book;
+    TradingEngine *engine;
+    TradingSession *seller;
+    TradingSession *buyer;
+    trading_create_orderbook(&book);
+    assert(trading_engine_create(book, 64, &engine) == TRADING_OK);
+    assert(trading_session_create(engine, 16, &seller) == TRADING_OK);
+    assert(trading_session_create(engine, 16, &buyer) == TRADING_OK);
+
+    TradingRequest sell = request(100, TRADING_OP_ADD, 1, 'S', 100, 10);
+    assert(trading_submit(seller, &sell, 1) == 1);
+    TradingRequest buys[4] = {
+        request(200, TRADING_OP_ADD, 2, 'B', 100, 4),
+        request(201, TRADING_OP_CANCEL, 99, 0, 0, 0),
+        request(202, TRADING_OP_ADD, 1, 'B', 90, 1), // id 1 is resting
+        request(203, TRADING_OP_MODIFY, 1, 0, 100, 0)};
+    assert(trading_submit(buyer, buys, 4) == 4);
+
+    TradingCompletion cq[16];
+    assert(trading_poll_completions(seller, cq, 16) == 0); // nothing until the engine runs
+    assert(trading_engine_run(engine) == 5);
+    assert(trading_engine_run(engine) == 0);
+
+    int n = trading_poll_completions(seller, cq, 16);
+    assert(n == 2);
+    assert(cq[0].type == TRADING_CQE_ACK && cq[0].user_data == 100 && cq[0].quantity == 10);
+    assert(cq[0].sequence == 1);
+    assert(cq[1].type == TRADING_CQE_FILL && cq[1].user_data == 100 && cq[1].order_id == 1);
+    assert(cq[1].quantity == 4 && cq[1].leftover == 6 && cq[1].price == 100 && cq[1].sequence == 2);
+
+    n = trading_poll_completions(buyer, cq, 16);
+    assert(n == 5);
+    assert(cq[0].type == TRADING_CQE_ACK && cq[0].user_data == 200 && cq[0].quantity == 0);
+    assert(cq[1].type == TRADING_CQE_FILL && cq[1].order_id == 2 && cq[1].leftover == 0);
+    assert(cq[2].type == TRADING_CQE_REJECT && cq[2].status == TRADING_ERR_NOT_FOUND);
+    assert(cq[3].type == TRADING_CQE_REJECT && cq[3].status == TRADING_ERR_DUPLICATE);
+    assert(cq[4].type == TRADING_CQE_REJECT && cq[4].status == TRADING_ERR_INVALID);
+    assert(cq[4].user_data == 203 && cq[4].sequence == 5);
+
+    TradingRequest bad = request(300, 7, 1, 'B', 100, 1);
+    assert(trading_submit(buyer, &bad, 1) == TRADING_ERR_INVALID);
+
+    // more completions than the ring holds wait in overflow, in order
+    for (int id = 10; id < 26; id++)
+    {
+        TradingRequest add = request(id, TRADING_OP_ADD, id, 'B', 100, 1);
+        assert(trading_submit(buyer, &add, 1) == 1);
+    }
+    assert(trading_engine_run(engine) == 16); // 16 acks + 6 fills for the buyer
+    int acks = 0;
+    int fills = 0;
+    uint64_t last_sequence = 0;
+    while ((n = trading_poll_completions(buyer, cq, 5)) > 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            assert(cq[i].sequence >= last_sequence);
+            last_sequence = cq[i].sequence;
+            acks += cq[i].type == TRADING_CQE_ACK;
+            fills += cq[i].type == TRADING_CQE_FILL;
+        }
+        trading_engine_run(engine);
+    }
+    assert(acks == 16 && fills == 6);
+    assert(trading_poll_completions(seller, cq, 16) == 6);
+
+    assert(trading_engine_free(engine) == TRADING_OK);
+    trading_free_orderbook(book);
+    printf("Asynchronous requests test passed!\n");
+}
+
+#define CLIENTS 3
+#define REQUESTS_PER_CLIENT 20000
+#define IN_FLIGHT 256
+
+typedef struct
+{
+    TradingSession *session;
+    int client;
+    _Atomic int results; // read by the engine loop
+    long long filled;
+} ClientState;
+
+static void *run_client(void *arg)
+{
+    ClientState *state = (ClientState *)arg;
+    unsigned int seed = 7 + state->client;
+    TradingCompletion cq[64];
+    int sent = 0;
+    while (state->results < REQUESTS_PER_CLIENT)
+    {
+        // keep up to IN_FLIGHT requests outstanding
+        while (sent < REQUESTS_PER_CLIENT && sent - state->results < IN_FLIGHT)
+        {
+            int order_id = 1 + state->client + CLIENTS * sent;
+            TradingRequest r = request(sent, TRADING_OP_ADD, order_id, rand_r(&seed) % 2 ? 'B' : 'S',
+                                       99 + rand_r(&seed) % 3, 1 + rand_r(&seed) % 10);
+            if (sent % 4 == 3)
+            {
+                r.op = TRADING_OP_CANCEL;
+                r.order.order_id = 1 + state->client + CLIENTS * (rand_r(&seed) % sent);
+            }
+            if (trading_submit(state->session, &r, 1) != 1)
+                break;
+            sent++;
+        }
+
+        int n = trading_poll_completions(state->session, cq, 64);
+        for (int i = 0; i < n; i++)
+        {
+            if (cq[i].type == TRADING_CQE_FILL)
+                state->filled += cq[i].quantity;
+            else
+                state->results++;
+        }
+        if (n == 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+// Test many requests in flight from concurrent client threads
+void test_api_async_pipelined()
+{
+    printf("Testing pipelined clients...\n");
+
+    OrderBook *book;
+    TradingEngine *engine;
+    trading_create_orderbook(&book);
+    trading_engine_create(book, 128, &engine);
+
+    ClientState states[CLIENTS];
+    pthread_t threads[CLIENTS];
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        states[c].client = c;
+        states[c].results = 0;
+        states[c].filled = 0;
+        assert(trading_session_create(engine, 512, &states[c].session) == TRADING_OK);
+    }
+    for (int c = 0; c < CLIENTS; c++)
+        assert(pthread_create(&threads[c], NULL, run_client, &states[c]) == 0);
+
+    int handled = 0;
+    while (handled < CLIENTS * REQUESTS_PER_CLIENT)
+    {
+        int n = trading_engine_run(engine);
+        handled += n;
+        if (n == 0)
+            sched_yield();
+    }
+    // flush any completions still waiting in overflow
+    for (int c = 0; c < CLIENTS; c++)
+        while (states[c].results < REQUESTS_PER_CLIENT)
+            trading_engine_run(engine);
+    for (int c = 0; c < CLIENTS; c++)
+        pthread_join(threads[c], NULL);
+
+    // fills of resting orders can land after their client has stopped
+    TradingCompletion cq[64];
+    trading_engine_run(engine);
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        int n;
+        while ((n = trading_poll_completions(states[c].session, cq, 64)) > 0)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                assert(cq[i].type == TRADING_CQE_FILL);
+                states[c].filled += cq[i].quantity;
+            }
+            trading_engine_run(engine);
+        }
+    }
+
+    // every trade reaches both the maker's and the taker's session
+    long long traded = 0;
+    for (int i = 0; i < book->trade_history_size; i++)
+        traded += book->trade_history[i].traded_quantity;
+    long long filled = 0;
+    for (int c = 0; c < CLIENTS; c++)
+        filled += states[c].filled;
+    assert(traded > 0 && filled == 2 * traded);
+
+    trading_engine_free(engine);
+    trading_free_orderbook(book);
+    printf("Pipelined clients test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING API TESTS ===\n\n");
+
+    test_api_orders();
+    test_api_modify();
+    test_api_async();
+    test_api_async_pipelined();
+
+    printf("\n=== ALL API TESTS PASSED ===\n");
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <math.h>
+#include "orderbook.h"
+#include "archive/archive.h"
+
+#define ROWS 10000
+
+static void archive_path(char *path, size_t size)
+{
+    snprintf(path, size, "/tmp/archive_test_%d.arc", (int)getpid());
+}
+
+static ArchiveRecord random_record(unsigned int *seed, int i)
+{
+    ArchiveRecord record;
+    record.time = 1000 + i * 0.25 + (rand_r(seed) % 4) * 0.001;
+    record.type = (uint8_t)(rand_r(seed) % 4);
+    record.side = rand_r(seed) % 2 ? 'B' : 'S';
+    record.order_id = 1 + i + rand_r(seed) % 50;
+    record.counterparty_id = record.type == BOOK_EVENT_TRADE ? record.order_id + 7 : 0;
+    record.owner_id = 100 + rand_r(seed) % 12;
+    record.price = 95 + (rand_r(seed) % 1000) * 0.01;
+    record.quantity = 1 + rand_r(seed) % 500;
+    record.leftover = rand_r(seed) % 100;
+    record.counterparty_leftover = rand_r(seed) % 3;
+    return record;
+}
+
+// Test that every column comes back exactly as written
+void test_archive_roundtrip()
+{
+    printf("Testing archive roundtrip...\n");
+
+    char path[64];
+    archive_path(path, sizeof(path));
+    ArchiveRecord *records = (ArchiveRecord *)malloc(ROWS * sizeof(ArchiveRecord));
+    unsigned int seed = 3;
+    ArchiveWriter *writer = create_archive_writer(path, 0.001);
+    assert(writer);
+    for (int i = 0; i < ROWS; i++)
+    {
+        records[i] = random_record(&seed, i);
+        assert(archive_append(writer, &records[i]) == 0);
+    }
+    assert(close_archive_writer(writer) == 0);
+
+    // well under the size of the records themselves, even for random data
+    struct stat info;
+    assert(stat(path, &info) == 0);
+    assert((size_t)info.st_size < ROWS * sizeof(ArchiveRecord) / 2);
+
+    ArchiveReader *reader = open_archive(path);
+    assert(reader);
+    assert(reader->header->chunk_count == (ROWS + ARCHIVE_CHUNK_ROWS - 1) / ARCHIVE_CHUNK_ROWS);
+
+    ArchiveQuery query = default_archive_query();
+    ArchiveColumns columns = {0};
+    assert(archive_scan(reader, &query, &columns) == ROWS);
+    for (int i = 0; i < ROWS; i++)
+    {
+        assert(columns.time[i] == llround(records[i].time * 1000) * 0.001);
+        assert(columns.type[i] == records[i].type && columns.side[i] == records[i].side);
+        assert(columns.order_id[i] == records[i].order_id);
+        assert(columns.counterparty_id[i] == records[i].counterparty_id);
+        assert(columns.owner_id[i] == records[i].owner_id);
+        assert(columns.price[i] == llround(records[i].price * ORDER_KEY_PRICE_SCALE) / ORDER_KEY_PRICE_SCALE);
+        assert(columns.quantity[i] == records[i].quantity);
+        assert(columns.leftover[i] == records[i].leftover);
+        assert(columns.counterparty_leftover[i] == records[i].counterparty_leftover);
+    }
+
+    free_archive_columns(&columns);
+    close_archive(reader);
+    free(records);
+    unlink(path);
+    printf("Archive roundtrip test passed!\n");
+}
+
+// Test time and price range queries over selected columns
+void test_archive_range_query()
+{
+    printf("Testing archive range queries...\n");
+
+    char path[64];
+    archive_path(path, sizeof(path));
+    ArchiveRecord *records = (ArchiveRecord *)malloc(ROWS * sizeof(ArchiveRecord));
+    unsigned int seed = 9;
+    ArchiveWriter *writer = create_archive_writer(path, 0.001);
+    for (int i = 0; i < ROWS; i++)
+    {
+        records[i] = random_record(&seed, i);
+        archive_append(writer, &records[i]);
+    }
+    close_archive_writer(writer);
+    ArchiveReader *reader = open_archive(path);
+
+    ArchiveQuery query = default_archive_query();
+    query.from = 1500;
+    query.to = 1600;
+    query.min_price = 97;
+    query.max_price = 98;
+    query.columns = ARCHIVE_COLUMN_BIT(ARCHIVE_ORDER_ID) | ARCHIVE_COLUMN_BIT(ARCHIVE_QUANTITY);
+    ArchiveColumns columns = {0};
+    int n = archive_scan(reader, &query, &columns);
+
+    int expected = 0;
+    for (int i = 0; i < ROWS; i++)
+    {
+        double time = llround(records[i].time * 1000) * 0.001;
+        double price = llround(records[i].price * ORDER_KEY_PRICE_SCALE) / ORDER_KEY_PRICE_SCALE;
+        if (time < 1500 || time > 1600 || price < 97 || price > 98)
+            continue;
+        assert(expected < n);
+        assert(columns.order_id[expected] == records[i].order_id);
+        assert(columns.quantity[expected] == records[i].quantity);
+        expected++;
+    }
+    assert(n == expected && n > 0);
+    assert(columns.time == NULL && columns.price == NULL && columns.owner_id == NULL);
+
+    // a range before the first record
+    query.from = 0;
+    query.to = 999;
+    assert(archive_scan(reader, &query, &columns) == 0);
+
+    free_archive_columns(&columns);
+    close_archive(reader);
+
+    // a truncated file is rejected
+    assert(truncate(path, 1000) == 0);
+    assert(open_archive(path) == NULL);
+
+    free(records);
+    unlink(path);
+    printf("Archive range query test passed!\n");
+}
+
+// Test streaming a book's events and appending its trade history
+void test_archive_book()
+{
+    printf("Testing archiving a book...\n");
+
+    char path[64];
+    archive_path(path, sizeof(path));
+    OrderBook *book = create_orderbook();
+    ArchiveWriter *writer = create_archive_writer(path, 1);
+    assert(archive_attach(writer, book) == 0);
+
+    unsigned int seed = 21;
+    for (int id = 1; id <= 3000; id++)
+    {
+        Order *order = create_owned_order(id, 0, 1 + rand_r(&seed) % 20, id, rand_r(&seed) % 2 ? 'B' : 'S',
+                                          1 + rand_r(&seed) % 5);
+        order->price = 99 + 0.5 * (rand_r(&seed) % 5);
+        add_order(book, order);
+        if (id % 7 == 0)
+            cancel_order(book, id - 3);
+    }
+    assert(book->trade_history_size > 0);
+    assert(close_archive_writer(writer) == 0);
+
+    ArchiveReader *reader = open_archive(path);
+    ArchiveQuery query = default_archive_query();
+    ArchiveColumns columns = {0};
+    int n = archive_scan(reader, &query, &columns);
+    int adds = 0;
+    int trades = 0;
+    for (int i = 0; i < n; i++)
+    {
+        adds += columns.type[i] == BOOK_EVENT_ADD;
+        if (columns.type[i] != BOOK_EVENT_TRADE)
+            continue;
+        const FilledOrder *fill = &book->trade_history[trades++];
+        assert(columns.order_id[i] == fill->maker_id && columns.counterparty_id[i] == fill->taker_id);
+        assert(columns.quantity[i] == fill->traded_quantity && columns.price[i] == fill->traded_price);
+        assert(columns.leftover[i] == fill->maker_leftover);
+        assert(columns.counterparty_leftover[i] == fill->taker_leftover);
+        assert(columns.time[i] == fill->timestamp);
+    }
+    assert(adds == 3000 && trades == book->trade_history_size);
+    close_archive(reader);
+
+    // end-of-session dump of the same trades
+    writer = create_archive_writer(path, 1);
+    assert(archive_append_trades(writer, book) == book->trade_history_size);
+    assert(close_archive_writer(writer) == 0);
+    reader = open_archive(path);
+    assert(archive_scan(reader, &query, &columns) == book->trade_history_size);
+    for (int i = 0; i < columns.count; i++)
+    {
+        assert(columns.type[i] == BOOK_EVENT_TRADE);
+        assert(columns.side[i] != book->trade_history[i].taker_side);
+        assert(columns.order_id[i] == book->trade_history[i].maker_id);
+    }
+
+    free_archive_columns(&columns);
+    close_archive(reader);
+    free_orderbook(book);
+    unlink(path);
+    printf("Archiving a book test passed!\n");
+}
+
+// Test that reduce and remove rows carry the time they happened, not the
+// order's arrival time
+void test_archive_event_times()
+{
+    printf("Testing archived event times...\n");
+
+    char path[64];
+    archive_path(path, sizeof(path));
+    OrderBook *book = create_orderbook();
+    ArchiveWriter *writer = create_archive_writer(path, 1);
+    assert(archive_attach(writer, book) == 0);
+
+    add_order(book, create_order(1, 100, 10, 10, 'B'));
+    archive_set_time(writer, 25);
+    assert(modify_order(book, 1, 100, 6) == 0); // reduce
+    archive_set_time(writer, 30);
+    assert(cancel_order(book, 1) == 0);
+
+    // a filled maker leaves the book at the trade's time
+    add_order(book, create_order(2, 100, 5, 35, 'S'));
+    add_order(book, create_order(3, 100, 5, 40, 'B'));
+    assert(close_archive_writer(writer) == 0);
+
+    ArchiveReader *reader = open_archive(path);
+    ArchiveQuery query = default_archive_query();
+    ArchiveColumns columns = {0};
+    assert(archive_scan(reader, &query, &columns) == 8);
+
+    const uint8_t types[] = {BOOK_EVENT_ADD, BOOK_EVENT_REDUCE, BOOK_EVENT_REMOVE, BOOK_EVENT_ADD,
+                             BOOK_EVENT_ADD, BOOK_EVENT_TRADE, BOOK_EVENT_REMOVE, BOOK_EVENT_REMOVE};
+    const double times[] = {10, 25, 30, 35, 40, 40, 40, 40};
+    for (int i = 0; i < 8; i++)
+        assert(columns.type[i] == types[i] && columns.time[i] == times[i]);
+    assert(columns.order_id[1] == 1 && columns.quantity[1] == 4 && columns.leftover[1] == 6);
+    assert(columns.order_id[2] == 1 && columns.quantity[2] == 6 && columns.leftover[2] == 0);
+
+    free_archive_columns(&columns);
+    close_archive(reader);
+    free_orderbook(book);
+    unlink(path);
+    printf("Archived event times test passed!\n");
+}
+
+// Test that a failed chunk write fails every later append and the close
+void test_archive_write_failure()
+{
+    printf("Testing archive write failure...\n");
+
+    // every write to /dev/full fails once stdio flushes its buffer
+    ArchiveWriter *writer = create_archive_writer("/dev/full", 1);
+    if (!writer)
+    {
+        printf("No /dev/full; archive write failure test skipped\n");
+        return;
+    }
+
+    unsigned int seed = 9;
+    int first_failure = -1;
+    for (int i = 0; i < 4 * ARCHIVE_CHUNK_ROWS; i++)
+    {
+        ArchiveRecord record = random_record(&seed, i);
+        int result = archive_append(writer, &record);
+        if (result != 0 && first_failure < 0)
+            first_failure = i;
+        // sticky: nothing is buffered past the failure
+        if (first_failure >= 0)
+            assert(result == -1 && writer->row_count == 0);
+    }
+    assert(first_failure >= 0 && writer->failed);
+    assert(close_archive_writer(writer) == -1);
+
+    printf("Archive write failure test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING ARCHIVE TESTS ===\n");
+    test_archive_roundtrip();
+    test_archive_range_query();
+    test_archive_book();
+    test_archive_event_times();
+    test_archive_write_failure();
+    printf("=== ALL ARCHIVE TESTS PASSED ===\n");
+    return 0;
+}
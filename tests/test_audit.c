@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "orderbook.h"
+#include "audit/audit.h"
+#include "loadgen/flowgen.h"
+#include "matching/auction.h"
+
+static void on_event(void *context, const BookEvent *event)
+{
+    level_book_apply((LevelBook *)context, event);
+}
+
+// A book after a stretch of synthetic flow, with owned, DAY and GTT orders
+// resting as well; levels (if not NULL) follows it
+static OrderBook *busy_book(int ladder, LevelBook *levels)
+{
+    OrderBook *book = create_orderbook();
+    if (ladder)
+        assert(use_price_ladder(book, 90, 0.01, 2048) == 0);
+    if (levels)
+    {
+        init_level_book(levels);
+        add_book_listener(book, on_event, levels);
+    }
+
+    FlowConfig config = default_flow_config();
+    config.symbols = 1;
+    config.max_distance = 500;
+    config.max_live = 2000;
+    FlowGenerator *generator = create_flow_generator(&config);
+    FlowMessage message;
+    SeqMessage seq;
+    for (int i = 0; i < 20000; i++)
+    {
+        flow_next(generator, &message);
+        flow_to_seq(&message, &seq);
+        seq.owner_id = 1 + i % 5;
+        seq.tif = i % 7 == 0 ? TIF_DAY : i % 11 == 0 ? TIF_GTT : TIF_GTC;
+        seq.expire_time = 1000 + i;
+        seq.receive_ns = i;
+        sequencer_apply(book, &seq);
+    }
+    free_flow_generator(generator);
+    assert(book->buy_orders->size > 100 && book->sell_orders->size > 100);
+    return book;
+}
+
+static int has_violation(const AuditReport *report, AuditViolationType type)
+{
+    for (int i = 0; i < report->stored; i++)
+    {
+        if (report->list[i].type == type)
+            return 1;
+    }
+    return 0;
+}
+
+static void print_report(const AuditReport *report)
+{
+    for (int i = 0; i < report->stored; i++)
+        printf("  %s: order %d: %s\n", audit_violation_name(report->list[i].type), report->list[i].order_id,
+               report->list[i].detail);
+}
+
+// Test that consistent books audit clean
+void test_clean_books()
+{
+    printf("Testing audit of consistent books...\n");
+
+    AuditReport report;
+    for (int ladder = 0; ladder < 2; ladder++)
+    {
+        LevelBook levels;
+        OrderBook *book = busy_book(ladder, &levels);
+        int violations = audit_orderbook(book, &levels, &report);
+        if (violations)
+            print_report(&report);
+        assert(violations == 0 && report.stored == 0);
+        assert(report.resting == book->buy_orders->size + book->sell_orders->size);
+
+        // an auction may rest crossed
+        begin_auction(book);
+        Order *order = create_order(900001, 0, 5, 0, 'B');
+        order->price = 110;
+        assert(add_order(book, order) == 0);
+        assert(audit_orderbook(book, &levels, &report) == 0);
+        book->phase = PHASE_CONTINUOUS;
+        assert(audit_orderbook(book, &levels, &report) == 1);
+        assert(report.list[0].type == AUDIT_CROSSED && report.list[0].order_id == 900001);
+
+        free_orderbook(book);
+        free_level_book(&levels);
+    }
+    assert(audit_orderbook(NULL, NULL, &report) == -1);
+
+    printf("Audit of consistent books test passed!\n");
+}
+
+// Test detection of heap, order and table corruption
+void test_heap_corruption()
+{
+    printf("Testing audit of heap corruption...\n");
+
+    AuditReport report;
+    OrderBook *book = busy_book(0, NULL);
+    OrderHeap *bids = book->buy_orders;
+    OrderTable *table = book->order_table;
+
+    // top and last key swapped: the heap is out of order and out of step with the table
+    int last = bids->size - 1;
+    uint64_t top_key = bids->keys[0];
+    bids->keys[0] = bids->keys[last];
+    bids->keys[last] = top_key;
+    assert(audit_orderbook(book, NULL, &report) > 0);
+    assert(has_violation(&report, AUDIT_HEAP_ORDER) && has_violation(&report, AUDIT_KEY));
+    bids->keys[last] = bids->keys[0];
+    bids->keys[0] = top_key;
+    assert(audit_orderbook(book, NULL, &report) == 0);
+
+    OrderHandle handle = bids->arr[3];
+    table->heap_index[handle] = 4;
+    assert(audit_orderbook(book, NULL, &report) == 1 && has_violation(&report, AUDIT_HEAP_INDEX));
+    table->heap_index[handle] = 3;
+
+    Order *order = table->orders[handle];
+    int quantity = order->quantity;
+    order->quantity = 0;
+    assert(audit_orderbook(book, NULL, &report) == 1);
+    assert(report.list[0].type == AUDIT_ORDER && report.list[0].order_id == order->order_id);
+    order->quantity = quantity;
+
+    order->price += 1;
+    assert(audit_orderbook(book, NULL, &report) >= 1 && has_violation(&report, AUDIT_KEY));
+    order->price -= 1;
+    assert(audit_orderbook(book, NULL, &report) == 0);
+
+    free_orderbook(book);
+    printf("Audit of heap corruption test passed!\n");
+}
+
+// Test detection of orders lost from a side, the map or an account
+void test_lost_orders()
+{
+    printf("Testing audit of lost orders...\n");
+
+    AuditReport report;
+    OrderBook *book = busy_book(0, NULL);
+    Order *order = getTop(book->sell_orders);
+
+    // dropped from its side but still in the table and the map
+    removeOrder(book->sell_orders, order);
+    assert(audit_orderbook(book, NULL, &report) > 0);
+    assert(has_violation(&report, AUDIT_ORPHAN) && has_violation(&report, AUDIT_MAP));
+    assert(has_violation(&report, AUDIT_ACCOUNT));
+    insertOrderHeap(book->sell_orders, order);
+    assert(audit_orderbook(book, NULL, &report) == 0);
+
+    // dropped from the map only
+    assert(ordermap_remove(book->order_map, order->order_id) == order);
+    assert(audit_orderbook(book, NULL, &report) == 1 && has_violation(&report, AUDIT_MAP));
+    ordermap_put(book->order_map, order->order_id, order);
+
+    accountmap_unlink(book->account_map, order);
+    assert(audit_orderbook(book, NULL, &report) == 1 && has_violation(&report, AUDIT_ACCOUNT));
+    accountmap_link(book->account_map, order);
+
+    book->expiry_wheel->session_size++;
+    assert(audit_orderbook(book, NULL, &report) == 1 && has_violation(&report, AUDIT_EXPIRY));
+    book->expiry_wheel->session_size--;
+    assert(audit_orderbook(book, NULL, &report) == 0);
+
+    free_orderbook(book);
+    printf("Audit of lost orders test passed!\n");
+}
+
+// Test detection of ladder corruption
+void test_ladder_corruption()
+{
+    printf("Testing audit of ladder corruption...\n");
+
+    AuditReport report;
+    OrderBook *book = busy_book(1, NULL);
+    PriceLadder *ladder = book->buy_orders->ladder;
+    int best = ladder->best;
+    PriceLevel *level = &ladder->levels[best];
+
+    level->count++;
+    assert(audit_orderbook(book, NULL, &report) == 2);
+    assert(has_violation(&report, AUDIT_LADDER_LEVEL) && has_violation(&report, AUDIT_SIDE_SIZE));
+    level->count--;
+
+    ladder->best = best - 1;
+    assert(audit_orderbook(book, NULL, &report) == 1 && has_violation(&report, AUDIT_LADDER_BITMAP));
+    ladder->best = best;
+
+    ladder->bitmap[best >> 6] ^= 1ULL << (best & 63);
+    assert(audit_orderbook(book, NULL, &report) >= 1 && has_violation(&report, AUDIT_LADDER_BITMAP));
+    ladder->bitmap[best >> 6] ^= 1ULL << (best & 63);
+
+    // a level whose two orders point past each other
+    int idx = best;
+    while (ladder->levels[idx].count < 2)
+        idx--;
+    Order *second = ladder->levels[idx].head->level_next;
+    second->level_prev = NULL;
+    assert(audit_orderbook(book, NULL, &report) == 1);
+    assert(report.list[0].type == AUDIT_LADDER_LEVEL && report.list[0].order_id == second->order_id);
+    second->level_prev = ladder->levels[idx].head;
+    assert(audit_orderbook(book, NULL, &report) == 0);
+
+    free_orderbook(book);
+    printf("Audit of ladder corruption test passed!\n");
+}
+
+// Test detection of a LevelBook that has drifted from the orders
+void test_level_aggregates()
+{
+    printf("Testing audit of level aggregates...\n");
+
+    AuditReport report;
+    LevelBook levels;
+    OrderBook *book = busy_book(0, &levels);
+
+    MdLevel *best_ask = &levels.asks.levels[levels.asks.count - 1];
+    best_ask->quantity += 3;
+    assert(audit_orderbook(book, &levels, &report) == 1);
+    assert(report.list[0].type == AUDIT_LEVEL_AGGREGATE);
+    assert(audit_orderbook(book, NULL, &report) == 0); // not checked without a LevelBook
+    best_ask->quantity -= 3;
+
+    levels.bids.count--; // the lowest bid level goes missing
+    assert(audit_orderbook(book, &levels, &report) == 1 && has_violation(&report, AUDIT_LEVEL_AGGREGATE));
+    levels.bids.count++;
+    assert(audit_orderbook(book, &levels, &report) == 0);
+
+    free_orderbook(book);
+    free_level_book(&levels);
+    printf("Audit of level aggregates test passed!\n");
+}
+
+static _Atomic int handled;
+
+static void on_report(void *context, const AuditReport *report)
+{
+    (void)context;
+    (void)report;
+    atomic_fetch_add(&handled, 1);
+}
+
+// Test periodic and on-demand audits on the auditor thread
+void test_audit_monitor()
+{
+    printf("Testing audit monitor...\n");
+
+    LevelBook levels;
+    OrderBook *book = busy_book(0, &levels);
+    AuditMonitor *monitor = create_audit_monitor(book, &levels, 500, on_report, NULL);
+    assert(monitor);
+    assert(create_audit_monitor(book, NULL, 0, NULL, NULL) == NULL);
+
+    AuditReport report;
+    assert(audit_monitor_report(monitor, &report) == 0);
+
+    // keep trading while the auditor works; a tick never blocks
+    FlowConfig config = default_flow_config();
+    config.symbols = 1;
+    config.seed = 99;
+    config.first_order_id = 1000000;
+    FlowGenerator *generator = create_flow_generator(&config);
+    FlowMessage message;
+    SeqMessage seq;
+    int handed = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        flow_next(generator, &message);
+        flow_to_seq(&message, &seq);
+        sequencer_apply(book, &seq);
+        handed += audit_monitor_tick(monitor);
+    }
+    audit_monitor_wait(monitor);
+    assert(handed >= 1 && handed <= 40);
+    assert(audit_monitor_report(monitor, &report) == 1);
+    assert(report.audit == (uint64_t)handed && report.violations == 0);
+    assert(atomic_load(&handled) == handed);
+
+    // corruption shows up in the next requested audit
+    Order *order = getTop(book->buy_orders);
+    int quantity = order->quantity;
+    order->quantity = -1;
+    audit_monitor_request(monitor);
+    assert(audit_monitor_tick(monitor) == 1);
+    audit_monitor_wait(monitor);
+    assert(audit_monitor_report(monitor, &report) == 1);
+    assert(report.audit == (uint64_t)handed + 1);
+    // the LevelBook still has the old quantity too
+    assert(report.violations == 2 && has_violation(&report, AUDIT_ORDER));
+    assert(has_violation(&report, AUDIT_LEVEL_AGGREGATE));
+    order->quantity = quantity;
+    assert(monitor->longest_capture_ns > 0);
+
+    // a book over the limit is only captured on request
+    audit_monitor_limit(monitor, 1);
+    int skipped = 0;
+    for (int i = 0; i < 2000; i++)
+        skipped += audit_monitor_tick(monitor) == 0;
+    assert(skipped == 2000 && monitor->skipped == 2000 / 500);
+    audit_monitor_request(monitor);
+    assert(audit_monitor_tick(monitor) == 1);
+    audit_monitor_wait(monitor);
+    assert(audit_monitor_report(monitor, &report) == 1 && report.audit == (uint64_t)handed + 2);
+
+    free_audit_monitor(monitor);
+    free_flow_generator(generator);
+    free_orderbook(book);
+    free_level_book(&levels);
+    printf("Audit monitor test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING AUDIT TESTS ===\n");
+
+    test_clean_books();
+    test_heap_corruption();
+    test_lost_orders();
+    test_ladder_corruption();
+    test_level_aggregates();
+    test_audit_monitor();
+
+    printf("=== ALL AUDIT TESTS PASSED ===\n");
+    return 0;
+}
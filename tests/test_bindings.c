@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <assert.h>
+#include "bindings/pybook.h"
+
+// Test batched submission and the fill/level views
+void test_pybook_batch()
+{
+    printf("Testing batched submission...\n");
+
+    PyBook *pybook = pybook_create();
+
+    int ids[] = {1, 2, 3, 2, 4};
+    char sides[] = {'B', 'B', 'S', 'S', 'X'};
+    double prices[] = {100.5, 99, 101, 101, 100};
+    int quantities[] = {10, 5, 3, 1, 1};
+    double timestamps[] = {1, 2, 3, 4, 5};
+    int status[5];
+    assert(pybook_submit(pybook, 5, ids, sides, prices, quantities, timestamps, NULL, status) == 3);
+    assert(status[0] == 0 && status[2] == 0);
+    assert(status[3] == -1 && status[4] == -1); // duplicate id, bad side
+
+    int count;
+    const MdLevel *bids = pybook_levels(pybook, 'B', &count);
+    assert(count == 2);
+    assert(bids[1].price == 100.5 && bids[1].quantity == 10); // best last
+    assert(bids[0].price == 99);
+
+    int sell_id[] = {5};
+    char sell_side[] = {'S'};
+    double sell_price[] = {99};
+    int sell_qty[] = {12};
+    int owner[] = {7};
+    pybook_submit(pybook, 1, sell_id, sell_side, sell_price, sell_qty, timestamps, owner, NULL);
+
+    const FilledOrder *fills = pybook_fills(pybook, &count);
+    assert(count == 2);
+    assert(fills[0].maker_id == 1 && fills[0].traded_quantity == 10 && fills[0].traded_price == 100.5);
+    assert(fills[1].maker_id == 2 && fills[1].traded_quantity == 2);
+
+    pybook_levels(pybook, 'B', &count);
+    assert(count == 1);
+
+    int cancel_ids[] = {2, 3, 42};
+    assert(pybook_cancel(pybook, 3, cancel_ids, status) == 2);
+    assert(status[2] == -1);
+    pybook_levels(pybook, 'S', &count);
+    assert(count == 0);
+
+    printf("Batched submission test passed!\n");
+
+    pybook_free(pybook);
+}
+
+// Test the layout descriptors the Python side checks against
+void test_pybook_layout()
+{
+    printf("Testing binding layouts...\n");
+
+    size_t layout[16];
+    assert(pybook_fill_layout(layout) == 9);
+    assert(layout[0] == sizeof(FilledOrder));
+    assert(layout[6] == offsetof(FilledOrder, traded_price));
+    assert(pybook_level_layout(layout) == 4);
+    assert(layout[0] == sizeof(MdLevel) && layout[2] == offsetof(MdLevel, quantity));
+
+    printf("Binding layouts test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING BINDINGS TESTS ===\n\n");
+
+    test_pybook_batch();
+    test_pybook_layout();
+
+    printf("\n=== ALL BINDINGS TESTS PASSED ===\n");
+    return 0;
+}
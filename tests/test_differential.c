@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <assert.h>
+#include "fuzz/harness.h"
+#include "fuzz/refbook.h"
+#include "orderbook.h"
+
+#define STEPS 1500
+
+// Test the reference book on a hand-checked sequence
+void test_reference_book()
+{
+    printf("Testing reference book...\n");
+
+    RefBook ref;
+    ref_init(&ref);
+    assert(ref_add(&ref, 1, 'S', 101, 5) == 0);
+    assert(ref_add(&ref, 2, 'S', 100, 5) == 0);
+    assert(ref_add(&ref, 1, 'B', 99, 5) == -1); // duplicate id
+    assert(ref_add(&ref, 3, 'B', 101, 8) == 0);
+
+    // best ask first, at the makers' prices
+    assert(ref.fill_count == 2);
+    assert(ref.fills[0].maker_id == 2 && ref.fills[0].price == 100 && ref.fills[0].quantity == 5);
+    assert(ref.fills[1].maker_id == 1 && ref.fills[1].price == 101 && ref.fills[1].quantity == 3);
+    assert(ref.fills[1].maker_leftover == 2 && ref.fills[1].taker_leftover == 0);
+
+    RefOrder side[4];
+    assert(ref_side(&ref, 'S', side) == 1 && side[0].order_id == 1 && side[0].quantity == 2);
+    assert(ref_side(&ref, 'B', side) == 0);
+
+    ref_market(&ref, 4, 0, 'B', 10);
+    assert(ref.fill_count == 3 && ref.fills[2].quantity == 2);
+    assert(ref_side(&ref, 'S', side) == 0 && ref_side(&ref, 'B', side) == 0);
+
+    ref_free(&ref);
+    printf("Reference book test passed!\n");
+}
+
+// Test the reference book's self-trade prevention, expiry and auctions
+void test_reference_events()
+{
+    printf("Testing reference book events...\n");
+
+    RefBook ref;
+    RefOrder side[4];
+
+    // the newest same-owner order goes; other owners still trade
+    ref_init(&ref);
+    ref.stp_mode = STP_CANCEL_NEWEST;
+    assert(ref_add_owned(&ref, 1, 7, 'S', 100, 5, TIF_GTC, 0) == 0);
+    assert(ref_add_owned(&ref, 2, 7, 'B', 100, 5, TIF_GTC, 0) == 0);
+    assert(ref.fill_count == 0 && ref_side(&ref, 'B', side) == 0 && ref_side(&ref, 'S', side) == 1);
+    ref_market(&ref, 3, 8, 'B', 2);
+    assert(ref.fill_count == 1 && ref.fills[0].maker_id == 1 && ref.fills[0].quantity == 2);
+    ref_free(&ref);
+
+    // decrement shrinks both sides without a fill
+    ref_init(&ref);
+    ref.stp_mode = STP_DECREMENT;
+    assert(ref_add_owned(&ref, 1, 7, 'S', 100, 5, TIF_GTC, 0) == 0);
+    assert(ref_add_owned(&ref, 2, 7, 'B', 101, 8, TIF_GTC, 0) == 0);
+    assert(ref.fill_count == 0);
+    assert(ref_side(&ref, 'S', side) == 0);
+    assert(ref_side(&ref, 'B', side) == 1 && side[0].order_id == 2 && side[0].quantity == 3);
+    ref_free(&ref);
+
+    // GTT orders go when the clock reaches them, DAY orders at session end
+    ref_init(&ref);
+    assert(ref_add_owned(&ref, 1, 0, 'B', 99, 5, TIF_GTT, 10) == 0);
+    assert(ref_add_owned(&ref, 2, 0, 'B', 98, 5, TIF_DAY, 0) == 0);
+    assert(ref_add_owned(&ref, 3, 0, 'B', 97, 5, TIF_GTC, 0) == 0);
+    ref_expire(&ref, 9);
+    assert(ref_side(&ref, 'B', side) == 3);
+    ref_expire(&ref, 10);
+    assert(ref_side(&ref, 'B', side) == 2);
+    assert(ref_add_owned(&ref, 4, 0, 'B', 99, 5, TIF_GTT, 10) == -1); // already expired
+    ref_end_session(&ref);
+    assert(ref_side(&ref, 'B', side) == 1 && side[0].order_id == 3);
+    ref_free(&ref);
+
+    // crossing orders rest during an auction and trade at one price
+    ref_init(&ref);
+    ref_begin_auction(&ref);
+    assert(ref_add(&ref, 1, 'B', 102, 5) == 0);
+    assert(ref_add(&ref, 2, 'S', 100, 3) == 0);
+    assert(ref_add(&ref, 3, 'S', 101, 4) == 0);
+    ref_market(&ref, 4, 0, 'S', 5);
+    assert(ref.fill_count == 0);
+    ref_uncross(&ref);
+    assert(ref.fill_count == 2);
+    assert(ref.fills[0].price == 101 && ref.fills[1].price == 101);
+    assert(ref.fills[0].quantity + ref.fills[1].quantity == 5);
+    assert(ref_side(&ref, 'S', side) == 1 && side[0].order_id == 3 && side[0].quantity == 2);
+    assert(ref.auction == 0);
+    ref_free(&ref);
+
+    printf("Reference book events test passed!\n");
+}
+
+// Test that engine and reference agree over random sequences, under
+// every self-trade prevention mode
+void test_differential(int ladder)
+{
+    printf("Testing engine against reference%s...\n", ladder ? " (price ladder)" : "");
+
+    FuzzConfig config = default_fuzz_config();
+    config.ladder = ladder;
+    FuzzOp ops[STEPS];
+    char why[256];
+
+    for (unsigned long long seed = 1; seed <= 20; seed++)
+    {
+        config.stp_mode = (int)(seed % (STP_DECREMENT + 1));
+        fuzz_generate(&config, seed, ops, STEPS);
+        int failed = fuzz_run(&config, ops, STEPS, why, sizeof(why));
+        if (failed >= 0)
+        {
+            printf("seed %llu diverged at step %d: %s\n", seed, failed, why);
+            fuzz_print(ops, fuzz_shrink(&config, ops, STEPS));
+        }
+        assert(failed < 0);
+    }
+
+    printf("Differential test passed!\n");
+}
+
+// Test that a broken sequence is caught and shrunk
+void test_shrink()
+{
+    printf("Testing failure shrinking...\n");
+
+    // the reference has no price limit, so an add beyond the engine's key
+    // range is a divergence on purpose
+    FuzzConfig config = default_fuzz_config();
+    FuzzOp ops[STEPS];
+    fuzz_generate(&config, 7, ops, STEPS);
+    int target = STEPS / 2;
+    for (int i = target; i < STEPS; i++)
+    {
+        if (ops[i].type == FUZZ_ADD)
+        {
+            ops[i].price = 1e12;
+            target = i;
+            break;
+        }
+    }
+
+    char why[256];
+    assert(fuzz_run(&config, ops, STEPS, why, sizeof(why)) == target);
+    int n = fuzz_shrink(&config, ops, STEPS);
+    assert(n == 1);
+    assert(ops[0].type == FUZZ_ADD && ops[0].price == 1e12 && ops[0].quantity == 1);
+
+    printf("Failure shrinking test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING DIFFERENTIAL TESTS ===\n");
+    test_reference_book();
+    test_reference_events();
+    test_differential(0);
+    test_differential(1);
+    test_shrink();
+    printf("=== ALL DIFFERENTIAL TESTS PASSED ===\n");
+    return 0;
+}
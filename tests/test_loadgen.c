@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "orderbook.h"
+#include "loadgen/flowgen.h"
+
+#define MESSAGES 200000
+
+static FlowMessage *generate(const FlowConfig *config, int count)
+{
+    FlowGenerator *generator = create_flow_generator(config);
+    assert(generator);
+    FlowMessage *messages = (FlowMessage *)malloc(count * sizeof(FlowMessage));
+    assert(messages);
+    flow_generate(generator, messages, count);
+    free_flow_generator(generator);
+    return messages;
+}
+
+// Test that a seed fixes the flow and bad configs are refused
+void test_determinism()
+{
+    printf("Testing flow determinism...\n");
+
+    FlowConfig config = default_flow_config();
+    config.arrivals = FLOW_HAWKES;
+    config.seed = 42;
+    FlowMessage *a = generate(&config, 10000);
+    FlowMessage *b = generate(&config, 10000);
+    assert(memcmp(a, b, 10000 * sizeof(FlowMessage)) == 0);
+    config.seed = 43;
+    FlowMessage *c = generate(&config, 10000);
+    assert(memcmp(a, c, 10000 * sizeof(FlowMessage)) != 0);
+    free(a);
+    free(b);
+    free(c);
+
+    FlowConfig bad = default_flow_config();
+    bad.cancel_ratio = 0.8;
+    bad.modify_ratio = 0.3;
+    assert(create_flow_generator(&bad) == NULL);
+    bad = default_flow_config();
+    bad.arrivals = FLOW_HAWKES;
+    bad.hawkes_alpha = bad.hawkes_beta; // explosive
+    assert(create_flow_generator(&bad) == NULL);
+    bad = default_flow_config();
+    bad.max_distance = 10000; // bids would reach a price of 0
+    assert(create_flow_generator(&bad) == NULL);
+    bad = default_flow_config();
+    bad.min_quantity = 0;
+    assert(create_flow_generator(&bad) == NULL);
+    assert(create_flow_generator(NULL) == NULL);
+
+    printf("Flow determinism test passed!\n");
+}
+
+// Index of dispersion of arrival counts in fixed windows; 1 for Poisson
+static double dispersion(const FlowMessage *messages, int count, uint64_t window_ns)
+{
+    int windows = (int)(messages[count - 1].time_ns / window_ns);
+    int *buckets = (int *)calloc(windows, sizeof(int));
+    assert(buckets);
+    for (int i = 0; i < count; i++)
+    {
+        int w = (int)(messages[i].time_ns / window_ns);
+        if (w < windows)
+            buckets[w]++;
+    }
+    double mean = 0;
+    double square = 0;
+    for (int w = 0; w < windows; w++)
+    {
+        mean += buckets[w];
+        square += (double)buckets[w] * buckets[w];
+    }
+    mean /= windows;
+    double variance = square / windows - mean * mean;
+    free(buckets);
+    return variance / mean;
+}
+
+// Test Poisson and Hawkes arrival rates and clustering
+void test_arrivals()
+{
+    printf("Testing flow arrivals...\n");
+
+    FlowConfig config = default_flow_config();
+    FlowMessage *poisson = generate(&config, MESSAGES);
+    for (int i = 1; i < MESSAGES; i++)
+        assert(poisson[i].time_ns >= poisson[i - 1].time_ns);
+    double rate = MESSAGES / (poisson[MESSAGES - 1].time_ns * 1e-9);
+    assert(fabs(rate / config.rate - 1) < 0.02);
+    double poisson_dispersion = dispersion(poisson, MESSAGES, 1000000);
+    assert(fabs(poisson_dispersion - 1) < 0.3);
+
+    // stationary Hawkes rate is rate / (1 - alpha / beta)
+    config.arrivals = FLOW_HAWKES;
+    FlowMessage *hawkes = generate(&config, MESSAGES);
+    double expected = config.rate / (1 - config.hawkes_alpha / config.hawkes_beta);
+    rate = MESSAGES / (hawkes[MESSAGES - 1].time_ns * 1e-9);
+    assert(fabs(rate / expected - 1) < 0.1);
+    double hawkes_dispersion = dispersion(hawkes, MESSAGES, 1000000);
+    assert(hawkes_dispersion > 3 * poisson_dispersion);
+    printf("  rate %.3g/s, dispersion %.2f (Poisson %.2f)\n", rate, hawkes_dispersion, poisson_dispersion);
+
+    free(poisson);
+    free(hawkes);
+    printf("Flow arrivals test passed!\n");
+}
+
+// Test the message mix, price distances and cancel targets
+void test_message_mix()
+{
+    printf("Testing flow message mix...\n");
+
+    FlowConfig config = default_flow_config();
+    config.symbols = 4;
+    FlowMessage *messages = generate(&config, MESSAGES);
+
+    int counts[3] = {0, 0, 0};
+    int one_tick = 0;
+    int crossing = 0;
+    char *state = (char *)calloc(MESSAGES + 2, 1); // 1 placed, 2 cancelled
+    uint32_t *symbol = (uint32_t *)calloc(MESSAGES + 2, sizeof(uint32_t));
+    assert(state && symbol);
+    for (int i = 0; i < MESSAGES; i++)
+    {
+        FlowMessage *m = &messages[i];
+        counts[m->type]++;
+        assert(m->symbol < 4);
+        if (m->type == SEQ_NEW_ORDER)
+        {
+            assert(state[m->order_id] == 0);
+            state[m->order_id] = 1;
+            symbol[m->order_id] = m->symbol;
+            assert(m->quantity >= config.min_quantity && m->quantity <= config.max_quantity);
+            double ticks = (m->price - config.mid) / config.tick;
+            long distance = lround(fabs(ticks));
+            assert(distance >= 1 && distance <= config.max_distance);
+            assert(fabs(fabs(ticks) - distance) < 1e-6);
+            one_tick += distance == 1;
+            crossing += (m->side == 'B') == (ticks > 0);
+        }
+        else
+        {
+            // only live orders of the same symbol are cancelled or modified
+            assert(state[m->order_id] == 1 && symbol[m->order_id] == m->symbol);
+            if (m->type == SEQ_CANCEL)
+                state[m->order_id] = 2;
+        }
+    }
+
+    double cancels = (double)counts[SEQ_CANCEL] / MESSAGES;
+    double modifies = (double)counts[SEQ_MODIFY] / MESSAGES;
+    assert(fabs(cancels - config.cancel_ratio) < 0.01);
+    assert(fabs(modifies - config.modify_ratio) < 0.01);
+    // P(distance = 1) = 1 - 2^-a
+    double expected = 1 - pow(2, -config.tail_exponent);
+    assert(fabs((double)one_tick / counts[SEQ_NEW_ORDER] - expected) < 0.01);
+    assert(fabs((double)crossing / counts[SEQ_NEW_ORDER] - config.cross_ratio) < 0.01);
+
+    free(state);
+    free(symbol);
+    free(messages);
+    printf("Flow message mix test passed!\n");
+}
+
+// Test the Zipf spread of flow across symbols
+void test_symbol_skew()
+{
+    printf("Testing flow symbol skew...\n");
+
+    FlowConfig config = default_flow_config();
+    config.symbols = 100;
+    FlowMessage *messages = generate(&config, MESSAGES);
+    int counts[100] = {0};
+    for (int i = 0; i < MESSAGES; i++)
+        counts[messages[i].symbol]++;
+    // Zipf with exponent 1: symbol k gets 1 / (k + 1) of symbol 0's flow
+    assert(fabs((double)counts[0] / counts[1] - 2) < 0.1);
+    assert(fabs((double)counts[0] / counts[9] - 10) < 1);
+    assert(counts[99] > 0);
+    free(messages);
+
+    config.symbol_skew = 0;
+    messages = generate(&config, MESSAGES);
+    memset(counts, 0, sizeof(counts));
+    for (int i = 0; i < MESSAGES; i++)
+        counts[messages[i].symbol]++;
+    for (int s = 0; s < 100; s++)
+        assert(abs(counts[s] - MESSAGES / 100) < MESSAGES / 100 / 5);
+    free(messages);
+
+    printf("Flow symbol skew test passed!\n");
+}
+
+// Test writing a flow to a file and reading it back
+void test_flow_file()
+{
+    printf("Testing flow files...\n");
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/flow_test_%d.bin", (int)getpid());
+    FlowConfig config = default_flow_config();
+    config.seed = 7;
+    int count = 10000;
+    FlowMessage *expected = generate(&config, count);
+
+    FlowGenerator *generator = create_flow_generator(&config);
+    assert(flow_write_file(generator, path, count) == 0);
+    free_flow_generator(generator);
+
+    FlowReader *reader = open_flow_file(path);
+    assert(reader && reader->header.seed == 7 && reader->header.count == (uint64_t)count);
+    FlowMessage batch[3000];
+    int read = 0;
+    int n;
+    while ((n = flow_read(reader, batch, 3000)) > 0)
+    {
+        assert(memcmp(batch, expected + read, n * sizeof(FlowMessage)) == 0);
+        read += n;
+    }
+    assert(n == 0 && read == count);
+    close_flow_file(reader);
+
+    // a truncated file reads short
+    assert(truncate(path, sizeof(FlowFileHeader) + 10 * sizeof(FlowMessage) + 3) == 0);
+    reader = open_flow_file(path);
+    assert(reader);
+    assert(flow_read(reader, batch, 3000) == -1);
+    close_flow_file(reader);
+
+    FILE *file = fopen(path, "wb");
+    fputs("not a flow file", file);
+    fclose(file);
+    assert(open_flow_file(path) == NULL);
+    unlink(path);
+    assert(open_flow_file(path) == NULL);
+
+    free(expected);
+    printf("Flow files test passed!\n");
+}
+
+// Test feeding a flow straight into engine ingress, one book per symbol
+void test_feed_engine()
+{
+    printf("Testing flow feed...\n");
+
+    FlowConfig config = default_flow_config();
+    config.symbols = 4;
+    config.cross_ratio = 0.2;
+    int total = 50000;
+    FlowMessage *expected = generate(&config, total);
+
+    Sequencer *sequencer = create_sequencer(256);
+    IngressQueue *queues[2];
+    queues[0] = sequencer_add_gateway(sequencer, 128);
+    queues[1] = sequencer_add_gateway(sequencer, 128);
+    OrderBook *books[4];
+    for (int s = 0; s < 4; s++)
+        books[s] = create_orderbook();
+
+    FlowGenerator *generator = create_flow_generator(&config);
+    // the queues fill long before a million messages
+    int fed = flow_feed(generator, queues, 2, 1000000);
+    assert(fed >= 128 && fed < 256);
+
+    int next[2] = {0, 0}; // next expected message per gateway
+    int applied = 0;
+    int rejected_adds = 0;
+    SeqMessage batch[256];
+    while (applied < total)
+    {
+        if (fed < total)
+            fed += flow_feed(generator, queues, 2, total - fed);
+        int n = sequencer_poll(sequencer, batch, 256);
+        for (int i = 0; i < n; i++)
+        {
+            SeqMessage *m = &batch[i];
+            // each gateway sees its symbols' messages in flow order
+            int g = m->gateway;
+            while (expected[next[g]].symbol % 2 != (uint32_t)g)
+                next[g]++;
+            FlowMessage *want = &expected[next[g]++];
+            assert(m->user_data == want->symbol && m->order_id == want->order_id && m->type == want->type);
+            int result = sequencer_apply(books[m->user_data], m);
+            rejected_adds += m->type == SEQ_NEW_ORDER && result != 0;
+        }
+        applied += n;
+    }
+    assert(fed == total && rejected_adds == 0);
+
+    int trades = 0;
+    for (int s = 0; s < 4; s++)
+    {
+        Order *bid = getTop(books[s]->buy_orders);
+        Order *ask = getTop(books[s]->sell_orders);
+        assert(bid && ask && bid->price < ask->price);
+        trades += books[s]->trade_history_size;
+        free_orderbook(books[s]);
+    }
+    assert(trades > 0);
+
+    free_flow_generator(generator);
+    free_sequencer(sequencer);
+    free(expected);
+    printf("Flow feed test passed!\n");
+}
+
+// Test generation throughput
+void test_flow_rate()
+{
+    printf("Testing flow generation rate...\n");
+
+    FlowConfig config = default_flow_config();
+    config.arrivals = FLOW_HAWKES;
+    FlowGenerator *generator = create_flow_generator(&config);
+    FlowMessage *messages = (FlowMessage *)malloc(4096 * sizeof(FlowMessage));
+    assert(messages);
+
+    int rounds = 500;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < rounds; r++)
+        flow_generate(generator, messages, 4096);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    printf("  %.1fM messages/s\n", rounds * 4096 / seconds / 1e6);
+
+    free(messages);
+    free_flow_generator(generator);
+    printf("Flow generation rate test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING LOADGEN TESTS ===\n");
+
+    test_determinism();
+    test_arrivals();
+    test_message_mix();
+    test_symbol_skew();
+    test_flow_file();
+    test_feed_engine();
+    test_flow_rate();
+
+    printf("=== ALL LOADGEN TESTS PASSED ===\n");
+    return 0;
+}
@@ -1,5 +1,438 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "orderbook.h"
+#include "matching/matcher.h"
+#include "matching/auction.h"
+
+// Test continuous matching at the maker's price
+void test_basic_matching()
+{
+    printf("Testing basic matching...\n");
+
+    OrderBook *orderbook = create_orderbook();
+
+    add_order(orderbook, create_order(1, 100, 10, 1000, 'S'));
+    add_order(orderbook, create_order(2, 101, 10, 1001, 'S'));
+    add_order(orderbook, create_order(3, 101, 15, 1002, 'B'));
+
+    // Sweeps order 1 and partially fills order 2
+    assert(orderbook->trade_history_size == 2);
+    assert(orderbook->price_history[0] == 100);
+    assert(orderbook->price_history[1] == 101);
+    assert(!ordermap_contains(orderbook->order_map, 1));
+    assert(!ordermap_contains(orderbook->order_map, 3));
+    assert(ordermap_get(orderbook->order_map, 2)->quantity == 5);
+    assert(orderbook->buy_orders->size == 0);
+    assert(orderbook->sell_orders->size == 1);
+
+    // Non-crossing book
+    assert(match_orderbook(orderbook) == 1);
+
+    printf("Basic matching test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test that self-trades are allowed when STP is disabled
+void test_stp_none()
+{
+    printf("Testing STP disabled...\n");
+
+    OrderBook *orderbook = create_orderbook();
+
+    add_order(orderbook, create_owned_order(1, 100, 10, 1000, 'S', 7));
+    add_order(orderbook, create_owned_order(2, 100, 10, 1001, 'B', 7));
+
+    assert(orderbook->trade_history_size == 1);
+    assert(orderbook->order_map->size == 0);
+
+    printf("STP disabled test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test cancel newest: the incoming order is cancelled
+void test_stp_cancel_newest()
+{
+    printf("Testing STP cancel newest...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    set_stp_mode(orderbook, STP_CANCEL_NEWEST);
+
+    add_order(orderbook, create_owned_order(1, 100, 10, 1000, 'S', 7));
+    add_order(orderbook, create_owned_order(2, 100, 5, 1001, 'B', 7));
+
+    assert(orderbook->trade_history_size == 0);
+    assert(ordermap_contains(orderbook->order_map, 1));
+    assert(!ordermap_contains(orderbook->order_map, 2));
+    assert(orderbook->buy_orders->size == 0);
+    assert(orderbook->sell_orders->size == 1);
+
+    // Different owner still trades
+    add_order(orderbook, create_owned_order(3, 100, 4, 1002, 'B', 8));
+    assert(orderbook->trade_history_size == 1);
+    assert(ordermap_get(orderbook->order_map, 1)->quantity == 6);
+
+    printf("STP cancel newest test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test cancel oldest: the resting order is cancelled and the taker keeps matching
+void test_stp_cancel_oldest()
+{
+    printf("Testing STP cancel oldest...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    set_stp_mode(orderbook, STP_CANCEL_OLDEST);
+
+    add_order(orderbook, create_owned_order(1, 100, 10, 1000, 'S', 7));
+    add_order(orderbook, create_owned_order(2, 101, 10, 1001, 'S', 8));
+    add_order(orderbook, create_owned_order(3, 101, 4, 1002, 'B', 7));
+
+    assert(!ordermap_contains(orderbook->order_map, 1));
+    assert(!ordermap_contains(orderbook->order_map, 3));
+    assert(orderbook->trade_history_size == 1);
+    assert(orderbook->price_history[0] == 101);
+    assert(ordermap_get(orderbook->order_map, 2)->quantity == 6);
+
+    printf("STP cancel oldest test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test cancel both
+void test_stp_cancel_both()
+{
+    printf("Testing STP cancel both...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    set_stp_mode(orderbook, STP_CANCEL_BOTH);
+
+    add_order(orderbook, create_owned_order(1, 100, 10, 1000, 'S', 7));
+    add_order(orderbook, create_owned_order(2, 100, 5, 1001, 'B', 7));
+
+    assert(orderbook->trade_history_size == 0);
+    assert(orderbook->order_map->size == 0);
+    assert(orderbook->buy_orders->size == 0);
+    assert(orderbook->sell_orders->size == 0);
+
+    printf("STP cancel both test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test decrement: both sides shrink by the overlap, no trade is recorded
+void test_stp_decrement()
+{
+    printf("Testing STP decrement...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    set_stp_mode(orderbook, STP_DECREMENT);
+
+    add_order(orderbook, create_owned_order(1, 100, 10, 1000, 'S', 7));
+    add_order(orderbook, create_owned_order(2, 100, 4, 1001, 'B', 7));
+
+    assert(orderbook->trade_history_size == 0);
+    assert(!ordermap_contains(orderbook->order_map, 2));
+    assert(ordermap_get(orderbook->order_map, 1)->quantity == 6);
+
+    printf("STP decrement test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test that orders accumulate during an auction and uncross at one price
+void test_auction_uncross()
+{
+    printf("Testing auction uncross...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    begin_auction(orderbook);
+
+    add_order(orderbook, create_order(1, 102, 10, 1000, 'B'));
+    add_order(orderbook, create_order(2, 101, 10, 1001, 'B'));
+    add_order(orderbook, create_order(3, 100, 10, 1002, 'B'));
+    add_order(orderbook, create_order(4, 99, 5, 1003, 'S'));
+    add_order(orderbook, create_order(5, 100, 10, 1004, 'S'));
+    add_order(orderbook, create_order(6, 101, 20, 1005, 'S'));
+
+    // Crossed book, but nothing trades during the call phase
+    assert(orderbook->trade_history_size == 0);
+
+    AuctionResult result;
+    assert(uncross_auction(orderbook, 0, &result) == 0);
+    assert(result.price == 101);
+    assert(result.volume == 20);
+    assert(result.imbalance == -15);
+    assert(result.levels == 4);
+    assert(orderbook->phase == PHASE_CONTINUOUS);
+
+    long long executed = 0;
+    for (int i = 0; i < orderbook->trade_history_size; i++)
+    {
+        assert(orderbook->price_history[i] == 101);
+        executed += orderbook->trade_history[i].traded_quantity;
+    }
+    assert(executed == 20);
+
+    assert(ordermap_contains(orderbook->order_map, 3));
+    assert(ordermap_get(orderbook->order_map, 6)->quantity == 15);
+    assert(orderbook->buy_orders->size == 1);
+    assert(orderbook->sell_orders->size == 1);
+
+    printf("Auction uncross test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test imbalance and reference price tie-breaks
+void test_auction_tie_breaks()
+{
+    printf("Testing auction tie-breaks...\n");
+
+    AuctionResult result;
+    OrderBook *orderbook = create_orderbook();
+    begin_auction(orderbook);
+
+    // Equal volume at 100 and 101 with no imbalance: reference decides
+    add_order(orderbook, create_order(1, 101, 10, 1000, 'B'));
+    add_order(orderbook, create_order(2, 100, 10, 1001, 'S'));
+    assert(compute_uncross(orderbook, 100.2, &result) == 0);
+    assert(result.price == 100);
+    assert(compute_uncross(orderbook, 100.9, &result) == 0);
+    assert(result.price == 101);
+    free_orderbook(orderbook);
+
+    // Equal volume everywhere: the smallest imbalance wins
+    orderbook = create_orderbook();
+    begin_auction(orderbook);
+    add_order(orderbook, create_order(1, 102, 10, 1000, 'B'));
+    add_order(orderbook, create_order(2, 101, 2, 1001, 'B'));
+    add_order(orderbook, create_order(3, 100, 10, 1002, 'S'));
+    assert(compute_uncross(orderbook, 100, &result) == 0);
+    assert(result.price == 102);
+    assert(result.volume == 10);
+    assert(result.imbalance == 0);
+
+    // Non-crossing book has nothing to uncross
+    free_orderbook(orderbook);
+    orderbook = create_orderbook();
+    begin_auction(orderbook);
+    add_order(orderbook, create_order(1, 99, 10, 1000, 'B'));
+    add_order(orderbook, create_order(2, 100, 10, 1001, 'S'));
+    assert(uncross_auction(orderbook, 0, &result) == 1);
+    assert(result.volume == 0);
+    assert(orderbook->phase == PHASE_CONTINUOUS);
+
+    printf("Auction tie-breaks test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test the uncross of heap and ladder books against a brute-force walk
+// over every candidate price
+void test_auction_levels()
+{
+    printf("Testing auction levels...\n");
+
+    srand(11);
+    for (int round = 0; round < 100; round++)
+    {
+        OrderBook *heap_book = create_orderbook();
+        OrderBook *ladder_book = create_orderbook();
+        assert(use_price_ladder(ladder_book, 80, 0.5, 128) == 0);
+        begin_auction(heap_book);
+        begin_auction(ladder_book);
+
+        int n = 1 + rand() % 300;
+        double prices[300];
+        int quantities[300];
+        char sides[300];
+        for (int i = 0; i < n; i++)
+        {
+            sides[i] = rand() % 2 ? 'B' : 'S';
+            prices[i] = 90 + (rand() % 41) * 0.5;
+            quantities[i] = 1 + rand() % 20;
+            for (int b = 0; b < 2; b++)
+            {
+                Order *order = create_order(i + 1, 0, quantities[i], 1000 + i, sides[i]);
+                order->price = prices[i];
+                assert(add_order(b ? ladder_book : heap_book, order) == 0);
+            }
+        }
+
+        double reference = 90 + rand() % 20;
+        long long best_volume = 0;
+        long long best_imbalance = 0;
+        double best_price = 0;
+        for (int c = 0; c < n; c++)
+        {
+            long long demand = 0;
+            long long supply = 0;
+            for (int i = 0; i < n; i++)
+            {
+                if (sides[i] == 'B' && prices[i] >= prices[c])
+                    demand += quantities[i];
+                if (sides[i] == 'S' && prices[i] <= prices[c])
+                    supply += quantities[i];
+            }
+            long long volume = demand < supply ? demand : supply;
+            long long imbalance = demand - supply;
+            long long size = imbalance < 0 ? -imbalance : imbalance;
+            long long best_size = best_imbalance < 0 ? -best_imbalance : best_imbalance;
+            double gap = prices[c] > reference ? prices[c] - reference : reference - prices[c];
+            double best_gap = best_price > reference ? best_price - reference : reference - best_price;
+            if (volume > best_volume ||
+                (volume > 0 && volume == best_volume &&
+                 (size < best_size || (size == best_size && gap < best_gap) ||
+                  (size == best_size && gap == best_gap && prices[c] < best_price))))
+            {
+                best_volume = volume;
+                best_imbalance = imbalance;
+                best_price = prices[c];
+            }
+        }
+
+        AuctionResult from_heap;
+        AuctionResult from_ladder;
+        int status = compute_uncross(heap_book, reference, &from_heap);
+        assert(compute_uncross(ladder_book, reference, &from_ladder) == status);
+        assert(status == (best_volume > 0 ? 0 : 1));
+        assert(from_heap.levels == from_ladder.levels);
+        assert(from_heap.volume == best_volume && from_ladder.volume == best_volume);
+        if (status == 0)
+        {
+            assert(from_heap.price == best_price && from_ladder.price == best_price);
+            assert(from_heap.imbalance == best_imbalance && from_ladder.imbalance == best_imbalance);
+        }
+
+        free_orderbook(heap_book);
+        free_orderbook(ladder_book);
+    }
+
+    printf("Auction levels test passed!\n");
+}
+
+// Test level allocation rules
+void test_policy_allocation()
+{
+    printf("Testing policy allocation...\n");
+
+    int resting[] = {10, 30, 60};
+    int alloc[3];
+
+    MatchingPolicy fifo = price_time_policy();
+    assert(allocate_level(&fifo, 35, resting, 3, alloc) == 35);
+    assert(alloc[0] == 10 && alloc[1] == 25 && alloc[2] == 0);
+
+    MatchingPolicy pro_rata = pro_rata_policy(0, RESIDUAL_FIFO);
+    assert(allocate_level(&pro_rata, 50, resting, 3, alloc) == 50);
+    assert(alloc[0] == 5 && alloc[1] == 15 && alloc[2] == 30);
+
+    // Rounding leaves one lot for the residual rule
+    assert(allocate_level(&pro_rata, 7, resting, 3, alloc) == 7);
+    assert(alloc[0] == 1 && alloc[1] == 2 && alloc[2] == 4);
+
+    MatchingPolicy largest = pro_rata_policy(0, RESIDUAL_LARGEST);
+    assert(allocate_level(&largest, 7, resting, 3, alloc) == 7);
+    assert(alloc[0] == 0 && alloc[1] == 2 && alloc[2] == 5);
+
+    // Shares below the minimum are folded into the residual
+    MatchingPolicy minimum = pro_rata_policy(3, RESIDUAL_FIFO);
+    assert(allocate_level(&minimum, 7, resting, 3, alloc) == 7);
+    assert(alloc[0] == 3 && alloc[1] == 0 && alloc[2] == 4);
+
+    // Top order takes its FIFO share, the rest is pro-rata
+    MatchingPolicy hybrid = hybrid_policy(40, 0, RESIDUAL_FIFO);
+    assert(allocate_level(&hybrid, 50, resting, 3, alloc) == 50);
+    assert(alloc[0] == 10 && alloc[1] == 14 && alloc[2] == 26);
+
+    // Out-of-range shares and minimums are rejected
+    assert(validate_matching_policy(&hybrid) == 0);
+    MatchingPolicy oversized = hybrid_policy(150, 0, RESIDUAL_FIFO);
+    MatchingPolicy negative = hybrid_policy(-10, 0, RESIDUAL_FIFO);
+    MatchingPolicy below_zero = pro_rata_policy(-1, RESIDUAL_FIFO);
+    assert(validate_matching_policy(&oversized) == -1);
+    assert(validate_matching_policy(&negative) == -1);
+    assert(validate_matching_policy(&below_zero) == -1);
+    OrderBook *orderbook = create_orderbook();
+    assert(set_matching_policy(orderbook, oversized) == -1);
+    assert(set_matching_policy(orderbook, below_zero) == -1);
+    assert(orderbook->policy.type == POLICY_PRICE_TIME);
+    assert(set_matching_policy(orderbook, hybrid_policy(100, 2, RESIDUAL_LARGEST)) == 0);
+    free_orderbook(orderbook);
+
+    // Oversized incoming quantity takes the whole level
+    assert(allocate_level(&pro_rata, 500, resting, 3, alloc) == 100);
+    assert(alloc[0] == 10 && alloc[1] == 30 && alloc[2] == 60);
+
+    printf("Policy allocation test passed!\n");
+}
+
+// Test pro-rata matching through the book
+void test_pro_rata_matching()
+{
+    printf("Testing pro-rata matching...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    set_matching_policy(orderbook, pro_rata_policy(0, RESIDUAL_FIFO));
+
+    add_order(orderbook, create_order(1, 100, 10, 1000, 'S'));
+    add_order(orderbook, create_order(2, 100, 30, 1001, 'S'));
+    add_order(orderbook, create_order(3, 100, 60, 1002, 'S'));
+    add_order(orderbook, create_order(4, 101, 20, 1003, 'S'));
+    add_order(orderbook, create_order(5, 100, 50, 1004, 'B'));
+
+    assert(orderbook->trade_history_size == 3);
+    assert(ordermap_get(orderbook->order_map, 1)->quantity == 5);
+    assert(ordermap_get(orderbook->order_map, 2)->quantity == 15);
+    assert(ordermap_get(orderbook->order_map, 3)->quantity == 30);
+    assert(!ordermap_contains(orderbook->order_map, 5));
+    assert(orderbook->sell_orders->size == 4);
+
+    // Sweeping through the level continues at the next price
+    add_order(orderbook, create_order(6, 101, 60, 1005, 'B'));
+    assert(orderbook->sell_orders->size == 1);
+    assert(ordermap_get(orderbook->order_map, 4)->quantity == 10);
+    assert(orderbook->price_history[orderbook->price_history_size - 1] == 101);
+    free_orderbook(orderbook);
+
+    // Same-owner resting orders are removed from the allocation
+    orderbook = create_orderbook();
+    set_matching_policy(orderbook, pro_rata_policy(0, RESIDUAL_FIFO));
+    set_stp_mode(orderbook, STP_CANCEL_OLDEST);
+
+    add_order(orderbook, create_owned_order(1, 100, 10, 1000, 'S', 7));
+    add_order(orderbook, create_owned_order(2, 100, 10, 1001, 'S', 8));
+    add_order(orderbook, create_owned_order(3, 100, 4, 1002, 'B', 7));
+
+    assert(!ordermap_contains(orderbook->order_map, 1));
+    assert(ordermap_get(orderbook->order_map, 2)->quantity == 6);
+    assert(orderbook->trade_history_size == 1);
+
+    printf("Pro-rata matching test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
 int main()
 {
-    printf("Nothing to test.");
-}
\ No newline at end of file
+    printf("=== RUNNING MATCHING TESTS ===\n\n");
+
+    test_basic_matching();
+    test_stp_none();
+    test_stp_cancel_newest();
+    test_stp_cancel_oldest();
+    test_stp_cancel_both();
+    test_stp_decrement();
+    test_auction_uncross();
+    test_auction_tie_breaks();
+    test_auction_levels();
+    test_policy_allocation();
+    test_pro_rata_matching();
+
+    printf("\n=== ALL MATCHING TESTS PASSED ===\n");
+    return 0;
+}
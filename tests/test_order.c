@@ -41,13 +41,15 @@ void test_buy_order_comparison()
     assert(compare_buy_orders(high_price, low_price) < 0);
     assert(compare_buy_orders(low_price, high_price) > 0);
 
-    // Same price, earlier timestamp should come first
-    Order *early_time = create_order(3, 100, 10, 900, 'B');
-    Order *late_time = create_order(4, 100, 10, 1000, 'B');
+    // Same price, earlier arrival should come first, whatever the timestamps
+    Order *early_time = create_order(3, 100, 10, 1000, 'B');
+    Order *late_time = create_order(4, 100, 10, 900, 'B');
+    early_time->sequence = 1;
+    late_time->sequence = 2;
     assert(compare_buy_orders(early_time, late_time) < 0);
     assert(compare_buy_orders(late_time, early_time) > 0);
 
-    // Same price and timestamp should be equal
+    // Same price and sequence should be equal
     Order *same_order1 = create_order(5, 100, 10, 1000, 'B');
     Order *same_order2 = create_order(6, 100, 10, 1000, 'B');
     assert(compare_buy_orders(same_order1, same_order2) == 0);
@@ -73,13 +75,15 @@ void test_sell_order_comparison()
     assert(compare_sell_orders(low_price, high_price) < 0);
     assert(compare_sell_orders(high_price, low_price) > 0);
 
-    // Same price, earlier timestamp should come first
-    Order *early_time = create_order(3, 100, 10, 900, 'S');
-    Order *late_time = create_order(4, 100, 10, 1000, 'S');
+    // Same price, earlier arrival should come first, whatever the timestamps
+    Order *early_time = create_order(3, 100, 10, 1000, 'S');
+    Order *late_time = create_order(4, 100, 10, 900, 'S');
+    early_time->sequence = 1;
+    late_time->sequence = 2;
     assert(compare_sell_orders(early_time, late_time) < 0);
     assert(compare_sell_orders(late_time, early_time) > 0);
 
-    // Same price and timestamp should be equal
+    // Same price and sequence should be equal
     Order *same_order1 = create_order(5, 100, 10, 1000, 'S');
     Order *same_order2 = create_order(6, 100, 10, 1000, 'S');
     assert(compare_sell_orders(same_order1, same_order2) == 0);
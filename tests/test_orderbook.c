@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include "orderbook.h"
+#include "audit/audit.h"
 
 // Test orderbook creation and initialization
 void test_orderbook_creation()
@@ -187,6 +188,609 @@ void test_edge_cases()
     free_order(neg_price);
 }
 
+// Test cancelling resting orders anywhere in the heap
+void test_cancel_order()
+{
+    printf("Testing order cancellation...\n");
+
+    OrderBook *orderbook = create_orderbook();
+
+    for (int i = 1; i <= 20; i++)
+        add_order(orderbook, create_order(i, 100 - (i * 7) % 13, 10, 1000 + i, 'B'));
+
+    assert(cancel_order(orderbook, 5) == 0);
+    assert(cancel_order(orderbook, 12) == 0);
+    assert(cancel_order(orderbook, 5) == -1);
+    assert(cancel_order(orderbook, 99) == -1);
+    assert(!ordermap_contains(orderbook->order_map, 5));
+    assert(orderbook->buy_orders->size == 18);
+
+    // Remaining orders still come out in priority order
+    Order *prev = extractTop(orderbook->buy_orders);
+    for (int i = 1; i < 18; i++)
+    {
+        Order *next = extractTop(orderbook->buy_orders);
+        assert(compare_buy_orders(prev, next) <= 0);
+        insertOrderHeap(orderbook->sell_orders, prev);
+        prev = next;
+    }
+    insertOrderHeap(orderbook->sell_orders, prev);
+
+    printf("Order cancellation test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test GTT and DAY expiry through the timing wheel
+void test_order_expiry()
+{
+    printf("Testing order expiry...\n");
+
+    OrderBook *orderbook = create_orderbook();
+
+    // Expiries spread over several wheel levels
+    long long expiries[] = {5, 300, 70000, 20000000, 5000000000LL};
+    for (int i = 0; i < 5; i++)
+    {
+        Order *order = create_order(i + 1, 100, 10, 1000 + i, 'B');
+        set_time_in_force(order, TIF_GTT, expiries[i]);
+        assert(add_order(orderbook, order) == 0);
+    }
+
+    Order *day = create_order(10, 90, 10, 2000, 'B');
+    set_time_in_force(day, TIF_DAY, 0);
+    add_order(orderbook, day);
+    add_order(orderbook, create_order(11, 90, 10, 2001, 'B'));
+
+    assert(expire_orders(orderbook, 4) == 0);
+    assert(expire_orders(orderbook, 5) == 1);
+    assert(!ordermap_contains(orderbook->order_map, 1));
+    assert(expire_orders(orderbook, 299) == 0);
+    assert(expire_orders(orderbook, 69999) == 1);
+    assert(expire_orders(orderbook, 70000) == 1);
+    assert(expire_orders(orderbook, 19999999) == 0);
+    assert(expire_orders(orderbook, 20000000) == 1);
+    assert(expire_orders(orderbook, 5000000000LL) == 1);
+    assert(orderbook->expiry_wheel->scheduled == 0);
+
+    // Orders already past their expiry are rejected
+    Order *stale = create_order(12, 100, 10, 3000, 'B');
+    set_time_in_force(stale, TIF_GTT, 100);
+    assert(add_order(orderbook, stale) == -1);
+    free_order(stale);
+
+    // Filled orders leave the wheel
+    Order *filled = create_order(13, 100, 10, 3001, 'S');
+    set_time_in_force(filled, TIF_GTT, 5000000100LL);
+    add_order(orderbook, filled);
+    add_order(orderbook, create_order(14, 100, 10, 3002, 'B'));
+    assert(orderbook->expiry_wheel->scheduled == 0);
+
+    assert(expire_day_orders(orderbook) == 1);
+    assert(!ordermap_contains(orderbook->order_map, 10));
+    assert(ordermap_contains(orderbook->order_map, 11));
+
+    printf("Order expiry test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test expiry timing against randomly scheduled and cancelled orders
+void test_expiry_randomized()
+{
+    printf("Testing randomized expiry...\n");
+
+    enum { N = 40, ROUNDS = 50 };
+    long long expire_at[N + 1];
+    int alive[N + 1];
+    srand(42);
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        OrderBook *orderbook = create_orderbook();
+
+        for (int i = 1; i <= N; i++)
+        {
+            expire_at[i] = 1 + ((long long)rand() * 7919 + rand()) % 400000;
+            alive[i] = 1;
+            Order *order = create_order(i, 100 + i % 5, 1, i, 'S');
+            set_time_in_force(order, TIF_GTT, expire_at[i]);
+            add_order(orderbook, order);
+        }
+        for (int i = 1 + round % 7; i <= N; i += 7)
+        {
+            cancel_order(orderbook, i);
+            alive[i] = 0;
+        }
+
+        long long now = 0;
+        while (now < 400000)
+        {
+            now += 1 + rand() % 3000;
+            int expected = 0;
+            for (int i = 1; i <= N; i++)
+                if (alive[i] && expire_at[i] <= now)
+                {
+                    alive[i] = 0;
+                    expected++;
+                }
+            assert(expire_orders(orderbook, now) == expected);
+        }
+        assert(orderbook->order_map->size == 0);
+        assert(orderbook->sell_orders->size == 0);
+
+        free_orderbook(orderbook);
+    }
+
+    printf("Randomized expiry test passed!\n");
+}
+
+// Test mass cancel by account, side and price range
+void test_mass_cancel()
+{
+    printf("Testing mass cancel...\n");
+
+    OrderBook *orderbook = create_orderbook();
+
+    // Accounts 1 and 2 quote both sides at several levels
+    int id = 1;
+    for (int owner = 1; owner <= 2; owner++)
+        for (int level = 0; level < 5; level++)
+        {
+            add_order(orderbook, create_owned_order(id, 95 - level, 10, 1000 + id, 'B', owner));
+            id++;
+            add_order(orderbook, create_owned_order(id, 105 + level, 10, 1000 + id, 'S', owner));
+            id++;
+        }
+    add_order(orderbook, create_order(id, 94, 10, 1000 + id, 'B'));
+
+    // Account 1 bids outside [93, 94]
+    MassCancelFilter filter = {1, 'B', 1, 93, 94};
+    assert(mass_cancel(orderbook, &filter) == 3);
+    assert(accountmap_get(orderbook->account_map, 1)->order_count == 7);
+    assert(orderbook->buy_orders->size == 8);
+
+    // Everything account 1 has left
+    assert(cancel_account_orders(orderbook, 1) == 7);
+    assert(accountmap_get(orderbook->account_map, 1)->order_count == 0);
+    assert(accountmap_get(orderbook->account_map, 1)->orders == NULL);
+
+    // All accounts, asks above 107
+    MassCancelFilter asks = {0, 'S', 1, 0, 107};
+    assert(mass_cancel(orderbook, &asks) == 2);
+    assert(orderbook->sell_orders->size == 3);
+    assert(getTop(orderbook->sell_orders)->price == 105);
+
+    // Cancel on disconnect only when enabled
+    assert(account_disconnected(orderbook, 2) == 0);
+    set_cancel_on_disconnect(orderbook, 2, 1);
+    assert(account_disconnected(orderbook, 2) == 8);
+
+    // Whole bid side, anonymous order included
+    MassCancelFilter bids = {0, 'B', 0, 0, 0};
+    assert(mass_cancel(orderbook, &bids) == 1);
+    assert(orderbook->buy_orders->size == 0);
+    assert(orderbook->sell_orders->size == 0);
+    assert(orderbook->order_map->size == 0);
+
+    printf("Mass cancel test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test range cancels against a count taken beforehand, for both side
+// layouts and ranges that cut one end, both ends or the whole side
+void test_mass_cancel_ranges()
+{
+    printf("Testing mass cancel ranges...\n");
+
+    srand(7);
+    for (int round = 0; round < 200; round++)
+    {
+        OrderBook *orderbook = create_orderbook();
+        if (round % 2)
+            assert(use_price_ladder(orderbook, 50, 1, 128) == 0);
+
+        int id = 1;
+        for (int i = 0; i < 300; i++, id++)
+        {
+            char side = rand() % 2 ? 'B' : 'S';
+            int price = side == 'B' ? 60 + rand() % 40 : 100 + rand() % 40;
+            assert(add_order(orderbook, create_order(id, price, 1 + rand() % 5, 1000 + i, side)) == 0);
+        }
+
+        double low = 55 + rand() % 90;
+        double high = low + rand() % 30;
+        char side = "BS"[round % 2 ? 0 : 1];
+        int expected = 0;
+        for (int order_id = 1; order_id < id; order_id++)
+        {
+            Order *order = ordermap_get(orderbook->order_map, order_id);
+            if (order->side == side && (order->price < low || order->price > high))
+                expected++;
+        }
+
+        MassCancelFilter filter = {0, side, 1, low, high};
+        assert(mass_cancel(orderbook, &filter) == expected);
+        AuditReport report;
+        assert(audit_orderbook(orderbook, NULL, &report) == 0);
+        OrderHeap *heap = side == 'B' ? orderbook->buy_orders : orderbook->sell_orders;
+        for (Order *order = getTop(heap); order; order = getTop(heap))
+        {
+            assert(order->price >= low && order->price <= high);
+            double price = order->price;
+            assert(extractTop(heap) == order);
+            release_order(orderbook, order);
+            Order *after = getTop(heap);
+            assert(!after || (side == 'B' ? after->price <= price : after->price >= price));
+        }
+        free_orderbook(orderbook);
+    }
+
+    printf("Mass cancel ranges test passed!\n");
+}
+
+// Test the dense price ladder side layout
+void test_price_ladder()
+{
+    printf("Testing price ladder...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    assert(use_price_ladder(orderbook, 90, 0.5, 64) == 0);
+
+    add_order(orderbook, create_order(1, 100, 10, 1000, 'B'));
+    add_order(orderbook, create_order(2, 101, 10, 1001, 'B'));
+    add_order(orderbook, create_order(3, 101, 10, 1002, 'B'));
+    add_order(orderbook, create_order(4, 103, 10, 1003, 'S'));
+    add_order(orderbook, create_order(5, 102, 10, 1004, 'S'));
+
+    // Off-tick prices are rejected
+    Order *off_tick = create_order(6, 100, 10, 1005, 'B');
+    off_tick->price = 100.2;
+    assert(add_order(orderbook, off_tick) == -1);
+    free_order(off_tick);
+
+    assert(getTop(orderbook->buy_orders)->order_id == 2);
+    assert(getTop(orderbook->sell_orders)->order_id == 5);
+    assert(orderbook->buy_orders->size == 3);
+
+    // Emptying the best level moves to the next one
+    assert(cancel_order(orderbook, 2) == 0);
+    assert(getTop(orderbook->buy_orders)->order_id == 3);
+    assert(cancel_order(orderbook, 3) == 0);
+    assert(getTop(orderbook->buy_orders)->order_id == 1);
+
+    // Prices far outside the ladder re-centre and grow it
+    add_order(orderbook, create_order(7, 20, 10, 1006, 'B'));
+    add_order(orderbook, create_order(8, 400, 10, 1007, 'S'));
+    assert(getTop(orderbook->buy_orders)->order_id == 1);
+    assert(getTop(orderbook->sell_orders)->order_id == 5);
+    assert(orderbook->sell_orders->ladder->num_levels > 64);
+
+    // Prices the ladder could only reach past LADDER_MAX_LEVELS are refused
+    Order *far_off = create_order(10, 0, 10, 1008, 'S');
+    far_off->price = 5000000;
+    assert(!ladder_fits(orderbook->sell_orders->ladder, far_off->price));
+    assert(add_order(orderbook, far_off) == -1);
+    far_off->price = 1e12;
+    assert(add_order(orderbook, far_off) == -1);
+    assert(modify_order(orderbook, 5, 5000000, 10) == -1);
+    assert(getTop(orderbook->sell_orders)->order_id == 5);
+    free_order(far_off);
+    assert(orderbook->sell_orders->ladder->num_levels <= LADDER_MAX_LEVELS);
+
+    // Matching sweeps through ladder levels
+    add_order(orderbook, create_order(9, 103, 15, 1008, 'B'));
+    assert(orderbook->trade_history_size == 2);
+    assert(getTop(orderbook->sell_orders)->order_id == 4);
+    assert(getTop(orderbook->sell_orders)->quantity == 5);
+
+    // Not allowed once orders rest
+    assert(use_price_ladder(orderbook, 90, 0.5, 64) == -1);
+    OrderBook *oversized = create_orderbook();
+    assert(use_price_ladder(oversized, 90, 0.5, LADDER_MAX_LEVELS + 1) == -1);
+    free_orderbook(oversized);
+
+    printf("Price ladder test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test the ladder against the heap on the same random flow
+void test_price_ladder_randomized()
+{
+    printf("Testing price ladder against heap...\n");
+
+    OrderBook *heap_book = create_orderbook();
+    OrderBook *ladder_book = create_orderbook();
+    use_price_ladder(ladder_book, 100, 0.25, 64);
+    srand(7);
+
+    for (int i = 1; i <= 5000; i++)
+    {
+        int action = rand() % 10;
+        if (action < 7 && heap_book->buy_orders->size < 40 && heap_book->sell_orders->size < 40)
+        {
+            double price = 90 + (rand() % 80) * 0.25;
+            int quantity = 1 + rand() % 20;
+            char side = rand() % 2 ? 'B' : 'S';
+            Order *heap_order = create_order(i, 0, quantity, i, side);
+            Order *ladder_order = create_order(i, 0, quantity, i, side);
+            heap_order->price = price;
+            ladder_order->price = price;
+            add_order(heap_book, heap_order);
+            add_order(ladder_book, ladder_order);
+        }
+        else
+        {
+            int target = 1 + rand() % i;
+            assert(cancel_order(heap_book, target) == cancel_order(ladder_book, target));
+        }
+
+        assert(heap_book->trade_history_size == ladder_book->trade_history_size);
+        assert(heap_book->buy_orders->size == ladder_book->buy_orders->size);
+        assert(heap_book->sell_orders->size == ladder_book->sell_orders->size);
+        Order *heap_top = getTop(heap_book->buy_orders);
+        Order *ladder_top = getTop(ladder_book->buy_orders);
+        assert((heap_top == NULL) == (ladder_top == NULL));
+        if (heap_top)
+            assert(heap_top->order_id == ladder_top->order_id);
+        heap_top = getTop(heap_book->sell_orders);
+        ladder_top = getTop(ladder_book->sell_orders);
+        assert((heap_top == NULL) == (ladder_top == NULL));
+        if (heap_top)
+            assert(heap_top->order_id == ladder_top->order_id);
+    }
+
+    printf("Price ladder randomized test passed!\n");
+
+    free_orderbook(heap_book);
+    free_orderbook(ladder_book);
+}
+
+// Test handle-addressed order storage
+void test_order_table()
+{
+    printf("Testing order table...\n");
+
+    OrderBook *orderbook = create_orderbook();
+
+    Order *buy = create_order(1, 100, 10, 1000, 'B');
+    Order *sell = create_order(2, 105, 5, 1001, 'S');
+    add_order(orderbook, buy);
+    add_order(orderbook, sell);
+
+    OrderTable *table = orderbook->order_table;
+    assert(buy->handle != INVALID_HANDLE && sell->handle != buy->handle);
+    assert(table->keys[buy->handle] == order_key('B', 100, 0));
+    assert(table->keys[sell->handle] == order_key('S', 105, 1));
+    assert(table->heap_index[buy->handle] == 0);
+    assert(order_table_get(table, sell->handle) == sell);
+
+    // Released handles are reused
+    OrderHandle freed = buy->handle;
+    assert(cancel_order(orderbook, 1) == 0);
+    assert(order_table_get(table, freed) == NULL);
+    Order *next = create_order(3, 99, 10, 1002, 'B');
+    add_order(orderbook, next);
+    assert(next->handle == freed);
+    assert(ordermap_get(orderbook->order_map, 3) == next);
+
+    // Columns grow without moving handles
+    for (int i = 10; i < 45; i++)
+        add_order(orderbook, create_order(i, 110 + i, 1, 2000 + i, 'S'));
+    assert(table->capacity >= 37);
+    assert(ordermap_get(orderbook->order_map, 2) == sell);
+    assert(getTop(orderbook->sell_orders)->order_id == 2);
+
+    printf("Order table test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test composite sort keys and rank rebasing
+void test_order_keys()
+{
+    printf("Testing order sort keys...\n");
+
+    // Better price wins on either side, then earlier rank
+    assert(order_key('B', 101, 5) < order_key('B', 100, 1));
+    assert(order_key('S', 100, 5) < order_key('S', 101, 1));
+    assert(order_key('B', 100.25, 1) < order_key('B', 100.25, 2));
+    assert(order_key('S', 100.0001, 1) > order_key('S', 100, 2));
+
+    OrderBook *orderbook = create_orderbook();
+    Order *too_high = create_order(1, 100, 10, 1000, 'S');
+    too_high->price = ORDER_KEY_MAX_PRICE * 2;
+    assert(add_order(orderbook, too_high) == -1);
+    free_order(too_high);
+
+    // Prices between key ticks would share a key with a better one
+    double prices[] = {100.00004, 100.0001, 100.1, 99.99};
+    for (int i = 0; i < 4; i++)
+    {
+        Order *order = create_order(i, 100, 10, 1000, i < 3 ? 'S' : 'B');
+        order->price = prices[i];
+        int added = add_order(orderbook, order);
+        assert(added == (i == 0 ? -1 : 0));
+        if (added != 0)
+            free_order(order);
+    }
+    assert(modify_order(orderbook, 2, 100.00001, 10) == -1);
+    cancel_order(orderbook, 1);
+    cancel_order(orderbook, 2);
+    cancel_order(orderbook, 3);
+
+    // Push the rank counter across its limit with orders resting
+    orderbook->order_table->next_rank = ORDER_KEY_RANK_MASK - 3;
+    int id = 1;
+    for (int i = 0; i < 30; i++, id++)
+        add_order(orderbook, create_order(id, 100 + i % 4, 1, 1000 + i, 'S'));
+    assert(orderbook->order_table->next_rank < ORDER_KEY_RANK_MASK);
+
+    // Same-price orders still come out first in, first out
+    Order *drained[30];
+    for (int i = 0; i < 30; i++)
+        drained[i] = extractTop(orderbook->sell_orders);
+    for (int i = 1; i < 30; i++)
+        assert(drained[i - 1]->price < drained[i]->price ||
+               (drained[i - 1]->price == drained[i]->price &&
+                drained[i - 1]->sequence < drained[i]->sequence));
+    for (int i = 29; i >= 0; i--)
+        insertOrderHeap(orderbook->sell_orders, drained[i]);
+
+    // Every resting order's recorded position matches the heap
+    OrderHeap *heap = orderbook->sell_orders;
+    for (int i = 0; i < heap->size; i++)
+    {
+        assert(orderbook->order_table->heap_index[heap->arr[i]] == i);
+        assert(heap->keys[i] == orderbook->order_table->keys[heap->arr[i]]);
+        if (i > 0)
+            assert(heap->keys[(i - 1) / HEAP_ARITY] < heap->keys[i]);
+    }
+
+    printf("Order sort keys test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test that sides grow past their initial capacity without dropping orders
+void test_side_growth()
+{
+    printf("Testing side growth...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    int initial = orderbook->buy_orders->capacity;
+
+    int count = 5000;
+    for (int i = 0; i < count; i++)
+    {
+        assert(add_order(orderbook, create_order(2 * i + 1, 100 - i % 50, 1, 1000 + i, 'B')) == 0);
+        assert(add_order(orderbook, create_order(2 * i + 2, 200 + i % 50, 1, 1000 + i, 'S')) == 0);
+    }
+    assert(orderbook->buy_orders->size == count);
+    assert(orderbook->sell_orders->size == count);
+    assert(orderbook->buy_orders->capacity > initial);
+    // headroom is kept ahead of the next insert, and doubling is spread
+    // over the adds that follow it starting
+    assert(orderbook->buy_orders->size * 4 < orderbook->buy_orders->capacity * 3);
+    OrderHeap *bids = orderbook->buy_orders;
+    int capacity = bids->capacity;
+    int id = 2 * count + 1;
+    while (!bids->next_arr)
+        assert(add_order(orderbook, create_order(id++, 60, 1, 9000, 'B')) == 0);
+    assert(bids->capacity == capacity && bids->next_capacity == 2 * capacity);
+    assert(add_order(orderbook, create_order(id++, 60, 1, 9000, 'B')) == 0);
+    assert(bids->migrated == HEAP_GROW_STEP && bids->capacity == capacity);
+    // entries already copied stay current while the side keeps changing
+    assert(cancel_order(orderbook, 101) == 0);
+    for (int steps = 0; bids->next_arr; steps++)
+    {
+        assert(steps < capacity / HEAP_GROW_STEP + 1);
+        assert(add_order(orderbook, create_order(id++, 99 - steps % 40, 1, 9001 + steps, 'B')) == 0);
+    }
+    assert(bids->capacity == 2 * capacity);
+    for (int i = 0; i < bids->size; i++)
+    {
+        assert(orderbook->order_table->heap_index[bids->arr[i]] == i);
+        assert(bids->keys[i] == orderbook->order_table->keys[bids->arr[i]]);
+        if (i > 0)
+            assert(bids->keys[(i - 1) / HEAP_ARITY] <= bids->keys[i]);
+    }
+    assert(getTop(bids)->order_id == 1);
+    assert(getTop(orderbook->buy_orders)->order_id == 1);
+    assert(getTop(orderbook->sell_orders)->order_id == 2);
+
+    // Everything is still reachable after the moves
+    for (int i = 0; i < count; i += 7)
+        assert(cancel_order(orderbook, 2 * i + 1) == 0);
+    int resting = bids->size;
+    Order *prev = extractTop(orderbook->buy_orders);
+    int drained = 1;
+    for (Order *next; (next = extractTop(orderbook->buy_orders)); drained++)
+    {
+        assert(compare_buy_orders(prev, next) <= 0);
+        release_order(orderbook, prev);
+        prev = next;
+    }
+    release_order(orderbook, prev);
+    assert(drained == resting);
+    assert(orderbook->order_map->size == orderbook->sell_orders->size);
+
+    free_orderbook(orderbook);
+
+    // Reserving up front avoids growth during the session
+    orderbook = create_orderbook();
+    reserve_orderbook(orderbook, 1000);
+    assert(orderbook->sell_orders->capacity == 1000);
+    assert(orderbook->order_table->capacity >= 2000);
+    for (int i = 0; i < 700; i++)
+        add_order(orderbook, create_order(i + 1, 100 + i, 1, 1000 + i, 'S'));
+    assert(orderbook->sell_orders->capacity == 1000);
+
+    printf("Side growth test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test that the order table and map grow in steps too
+void test_table_and_map_growth()
+{
+    printf("Testing table and map growth...\n");
+
+    OrderBook *orderbook = create_orderbook();
+    OrderTable *table = orderbook->order_table;
+    OrderMap *map = orderbook->order_map;
+    AuditReport report;
+
+    // past the sizes a single step copies outright
+    int id = 1;
+    for (; !table->next_keys || table->capacity < 4 * TABLE_GROW_STEP; id++)
+        assert(add_order(orderbook, create_order(id, 100 + id % 20, 1, 1000, 'S')) == 0);
+    uint32_t capacity = table->capacity;
+    assert(table->next_capacity == 2 * capacity && table->used * 4 >= capacity * 3);
+    assert(add_order(orderbook, create_order(id++, 90, 1, 1000, 'B')) == 0);
+    assert(table->migrated == TABLE_GROW_STEP && table->capacity == capacity);
+
+    // handles already copied are freed, reused and re-keyed mid-growth
+    assert(cancel_order(orderbook, 1) == 0 && cancel_order(orderbook, 2) == 0);
+    assert(audit_orderbook(orderbook, NULL, &report) == 0);
+    for (int steps = 0; table->next_keys; steps++)
+    {
+        assert(steps < (int)capacity / TABLE_GROW_STEP + 1);
+        assert(add_order(orderbook, create_order(id++, 100 + steps % 20, 1, 1000, 'S')) == 0);
+    }
+    assert(table->capacity == 2 * capacity);
+    assert(audit_orderbook(orderbook, NULL, &report) == 0);
+
+    // the map moves a few buckets per put while both arrays serve lookups
+    for (; !map->old_buckets || map->rehash_index > 0 || map->old_capacity < 4 * MAP_REHASH_STEP; id++)
+        assert(add_order(orderbook, create_order(id, 100 + id % 20, 1, 1000, 'S')) == 0);
+    int old_capacity = map->old_capacity;
+    assert(map->capacity == 2 * old_capacity && map->rehash_index == 0);
+    assert(add_order(orderbook, create_order(id++, 90, 1, 1000, 'B')) == 0);
+    assert(map->rehash_index == MAP_REHASH_STEP);
+    assert(audit_orderbook(orderbook, NULL, &report) == 0);
+    int cancelled_below = id;
+    for (int order_id = 3; order_id < cancelled_below; order_id += 5)
+        assert(cancel_order(orderbook, order_id) == 0);
+    for (int steps = 0; map->old_buckets; steps++)
+    {
+        assert(steps < old_capacity / MAP_REHASH_STEP + 1);
+        assert(add_order(orderbook, create_order(id++, 90 - steps % 20, 1, 1000, 'B')) == 0);
+    }
+    assert(audit_orderbook(orderbook, NULL, &report) == 0);
+    for (int order_id = 3; order_id < id; order_id++)
+    {
+        Order *order = ordermap_get(map, order_id);
+        assert((order != NULL) == (order_id % 5 != 3 || order_id >= cancelled_below));
+        assert(!order || order->order_id == order_id);
+    }
+
+    free_orderbook(orderbook);
+    printf("Table and map growth test passed!\n");
+}
+
 int main()
 {
     printf("=== RUNNING ORDERBOOK TESTS ===\n\n");
@@ -195,6 +799,17 @@ int main()
     test_add_orders();
     test_order_matching();
     test_edge_cases();
+    test_cancel_order();
+    test_order_expiry();
+    test_expiry_randomized();
+    test_mass_cancel();
+    test_mass_cancel_ranges();
+    test_price_ladder();
+    test_price_ladder_randomized();
+    test_order_table();
+    test_order_keys();
+    test_side_growth();
+    test_table_and_map_growth();
 
     printf("\n=== ALL ORDERBOOK TESTS PASSED ===\n");
     return 0;
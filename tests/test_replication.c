@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "orderbook.h"
+#include "replication/replication.h"
+
+// Drives the primary with a random mix of adds, cancels, modifies, expiries
+// and call auctions
+static void random_flow(ReplPrimary *primary, unsigned int *seed, int count, int *next_id)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int roll = rand_r(seed) % 100;
+        if (roll < 60 || *next_id == 1)
+        {
+            Order *order = create_owned_order(*next_id, 0, 1 + rand_r(seed) % 50, i,
+                                              rand_r(seed) % 2 ? 'B' : 'S', 1 + rand_r(seed) % 4);
+            order->price = 95 + 0.5 * (rand_r(seed) % 20);
+            if (rand_r(seed) % 5 == 0)
+                set_time_in_force(order, TIF_GTT, i + rand_r(seed) % 200);
+            repl_add_order(primary, order);
+            free_order(order);
+            (*next_id)++;
+        }
+        else if (roll < 80)
+            repl_cancel_order(primary, 1 + rand_r(seed) % *next_id);
+        else if (roll < 95)
+            repl_modify_order(primary, 1 + rand_r(seed) % *next_id, 95 + 0.5 * (rand_r(seed) % 20),
+                              1 + rand_r(seed) % 50);
+        else if (roll < 98)
+            repl_expire_orders(primary, i);
+        else if (primary->book->phase == PHASE_CONTINUOUS)
+            repl_begin_auction(primary);
+        else
+            repl_uncross_auction(primary, rand_r(seed) % 2 ? 100 : 0);
+    }
+}
+
+// Test that a standby applying the stream ends up with the same book
+void test_replicated_stream()
+{
+    printf("Testing replicated stream...\n");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/repl_test_%d", (int)getpid());
+    OrderBook *book = create_orderbook();
+    OrderBook *standby = create_orderbook();
+    // decrements exercise the reduce events the running checksums follow
+    set_stp_mode(book, STP_DECREMENT);
+    set_stp_mode(standby, STP_DECREMENT);
+    ReplPrimary *primary = create_repl_primary(book, name, 64);
+    ReplBackup *backup = create_repl_backup(standby, name);
+    assert(primary && backup);
+
+    unsigned int seed = 11;
+    int next_id = 1;
+    for (int round = 0; round < 20; round++)
+    {
+        random_flow(primary, &seed, 500, &next_id);
+        assert(repl_backup_poll(backup, REPL_RING_CAPACITY) > 0);
+        assert(repl_primary_lag(primary) == 0);
+        assert(repl_primary_checksum(primary) == orderbook_checksum(book));
+        assert(repl_backup_checksum(backup) == orderbook_checksum(standby));
+    }
+
+    assert(backup->state == REPL_BACKUP_OK);
+    assert(backup->checksums_matched >= 10000 / 64);
+    assert(book->trade_history_size > 0);
+    assert(standby->trade_history_size == book->trade_history_size);
+    assert(orderbook_checksum(standby) == orderbook_checksum(book));
+    assert(standby->phase == book->phase);
+
+    // the checksum follows priority, not just contents
+    OrderBook *a = create_orderbook();
+    OrderBook *b = create_orderbook();
+    add_order(a, create_order(1, 100, 5, 0, 'B'));
+    add_order(a, create_order(2, 100, 5, 0, 'B'));
+    add_order(b, create_order(2, 100, 5, 0, 'B'));
+    add_order(b, create_order(1, 100, 5, 0, 'B'));
+    assert(orderbook_checksum(a) != orderbook_checksum(b));
+    free_orderbook(a);
+    free_orderbook(b);
+
+    free_repl_backup(backup);
+    free_repl_primary(primary);
+    free_orderbook(standby);
+    free_orderbook(book);
+    printf("Replicated stream test passed!\n");
+}
+
+// Test that a standby lapped by the log reports the gap
+void test_gap_detection()
+{
+    printf("Testing sequence gap detection...\n");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/repl_test_%d", (int)getpid());
+    OrderBook *book = create_orderbook();
+    OrderBook *standby = create_orderbook();
+    ReplPrimary *primary = create_repl_primary(book, name, 0);
+    ReplBackup *backup = create_repl_backup(standby, name);
+
+    for (int i = 1; i <= REPL_RING_CAPACITY + 10; i++)
+        repl_cancel_order(primary, i);
+    assert(repl_primary_lag(primary) == REPL_RING_CAPACITY + 10);
+
+    assert(repl_backup_poll(backup, 100) == -1);
+    assert(backup->state == REPL_BACKUP_GAP);
+    assert(backup->gap_at == 1 && backup->applied == 0);
+    assert(repl_promote(backup) == NULL);
+
+    free_repl_backup(backup);
+    free_repl_primary(primary);
+    free_orderbook(standby);
+    free_orderbook(book);
+    printf("Sequence gap detection test passed!\n");
+}
+
+// Test that a standby whose book drifted fails the next checksum
+void test_checksum_mismatch()
+{
+    printf("Testing checksum mismatch...\n");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/repl_test_%d", (int)getpid());
+    OrderBook *book = create_orderbook();
+    OrderBook *standby = create_orderbook();
+    ReplPrimary *primary = create_repl_primary(book, name, 4);
+    ReplBackup *backup = create_repl_backup(standby, name);
+
+    Order *order = create_order(1, 100, 10, 0, 'B');
+    repl_add_order(primary, order);
+    free_order(order);
+    assert(repl_backup_poll(backup, 100) == 1);
+
+    // touched outside the stream
+    assert(cancel_order(standby, 1) == 0);
+
+    for (int i = 2; i <= 4; i++)
+        repl_cancel_order(primary, i);
+    assert(repl_backup_poll(backup, 100) == -1);
+    assert(backup->state == REPL_BACKUP_DIVERGED);
+    assert(backup->applied == 4);
+    assert(repl_promote(backup) == NULL);
+
+    free_repl_backup(backup);
+    free_repl_primary(primary);
+    free_orderbook(standby);
+    free_orderbook(book);
+    printf("Checksum mismatch test passed!\n");
+}
+
+typedef struct
+{
+    ReplBackup *backup;
+    uint64_t timeout_ns;
+    OrderBook *promoted;
+    uint64_t promoted_at;
+} StandbyState;
+
+static void *run_standby(void *arg)
+{
+    StandbyState *state = (StandbyState *)arg;
+    while (repl_primary_alive(state->backup, state->timeout_ns))
+        if (repl_backup_poll(state->backup, 1024) < 0)
+            return NULL;
+        else
+            sched_yield();
+
+    state->promoted = repl_promote(state->backup);
+    state->promoted_at = repl_clock_ns();
+    return NULL;
+}
+
+// Test failover: the standby notices the silent primary and takes over
+void test_promotion()
+{
+    printf("Testing standby promotion...\n");
+
+    char name[64];
+    char next_name[64];
+    snprintf(name, sizeof(name), "/repl_test_%d", (int)getpid());
+    snprintf(next_name, sizeof(next_name), "/repl_test_%d_next", (int)getpid());
+    OrderBook *book = create_orderbook();
+    OrderBook *standby = create_orderbook();
+    ReplPrimary *primary = create_repl_primary(book, name, 128);
+    ReplBackup *backup = create_repl_backup(standby, name);
+
+    StandbyState state = {backup, 200 * 1000000ULL, NULL, 0};
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, run_standby, &state) == 0);
+
+    unsigned int seed = 5;
+    int next_id = 1;
+    for (int round = 0; round < 40; round++)
+    {
+        random_flow(primary, &seed, 250, &next_id);
+        while (repl_primary_lag(primary) > REPL_RING_CAPACITY / 2)
+            sched_yield();
+        repl_primary_heartbeat(primary);
+    }
+    // the primary goes silent
+    uint64_t last_heartbeat = repl_clock_ns();
+    pthread_join(thread, NULL);
+
+    assert(state.promoted == standby);
+    assert(backup->state == REPL_BACKUP_PROMOTED);
+    assert(state.promoted_at - last_heartbeat < 1000000000ULL);
+    assert(orderbook_checksum(standby) == orderbook_checksum(book));
+
+    // the old primary is fenced
+    assert(repl_cancel_order(primary, 1) == -1);
+
+    // the promoted book replicates onward
+    ReplPrimary *next = create_repl_primary(standby, next_name, 0);
+    assert(next);
+    Order *order = create_order(next_id, 200, 1, 0, 'S');
+    assert(repl_add_order(next, order) == 0);
+    free_order(order);
+    assert(ordermap_get(standby->order_map, next_id) != NULL);
+    // seeded from the book it took over, not from empty
+    assert(repl_primary_checksum(next) == orderbook_checksum(standby));
+
+    free_repl_primary(next);
+    free_repl_backup(backup);
+    free_repl_primary(primary);
+    free_orderbook(standby);
+    free_orderbook(book);
+    printf("Standby promotion test passed!\n");
+}
+
+static void *run_submitter(void *arg)
+{
+    ReplPrimary *primary = (ReplPrimary *)arg;
+    // resting buys only, so every submit succeeds until the fence
+    for (int id = 1;; id++)
+    {
+        Order *order = create_order(id, 0, 1, 0, 'B');
+        order->price = 50 + id % 100;
+        int result = repl_add_order(primary, order);
+        free_order(order);
+        if (result != 0)
+            return NULL;
+    }
+}
+
+// Test that a promotion racing a busy primary loses nothing: every add the
+// primary applied before the fence reaches the promoted book
+void test_fencing_race()
+{
+    printf("Testing fencing against in-flight submits...\n");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/repl_test_%d", (int)getpid());
+    for (int round = 0; round < 20; round++)
+    {
+        OrderBook *book = create_orderbook();
+        OrderBook *standby = create_orderbook();
+        ReplPrimary *primary = create_repl_primary(book, name, 0);
+        ReplBackup *backup = create_repl_backup(standby, name);
+
+        pthread_t thread;
+        assert(pthread_create(&thread, NULL, run_submitter, primary) == 0);
+        while (repl_primary_lag(primary) < 100 + 50 * (uint64_t)round)
+            repl_backup_poll(backup, 64);
+
+        assert(repl_promote(backup) == standby);
+        pthread_join(thread, NULL);
+
+        assert(repl_cancel_order(primary, 1) == -1);
+        assert(standby->buy_orders->size == book->buy_orders->size);
+        assert(orderbook_checksum(standby) == orderbook_checksum(book));
+
+        free_repl_backup(backup);
+        free_repl_primary(primary);
+        free_orderbook(standby);
+        free_orderbook(book);
+    }
+
+    printf("Fencing test passed!\n");
+}
+
+// Test that a call auction run on the primary runs the same on the standby
+void test_replicated_auction()
+{
+    printf("Testing replicated auction...\n");
+
+    char name[64];
+    snprintf(name, sizeof(name), "/repl_test_%d", (int)getpid());
+    OrderBook *book = create_orderbook();
+    OrderBook *standby = create_orderbook();
+    ReplPrimary *primary = create_repl_primary(book, name, 1);
+    ReplBackup *backup = create_repl_backup(standby, name);
+
+    assert(repl_begin_auction(primary) == 0);
+    Order *buy = create_order(1, 102, 5, 0, 'B');
+    Order *sell = create_order(2, 100, 8, 0, 'S');
+    repl_add_order(primary, buy);
+    repl_add_order(primary, sell);
+    free_order(buy);
+    free_order(sell);
+
+    assert(repl_backup_poll(backup, 100) > 0);
+    assert(standby->phase == PHASE_AUCTION);
+    assert(standby->trade_history_size == 0 && standby->sell_orders->size == 1);
+
+    assert(repl_uncross_auction(primary, 0) == 0);
+    assert(book->trade_history_size == 1);
+    assert(repl_backup_poll(backup, 100) > 0);
+    assert(backup->state == REPL_BACKUP_OK);
+    assert(standby->phase == PHASE_CONTINUOUS);
+    assert(standby->trade_history_size == 1);
+    assert(standby->trade_history[0].traded_price == book->trade_history[0].traded_price);
+    assert(orderbook_checksum(standby) == orderbook_checksum(book));
+
+    free_repl_backup(backup);
+    free_repl_primary(primary);
+    free_orderbook(standby);
+    free_orderbook(book);
+    printf("Replicated auction test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING REPLICATION TESTS ===\n");
+    test_replicated_stream();
+    test_replicated_auction();
+    test_gap_detection();
+    test_checksum_mismatch();
+    test_promotion();
+    test_fencing_race();
+    printf("=== ALL REPLICATION TESTS PASSED ===\n");
+    return 0;
+}
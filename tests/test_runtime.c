@@ -0,0 +1,233 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdint.h>
+#include "runtime/runtime.h"
+#include "audit/audit.h"
+#include "loadgen/flowgen.h"
+
+// Test runtime config parsing
+void test_parse_runtime_config()
+{
+    printf("Testing runtime config parsing...\n");
+
+    RuntimeConfig config = default_runtime_config();
+    assert(config.cpu[ROLE_MATCHING] == -1);
+    assert(!config.prefault && !config.lock_memory);
+
+    assert(parse_runtime_config("matching=2,publisher=5,reserve=1000,prefault", &config) == 0);
+    assert(config.cpu[ROLE_MATCHING] == 2);
+    assert(config.cpu[ROLE_INGRESS] == -1);
+    assert(config.cpu[ROLE_PUBLISHER] == 5);
+    assert(config.reserve_orders == 1000);
+    assert(config.prefault && !config.lock_memory);
+
+    assert(parse_runtime_config("mlock", &config) == 0);
+    assert(config.lock_memory && config.cpu[ROLE_MATCHING] == 2);
+
+    assert(config.arena_bytes == 0 && config.arena_pages == ARENA_PAGES_2M);
+    assert(parse_runtime_config("arena=512M,hugepages=1G", &config) == 0);
+    assert(config.arena_bytes == (size_t)512 << 20 && config.arena_pages == ARENA_PAGES_1G);
+    assert(parse_runtime_config("arena=4096,hugepages=none", &config) == 0);
+    assert(config.arena_bytes == 4096 && config.arena_pages == ARENA_PAGES_NORMAL);
+
+    assert(parse_runtime_config("matching=x", &config) == -1);
+    assert(parse_runtime_config("turbo", &config) == -1);
+    assert(parse_runtime_config("ingress=-1", &config) == -1);
+    assert(parse_runtime_config("arena=12X", &config) == -1);
+    assert(parse_runtime_config("hugepages=4M", &config) == -1);
+
+    printf("Runtime config parsing test passed!\n");
+}
+
+// Test pinning the matching thread and building a placed book
+void test_runtime_orderbook()
+{
+    printf("Testing placed order book...\n");
+
+    // pin to a core the test is already allowed to run on
+    cpu_set_t allowed;
+    assert(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    int cpu = 0;
+    while (!CPU_ISSET(cpu, &allowed))
+        cpu++;
+
+    RuntimeConfig config = default_runtime_config();
+    config.cpu[ROLE_MATCHING] = cpu;
+    config.reserve_orders = 500;
+    config.prefault = 1;
+
+    assert(runtime_cpu_node(cpu) >= 0);
+    assert(runtime_enter_thread(&config, ROLE_INGRESS) == 0); // unpinned role
+
+    OrderBook *orderbook = runtime_create_orderbook(&config);
+    assert(sched_getcpu() == cpu);
+    assert(orderbook->buy_orders->capacity == 500);
+    assert(orderbook->order_map->capacity > 1000);
+
+    Order *buy = create_order(1, 100, 10, 1000, 'B');
+    Order *sell = create_order(2, 100, 4, 1001, 'S');
+    add_order(orderbook, buy);
+    add_order(orderbook, sell);
+    assert(orderbook->trade_history_size == 1);
+    assert(buy->quantity == 6);
+
+    printf("Placed order book test passed!\n");
+
+    free_orderbook(orderbook);
+}
+
+// Test block reuse, alignment and the malloc fallback of an arena
+void test_arena_allocation()
+{
+    printf("Testing arena allocation...\n");
+
+    // without a current arena, blocks come from malloc
+    assert(arena_current() == NULL);
+    char *plain = (char *)arena_malloc(100);
+    plain = (char *)arena_realloc(plain, 10000);
+    assert(plain && !arena_owns(NULL, plain));
+    arena_free(plain);
+
+    Arena *arena = create_arena(1 << 20, ARENA_PAGES_2M, 1);
+    assert(arena && arena->size >= 1 << 20 && arena->page_size >= 4096);
+    assert(create_arena(0, ARENA_PAGES_2M, 0) == NULL);
+    assert(arena_set_current(arena) == NULL && arena_current() == arena);
+
+    // freed blocks are reused by their size class
+    char *first = (char *)arena_malloc(40);
+    assert(arena_owns(arena, first) && ((uintptr_t)first & 15) == 0);
+    arena_free(first);
+    assert(arena_malloc(48) == first);
+    size_t used = arena->used;
+    arena_free(first);
+
+    int *zeroed = (int *)arena_calloc(64, sizeof(int));
+    for (int i = 0; i < 64; i++)
+        assert(zeroed[i] == 0);
+    void *aligned = arena_aligned_alloc(256, 1000);
+    assert(arena_owns(arena, aligned) && ((uintptr_t)aligned & 255) == 0);
+
+    // growing keeps the contents; shrinking stays in place
+    for (int i = 0; i < 64; i++)
+        zeroed[i] = i;
+    zeroed = (int *)arena_realloc(zeroed, 4096 * sizeof(int));
+    assert(arena_owns(arena, zeroed) && zeroed[63] == 63);
+    assert(arena_realloc(zeroed, 16) == zeroed);
+    assert(arena->used > used && arena->overflows == 0);
+
+    // a block that starts a page still only needs its class's alignment
+    char *small = (char *)arena_malloc(128);
+    assert(((uintptr_t)small & (ARENA_PAGE_SIZE - 1)) == 0);
+    char *grown = (char *)arena_realloc(small, 256);
+    assert(arena->page_classes[(grown - arena->base) >> ARENA_PAGE_SHIFT] == 8);
+    arena_free(grown);
+
+    // a full arena hands requests to malloc
+    void *large = arena_malloc(2 << 20);
+    assert(large && !arena_owns(arena, large) && arena->overflows == 1);
+    arena_free(large);
+    arena_free(zeroed);
+    arena_free(aligned);
+
+    assert(arena_set_current(NULL) == arena);
+    free_arena(arena);
+    printf("Arena allocation test passed!\n");
+}
+
+// Test a book served from an arena through a stretch of trading
+// Blocks carry no header, so an Order or a power-of-two array takes
+// exactly its own size out of the arena
+void test_arena_footprint()
+{
+    printf("Testing arena footprint...\n");
+
+    Arena *arena = create_arena(256 << 20, ARENA_PAGES_NORMAL, 0);
+    assert(arena);
+    arena_set_current(arena);
+
+    size_t used = arena->used;
+    for (int i = 0; i < 4096; i++)
+        assert(arena_malloc(sizeof(Order)));
+    assert(arena->used - used == 4096 * sizeof(Order));
+
+    used = arena->used;
+    void *block = arena_malloc(8 << 20);
+    assert(arena_owns(arena, block));
+    assert(arena->used - used == 8 << 20);
+    // freed with no current arena, the registry still finds its owner
+    arena_set_current(NULL);
+    arena_free(block);
+    arena_set_current(arena);
+    assert(arena_malloc(8 << 20) == block && arena->used - used == 8 << 20);
+
+    // heaps, order table and map together; with a header per block each
+    // power-of-two array doubled and this came to 176 bytes an order
+    int orders_per_side = 1 << 16;
+    OrderBook *orderbook = create_orderbook();
+    used = arena->used;
+    reserve_orderbook(orderbook, orders_per_side);
+    assert(arena->used - used <= (size_t)orders_per_side * 128);
+
+    free_orderbook(orderbook);
+    free_arena(arena_set_current(NULL));
+    printf("Arena footprint test passed!\n");
+}
+
+void test_arena_orderbook()
+{
+    printf("Testing order book in an arena...\n");
+
+    RuntimeConfig config = default_runtime_config();
+    config.reserve_orders = 1000;
+    config.arena_bytes = 64 << 20;
+    config.prefault = 1;
+    OrderBook *orderbook = runtime_create_orderbook(&config);
+    Arena *arena = arena_current();
+    assert(arena && arena->allocations > 0);
+    assert(arena_owns(arena, orderbook) && arena_owns(arena, orderbook->order_table->keys));
+    assert(arena_owns(arena, orderbook->buy_orders->key_block));
+
+    FlowConfig flow = default_flow_config();
+    flow.symbols = 1;
+    FlowGenerator *generator = create_flow_generator(&flow);
+    FlowMessage message;
+    SeqMessage seq;
+    for (int i = 0; i < 50000; i++)
+    {
+        flow_next(generator, &message);
+        flow_to_seq(&message, &seq);
+        sequencer_apply(orderbook, &seq);
+    }
+    free_flow_generator(generator);
+
+    AuditReport report;
+    assert(orderbook->trade_history_size > 0);
+    assert(audit_orderbook(orderbook, NULL, &report) == 0);
+    assert(arena->overflows == 0);
+
+    // recycled blocks keep the footprint flat once the book has warmed up
+    size_t used = arena->used;
+    free_orderbook(orderbook);
+    orderbook = runtime_create_orderbook(&config);
+    assert(arena_current() == arena && arena->used == used);
+
+    free_orderbook(orderbook);
+    free_arena(arena_set_current(NULL));
+    printf("Order book in an arena test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING RUNTIME TESTS ===\n\n");
+
+    test_parse_runtime_config();
+    test_runtime_orderbook();
+    test_arena_allocation();
+    test_arena_footprint();
+    test_arena_orderbook();
+
+    printf("\n=== ALL RUNTIME TESTS PASSED ===\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include "orderbook.h"
+#include "sequencer/sequencer.h"
+#include "replication/replication.h"
+
+static SeqMessage new_order(int order_id, char side, double price, int quantity)
+{
+    SeqMessage message;
+    memset(&message, 0, sizeof(message));
+    message.type = SEQ_NEW_ORDER;
+    message.order_id = order_id;
+    message.side = side;
+    message.price = price;
+    message.quantity = quantity;
+    message.tif = TIF_GTC;
+    return message;
+}
+
+// Test merging, stamping and applying queued messages
+void test_sequencing()
+{
+    printf("Testing sequencing...\n");
+
+    Sequencer *sequencer = create_sequencer(64);
+    IngressQueue *a = sequencer_add_gateway(sequencer, 3);
+    IngressQueue *b = sequencer_add_gateway(sequencer, 4);
+    assert(a->mask == 3 && b->gateway == 1);
+
+    // queued alternately, so merged alternately
+    SeqMessage message = new_order(1, 'S', 100, 5);
+    assert(ingress_push(a, &message) == 0);
+    message = new_order(2, 'S', 100, 5);
+    assert(ingress_push(b, &message) == 0);
+    message = new_order(3, 'B', 100, 7);
+    assert(ingress_push(a, &message) == 0);
+    for (int i = 0; i < 2; i++)
+        assert(ingress_push(a, &message) == 0);
+    assert(ingress_push(a, &message) == -1); // full
+
+    SeqMessage out[8];
+    int n = sequencer_poll(sequencer, out, 3);
+    assert(n == 3);
+    assert(out[0].order_id == 1 && out[0].gateway == 0 && out[0].sequence == 1);
+    assert(out[1].order_id == 2 && out[1].gateway == 1 && out[1].sequence == 2);
+    assert(out[2].order_id == 3 && out[2].sequence == 3);
+    assert(out[0].receive_ns > 0 && out[2].receive_ns >= out[0].receive_ns);
+    assert(ingress_push(a, &message) == 0); // space freed by the poll
+
+    // the first seller to arrive trades first; the buyer's leftover rests
+    OrderBook *book = create_orderbook();
+    for (int i = 0; i < n; i++)
+        assert(sequencer_apply(book, &out[i]) == 0);
+    assert(book->trade_history_size == 2);
+    assert(book->trade_history[0].maker_id == 1 && book->trade_history[0].traded_quantity == 5);
+    assert(book->trade_history[1].maker_id == 2 && book->trade_history[1].traded_quantity == 2);
+    assert(ordermap_get(book->order_map, 2)->quantity == 3);
+    assert(book->trade_history[0].timestamp == (double)out[2].receive_ns);
+
+    // the rest of the queue repeats order 3: the first copy rests, the
+    // others are duplicates
+    n = sequencer_poll(sequencer, out, 8);
+    assert(n == 3 && out[0].sequence == 4 && out[2].sequence == 6);
+    assert(sequencer_poll(sequencer, out, 8) == 0);
+    assert(sequencer_apply(book, &out[0]) == 0);
+    assert(sequencer_apply(book, &out[1]) == -1);
+    assert(sequencer_apply(book, &out[2]) == -1);
+    assert(ordermap_get(book->order_map, 3)->quantity == 4);
+
+    free_orderbook(book);
+    free_sequencer(sequencer);
+    printf("Sequencing test passed!\n");
+}
+
+#define GATEWAYS 4
+#define PER_GATEWAY 20000
+
+typedef struct
+{
+    IngressQueue *queue;
+    unsigned int seed;
+} GatewayState;
+
+static void *run_gateway(void *arg)
+{
+    GatewayState *state = (GatewayState *)arg;
+    for (int i = 0; i < PER_GATEWAY; i++)
+    {
+        // gateway g owns ids g, g + GATEWAYS, ...
+        int order_id = 1 + state->queue->gateway + GATEWAYS * (i / 2);
+        SeqMessage message = new_order(order_id, rand_r(&state->seed) % 2 ? 'B' : 'S',
+                                       95 + 0.5 * (rand_r(&state->seed) % 20), 1 + rand_r(&state->seed) % 30);
+        if (i % 2)
+        {
+            message.type = rand_r(&state->seed) % 3 ? SEQ_CANCEL : SEQ_MODIFY;
+            message.order_id = 1 + state->queue->gateway + GATEWAYS * (rand_r(&state->seed) % (i / 2 + 1));
+        }
+        while (ingress_push(state->queue, &message) != 0)
+            sched_yield();
+    }
+    return NULL;
+}
+
+typedef struct
+{
+    SeqMessage *messages;
+    int count;
+} Journal;
+
+static void record(void *context, const SeqMessage *message, int result)
+{
+    (void)result;
+    Journal *journal = (Journal *)context;
+    journal->messages[journal->count++] = *message;
+}
+
+static int same_fill(const FilledOrder *a, const FilledOrder *b)
+{
+    return a->maker_id == b->maker_id && a->taker_id == b->taker_id &&
+           a->traded_quantity == b->traded_quantity && a->maker_leftover == b->maker_leftover &&
+           a->taker_leftover == b->taker_leftover && a->traded_price == b->traded_price &&
+           a->timestamp == b->timestamp && a->taker_side == b->taker_side;
+}
+
+// Test that concurrent gateways produce one stream that replays exactly
+void test_concurrent_replay()
+{
+    printf("Testing concurrent gateways and replay...\n");
+
+    Sequencer *sequencer = create_sequencer(256);
+    Journal journal = {(SeqMessage *)malloc(GATEWAYS * PER_GATEWAY * sizeof(SeqMessage)), 0};
+    set_sequenced_handler(sequencer, record, &journal);
+
+    GatewayState states[GATEWAYS];
+    pthread_t threads[GATEWAYS];
+    for (int g = 0; g < GATEWAYS; g++)
+    {
+        states[g].queue = sequencer_add_gateway(sequencer, 1024);
+        states[g].seed = 17 + g;
+    }
+    for (int g = 0; g < GATEWAYS; g++)
+        assert(pthread_create(&threads[g], NULL, run_gateway, &states[g]) == 0);
+
+    OrderBook *book = create_orderbook();
+    while (journal.count < GATEWAYS * PER_GATEWAY)
+        if (sequencer_run(sequencer, book) == 0)
+            sched_yield();
+    for (int g = 0; g < GATEWAYS; g++)
+        pthread_join(threads[g], NULL);
+
+    for (int i = 0; i < journal.count; i++)
+    {
+        assert(journal.messages[i].sequence == (uint64_t)i + 1);
+        assert(i == 0 || journal.messages[i].receive_ns >= journal.messages[i - 1].receive_ns);
+    }
+
+    // replaying the journal reproduces the session bit for bit
+    OrderBook *replay = create_orderbook();
+    for (int i = 0; i < journal.count; i++)
+        sequencer_apply(replay, &journal.messages[i]);
+    assert(book->trade_history_size > 0);
+    assert(replay->trade_history_size == book->trade_history_size);
+    for (int i = 0; i < book->trade_history_size; i++)
+        assert(same_fill(&replay->trade_history[i], &book->trade_history[i]));
+    assert(orderbook_checksum(replay) == orderbook_checksum(book));
+
+    free_orderbook(replay);
+    free_orderbook(book);
+    free(journal.messages);
+    free_sequencer(sequencer);
+    printf("Concurrent gateways and replay test passed!\n");
+}
+
+int main()
+{
+    printf("=== RUNNING SEQUENCER TESTS ===\n");
+    test_sequencing();
+    test_concurrent_replay();
+    printf("=== ALL SEQUENCER TESTS PASSED ===\n");
+    return 0;
+}
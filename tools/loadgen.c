@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "orderbook.h"
+#include "loadgen/flowgen.h"
+
+/*
+    Synthetic order-flow generator. Writes a flow to a file, feeds it
+    through the sequencer into one book per symbol, or just generates it,
+    and reports the rate.
+
+    usage: loadgen [-s seed] [-n messages] [-r rate] [-hawkes alpha beta]
+                   [-symbols n] [-skew z] [-cancel ratio] [-modify ratio]
+                   [-o file | -engine]
+*/
+
+#define LOADGEN_BATCH 4096
+
+static double now_seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-s seed] [-n messages] [-r rate] [-hawkes alpha beta] [-symbols n] [-skew z]\n"
+            "          [-cancel ratio] [-modify ratio] [-o file | -engine]\n",
+            name);
+}
+
+// Feeds the flow through a sequencer; returns the adds the books rejected
+static long long run_engine(FlowGenerator *generator, long long messages)
+{
+    int symbols = generator->config.symbols;
+    Sequencer *sequencer = create_sequencer(LOADGEN_BATCH);
+    IngressQueue *queue = sequencer_add_gateway(sequencer, LOADGEN_BATCH);
+    OrderBook **books = (OrderBook **)malloc(symbols * sizeof(OrderBook *));
+    SeqMessage *batch = (SeqMessage *)malloc(LOADGEN_BATCH * sizeof(SeqMessage));
+    if (!books || !batch)
+    {
+        fprintf(stderr, "Memory allocation failed for loadgen books\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int s = 0; s < symbols; s++)
+        books[s] = create_orderbook();
+
+    long long rejected = 0;
+    for (long long done = 0; done < messages;)
+    {
+        long long left = messages - done;
+        flow_feed(generator, &queue, 1, left < LOADGEN_BATCH ? (int)left : LOADGEN_BATCH);
+        int n = sequencer_poll(sequencer, batch, LOADGEN_BATCH);
+        for (int i = 0; i < n; i++)
+        {
+            int result = sequencer_apply(books[batch[i].user_data], &batch[i]);
+            rejected += batch[i].type == SEQ_NEW_ORDER && result != 0;
+        }
+        done += n;
+    }
+
+    for (int s = 0; s < symbols; s++)
+        free_orderbook(books[s]);
+    free(books);
+    free(batch);
+    free_sequencer(sequencer);
+    return rejected;
+}
+
+int main(int argc, char **argv)
+{
+    FlowConfig config = default_flow_config();
+    long long messages = 10000000;
+    const char *path = NULL;
+    int engine = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            config.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            messages = atoll(argv[++i]);
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            config.rate = atof(argv[++i]);
+        else if (strcmp(argv[i], "-hawkes") == 0 && i + 2 < argc)
+        {
+            config.arrivals = FLOW_HAWKES;
+            config.hawkes_alpha = atof(argv[++i]);
+            config.hawkes_beta = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-symbols") == 0 && i + 1 < argc)
+            config.symbols = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-skew") == 0 && i + 1 < argc)
+            config.symbol_skew = atof(argv[++i]);
+        else if (strcmp(argv[i], "-cancel") == 0 && i + 1 < argc)
+            config.cancel_ratio = atof(argv[++i]);
+        else if (strcmp(argv[i], "-modify") == 0 && i + 1 < argc)
+            config.modify_ratio = atof(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            path = argv[++i];
+        else if (strcmp(argv[i], "-engine") == 0)
+            engine = 1;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (messages <= 0 || (path && engine))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FlowGenerator *generator = create_flow_generator(&config);
+    if (!generator)
+    {
+        fprintf(stderr, "inconsistent flow configuration\n");
+        return 2;
+    }
+
+    double start = now_seconds();
+    long long rejected = 0;
+    if (path)
+    {
+        if (flow_write_file(generator, path, messages) != 0)
+        {
+            fprintf(stderr, "could not write %s\n", path);
+            free_flow_generator(generator);
+            return 1;
+        }
+    }
+    else if (engine)
+        rejected = run_engine(generator, messages);
+    else
+    {
+        FlowMessage *batch = (FlowMessage *)malloc(LOADGEN_BATCH * sizeof(FlowMessage));
+        if (!batch)
+        {
+            fprintf(stderr, "Memory allocation failed for loadgen batch\n");
+            exit(EXIT_FAILURE);
+        }
+        for (long long done = 0; done < messages; done += LOADGEN_BATCH)
+            flow_generate(generator, batch, messages - done < LOADGEN_BATCH ? (int)(messages - done) : LOADGEN_BATCH);
+        free(batch);
+    }
+    double seconds = now_seconds() - start;
+
+    printf("%lld messages (%llu new, %llu cancel, %llu modify) spanning %.3fs of flow\n", messages,
+           (unsigned long long)generator->counts[SEQ_NEW_ORDER], (unsigned long long)generator->counts[SEQ_CANCEL],
+           (unsigned long long)generator->counts[SEQ_MODIFY], generator->time);
+    printf("%.1fM messages/s%s", messages / seconds / 1e6, path ? " to file" : engine ? " through the engine" : "");
+    if (engine)
+        printf(", %lld adds rejected", rejected);
+    printf("\n");
+
+    free_flow_generator(generator);
+    return 0;
+}